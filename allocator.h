@@ -0,0 +1,73 @@
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#include <stdlib.h>
+
+/**
+* Allocator
+*
+* A pluggable memory allocator: a pair of functions and a context that is
+* passed to both of them. Modules that accept an Allocator make every
+* allocation of their nodes, names and dates through it, so they can be put
+* on an arena, a per-thread cache or a memory-capped pool.
+*
+* An Allocator whose functions are NULL, and a NULL pointer to an Allocator,
+* stand for malloc and free.
+*
+* The following functions are available:
+*   allocatorAlloc  - Allocates memory through an allocator.
+*   allocatorFree   - Frees memory through the allocator that allocated it.
+*/
+
+/** Type of function that allocates size bytes, returns NULL on failure */
+typedef void* (*AllocateFunction)(size_t size, void* ctx);
+
+/** Type of function that frees memory returned by the matching AllocateFunction */
+typedef void (*DeallocateFunction)(void* ptr, void* ctx);
+
+/** Type for defining an allocator, copied by value by the modules that use it */
+typedef struct Allocator_t {
+    AllocateFunction alloc;
+    DeallocateFunction free;
+    void* ctx;
+} Allocator;
+
+/**
+* allocatorAlloc: Allocates memory through an allocator.
+*
+* @param allocator - The allocator, NULL for malloc.
+* @param size - The number of bytes to allocate.
+* @return
+*   NULL if allocation failed.
+*   Otherwise the allocated memory.
+*/
+static inline void* allocatorAlloc(const Allocator* allocator, size_t size)
+{
+    if(allocator==NULL||allocator->alloc==NULL)
+    {
+        return malloc(size);
+    }
+    return allocator->alloc(size,allocator->ctx);
+}
+
+/**
+* allocatorFree: Frees memory through the allocator that allocated it.
+*
+* @param allocator - The allocator, NULL for free.
+* @param ptr - The memory to free. If ptr is NULL nothing will be done.
+*/
+static inline void allocatorFree(const Allocator* allocator, void* ptr)
+{
+    if(ptr==NULL)
+    {
+        return;
+    }
+    if(allocator==NULL||allocator->free==NULL)
+    {
+        free(ptr);
+        return;
+    }
+    allocator->free(ptr,allocator->ctx);
+}
+
+#endif /* ALLOCATOR_H_ */
@@ -0,0 +1,541 @@
+#define _POSIX_C_SOURCE 199309L
+#include "event_manager.h"
+#include "event_manager_ext.h"
+#include "priority_queue.h"
+#include "priority_queue_ext.h"
+#include "date.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#define NS_IN_SECOND 1000000000L
+#define NAME_LEN 32
+#define DEFAULT_REPS 100
+#define DEFAULT_WARMUP 10
+#define DEFAULT_BUDGET 10.0
+#define DEFAULT_SEED 12345u
+#define MAX_SIZES 16
+#define EXPORT_REPS 5
+#define DAYS_SPREAD 3650
+#define MEMBERS_RATIO 100
+#define MIN_MEMBERS 16
+#define ID_STRIDE 7919
+#define START_DAY 1
+#define START_MONTH 1
+#define START_YEAR 2020
+#define PERCENT 100
+#define P99 99
+#define EXPORT_FILE "bench_output.txt"
+#define EXPORT_WORKERS 4
+
+/**
+* em_bench: times the PriorityQueue and EventManager APIs over growing sizes.
+*
+* usage: em_bench [-f csv|json] [-o file] [-r reps] [-w warmup] [-b budget_seconds]
+*                 [-s seed] [-n size]...
+*
+* For every case and size a fixture of that size is built, warmup untimed
+* operations are run, and then reps operations are timed one by one.
+* The median, p99, mean, min and max of the per operation latency are reported.
+* A size is skipped if building its fixture is expected to take longer than
+* the budget, based on the build time of the previous size.
+*/
+
+typedef struct fixture
+{
+    PriorityQueue queue;
+    int* priorities;
+    int* take_element;
+    int* take_priority;
+    EventManager em;
+    Date start;
+    int size;
+    int members;
+    int next_id;
+    unsigned int seed;
+    Date date;
+    char name[NAME_LEN];
+}*Fixture;
+
+typedef struct bench_case
+{
+    const char* name;
+    bool is_em;
+    int max_reps;
+    void (*prepare)(Fixture fixture,int iteration);
+    void (*run)(Fixture fixture,int iteration);
+}Bench_case;
+
+typedef struct bench_result
+{
+    const char* name;
+    int size;
+    int reps;
+    double build_seconds;
+    long median_ns;
+    long p99_ns;
+    long mean_ns;
+    long min_ns;
+    long max_ns;
+    bool skipped;
+}Bench_result;
+
+/**
+* now_ns: returns the monotonic time in nanoseconds.
+*/
+static long now_ns(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC,&time);
+    return time.tv_sec*NS_IN_SECOND+time.tv_nsec;
+}
+
+/**
+* next_random: advances a xorshift generator.
+*
+* @param seed - the state of the generator.
+* @return
+* the next random number.
+*/
+static unsigned int next_random(unsigned int* seed)
+{
+    *seed^=*seed<<13;
+    *seed^=*seed>>17;
+    *seed^=*seed<<5;
+    return *seed;
+}
+
+static PQElement copy_int(PQElement element)
+{
+    int* copy=malloc(sizeof(*copy));
+    if(copy!=NULL)
+    {
+        *copy=*(int*)element;
+    }
+    return copy;
+}
+
+static void free_int(PQElement element)
+{
+    free(element);
+}
+
+static bool equal_ints(PQElement element1,PQElement element2)
+{
+    return *(int*)element1==*(int*)element2;
+}
+
+static int compare_ints(PQElementPriority priority1,PQElementPriority priority2)
+{
+    return *(int*)priority1-*(int*)priority2;
+}
+
+/**
+* fixture_create: builds a queue or an event manager with size elements.
+*
+* @param size - the number of elements or events.
+* @param is_em - TRUE to build an event manager, FALSE to build a queue.
+* @param seed - the seed of the random generator.
+* @return
+* NULL - if allocation fails.
+* otherwise a new fixture.
+*/
+static Fixture fixture_create(int size,bool is_em,unsigned int seed)
+{
+    Fixture fixture=malloc(sizeof(*fixture));
+    if(fixture==NULL)
+    {
+        return NULL;
+    }
+    memset(fixture,0,sizeof(*fixture));
+    fixture->size=size;
+    fixture->next_id=size;
+    fixture->seed=seed;
+    if(!is_em)
+    {
+        fixture->queue=pqCreate(copy_int,free_int,equal_ints,copy_int,free_int,compare_ints);
+        fixture->priorities=malloc(sizeof(*fixture->priorities)*size);
+        for(int i=0;i<size;i++){
+            fixture->priorities[i]=(int)(next_random(&fixture->seed)%(unsigned int)size);
+            pqInsert(fixture->queue,&i,&fixture->priorities[i]);
+        }
+        return fixture;
+    }
+    fixture->start=dateCreate(START_DAY,START_MONTH,START_YEAR);
+    fixture->em=createEventManager(fixture->start);
+    fixture->members=size/MEMBERS_RATIO>MIN_MEMBERS ? size/MEMBERS_RATIO : MIN_MEMBERS;
+    for(int i=0;i<fixture->members;i++){
+        sprintf(fixture->name,"member%d",i);
+        emAddMember(fixture->em,fixture->name,i);
+    }
+    for(int i=0;i<size;i++){
+        sprintf(fixture->name,"event%d",i);
+        emAddEventByDiff(fixture->em,fixture->name,i%DAYS_SPREAD,i);
+        emAddMemberToEvent(fixture->em,i%fixture->members,i);
+    }
+    return fixture;
+}
+
+/**
+* fixture_destroy: frees a fixture.
+*
+* @param fixture - the fixture to free.
+*/
+static void fixture_destroy(Fixture fixture)
+{
+    if(fixture==NULL)
+    {
+        return;
+    }
+    pqDestroy(fixture->queue);
+    free(fixture->priorities);
+    destroyEventManager(fixture->em);
+    dateDestroy(fixture->start);
+    dateDestroy(fixture->date);
+    free(fixture);
+}
+
+/**
+* existing_id: picks a distinct id of the fixture for every iteration.
+*/
+static int existing_id(Fixture fixture,int iteration)
+{
+    return (int)(((long)iteration*ID_STRIDE)%fixture->size);
+}
+
+static void run_pq_insert(Fixture fixture,int iteration)
+{
+    int element=fixture->next_id+iteration;
+    int priority=(int)(next_random(&fixture->seed)%(unsigned int)fixture->size);
+    pqInsert(fixture->queue,&element,&priority);
+}
+
+static void prepare_take(Fixture fixture,int iteration)
+{
+    int element=fixture->next_id+iteration;
+    int priority=(int)(next_random(&fixture->seed)%(unsigned int)fixture->size);
+    fixture->take_element=copy_int(&element);
+    fixture->take_priority=copy_int(&priority);
+}
+
+static void run_pq_insert_take(Fixture fixture,int iteration)
+{
+    pqInsertTake(fixture->queue,fixture->take_element,fixture->take_priority);
+}
+
+static void run_pq_remove(Fixture fixture,int iteration)
+{
+    pqRemove(fixture->queue);
+}
+
+static void run_pq_change_priority(Fixture fixture,int iteration)
+{
+    int element=existing_id(fixture,iteration);
+    int priority=(int)(next_random(&fixture->seed)%(unsigned int)fixture->size);
+    pqChangePriority(fixture->queue,&element,&fixture->priorities[element],&priority);
+    fixture->priorities[element]=priority;
+}
+
+static void prepare_name(Fixture fixture,int iteration)
+{
+    sprintf(fixture->name,"new%d",iteration);
+}
+
+static void prepare_date(Fixture fixture,int iteration)
+{
+    prepare_name(fixture,iteration);
+    dateDestroy(fixture->date);
+    fixture->date=dateCopy(fixture->start);
+    int days=(int)(next_random(&fixture->seed)%DAYS_SPREAD);
+    for(int i=0;i<days;i++){
+        dateTick(fixture->date);
+    }
+}
+
+static void run_em_add_event_by_diff(Fixture fixture,int iteration)
+{
+    emAddEventByDiff(fixture->em,fixture->name,(int)(next_random(&fixture->seed)%DAYS_SPREAD),
+                     fixture->next_id+iteration);
+}
+
+static void run_em_add_event_by_date(Fixture fixture,int iteration)
+{
+    emAddEventByDate(fixture->em,fixture->name,fixture->date,fixture->next_id+iteration);
+}
+
+static void run_em_remove_event(Fixture fixture,int iteration)
+{
+    emRemoveEvent(fixture->em,existing_id(fixture,iteration));
+}
+
+static void run_em_change_event_date(Fixture fixture,int iteration)
+{
+    emChangeEventDate(fixture->em,existing_id(fixture,iteration),fixture->date);
+}
+
+static void run_em_add_member(Fixture fixture,int iteration)
+{
+    emAddMember(fixture->em,fixture->name,fixture->members+iteration);
+}
+
+static void run_em_add_member_to_event(Fixture fixture,int iteration)
+{
+    int event_id=existing_id(fixture,iteration);
+    emAddMemberToEvent(fixture->em,(event_id+1)%fixture->members,event_id);
+}
+
+static void run_em_remove_member_from_event(Fixture fixture,int iteration)
+{
+    int event_id=existing_id(fixture,iteration);
+    emRemoveMemberFromEvent(fixture->em,event_id%fixture->members,event_id);
+}
+
+static void run_em_tick(Fixture fixture,int iteration)
+{
+    emTick(fixture->em,1);
+}
+
+static void run_em_get_next_event(Fixture fixture,int iteration)
+{
+    emGetNextEvent(fixture->em);
+}
+
+static void run_em_count_events_before(Fixture fixture,int iteration)
+{
+    emCountEventsBefore(fixture->em,fixture->date);
+}
+
+static void run_em_print_all_events(Fixture fixture,int iteration)
+{
+    emPrintAllEvents(fixture->em,EXPORT_FILE);
+}
+
+static void run_em_print_all_responsible_members(Fixture fixture,int iteration)
+{
+    emPrintAllResponsibleMembers(fixture->em,EXPORT_FILE);
+}
+
+static void prepare_export_workers(Fixture fixture,int iteration)
+{
+    emSetExportWorkers(fixture->em,EXPORT_WORKERS);
+}
+
+static const Bench_case cases[]={
+        {"pq_insert",false,0,NULL,run_pq_insert},
+        {"pq_insert_take",false,0,prepare_take,run_pq_insert_take},
+        {"pq_remove",false,0,NULL,run_pq_remove},
+        {"pq_change_priority",false,0,NULL,run_pq_change_priority},
+        {"em_add_event_by_diff",true,0,prepare_name,run_em_add_event_by_diff},
+        {"em_add_event_by_date",true,0,prepare_date,run_em_add_event_by_date},
+        {"em_remove_event",true,0,NULL,run_em_remove_event},
+        {"em_change_event_date",true,0,prepare_date,run_em_change_event_date},
+        {"em_add_member",true,0,prepare_name,run_em_add_member},
+        {"em_add_member_to_event",true,0,NULL,run_em_add_member_to_event},
+        {"em_remove_member_from_event",true,0,NULL,run_em_remove_member_from_event},
+        {"em_tick",true,0,NULL,run_em_tick},
+        {"em_get_next_event",true,0,NULL,run_em_get_next_event},
+        {"em_count_events_before",true,0,prepare_date,run_em_count_events_before},
+        {"em_print_all_events",true,EXPORT_REPS,NULL,run_em_print_all_events},
+        {"em_print_all_responsible_members",true,EXPORT_REPS,NULL,run_em_print_all_responsible_members},
+        {"em_print_all_events_parallel",true,EXPORT_REPS,prepare_export_workers,run_em_print_all_events},
+        {"em_print_all_responsible_members_parallel",true,EXPORT_REPS,prepare_export_workers,
+         run_em_print_all_responsible_members},
+};
+
+static int compare_longs(const void* long1,const void* long2)
+{
+    long value1=*(const long*)long1;
+    long value2=*(const long*)long2;
+    return (value1>value2)-(value1<value2);
+}
+
+/**
+* run_case: builds a fixture and times the operations of a case on it.
+*
+* @param bench - the case to run.
+* @param size - the size of the fixture.
+* @param reps - the number of timed operations.
+* @param warmup - the number of untimed operations run first.
+* @param seed - the seed of the random generator.
+* @param result - receives the measurements.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool run_case(const Bench_case* bench,int size,int reps,int warmup,unsigned int seed,
+                     Bench_result* result)
+{
+    if(bench->max_reps>0&&reps>bench->max_reps)
+    {
+        reps=bench->max_reps;
+    }
+    if(reps+warmup>size)
+    {
+        reps=size/2>0 ? size/2 : 1;
+        warmup=0;
+    }
+    long* samples=malloc(sizeof(*samples)*reps);
+    if(samples==NULL)
+    {
+        return false;
+    }
+    long build_start=now_ns();
+    Fixture fixture=fixture_create(size,bench->is_em,seed);
+    result->build_seconds=(double)(now_ns()-build_start)/NS_IN_SECOND;
+    if(fixture==NULL)
+    {
+        free(samples);
+        return false;
+    }
+    for(int i=0;i<warmup+reps;i++){
+        if(bench->prepare!=NULL)
+        {
+            bench->prepare(fixture,i);
+        }
+        long start=now_ns();
+        bench->run(fixture,i);
+        long elapsed=now_ns()-start;
+        if(i>=warmup)
+        {
+            samples[i-warmup]=elapsed;
+        }
+    }
+    fixture_destroy(fixture);
+    qsort(samples,reps,sizeof(*samples),compare_longs);
+    long total=0;
+    for(int i=0;i<reps;i++){
+        total+=samples[i];
+    }
+    result->reps=reps;
+    result->median_ns=samples[reps/2];
+    result->p99_ns=samples[(reps-1)*P99/PERCENT];
+    result->mean_ns=total/reps;
+    result->min_ns=samples[0];
+    result->max_ns=samples[reps-1];
+    free(samples);
+    return true;
+}
+
+/**
+* print_result: writes one measurement in the chosen format.
+*
+* @param output - the stream to write to.
+* @param result - the measurement.
+* @param json - TRUE for a JSON object, FALSE for a CSV row.
+* @param first - TRUE if this is the first measurement written.
+*/
+static void print_result(FILE* output,Bench_result* result,bool json,bool first)
+{
+    if(!json)
+    {
+        fprintf(output,"%s,%d,%s,%d,%.6f,%ld,%ld,%ld,%ld,%ld\n",result->name,result->size,
+                result->skipped ? "skipped" : "ok",result->reps,result->build_seconds,
+                result->median_ns,result->p99_ns,result->mean_ns,result->min_ns,result->max_ns);
+        return;
+    }
+    fprintf(output,"%s\n  {\"case\": \"%s\", \"size\": %d, \"status\": \"%s\", \"reps\": %d, "
+                   "\"build_seconds\": %.6f, \"median_ns\": %ld, \"p99_ns\": %ld, \"mean_ns\": %ld, "
+                   "\"min_ns\": %ld, \"max_ns\": %ld}",first ? "" : ",",result->name,result->size,
+            result->skipped ? "skipped" : "ok",result->reps,result->build_seconds,
+            result->median_ns,result->p99_ns,result->mean_ns,result->min_ns,result->max_ns);
+}
+
+int main(int argc, char** argv)
+{
+    int sizes[MAX_SIZES]={1000,10000,100000,1000000};
+    int sizes_num=4;
+    bool custom_sizes=false;
+    int reps=DEFAULT_REPS;
+    int warmup=DEFAULT_WARMUP;
+    double budget=DEFAULT_BUDGET;
+    unsigned int seed=DEFAULT_SEED;
+    bool json=false;
+    FILE* output=stdout;
+    for(int i=1;i+1<argc;i+=2){
+        if(strcmp(argv[i],"-f")==0){
+            json=strcmp(argv[i+1],"json")==0;
+        }
+        else if(strcmp(argv[i],"-o")==0){
+            output=fopen(argv[i+1],"w");
+            if(output==NULL)
+            {
+                fprintf(stderr,"cannot open %s\n",argv[i+1]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i],"-r")==0){
+            reps=atoi(argv[i+1])>0 ? atoi(argv[i+1]) : DEFAULT_REPS;
+        }
+        else if(strcmp(argv[i],"-w")==0){
+            warmup=atoi(argv[i+1])>=0 ? atoi(argv[i+1]) : DEFAULT_WARMUP;
+        }
+        else if(strcmp(argv[i],"-b")==0){
+            budget=atof(argv[i+1]);
+        }
+        else if(strcmp(argv[i],"-s")==0){
+            seed=(unsigned int)strtoul(argv[i+1],NULL,10);
+            seed=seed!=0 ? seed : DEFAULT_SEED;
+        }
+        else if(strcmp(argv[i],"-n")==0&&atoi(argv[i+1])>0){
+            if(!custom_sizes)
+            {
+                sizes_num=0;
+                custom_sizes=true;
+            }
+            if(sizes_num<MAX_SIZES)
+            {
+                sizes[sizes_num++]=atoi(argv[i+1]);
+            }
+        }
+        else{
+            fprintf(stderr,"unknown option %s\n",argv[i]);
+            return 1;
+        }
+    }
+    if(json)
+    {
+        fprintf(output,"[");
+    }
+    else
+    {
+        fprintf(output,"case,size,status,reps,build_seconds,median_ns,p99_ns,mean_ns,min_ns,max_ns\n");
+    }
+    bool first=true;
+    for(unsigned int c=0;c<sizeof(cases)/sizeof(cases[0]);c++){
+        double previous_build=0;
+        int previous_size=0;
+        bool skip=false;
+        for(int s=0;s<sizes_num;s++){
+            Bench_result result;
+            memset(&result,0,sizeof(result));
+            result.name=cases[c].name;
+            result.size=sizes[s];
+            if(!skip&&previous_size>0)
+            {
+                double ratio=(double)sizes[s]/previous_size;
+                skip=previous_build*ratio*ratio>budget;
+            }
+            if(skip||!run_case(&cases[c],sizes[s],reps,warmup,seed,&result))
+            {
+                result.skipped=true;
+                skip=true;
+            }
+            previous_build=result.build_seconds;
+            previous_size=sizes[s];
+            print_result(output,&result,json,first);
+            fflush(output);
+            first=false;
+        }
+    }
+    if(json)
+    {
+        fprintf(output,"\n]\n");
+    }
+    if(output!=stdout)
+    {
+        fclose(output);
+    }
+    remove(EXPORT_FILE);
+    return 0;
+}
@@ -0,0 +1,655 @@
+#define _POSIX_C_SOURCE 199309L
+#include "event_manager.h"
+#include "date.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#define NS_IN_SECOND 1000000000L
+#define NAME_LEN 32
+#define TRACE_MAGIC "EMTR"
+#define TRACE_MAGIC_LEN 4
+#define TRACE_VERSION 1
+#define VARINT_BITS 7
+#define VARINT_MASK 0x7F
+#define VARINT_MORE 0x80
+#define DEFAULT_SEED 12345u
+#define DEFAULT_EVENTS 1000
+#define DEFAULT_MEMBERS 100
+#define DEFAULT_OPS 10000
+#define DEFAULT_FANOUT 3
+#define DEFAULT_SPREAD 365
+#define DEFAULT_TICK_DAYS 1
+#define START_DAY 1
+#define START_MONTH 1
+#define START_YEAR 2020
+#define PERCENT 100
+#define P99 99
+
+/**
+* em_trace: generates synthetic EventManager workloads and replays them.
+*
+* usage: em_trace generate <trace> [-s seed] [-e events] [-m members] [-n ops]
+*                                  [-l fanout] [-d spread_days]
+*                                  [-x add=30,member=2,link=30,unlink=10,date=10,remove=5,tick=3,next=10]
+*        em_trace replay <trace> [-f csv|json]
+*
+* A generated trace first adds the members, then the events with fanout
+* links each, and then runs ops operations drawn from the mix weights.
+*
+* Trace format: the magic "EMTR", a version byte, and then unsigned LEB128
+* varints: seed, start day, start month, start year, number of operations.
+* Every operation is a type byte followed by its varint arguments:
+*   OP_ADD_EVENT     event_id days   (days from the current date)
+*   OP_ADD_MEMBER    member_id
+*   OP_LINK          member_id event_id
+*   OP_UNLINK        member_id event_id
+*   OP_CHANGE_DATE   event_id days   (days from the current date)
+*   OP_REMOVE_EVENT  event_id
+*   OP_TICK          days
+*   OP_NEXT_EVENT
+* Names are not stored, the replay names event i "event<i>" and member i "member<i>".
+*/
+
+typedef enum op_type
+{
+    OP_ADD_EVENT,
+    OP_ADD_MEMBER,
+    OP_LINK,
+    OP_UNLINK,
+    OP_CHANGE_DATE,
+    OP_REMOVE_EVENT,
+    OP_TICK,
+    OP_NEXT_EVENT,
+    OPS_NUM
+}Op_type;
+
+static const char* const op_names[OPS_NUM]={"add","member","link","unlink","date","remove","tick","next"};
+static const int op_args[OPS_NUM]={2,1,2,2,2,1,1,0};
+
+typedef struct generated_event
+{
+    int day;
+    bool alive;
+}Generated_event;
+
+typedef struct generated_link
+{
+    int member_id;
+    int event_id;
+}Generated_link;
+
+typedef struct generator
+{
+    unsigned int seed;
+    int spread;
+    int day;
+    Generated_event* events;
+    int events_num;
+    int events_capacity;
+    Generated_link* links;
+    int links_num;
+    int links_capacity;
+    int members_num;
+    long ops_written;
+    FILE* file;
+}*Generator;
+
+typedef struct op_stats
+{
+    long* samples;
+    long count;
+    long errors;
+    long total_ns;
+}Op_stats;
+
+/**
+* now_ns: returns the monotonic time in nanoseconds.
+*/
+static long now_ns(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC,&time);
+    return time.tv_sec*NS_IN_SECOND+time.tv_nsec;
+}
+
+/**
+* next_random: returns a random number below bound from a xorshift generator.
+*
+* @param seed - the state of the generator.
+* @param bound - the exclusive upper bound, must be positive.
+* @return
+* the next random number.
+*/
+static int next_random(unsigned int* seed,int bound)
+{
+    *seed^=*seed<<13;
+    *seed^=*seed>>17;
+    *seed^=*seed<<5;
+    return (int)(*seed%(unsigned int)bound);
+}
+
+/**
+* write_varint: writes an unsigned LEB128 varint.
+*/
+static void write_varint(FILE* file,unsigned long value)
+{
+    while(value>VARINT_MASK){
+        fputc((int)((value&VARINT_MASK)|VARINT_MORE),file);
+        value>>=VARINT_BITS;
+    }
+    fputc((int)value,file);
+}
+
+/**
+* read_varint: reads an unsigned LEB128 varint.
+*
+* @return
+* FALSE - if the file ended.
+* otherwise TRUE.
+*/
+static bool read_varint(FILE* file,unsigned long* value)
+{
+    *value=0;
+    for(int shift=0;;shift+=VARINT_BITS){
+        int byte=fgetc(file);
+        if(byte==EOF)
+        {
+            return false;
+        }
+        *value|=(unsigned long)(byte&VARINT_MASK)<<shift;
+        if(!(byte&VARINT_MORE))
+        {
+            return true;
+        }
+    }
+}
+
+/**
+* write_op: writes an operation with its arguments to the trace.
+*/
+static void write_op(Generator generator,Op_type type,int arg1,int arg2)
+{
+    fputc(type,generator->file);
+    if(op_args[type]>0)
+    {
+        write_varint(generator->file,(unsigned long)arg1);
+    }
+    if(op_args[type]>1)
+    {
+        write_varint(generator->file,(unsigned long)arg2);
+    }
+    generator->ops_written++;
+}
+
+/**
+* grow: doubles an array if it is full.
+*
+* @return
+* NULL - if allocation fails, the array is left unchanged.
+* otherwise the array, which may have moved.
+*/
+static void* grow(void* array,int* capacity,int size,size_t element_size)
+{
+    if(size<*capacity)
+    {
+        return array;
+    }
+    int new_capacity=*capacity>0 ? *capacity*2 : DEFAULT_EVENTS;
+    void* new_array=realloc(array,element_size*new_capacity);
+    if(new_array!=NULL)
+    {
+        *capacity=new_capacity;
+    }
+    return new_array;
+}
+
+/**
+* pick_event: picks a live event, expired events are marked on the way.
+*
+* @return
+* -1 - if no live event was found.
+* otherwise the id of the event.
+*/
+static int pick_event(Generator generator)
+{
+    for(int attempt=0;attempt<generator->events_num&&generator->events_num>0;attempt++){
+        int event_id=next_random(&generator->seed,generator->events_num);
+        Generated_event* event=&generator->events[event_id];
+        if(event->alive&&event->day<generator->day)
+        {
+            event->alive=false;
+        }
+        if(event->alive)
+        {
+            return event_id;
+        }
+    }
+    return -1;
+}
+
+static bool generate_add_event(Generator generator)
+{
+    Generated_event* events=grow(generator->events,&generator->events_capacity,generator->events_num,
+                                 sizeof(*events));
+    if(events==NULL)
+    {
+        return false;
+    }
+    generator->events=events;
+    int days=next_random(&generator->seed,generator->spread);
+    generator->events[generator->events_num].day=generator->day+days;
+    generator->events[generator->events_num].alive=true;
+    write_op(generator,OP_ADD_EVENT,generator->events_num,days);
+    generator->events_num++;
+    return true;
+}
+
+static bool generate_link(Generator generator)
+{
+    int event_id=pick_event(generator);
+    if(event_id<0||generator->members_num==0)
+    {
+        return true;
+    }
+    Generated_link* links=grow(generator->links,&generator->links_capacity,generator->links_num,
+                               sizeof(*links));
+    if(links==NULL)
+    {
+        return false;
+    }
+    generator->links=links;
+    int member_id=next_random(&generator->seed,generator->members_num);
+    generator->links[generator->links_num].member_id=member_id;
+    generator->links[generator->links_num].event_id=event_id;
+    generator->links_num++;
+    write_op(generator,OP_LINK,member_id,event_id);
+    return true;
+}
+
+static void generate_unlink(Generator generator)
+{
+    if(generator->links_num==0)
+    {
+        return;
+    }
+    int link=next_random(&generator->seed,generator->links_num);
+    write_op(generator,OP_UNLINK,generator->links[link].member_id,generator->links[link].event_id);
+    generator->links_num--;
+    generator->links[link]=generator->links[generator->links_num];
+}
+
+static void generate_change_date(Generator generator)
+{
+    int event_id=pick_event(generator);
+    if(event_id<0)
+    {
+        return;
+    }
+    int days=next_random(&generator->seed,generator->spread);
+    generator->events[event_id].day=generator->day+days;
+    write_op(generator,OP_CHANGE_DATE,event_id,days);
+}
+
+static void generate_remove_event(Generator generator)
+{
+    int event_id=pick_event(generator);
+    if(event_id<0)
+    {
+        return;
+    }
+    generator->events[event_id].alive=false;
+    write_op(generator,OP_REMOVE_EVENT,event_id,0);
+}
+
+/**
+* generate: writes a synthetic trace.
+*
+* @return
+* 0 on success, 1 otherwise.
+*/
+static int generate(const char* path,unsigned int seed,int events,int members,long ops,int fanout,
+                    int spread,const int* mix)
+{
+    struct generator generator;
+    memset(&generator,0,sizeof(generator));
+    generator.seed=seed;
+    generator.spread=spread;
+    generator.file=fopen(path,"wb");
+    if(generator.file==NULL)
+    {
+        fprintf(stderr,"cannot open %s\n",path);
+        return 1;
+    }
+    long total_ops=members+(long)events*(1+fanout)+ops;
+    fwrite(TRACE_MAGIC,1,TRACE_MAGIC_LEN,generator.file);
+    fputc(TRACE_VERSION,generator.file);
+    write_varint(generator.file,seed);
+    write_varint(generator.file,START_DAY);
+    write_varint(generator.file,START_MONTH);
+    write_varint(generator.file,START_YEAR);
+    write_varint(generator.file,(unsigned long)total_ops);
+    bool success=true;
+    for(int i=0;i<members;i++){
+        write_op(&generator,OP_ADD_MEMBER,generator.members_num++,0);
+    }
+    for(int i=0;i<events&&success;i++){
+        success=generate_add_event(&generator);
+        for(int j=0;j<fanout&&success;j++){
+            success=generate_link(&generator);
+        }
+    }
+    int mix_total=0;
+    for(int i=0;i<OPS_NUM;i++){
+        mix_total+=mix[i];
+    }
+    while(success&&generator.ops_written<total_ops){
+        int draw=next_random(&generator.seed,mix_total);
+        Op_type type=OP_ADD_EVENT;
+        while(draw>=mix[type]){
+            draw-=mix[type];
+            type++;
+        }
+        long before=generator.ops_written;
+        switch(type){
+            case OP_ADD_EVENT:
+                success=generate_add_event(&generator);
+                break;
+            case OP_ADD_MEMBER:
+                write_op(&generator,OP_ADD_MEMBER,generator.members_num++,0);
+                break;
+            case OP_LINK:
+                success=generate_link(&generator);
+                break;
+            case OP_UNLINK:
+                generate_unlink(&generator);
+                break;
+            case OP_CHANGE_DATE:
+                generate_change_date(&generator);
+                break;
+            case OP_REMOVE_EVENT:
+                generate_remove_event(&generator);
+                break;
+            case OP_TICK:
+                generator.day+=DEFAULT_TICK_DAYS;
+                write_op(&generator,OP_TICK,DEFAULT_TICK_DAYS,0);
+                break;
+            default:
+                write_op(&generator,OP_NEXT_EVENT,0,0);
+                break;
+        }
+        if(generator.ops_written==before)
+        {
+            write_op(&generator,OP_NEXT_EVENT,0,0);
+        }
+    }
+    fclose(generator.file);
+    free(generator.events);
+    free(generator.links);
+    if(!success)
+    {
+        fprintf(stderr,"out of memory\n");
+        return 1;
+    }
+    return 0;
+}
+
+/**
+* date_after: returns a copy of a date moved forward by a number of days.
+*/
+static Date date_after(Date date,int days)
+{
+    Date result=dateCopy(date);
+    for(int i=0;i<days;i++){
+        dateTick(result);
+    }
+    return result;
+}
+
+static int compare_longs(const void* long1,const void* long2)
+{
+    long value1=*(const long*)long1;
+    long value2=*(const long*)long2;
+    return (value1>value2)-(value1<value2);
+}
+
+/**
+* replay: runs a trace against the em* API and reports per operation latency.
+*
+* @return
+* 0 on success, 1 otherwise.
+*/
+static int replay(const char* path,bool json)
+{
+    FILE* file=fopen(path,"rb");
+    if(file==NULL)
+    {
+        fprintf(stderr,"cannot open %s\n",path);
+        return 1;
+    }
+    char magic[TRACE_MAGIC_LEN];
+    unsigned long seed=0;
+    unsigned long day=0;
+    unsigned long month=0;
+    unsigned long year=0;
+    unsigned long ops=0;
+    if(fread(magic,1,TRACE_MAGIC_LEN,file)!=TRACE_MAGIC_LEN||memcmp(magic,TRACE_MAGIC,TRACE_MAGIC_LEN)!=0
+       ||fgetc(file)!=TRACE_VERSION||!read_varint(file,&seed)||!read_varint(file,&day)
+       ||!read_varint(file,&month)||!read_varint(file,&year)||!read_varint(file,&ops))
+    {
+        fprintf(stderr,"%s is not a trace\n",path);
+        fclose(file);
+        return 1;
+    }
+    Op_stats stats[OPS_NUM];
+    memset(stats,0,sizeof(stats));
+    for(int i=0;i<OPS_NUM;i++){
+        stats[i].samples=malloc(sizeof(long)*(ops>0 ? ops : 1));
+        if(stats[i].samples==NULL)
+        {
+            fprintf(stderr,"out of memory\n");
+            return 1;
+        }
+    }
+    Date now=dateCreate((int)day,(int)month,(int)year);
+    EventManager em=createEventManager(now);
+    char name[NAME_LEN];
+    long replay_start=now_ns();
+    for(unsigned long i=0;i<ops;i++){
+        int type=fgetc(file);
+        unsigned long args[2]={0,0};
+        if(type==EOF||type>=OPS_NUM)
+        {
+            fprintf(stderr,"trace ended after %lu of %lu operations\n",i,ops);
+            break;
+        }
+        for(int j=0;j<op_args[type];j++){
+            read_varint(file,&args[j]);
+        }
+        Date date=NULL;
+        if(type==OP_ADD_EVENT||type==OP_ADD_MEMBER)
+        {
+            sprintf(name,type==OP_ADD_EVENT ? "event%lu" : "member%lu",args[0]);
+        }
+        if(type==OP_CHANGE_DATE)
+        {
+            date=date_after(now,(int)args[1]);
+        }
+        EventManagerResult result=EM_SUCCESS;
+        long start=now_ns();
+        switch(type){
+            case OP_ADD_EVENT:
+                result=emAddEventByDiff(em,name,(int)args[1],(int)args[0]);
+                break;
+            case OP_ADD_MEMBER:
+                result=emAddMember(em,name,(int)args[0]);
+                break;
+            case OP_LINK:
+                result=emAddMemberToEvent(em,(int)args[0],(int)args[1]);
+                break;
+            case OP_UNLINK:
+                result=emRemoveMemberFromEvent(em,(int)args[0],(int)args[1]);
+                break;
+            case OP_CHANGE_DATE:
+                result=emChangeEventDate(em,(int)args[0],date);
+                break;
+            case OP_REMOVE_EVENT:
+                result=emRemoveEvent(em,(int)args[0]);
+                break;
+            case OP_TICK:
+                result=emTick(em,(int)args[0]);
+                break;
+            default:
+                emGetNextEvent(em);
+                break;
+        }
+        long elapsed=now_ns()-start;
+        Op_stats* op=&stats[type];
+        op->samples[op->count++]=elapsed;
+        op->total_ns+=elapsed;
+        if(result!=EM_SUCCESS)
+        {
+            op->errors++;
+        }
+        if(type==OP_TICK)
+        {
+            for(unsigned long j=0;j<args[0];j++){
+                dateTick(now);
+            }
+        }
+        dateDestroy(date);
+    }
+    long replay_ns=now_ns()-replay_start;
+    fclose(file);
+    destroyEventManager(em);
+    dateDestroy(now);
+    if(json)
+    {
+        printf("{\"trace\": \"%s\", \"seed\": %lu, \"ops\": %lu, \"seconds\": %.6f, \"per_op\": [",
+               path,seed,ops,(double)replay_ns/NS_IN_SECOND);
+    }
+    else
+    {
+        printf("op,count,errors,total_seconds,ops_per_second,median_ns,p99_ns,max_ns\n");
+    }
+    bool first=true;
+    for(int i=0;i<OPS_NUM;i++){
+        Op_stats* op=&stats[i];
+        if(op->count==0)
+        {
+            free(op->samples);
+            continue;
+        }
+        qsort(op->samples,op->count,sizeof(long),compare_longs);
+        double seconds=(double)op->total_ns/NS_IN_SECOND;
+        double throughput=op->total_ns>0 ? op->count/seconds : 0;
+        long median=op->samples[op->count/2];
+        long p99=op->samples[(op->count-1)*P99/PERCENT];
+        long max=op->samples[op->count-1];
+        if(json)
+        {
+            printf("%s\n  {\"op\": \"%s\", \"count\": %ld, \"errors\": %ld, \"total_seconds\": %.6f, "
+                   "\"ops_per_second\": %.1f, \"median_ns\": %ld, \"p99_ns\": %ld, \"max_ns\": %ld}",
+                   first ? "" : ",",op_names[i],op->count,op->errors,seconds,throughput,median,p99,max);
+        }
+        else
+        {
+            printf("%s,%ld,%ld,%.6f,%.1f,%ld,%ld,%ld\n",op_names[i],op->count,op->errors,seconds,
+                   throughput,median,p99,max);
+        }
+        first=false;
+        free(op->samples);
+    }
+    if(json)
+    {
+        printf("\n]}\n");
+    }
+    return 0;
+}
+
+/**
+* parse_mix: parses "name=weight,..." into the operation weights.
+*
+* @return
+* FALSE - if the mix is malformed or all the weights are 0.
+* otherwise TRUE.
+*/
+static bool parse_mix(char* text,int* mix)
+{
+    memset(mix,0,sizeof(int)*OPS_NUM);
+    int total=0;
+    for(char* token=strtok(text,",");token!=NULL;token=strtok(NULL,",")){
+        char* equal=strchr(token,'=');
+        if(equal==NULL)
+        {
+            return false;
+        }
+        *equal='\0';
+        int op=0;
+        while(op<OPS_NUM&&strcmp(op_names[op],token)!=0){
+            op++;
+        }
+        if(op==OPS_NUM||atoi(equal+1)<0)
+        {
+            return false;
+        }
+        mix[op]=atoi(equal+1);
+        total+=mix[op];
+    }
+    return total>0;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc<3)
+    {
+        fprintf(stderr,"usage: %s generate|replay <trace> [options]\n",argv[0]);
+        return 1;
+    }
+    if(strcmp(argv[1],"replay")==0)
+    {
+        bool json=argc>=5&&strcmp(argv[3],"-f")==0&&strcmp(argv[4],"json")==0;
+        return replay(argv[2],json);
+    }
+    if(strcmp(argv[1],"generate")!=0)
+    {
+        fprintf(stderr,"unknown command %s\n",argv[1]);
+        return 1;
+    }
+    unsigned int seed=DEFAULT_SEED;
+    int events=DEFAULT_EVENTS;
+    int members=DEFAULT_MEMBERS;
+    long ops=DEFAULT_OPS;
+    int fanout=DEFAULT_FANOUT;
+    int spread=DEFAULT_SPREAD;
+    int mix[OPS_NUM]={30,2,30,10,10,5,3,10};
+    for(int i=3;i+1<argc;i+=2){
+        if(strcmp(argv[i],"-s")==0&&strtoul(argv[i+1],NULL,10)>0){
+            seed=(unsigned int)strtoul(argv[i+1],NULL,10);
+        }
+        else if(strcmp(argv[i],"-e")==0&&atoi(argv[i+1])>=0){
+            events=atoi(argv[i+1]);
+        }
+        else if(strcmp(argv[i],"-m")==0&&atoi(argv[i+1])>=0){
+            members=atoi(argv[i+1]);
+        }
+        else if(strcmp(argv[i],"-n")==0&&atol(argv[i+1])>=0){
+            ops=atol(argv[i+1]);
+        }
+        else if(strcmp(argv[i],"-l")==0&&atoi(argv[i+1])>=0){
+            fanout=atoi(argv[i+1]);
+        }
+        else if(strcmp(argv[i],"-d")==0&&atoi(argv[i+1])>0){
+            spread=atoi(argv[i+1]);
+        }
+        else if(strcmp(argv[i],"-x")==0&&parse_mix(argv[i+1],mix)){
+            continue;
+        }
+        else{
+            fprintf(stderr,"bad option %s %s\n",argv[i],argv[i+1]);
+            return 1;
+        }
+    }
+    return generate(argv[2],seed,events,members,ops,fanout,spread,mix);
+}
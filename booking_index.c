@@ -0,0 +1,225 @@
+#include "booking_index.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#define INITIAL_ENTRIES 64
+#define EXPAND_FACTOR 2
+#define MAX_LOAD_PERCENT 50
+#define PERCENT 100
+
+/**
+* Booking: the number of events of a member on a date. An entry whose count
+* is 0 is empty.
+*/
+typedef struct booking{
+    int member_id;
+    int date_key;
+    int count;
+}Booking;
+
+struct BookingIndex_t{
+    Booking* entries;
+    int entries_num;
+    int size;
+    Allocator allocator;
+};
+
+/**
+* hash_booking: maps a member and a date to their home entry.
+*
+* @param entries_num - the number of entries, a power of 2.
+* @param member_id - the id of the member.
+* @param date_key - the packed date.
+* @return
+* the home entry of the pair.
+*/
+static int hash_booking(int entries_num,int member_id,int date_key)
+{
+    unsigned int hash=(unsigned int)member_id*2654435761u;
+    hash^=(unsigned int)date_key*2246822519u;
+    hash^=hash>>15;
+    return (int)(hash&(unsigned int)(entries_num-1));
+}
+
+/**
+* find_booking: looks for the entry of a member and a date, or the empty
+* entry where it would be put.
+*
+* @param entries - the entries to search in.
+* @param entries_num - the number of entries, a power of 2.
+* @param member_id - the id of the member.
+* @param date_key - the packed date.
+* @return
+* the entry of the pair, or the first empty entry on its probe sequence.
+*/
+static Booking* find_booking(Booking* entries,int entries_num,int member_id,int date_key)
+{
+    int position=hash_booking(entries_num,member_id,date_key);
+    while(entries[position].count>0&&
+          (entries[position].member_id!=member_id||entries[position].date_key!=date_key)){
+        position=(position+1)&(entries_num-1);
+    }
+    return &entries[position];
+}
+
+/**
+* expand_entries: doubles the number of entries and rehashes all the bookings.
+*
+* @param index - the index to expand.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool expand_entries(BookingIndex index)
+{
+    int entries_num=index->entries_num*EXPAND_FACTOR;
+    Booking* entries=allocatorAlloc(&index->allocator,sizeof(*entries)*entries_num);
+    if(entries==NULL)
+    {
+        return false;
+    }
+    memset(entries,0,sizeof(*entries)*entries_num);
+    for(int i=0;i<index->entries_num;i++){
+        Booking* booking=&index->entries[i];
+        if(booking->count>0)
+        {
+            *find_booking(entries,entries_num,booking->member_id,booking->date_key)=*booking;
+        }
+    }
+    allocatorFree(&index->allocator,index->entries);
+    index->entries=entries;
+    index->entries_num=entries_num;
+    return true;
+}
+
+/**
+* remove_entry: empties an entry and moves the bookings that follow it on
+* their probe sequences back, so no probe sequence has a hole.
+*
+* @param index - the index to remove from.
+* @param position - the entry to empty.
+*/
+static void remove_entry(BookingIndex index,int position)
+{
+    int mask=index->entries_num-1;
+    int next=(position+1)&mask;
+    while(index->entries[next].count>0){
+        Booking* booking=&index->entries[next];
+        int home=hash_booking(index->entries_num,booking->member_id,booking->date_key);
+        if(((next-home)&mask)>=((next-position)&mask))
+        {
+            index->entries[position]=*booking;
+            position=next;
+        }
+        next=(next+1)&mask;
+    }
+    index->entries[position].count=0;
+    index->size--;
+}
+
+BookingIndex bookingIndexCreate(void)
+{
+    return bookingIndexCreateWithAllocator(NULL);
+}
+
+BookingIndex bookingIndexCreateWithAllocator(const Allocator* allocator)
+{
+    BookingIndex index=allocatorAlloc(allocator,sizeof(*index));
+    if(index==NULL)
+    {
+        return NULL;
+    }
+    if(allocator!=NULL)
+    {
+        index->allocator=*allocator;
+    }
+    else
+    {
+        memset(&index->allocator,0,sizeof(index->allocator));
+    }
+    index->entries=allocatorAlloc(allocator,sizeof(*index->entries)*INITIAL_ENTRIES);
+    if(index->entries==NULL)
+    {
+        allocatorFree(allocator,index);
+        return NULL;
+    }
+    memset(index->entries,0,sizeof(*index->entries)*INITIAL_ENTRIES);
+    index->entries_num=INITIAL_ENTRIES;
+    index->size=0;
+    return index;
+}
+
+void bookingIndexDestroy(BookingIndex index)
+{
+    if(index==NULL)
+    {
+        return;
+    }
+    allocatorFree(&index->allocator,index->entries);
+    Allocator allocator=index->allocator;
+    allocatorFree(&allocator,index);
+}
+
+int bookingIndexGetCount(BookingIndex index, int member_id, int date_key)
+{
+    if(index==NULL)
+    {
+        return -1;
+    }
+    return find_booking(index->entries,index->entries_num,member_id,date_key)->count;
+}
+
+BookingIndexResult bookingIndexAdd(BookingIndex index, int member_id, int date_key)
+{
+    if(index==NULL)
+    {
+        return BI_NULL_ARGUMENT;
+    }
+    Booking* booking=find_booking(index->entries,index->entries_num,member_id,date_key);
+    if(booking->count>0)
+    {
+        booking->count++;
+        return BI_SUCCESS;
+    }
+    if((index->size+1)*PERCENT>index->entries_num*MAX_LOAD_PERCENT)
+    {
+        if(!expand_entries(index))
+        {
+            return BI_OUT_OF_MEMORY;
+        }
+        booking=find_booking(index->entries,index->entries_num,member_id,date_key);
+    }
+    booking->member_id=member_id;
+    booking->date_key=date_key;
+    booking->count=1;
+    index->size++;
+    return BI_SUCCESS;
+}
+
+BookingIndexResult bookingIndexRemove(BookingIndex index, int member_id, int date_key)
+{
+    if(index==NULL)
+    {
+        return BI_NULL_ARGUMENT;
+    }
+    Booking* booking=find_booking(index->entries,index->entries_num,member_id,date_key);
+    if(booking->count==0)
+    {
+        return BI_NOT_BOOKED;
+    }
+    booking->count--;
+    if(booking->count==0)
+    {
+        remove_entry(index,(int)(booking-index->entries));
+    }
+    return BI_SUCCESS;
+}
+
+long bookingIndexGetMemoryUsage(BookingIndex index)
+{
+    if(index==NULL)
+    {
+        return 0;
+    }
+    return (long)(sizeof(*index)+sizeof(*index->entries)*index->entries_num);
+}
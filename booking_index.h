@@ -0,0 +1,113 @@
+#ifndef BOOKING_INDEX_H_
+#define BOOKING_INDEX_H_
+
+#include <stdbool.h>
+#include "allocator.h"
+
+/**
+* Booking Index
+*
+* Counts the events every member is linked to on every date. The counts are
+* kept in an open addressing hash table keyed on the member id and the packed
+* date, so a count is read and updated in O(1) on average. Pairs whose count
+* drops to 0 are removed from the table. The index may be allocated through an
+* Allocator.
+*
+* The following functions are available:
+*   bookingIndexCreate      - Creates a new empty index.
+*   bookingIndexCreateWithAllocator - Creates a new empty index whose memory is allocated by an allocator.
+*   bookingIndexDestroy     - Deletes an existing index and frees all its resources.
+*   bookingIndexGetCount    - Returns the number of events of a member on a date.
+*   bookingIndexAdd         - Counts one more event of a member on a date.
+*   bookingIndexRemove      - Counts one less event of a member on a date.
+*   bookingIndexGetMemoryUsage - Returns the number of bytes the index takes.
+*/
+
+/** Type for defining the index */
+typedef struct BookingIndex_t *BookingIndex;
+
+/** Type used for returning error codes from index functions */
+typedef enum BookingIndexResult_t {
+    BI_SUCCESS,
+    BI_OUT_OF_MEMORY,
+    BI_NULL_ARGUMENT,
+    BI_NOT_BOOKED
+} BookingIndexResult;
+
+/**
+* bookingIndexCreate: Allocates a new empty index.
+*
+* @return
+*   NULL - if allocation failed.
+*   A new index in case of success.
+*/
+BookingIndex bookingIndexCreate(void);
+
+/**
+* bookingIndexCreateWithAllocator: Allocates a new empty index whose structure
+* and table are allocated and freed through allocator.
+*
+* @param allocator - The allocator, copied into the index. NULL for malloc.
+* @return
+*   NULL - if allocation failed.
+*   A new index in case of success.
+*/
+BookingIndex bookingIndexCreateWithAllocator(const Allocator* allocator);
+
+/**
+* bookingIndexDestroy: Deallocates an existing index.
+*
+* @param index - Target index to be deallocated. If index is NULL nothing will be done.
+*/
+void bookingIndexDestroy(BookingIndex index);
+
+/**
+* bookingIndexGetCount: Returns the number of events a member is linked to on a date.
+*
+* @param index - The index to query.
+* @param member_id - The id of the member.
+* @param date_key - The packed date.
+* @return
+*   -1 if a NULL was sent as index.
+*   Otherwise the number of events.
+*/
+int bookingIndexGetCount(BookingIndex index, int member_id, int date_key);
+
+/**
+* bookingIndexAdd: Counts one more event of a member on a date.
+*
+* @param index - The index to update.
+* @param member_id - The id of the member.
+* @param date_key - The packed date of the event.
+* @return
+*   BI_NULL_ARGUMENT if a NULL was sent as index.
+*   BI_OUT_OF_MEMORY if an allocation failed, the index is unchanged.
+*   BI_SUCCESS otherwise.
+*/
+BookingIndexResult bookingIndexAdd(BookingIndex index, int member_id, int date_key);
+
+/**
+* bookingIndexRemove: Counts one less event of a member on a date.
+*
+* @param index - The index to update.
+* @param member_id - The id of the member.
+* @param date_key - The packed date of the event.
+* @return
+*   BI_NULL_ARGUMENT if a NULL was sent as index.
+*   BI_NOT_BOOKED if the member has no event on the date.
+*   BI_SUCCESS otherwise.
+*/
+BookingIndexResult bookingIndexRemove(BookingIndex index, int member_id, int date_key);
+
+/**
+* bookingIndexGetMemoryUsage: Returns the number of bytes allocated for an
+* index and its hash table. Runs in O(1).
+*
+* @param index - The index to measure.
+* @return
+*   0 if a NULL pointer was sent.
+*   Otherwise the number of bytes.
+*/
+long bookingIndexGetMemoryUsage(BookingIndex index);
+
+#endif /* BOOKING_INDEX_H_ */
@@ -0,0 +1,239 @@
+#include "change_log.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#define INITIAL_CAPACITY 64
+#define EXPAND_FACTOR 2
+
+typedef struct change{
+    long version;
+    int event_id;
+}Change;
+
+struct ChangeLog_t{
+    Change* changes;
+    int size;
+    int capacity;
+    long version;
+    long complete_from;
+    Allocator allocator;
+};
+
+/**
+* compare_by_event: orders changes by event id and then by version.
+*/
+static int compare_by_event(const void* first,const void* second)
+{
+    const Change* change1=first;
+    const Change* change2=second;
+    if(change1->event_id!=change2->event_id)
+    {
+        return change1->event_id<change2->event_id ? -1 : 1;
+    }
+    return (change1->version>change2->version)-(change1->version<change2->version);
+}
+
+/**
+* compare_by_version: orders changes by version.
+*/
+static int compare_by_version(const void* first,const void* second)
+{
+    const Change* change1=first;
+    const Change* change2=second;
+    return (change1->version>change2->version)-(change1->version<change2->version);
+}
+
+/**
+* compare_ids: orders event ids.
+*/
+static int compare_ids(const void* first,const void* second)
+{
+    int id1=*(const int*)first;
+    int id2=*(const int*)second;
+    return (id1>id2)-(id1<id2);
+}
+
+/**
+* compact: drops every change that is followed by a later change of the same
+* event, keeping the log ordered by version.
+*
+* @param log - the log to compact.
+*/
+static void compact(ChangeLog log)
+{
+    if(log->size<2)
+    {
+        return;
+    }
+    qsort(log->changes,log->size,sizeof(*log->changes),compare_by_event);
+    int kept=0;
+    for(int i=0;i<log->size;i++){
+        if(i+1==log->size||log->changes[i+1].event_id!=log->changes[i].event_id)
+        {
+            log->changes[kept++]=log->changes[i];
+        }
+    }
+    log->size=kept;
+    qsort(log->changes,log->size,sizeof(*log->changes),compare_by_version);
+}
+
+/**
+* make_room: makes room for one more change. A full log is compacted first,
+* and grows only if compacting freed less than half of it, so every change is
+* moved O(log n) times on average.
+*
+* @param log - the log to make room in.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool make_room(ChangeLog log)
+{
+    if(log->size<log->capacity)
+    {
+        return true;
+    }
+    compact(log);
+    if(log->size<=log->capacity/EXPAND_FACTOR&&log->capacity>0)
+    {
+        return true;
+    }
+    int capacity= log->capacity==0 ? INITIAL_CAPACITY : log->capacity*EXPAND_FACTOR;
+    Change* changes=allocatorAlloc(&log->allocator,sizeof(*changes)*capacity);
+    if(changes==NULL)
+    {
+        return log->size<log->capacity;
+    }
+    if(log->size>0)
+    {
+        memcpy(changes,log->changes,sizeof(*changes)*log->size);
+    }
+    allocatorFree(&log->allocator,log->changes);
+    log->changes=changes;
+    log->capacity=capacity;
+    return true;
+}
+
+ChangeLog changeLogCreate(void)
+{
+    return changeLogCreateWithAllocator(NULL);
+}
+
+ChangeLog changeLogCreateWithAllocator(const Allocator* allocator)
+{
+    ChangeLog log=allocatorAlloc(allocator,sizeof(*log));
+    if(log==NULL)
+    {
+        return NULL;
+    }
+    if(allocator!=NULL)
+    {
+        log->allocator=*allocator;
+    }
+    else
+    {
+        memset(&log->allocator,0,sizeof(log->allocator));
+    }
+    log->changes=NULL;
+    log->size=0;
+    log->capacity=0;
+    log->version=0;
+    log->complete_from=0;
+    return log;
+}
+
+void changeLogDestroy(ChangeLog log)
+{
+    if(log==NULL)
+    {
+        return;
+    }
+    allocatorFree(&log->allocator,log->changes);
+    Allocator allocator=log->allocator;
+    allocatorFree(&allocator,log);
+}
+
+ChangeLogResult changeLogRecord(ChangeLog log, int event_id)
+{
+    if(log==NULL)
+    {
+        return CL_NULL_ARGUMENT;
+    }
+    log->version++;
+    if(!make_room(log))
+    {
+        log->complete_from=log->version;
+        return CL_OUT_OF_MEMORY;
+    }
+    log->changes[log->size].version=log->version;
+    log->changes[log->size].event_id=event_id;
+    log->size++;
+    return CL_SUCCESS;
+}
+
+long changeLogGetVersion(ChangeLog log)
+{
+    if(log==NULL)
+    {
+        return -1;
+    }
+    return log->version;
+}
+
+ChangeLogResult changeLogGetChanged(ChangeLog log, long since_version, int** event_ids, int* size)
+{
+    if(log==NULL||event_ids==NULL||size==NULL)
+    {
+        return CL_NULL_ARGUMENT;
+    }
+    if(since_version<log->complete_from||since_version>log->version)
+    {
+        return CL_INVALID_VERSION;
+    }
+    int low=0;
+    int high=log->size;
+    while(low<high){
+        int middle=low+(high-low)/2;
+        if(log->changes[middle].version<=since_version){
+            low=middle+1;
+        }
+        else{
+            high=middle;
+        }
+    }
+    *event_ids=NULL;
+    *size=0;
+    if(low==log->size)
+    {
+        return CL_SUCCESS;
+    }
+    int* ids=malloc(sizeof(*ids)*(log->size-low));
+    if(ids==NULL)
+    {
+        return CL_OUT_OF_MEMORY;
+    }
+    int count=0;
+    for(int i=low;i<log->size;i++){
+        ids[count++]=log->changes[i].event_id;
+    }
+    qsort(ids,count,sizeof(*ids),compare_ids);
+    int unique=0;
+    for(int i=0;i<count;i++){
+        if(unique==0||ids[unique-1]!=ids[i])
+        {
+            ids[unique++]=ids[i];
+        }
+    }
+    *event_ids=ids;
+    *size=unique;
+    return CL_SUCCESS;
+}
+
+long changeLogGetMemoryUsage(ChangeLog log)
+{
+    if(log==NULL)
+    {
+        return 0;
+    }
+    return (long)(sizeof(*log)+sizeof(*log->changes)*log->capacity);
+}
@@ -0,0 +1,120 @@
+#ifndef CHANGE_LOG_H_
+#define CHANGE_LOG_H_
+
+#include <stdbool.h>
+#include "allocator.h"
+
+/**
+* Change Log
+*
+* A versioned log of the events that changed. Every recorded change gets the
+* next version, starting from 1, and the log answers which events changed
+* after a given version. The log keeps only the latest change of every event,
+* older changes are dropped once they are superseded, so its size is bounded
+* by the number of distinct events that ever changed. The log and its changes
+* may be allocated through an Allocator.
+*
+* The following functions are available:
+*   changeLogCreate         - Creates a new empty log at version 0.
+*   changeLogCreateWithAllocator - Creates a new empty log whose memory is allocated by an allocator.
+*   changeLogDestroy        - Deletes an existing log and frees all its resources.
+*   changeLogRecord         - Records a change of an event.
+*   changeLogGetVersion     - Returns the version of the latest change.
+*   changeLogGetChanged     - Returns the events that changed after a version.
+*   changeLogGetMemoryUsage - Returns the number of bytes the log takes.
+*/
+
+/** Type for defining the log */
+typedef struct ChangeLog_t *ChangeLog;
+
+/** Type used for returning error codes from log functions */
+typedef enum ChangeLogResult_t {
+    CL_SUCCESS,
+    CL_OUT_OF_MEMORY,
+    CL_NULL_ARGUMENT,
+    CL_INVALID_VERSION
+} ChangeLogResult;
+
+/**
+* changeLogCreate: Allocates a new empty log at version 0.
+*
+* @return
+*   NULL - if allocation failed.
+*   A new log in case of success.
+*/
+ChangeLog changeLogCreate(void);
+
+/**
+* changeLogCreateWithAllocator: Allocates a new empty log at version 0 whose
+* structure and changes are allocated and freed through allocator. The
+* arrays returned by changeLogGetChanged are still allocated with malloc.
+*
+* @param allocator - The allocator, copied into the log. NULL for malloc.
+* @return
+*   NULL - if allocation failed.
+*   A new log in case of success.
+*/
+ChangeLog changeLogCreateWithAllocator(const Allocator* allocator);
+
+/**
+* changeLogDestroy: Deallocates an existing log.
+*
+* @param log - Target log to be deallocated. If log is NULL nothing will be done.
+*/
+void changeLogDestroy(ChangeLog log);
+
+/**
+* changeLogRecord: Records a change of an event at the next version.
+* If the change cannot be stored the version still advances, and the changes
+* up to it can no longer be queried.
+*
+* @param log - The log to record in.
+* @param event_id - The id of the event that changed.
+* @return
+*   CL_NULL_ARGUMENT if a NULL was sent as log.
+*   CL_OUT_OF_MEMORY if an allocation failed.
+*   CL_SUCCESS the change had been recorded successfully.
+*/
+ChangeLogResult changeLogRecord(ChangeLog log, int event_id);
+
+/**
+* changeLogGetVersion: Returns the version of the latest change.
+*
+* @param log - The log to query.
+* @return
+*   -1 if a NULL was sent as log.
+*   Otherwise the version, 0 if nothing was recorded.
+*/
+long changeLogGetVersion(ChangeLog log);
+
+/**
+* changeLogGetChanged: Returns the ids of the events that changed after
+* since_version, in increasing order and without repetitions.
+*
+* @param log - The log to query.
+* @param since_version - The version the caller is up to date with.
+* @param event_ids - Receives an array of the ids allocated with malloc, to be
+*   freed by the caller. Receives NULL if no event changed.
+* @param size - Receives the number of ids.
+* @return
+*   CL_NULL_ARGUMENT if a NULL was sent as one of the parameters.
+*   CL_INVALID_VERSION if since_version is negative, later than the current
+*     version, or earlier than a change that could not be recorded.
+*   CL_OUT_OF_MEMORY if an allocation failed.
+*   CL_SUCCESS otherwise.
+*/
+ChangeLogResult changeLogGetChanged(ChangeLog log, long since_version, int** event_ids, int* size);
+
+/**
+* changeLogGetMemoryUsage: Returns the number of bytes allocated for a log and
+* its changes. The ids returned by changeLogGetChanged belong to the caller
+* and are not counted. Runs in O(1).
+*
+* @param log - The log to measure.
+* @return
+*   0 if a NULL pointer was sent.
+*   Otherwise the number of bytes.
+*/
+long changeLogGetMemoryUsage(ChangeLog log);
+
+#endif /* CHANGE_LOG_H_ */
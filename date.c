@@ -1,5 +1,6 @@
 
 #include "date.h"
+#include "date_ext.h"
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -78,13 +79,13 @@ static int dateToDays(Date date)
            + DAYS_IN_YEAR * date->year;
 }
 
-Date dateCreate(int day, int month, int year)
+Date dateCreateWithAllocator(int day, int month, int year, const Allocator* allocator)
 {
     if(!isDayValid(day) || !isMonthNumberValid(month))
     {
         return NULL;
     }
-    Date date = malloc(sizeof(*date));
+    Date date = allocatorAlloc(allocator,sizeof(*date));
     if(date == NULL)
     {
         return NULL;
@@ -94,17 +95,37 @@ Date dateCreate(int day, int month, int year)
     date->year = year;
     return date;
 }
+Date dateCreate(int day, int month, int year)
+{
+    return dateCreateWithAllocator(day,month,year,NULL);
+}
+void dateDestroyWithAllocator(Date date, const Allocator* allocator)
+{
+    allocatorFree(allocator,date);
+}
 void dateDestroy(Date date)
 {
     free(date);
 }
-Date dateCopy(Date date)
+Date dateCopyWithAllocator(Date date, const Allocator* allocator)
 {
     if(date == NULL)
     {
         return NULL;
     }
-    return dateCreate(date->day,monthToInt(date->month),date->year);
+    return dateCreateWithAllocator(date->day,monthToInt(date->month),date->year,allocator);
+}
+Date dateCopy(Date date)
+{
+    return dateCopyWithAllocator(date,NULL);
+}
+long dateGetMemoryUsage(Date date)
+{
+    if(date == NULL)
+    {
+        return 0;
+    }
+    return (long)sizeof(*date);
 }
 bool dateGet(Date date, int* day, int* month, int* year)
 {
@@ -0,0 +1,62 @@
+#ifndef DATE_EXT_H_
+#define DATE_EXT_H_
+
+#include "date.h"
+#include "allocator.h"
+
+/**
+* Date extensions
+*
+* Additional functions over a Date that are not part of the basic interface
+* declared in date.h.
+*
+* The following functions are available:
+*   dateCreateWithAllocator     - Creates a new date allocated by an allocator.
+*   dateCopyWithAllocator       - Copies a date into memory allocated by an allocator.
+*   dateDestroyWithAllocator    - Deletes a date allocated by an allocator.
+*   dateGetMemoryUsage          - Returns the number of bytes a date takes.
+*/
+
+/**
+* dateCreateWithAllocator: Allocates a new date through an allocator.
+*
+* @param day - The day of the date.
+* @param month - The month of the date, 1 to 12.
+* @param year - The year of the date.
+* @param allocator - The allocator, NULL for malloc.
+* @return
+* 	NULL - if the day or the month is invalid or allocation failed.
+* 	A new date in case of success.
+*/
+Date dateCreateWithAllocator(int day, int month, int year, const Allocator* allocator);
+
+/**
+* dateCopyWithAllocator: Copies a date into memory allocated through an allocator.
+*
+* @param date - The date to copy.
+* @param allocator - The allocator of the copy, NULL for malloc.
+* @return
+* 	NULL - if date is NULL or allocation failed.
+* 	A copy of the date in case of success.
+*/
+Date dateCopyWithAllocator(Date date, const Allocator* allocator);
+
+/**
+* dateDestroyWithAllocator: Deallocates a date through the allocator that allocated it.
+*
+* @param date - The date to deallocate. If date is NULL nothing will be done.
+* @param allocator - The allocator of the date, NULL for free.
+*/
+void dateDestroyWithAllocator(Date date, const Allocator* allocator);
+
+/**
+* dateGetMemoryUsage: Returns the number of bytes allocated for a date.
+*
+* @param date - The date to measure.
+* @return
+* 	0 - if date is NULL.
+* 	Otherwise the number of bytes.
+*/
+long dateGetMemoryUsage(Date date);
+
+#endif /* DATE_EXT_H_ */
@@ -0,0 +1,333 @@
+#include "event_index.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#define MAX_LEVEL 24
+#define LEVEL_UP_MASK 3
+#define RANDOM_SEED 2463534242u
+
+typedef struct index_node *IndexNode;
+
+typedef struct index_level{
+
+    IndexNode next;
+    int span;
+
+}IndexLevel;
+
+struct index_node{
+
+    int date_key;
+    int order;
+    void* data;
+    int level;
+    IndexLevel levels[];
+
+};
+
+struct EventIndex_t{
+    IndexNode head;
+    int level;
+    int size;
+    unsigned int seed;
+    long bytes;
+    Allocator allocator;
+};
+
+/**
+* key_cmp: compares the key of a node with a given key.
+*
+* @param node - the node to compare.
+* @param date_key - the packed date of the key.
+* @param order - the insertion counter of the key.
+* @return
+* 		A negative integer if the node comes before the key;
+* 		0 if they're equal;
+*		A positive integer if the node comes after the key.
+*/
+static int key_cmp(IndexNode node,int date_key,int order)
+{
+    if(node->date_key!=date_key)
+    {
+        return node->date_key<date_key ? -1 : 1;
+    }
+    if(node->order!=order)
+    {
+        return node->order<order ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+* random_level: draws the level of a new node, each level with probability 1/4.
+*
+* @param index - the index that owns the random seed.
+* @return
+* a level between 1 and MAX_LEVEL.
+*/
+static int random_level(EventIndex index)
+{
+    int level=1;
+    while(level<MAX_LEVEL){
+        index->seed^=index->seed<<13;
+        index->seed^=index->seed>>17;
+        index->seed^=index->seed<<5;
+        if((index->seed&LEVEL_UP_MASK)!=0){
+            break;
+        }
+        level++;
+    }
+    return level;
+}
+
+/**
+* index_node_size: returns the number of bytes of a node with the given number of levels.
+*/
+static size_t index_node_size(int level)
+{
+    return sizeof(struct index_node)+sizeof(IndexLevel)*level;
+}
+
+/**
+* create_index_node: allocates a new node with the given number of levels.
+*
+* @param allocator - the allocator of the index.
+* @param date_key - the packed date of the node.
+* @param order - the insertion counter of the node.
+* @param data - the data pointer stored in the node.
+* @param level - the number of levels of the node.
+* @return
+* NULL - if allocation failed.
+* otherwise a new node with all its levels empty.
+*/
+static IndexNode create_index_node(const Allocator* allocator,int date_key,int order,void* data,int level)
+{
+    IndexNode ptr=allocatorAlloc(allocator,index_node_size(level));
+    if(ptr==NULL)
+    {
+        return NULL;
+    }
+    ptr->date_key=date_key;
+    ptr->order=order;
+    ptr->data=data;
+    ptr->level=level;
+    for(int i=0;i<level;i++){
+        ptr->levels[i].next=NULL;
+        ptr->levels[i].span=0;
+    }
+    return ptr;
+}
+
+/**
+* rank_before: counts the entries whose date is smaller than date_key.
+*
+* @param index - the index to count in.
+* @param date_key - the packed date to count up to.
+* @return
+* the number of entries before date_key.
+*/
+static int rank_before(EventIndex index,int date_key)
+{
+    int rank=0;
+    IndexNode current=index->head;
+    for(int i=index->level-1;i>=0;i--){
+        while(current->levels[i].next!=NULL&&current->levels[i].next->date_key<date_key){
+            rank+=current->levels[i].span;
+            current=current->levels[i].next;
+        }
+    }
+    return rank;
+}
+
+EventIndex eventIndexCreate(void)
+{
+    return eventIndexCreateWithAllocator(NULL);
+}
+
+EventIndex eventIndexCreateWithAllocator(const Allocator* allocator)
+{
+    EventIndex index=allocatorAlloc(allocator,sizeof(*index));
+    if(index==NULL)
+    {
+        return NULL;
+    }
+    if(allocator!=NULL)
+    {
+        index->allocator=*allocator;
+    }
+    else
+    {
+        memset(&index->allocator,0,sizeof(index->allocator));
+    }
+    index->head=create_index_node(allocator,0,0,NULL,MAX_LEVEL);
+    if(index->head==NULL)
+    {
+        allocatorFree(allocator,index);
+        return NULL;
+    }
+    index->level=1;
+    index->size=0;
+    index->seed=RANDOM_SEED;
+    index->bytes=(long)(sizeof(*index)+index_node_size(MAX_LEVEL));
+    return index;
+}
+
+void eventIndexDestroy(EventIndex index)
+{
+    if(index==NULL)
+    {
+        return;
+    }
+    IndexNode current=index->head;
+    while(current!=NULL){
+        IndexNode to_free=current;
+        current=current->levels[0].next;
+        allocatorFree(&index->allocator,to_free);
+    }
+    Allocator allocator=index->allocator;
+    allocatorFree(&allocator,index);
+}
+
+int eventIndexGetSize(EventIndex index)
+{
+    if(index==NULL)
+    {
+        return -1;
+    }
+    return index->size;
+}
+
+long eventIndexGetMemoryUsage(EventIndex index)
+{
+    if(index==NULL)
+    {
+        return 0;
+    }
+    return index->bytes;
+}
+
+EventIndexResult eventIndexInsert(EventIndex index, int date_key, int order, void* data)
+{
+    if(index==NULL)
+    {
+        return EI_NULL_ARGUMENT;
+    }
+    IndexNode update[MAX_LEVEL];
+    int rank[MAX_LEVEL];
+    IndexNode current=index->head;
+    for(int i=index->level-1;i>=0;i--){
+        rank[i]= i==index->level-1 ? 0 : rank[i+1];
+        while(current->levels[i].next!=NULL&&key_cmp(current->levels[i].next,date_key,order)<0){
+            rank[i]+=current->levels[i].span;
+            current=current->levels[i].next;
+        }
+        update[i]=current;
+    }
+    if(current->levels[0].next!=NULL&&key_cmp(current->levels[0].next,date_key,order)==0)
+    {
+        return EI_KEY_ALREADY_EXISTS;
+    }
+    IndexNode new=create_index_node(&index->allocator,date_key,order,data,random_level(index));
+    if(new==NULL)
+    {
+        return EI_OUT_OF_MEMORY;
+    }
+    for(int i=index->level;i<new->level;i++){
+        rank[i]=0;
+        update[i]=index->head;
+        update[i]->levels[i].span=index->size;
+    }
+    if(new->level>index->level)
+    {
+        index->level=new->level;
+    }
+    for(int i=0;i<new->level;i++){
+        new->levels[i].next=update[i]->levels[i].next;
+        update[i]->levels[i].next=new;
+        new->levels[i].span=update[i]->levels[i].span-(rank[0]-rank[i]);
+        update[i]->levels[i].span=rank[0]-rank[i]+1;
+    }
+    for(int i=new->level;i<index->level;i++){
+        update[i]->levels[i].span++;
+    }
+    index->size++;
+    index->bytes+=(long)index_node_size(new->level);
+    return EI_SUCCESS;
+}
+
+EventIndexResult eventIndexRemove(EventIndex index, int date_key, int order)
+{
+    if(index==NULL)
+    {
+        return EI_NULL_ARGUMENT;
+    }
+    IndexNode update[MAX_LEVEL];
+    IndexNode current=index->head;
+    for(int i=index->level-1;i>=0;i--){
+        while(current->levels[i].next!=NULL&&key_cmp(current->levels[i].next,date_key,order)<0){
+            current=current->levels[i].next;
+        }
+        update[i]=current;
+    }
+    IndexNode to_remove=current->levels[0].next;
+    if(to_remove==NULL||key_cmp(to_remove,date_key,order)!=0)
+    {
+        return EI_KEY_NOT_EXISTS;
+    }
+    for(int i=0;i<index->level;i++){
+        if(update[i]->levels[i].next==to_remove){
+            update[i]->levels[i].span+=to_remove->levels[i].span-1;
+            update[i]->levels[i].next=to_remove->levels[i].next;
+        }
+        else{
+            update[i]->levels[i].span--;
+        }
+    }
+    while(index->level>1&&index->head->levels[index->level-1].next==NULL){
+        index->level--;
+    }
+    index->bytes-=(long)index_node_size(to_remove->level);
+    allocatorFree(&index->allocator,to_remove);
+    index->size--;
+    return EI_SUCCESS;
+}
+
+int eventIndexCountRange(EventIndex index, int from_key, int to_key)
+{
+    if(index==NULL)
+    {
+        return -1;
+    }
+    if(from_key>to_key)
+    {
+        return 0;
+    }
+    int to_rank=to_key==INT_MAX?index->size:rank_before(index,to_key+1);
+    return to_rank-rank_before(index,from_key);
+}
+
+EventIndexResult eventIndexForEachRange(EventIndex index, int from_key, int to_key,
+                                        EventIndexVisitor visitor, void* ctx)
+{
+    if(index==NULL||visitor==NULL)
+    {
+        return EI_NULL_ARGUMENT;
+    }
+    IndexNode current=index->head;
+    for(int i=index->level-1;i>=0;i--){
+        while(current->levels[i].next!=NULL&&current->levels[i].next->date_key<from_key){
+            current=current->levels[i].next;
+        }
+    }
+    current=current->levels[0].next;
+    while(current!=NULL&&current->date_key<=to_key){
+        IndexNode next=current->levels[0].next;
+        if(!visitor(current->date_key,current->order,current->data,ctx))
+        {
+            break;
+        }
+        current=next;
+    }
+    return EI_SUCCESS;
+}
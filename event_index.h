@@ -0,0 +1,151 @@
+#ifndef EVENT_INDEX_H_
+#define EVENT_INDEX_H_
+
+#include <stdbool.h>
+#include "allocator.h"
+
+/**
+* Event Index
+*
+* An ordered index of events implemented as an indexable skip list.
+* Entries are keyed on a packed date (days since year 0) and the insertion
+* counter of the event, so events on the same date keep their insertion order.
+* Every entry carries an opaque data pointer that is not owned by the index.
+* The index and its nodes may be allocated through an Allocator.
+*
+* The following functions are available:
+*   eventIndexCreate        - Creates a new empty index.
+*   eventIndexCreateWithAllocator - Creates a new empty index whose memory is allocated by an allocator.
+*   eventIndexDestroy       - Deletes an existing index and frees all its entries.
+*   eventIndexGetSize       - Returns the number of entries in the index.
+*   eventIndexGetMemoryUsage - Returns the number of bytes the index takes.
+*   eventIndexInsert        - Inserts a new entry.
+*   eventIndexRemove        - Removes an entry by its key.
+*   eventIndexCountRange    - Counts the entries between two dates in O(log n).
+*   eventIndexForEachRange  - Visits the entries between two dates in order.
+*/
+
+/** Type for defining the index */
+typedef struct EventIndex_t *EventIndex;
+
+/** Type used for returning error codes from index functions */
+typedef enum EventIndexResult_t {
+    EI_SUCCESS,
+    EI_OUT_OF_MEMORY,
+    EI_NULL_ARGUMENT,
+    EI_KEY_ALREADY_EXISTS,
+    EI_KEY_NOT_EXISTS
+} EventIndexResult;
+
+/**
+* Type of function used by eventIndexForEachRange to visit an entry.
+* Returns false to stop the iteration.
+*/
+typedef bool (*EventIndexVisitor)(int date_key, int order, void* data, void* ctx);
+
+/**
+* eventIndexCreate: Allocates a new empty index.
+*
+* @return
+*   NULL - if allocation failed.
+*   A new index in case of success.
+*/
+EventIndex eventIndexCreate(void);
+
+/**
+* eventIndexCreateWithAllocator: Allocates a new empty index whose structure
+* and nodes are allocated and freed through allocator.
+*
+* @param allocator - The allocator, copied into the index. NULL for malloc.
+* @return
+*   NULL - if allocation failed.
+*   A new index in case of success.
+*/
+EventIndex eventIndexCreateWithAllocator(const Allocator* allocator);
+
+/**
+* eventIndexDestroy: Deallocates an existing index. The data pointers are not freed.
+*
+* @param index - Target index to be deallocated. If index is NULL nothing will be done.
+*/
+void eventIndexDestroy(EventIndex index);
+
+/**
+* eventIndexGetSize: Returns the number of entries in the index.
+*
+* @param index - The index whose size is requested.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the number of entries in the index.
+*/
+int eventIndexGetSize(EventIndex index);
+
+/**
+* eventIndexGetMemoryUsage: Returns the number of bytes allocated for an index
+* and its nodes. The bytes are counted as nodes are inserted and removed, so
+* this runs in O(1).
+*
+* @param index - The index to measure.
+* @return
+*   0 if a NULL pointer was sent.
+*   Otherwise the number of bytes.
+*/
+long eventIndexGetMemoryUsage(EventIndex index);
+
+/**
+* eventIndexInsert: Adds a new entry to the index.
+*
+* @param index - The index to insert to.
+* @param date_key - The packed date of the entry.
+* @param order - The insertion counter of the entry, breaks ties between equal dates.
+* @param data - Opaque pointer stored with the entry.
+* @return
+*   EI_NULL_ARGUMENT if a NULL was sent as index.
+*   EI_KEY_ALREADY_EXISTS if an entry with the same key is already in the index.
+*   EI_OUT_OF_MEMORY if an allocation failed.
+*   EI_SUCCESS the entry had been inserted successfully.
+*/
+EventIndexResult eventIndexInsert(EventIndex index, int date_key, int order, void* data);
+
+/**
+* eventIndexRemove: Removes the entry with the given key from the index.
+*
+* @param index - The index to remove from.
+* @param date_key - The packed date of the entry.
+* @param order - The insertion counter of the entry.
+* @return
+*   EI_NULL_ARGUMENT if a NULL was sent as index.
+*   EI_KEY_NOT_EXISTS if no entry with the given key is in the index.
+*   EI_SUCCESS the entry had been removed successfully.
+*/
+EventIndexResult eventIndexRemove(EventIndex index, int date_key, int order);
+
+/**
+* eventIndexCountRange: Counts the entries whose date is in [from_key, to_key].
+*
+* @param index - The index to count in.
+* @param from_key - The first packed date of the range.
+* @param to_key - The last packed date of the range.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the number of entries in the range.
+*/
+int eventIndexCountRange(EventIndex index, int from_key, int to_key);
+
+/**
+* eventIndexForEachRange: Calls visitor on every entry whose date is in
+* [from_key, to_key], ordered by date and then by insertion counter.
+*
+* @param index - The index to iterate over.
+* @param from_key - The first packed date of the range.
+* @param to_key - The last packed date of the range.
+* @param visitor - Function called for every entry. Returning false stops the iteration.
+* @param ctx - Passed as is to visitor.
+* @return
+*   EI_NULL_ARGUMENT if a NULL was sent as index or visitor.
+*   EI_SUCCESS otherwise.
+*/
+EventIndexResult eventIndexForEachRange(EventIndex index, int from_key, int to_key,
+                                        EventIndexVisitor visitor, void* ctx);
+
+#endif /* EVENT_INDEX_H_ */
@@ -1,11 +1,32 @@
+#ifdef ENABLE_STATS
+#define _POSIX_C_SOURCE 199309L
+#endif
 #include "date.h"
+#include "date_ext.h"
+#include "allocator.h"
 #include "event_manager.h"
-#include "priority_queue.h"
+#include "event_manager_ext.h"
+#include "typed_priority_queue.h"
+#include "event_index.h"
+#include "member_index.h"
+#include "member_set.h"
+#include "event_scan.h"
+#include "export_writer.h"
+#include "change_log.h"
+#include "schedule_file.h"
+#include "notification_ring.h"
+#include "version_table.h"
+#include "booking_index.h"
+#include "slot_map.h"
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
+#ifdef ENABLE_STATS
+#include <time.h>
+#endif
 #define INVALID_MONTH 0
 #define MIN_DAY 1
 #define MAX_DAY 30
@@ -14,46 +35,213 @@
 #define MONTH_STR_LEN 4
 #define NEGATIVE -1
 #define POSITIVE 1
+#define NS_IN_SECOND 1000000000L
+#define INITIAL_EVENT_SLOTS 16
+#define INITIAL_MEMBER_SLOTS 16
+#define EXPAND_FACTOR 2
+#define FREE_SLOT -1
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME 16777619u
+#define EXPORT_CHUNK_LINES 4096
+#define DATE_CACHE_SIZE 64
+#define DATE_TEXT_LEN (3*EXPORT_INT_TEXT_LEN+2)
+#define DELTA_HEADER_LEN 32
+#define DEFAULT_EXPORT_WORKERS 1
+
+#ifdef ENABLE_STATS
+#define EM_STAT_ADD(em,field,amount) ((em)->stats.field+=(amount))
+#define EM_TIMER_START(timer) struct timespec timer; clock_gettime(CLOCK_MONOTONIC,&timer)
+#define EM_TIMER_RECORD(em,call,timer) record_latency(em,call,&timer)
+#else
+#define EM_STAT_ADD(em,field,amount) ((void)0)
+#define EM_TIMER_START(timer) ((void)0)
+#define EM_TIMER_RECORD(em,call,timer) ((void)0)
+#endif
+#define EM_LOOKUP(em) EM_STAT_ADD(em,lookups,1)
+#define EM_SCAN(em) EM_STAT_ADD(em,nodes_scanned,1)
+
+#ifdef ENABLE_STATS
+typedef union alloc_header
+{
+    size_t size;
+    long double align_long_double;
+    long long align_long_long;
+    void* align_pointer;
+}Alloc_header;
+
+static struct
+{
+    long allocations;
+    long frees;
+    long bytes_live;
+    long bytes_peak;
+}alloc_stats;
+
+/**
+* em_malloc: allocates memory and records its size for the allocation counters.
+*
+* @param allocator - the allocator of the event manager.
+* @param size - the number of bytes to allocate.
+* @return
+* NULL - if allocation fails.
+* otherwise the allocated memory.
+*/
+static void* em_malloc(const Allocator* allocator,size_t size)
+{
+    Alloc_header* header=allocatorAlloc(allocator,sizeof(*header)+size);
+    if(header==NULL)
+    {
+        return NULL;
+    }
+    header->size=size;
+    alloc_stats.allocations++;
+    alloc_stats.bytes_live+=(long)size;
+    if(alloc_stats.bytes_live>alloc_stats.bytes_peak)
+    {
+        alloc_stats.bytes_peak=alloc_stats.bytes_live;
+    }
+    return header+1;
+}
+
+/**
+* em_free: frees memory allocated by em_malloc.
+*
+* @param allocator - the allocator of the event manager.
+* @param ptr - the memory to free, may be NULL.
+*/
+static void em_free(const Allocator* allocator,void* ptr)
+{
+    if(ptr==NULL)
+    {
+        return;
+    }
+    Alloc_header* header=(Alloc_header*)ptr-1;
+    alloc_stats.frees++;
+    alloc_stats.bytes_live-=(long)header->size;
+    allocatorFree(allocator,header);
+}
+#else
+#define em_malloc allocatorAlloc
+#define em_free allocatorFree
+#endif
 
 typedef struct node
 {
 
     char *name;
+    int name_length;
     int id;
     int counter;
+    int view_slot;
     Date date;
+    MemberSet members;
     struct node *next;
 
 }*Node;
 
-typedef struct event_element
+/**
+* Recurrence: the rule of a recurring event. Occurrence k of the rule has the
+* id base_id+k and falls period_days after occurrence k-1. Only the current
+* occurrence is an event, date is its scheduled date and index its k.
+* A count of 0 or a NULL until leaves the rule unbounded by it.
+*/
+typedef struct recurrence
+{
+    Date date;
+    Date until;
+    int period_days;
+    int count;
+    int index;
+    int base_id;
+}*Recurrence;
+
+/**
+* Event_view: the record of an event in the versioned view of the events,
+* which snapshots share. Its members are listed by their slots in the view of
+* the members, and its name follows them.
+*/
+typedef struct event_view
+{
+    int id;
+    int counter;
+    int date_key;
+    int day;
+    int month;
+    int year;
+    int name_length;
+    int members_num;
+    int member_slots[];
+}Event_view;
+
+/**
+* Member_view: the record of a member in the versioned view of the members.
+*/
+typedef struct member_view
 {
-    char *name;
     int id;
-    Node members_head;
     int counter;
-}*Event_element;
+    int name_length;
+    char name[];
+}Member_view;
+
+/**
+* EventQueue: the events ordered by their packed date, the earliest first.
+* The queue holds the slots of the events in the event table.
+*/
+TYPED_PQ_DEFINE(EventQueue, eventQueue, int, int, TYPED_PQ_INT_ASCENDING, TYPED_PQ_SAME_VALUE)
+
+/**
+* Event_table: the events of an event manager stored as columns. Slot i of
+* every column describes the same event, so a scan over the ids or the dates
+* reads a single contiguous array. The name, the date and the members of an
+* event stay in its node, and the rule of a recurring event in its rules
+* entry, NULL for other events. The slots are assigned to the ids by a slot
+* map, which finds the slot of an id in O(1). Slots of removed events hold
+* FREE_SLOT as their id and are reused by the next events.
+*/
+typedef struct event_table
+{
+    int* ids;
+    int* date_keys;
+    int* counters;
+    unsigned int* name_hashes;
+    Node* nodes;
+    Recurrence* rules;
+    SlotMap slots;
+    int used;
+    int capacity;
+}Event_table;
 
 /**
 * create_in_Node: creates a date in new node.
 *
 * @param date - the date to put in the node.
+* @param allocator - the allocator of the node and its date.
 
 * @return
 * NULL - if allocation fails.
 * otherwise a new node.
 */
-static Node create_in_Node(Date date)
+static Node create_in_Node(Date date,const Allocator* allocator)
 {
-    Node ptr = malloc(sizeof(*ptr));
+    Node ptr = em_malloc(allocator,sizeof(*ptr));
     if(ptr == NULL) {
         return NULL;
     }
     assert(ptr!=NULL);
     ptr->name=NULL;
+    ptr->name_length=0;
     ptr->id=0;
     ptr->counter=0;
-    ptr->date=dateCopy(date);
+    ptr->view_slot=0;
+    ptr->date=dateCopyWithAllocator(date,allocator);
+    if(ptr->date==NULL)
+    {
+        em_free(allocator,ptr);
+        return NULL;
+    }
+    ptr->members=NULL;
+    ptr->next=NULL;
     return ptr;
 }
 
@@ -64,22 +252,30 @@ static Node create_in_Node(Date date)
 * @param id - the id to put in node.
 * @param counter - counter  for the node.
 * @param date - the date to put in node.
+* @param allocator - the allocator of the node, its name and its date.
 * @return
 * NULL - if allocation fails.
 * otherwise a new node.
 */
 
-static Node createNode(char *name,int id,int counter,Date date)
+static Node createNode(char *name,int id,int counter,Date date,const Allocator* allocator)
 {
-    Node ptr = malloc(sizeof(*ptr));
+    Node ptr = em_malloc(allocator,sizeof(*ptr));
     if(ptr == NULL) {
         return NULL;
     }
     assert(ptr!=NULL);
+    ptr->name_length=0;
     if(name){
-        char * new_name=malloc(sizeof(char)*strlen(name)+1);
+        ptr->name_length=(int)strlen(name);
+        char * new_name=em_malloc(allocator,sizeof(char)*ptr->name_length+1);
+        if(new_name==NULL)
+        {
+            em_free(allocator,ptr);
+            return NULL;
+        }
 
-        strcpy( new_name,name);
+        memcpy( new_name,name,ptr->name_length+1);
         ptr->name=new_name;
     }
     if(!name){
@@ -87,1200 +283,3257 @@ static Node createNode(char *name,int id,int counter,Date date)
     }
     ptr->id=id;
     ptr->counter=counter;
-    ptr->date=dateCopy(date);
+    ptr->view_slot=0;
+    ptr->date=dateCopyWithAllocator(date,allocator);
+    if(date!=NULL&&ptr->date==NULL)
+    {
+        em_free(allocator,ptr->name);
+        em_free(allocator,ptr);
+        return NULL;
+    }
+    ptr->members=NULL;
     ptr->next=NULL;
     return ptr;
 }
 
 
-/**
-* eventElement_create: creates a new event element.
-*
-* @param name - name of the element.
-* @param id - the id of the element.
-* @param counter - counter of elements.
-* @return
-* NULL - if allocation fails.
-* otherwise a new event element.
-*/
-static Event_element eventElement_create(char* name,int id,int counter)
-{
-    Event_element element=malloc(sizeof(*element));
-    char* new_name=malloc(sizeof(char)*strlen(name)+1);
-    strcpy(new_name,name);
-    element->name=new_name;
-    element->id=id;
-    element->counter=counter;
-    element->members_head=NULL;
-    return element;
-}
-
-
 struct EventManager_t
 {
-    PriorityQueue queue;
-    Node head_events;
+    EventQueue queue;
+    Event_table events;
     int counter_num_of_events;
     Date begginig_date;
     Node members_in_sysem_head;
     int counter;
     int current_event_id;
+    EventIndex events_index;
+    MemberIndex members_index;
+    int export_workers;
+    ChangeLog changes;
+    Allocator allocator;
+    EMMemoryUsage memory;
+    NotificationRing notifications;
+    VersionTable events_view;
+    VersionTable members_view;
+    long* view_references;
+    int members_num;
+    SlotMap member_slots;
+    Node* member_nodes;
+    int member_capacity;
+    BookingIndex bookings;
+    int max_event_members;
+    int max_member_events_per_date;
+#ifdef ENABLE_STATS
+    EMStats stats;
+#endif
 };
 
+struct EMSnapshot_t
+{
+    VersionTable events;
+    VersionTable members;
+    int events_num;
+    long version;
+    int export_workers;
+    long* view_references;
+};
+
+#ifdef ENABLE_STATS
 /**
-* Destroy_Node: destroys a given node.
+* record_latency: adds the time passed since a call started to its histogram.
 *
-* @param node - the node to destroy.
+* @param em - the event manager the call was made on, may be NULL.
+* @param call - the call that ended.
+* @param start - the time the call started.
 */
-static void Destroy_Node(Node node)
+static void record_latency(EventManager em,EMCall call,struct timespec* start)
 {
-    if(node==NULL){
-        return;
-    }
-
-    if(node->name==NULL&&node->date!=NULL)
+    if(em==NULL)
     {
-        dateDestroy(node->date);
-        free(node);
-        return;
-    }
-
-    Node current=node;
-
-    if(current->next==NULL){
-        free(node->name);
-        dateDestroy(node->date);
-        free(node);
         return;
-
     }
-    while (current!=NULL){
-        Node fr=current;
-        current=current->next;
-        free(fr->name);
-        dateDestroy(fr->date);
-        free(fr);
-        fr=NULL;
-
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC,&end);
+    long elapsed=(end.tv_sec-start->tv_sec)*NS_IN_SECOND+(end.tv_nsec-start->tv_nsec);
+    EMLatency* latency=&em->stats.calls[call];
+    int bucket=0;
+    while(bucket<EM_LATENCY_BUCKETS-1&&(elapsed>>(bucket+1))>0){
+        bucket++;
+    }
+    latency->calls++;
+    latency->total_ns+=elapsed;
+    if(elapsed>latency->max_ns)
+    {
+        latency->max_ns=elapsed;
     }
-
-
+    latency->buckets[bucket]++;
 }
+#endif
 
 /**
-* date_cmp: compare between two given dates.
+* hash_name: hashes an event name, so names can be compared as numbers first.
 *
-* @param date1 - the first date.
-* @param date2 - the second date.
+* @param name - the name to hash.
 * @return
-* 		A positive integer if date1 occurs first;
-* 		0 if they're equal;
-*		A negative integer if date1 arrives after date2.
+* the FNV-1a hash of the name.
 */
-static int date_cmp(Date date1, Date date2)
+static unsigned int hash_name(const char* name)
 {
-    return -1*dateCompare(date1,date2);
+    unsigned int hash=FNV_OFFSET_BASIS;
+    for(const unsigned char* c=(const unsigned char*)name;*c!='\0';c++){
+        hash^=*c;
+        hash*=FNV_PRIME;
+    }
+    return hash;
 }
 
 /**
-* copy_Node: create a new copy of node.
+* grow_column: moves a column of the event table into a larger allocation,
+* the way realloc would, through the allocator of the event manager.
 *
-* @param node - the node we want to copy.
+* @param allocator - the allocator of the event manager.
+* @param column - the column to grow, may be NULL.
+* @param old_size - the size of the column in bytes.
+* @param new_size - the new size of the column in bytes.
 * @return
-* NULL - if allocation fails.
-* otherwise a new copy of node.
+* NULL - if allocation fails, the column is left as it was.
+* otherwise the grown column.
 */
-static Node copy_Node(Node node)
+static void* grow_column(const Allocator* allocator,void* column,size_t old_size,size_t new_size)
 {
-    if(!node)
+    void* grown=allocatorAlloc(allocator,new_size);
+    if(grown==NULL)
     {
         return NULL;
     }
-    Node new=create_in_Node(node->date);
-    char*   new_name=malloc(sizeof(char)*strlen(node->name)+1);
-    strcpy(new_name,node->name);
-    new->name=new_name;
-    new->id=node->id;
-    new->counter=node->counter;
-    new->next=NULL;
-    Node current=node->next;
-    Node current_new=new;
-    while (current!=NULL){
-        current_new->next=createNode(current->name,current->id,current->counter,current->date);
-        current=current->next;
-        current_new=current_new->next;
-        if(current==NULL){
-            current_new->next=NULL;
-        }
-
+    if(old_size>0)
+    {
+        memcpy(grown,column,old_size);
     }
-
-    return new;
+    allocatorFree(allocator,column);
+    return grown;
 }
 
-
+/**
+* expand_event_table: grows all the columns of the event table.
+*
+* @param table - the table to expand.
+* @param allocator - the allocator of the event manager.
+* @return
+* FALSE - if allocation fails, the table stays usable with its old capacity.
+* otherwise TRUE.
+*/
+static bool expand_event_table(Event_table* table,const Allocator* allocator)
+{
+    size_t old_capacity=(size_t)table->capacity;
+    int capacity= table->capacity==0 ? INITIAL_EVENT_SLOTS : table->capacity*EXPAND_FACTOR;
+    int* ids=grow_column(allocator,table->ids,sizeof(*ids)*old_capacity,sizeof(*ids)*capacity);
+    if(ids==NULL)
+    {
+        return false;
+    }
+    table->ids=ids;
+    int* date_keys=grow_column(allocator,table->date_keys,sizeof(*date_keys)*old_capacity,
+                               sizeof(*date_keys)*capacity);
+    if(date_keys==NULL)
+    {
+        return false;
+    }
+    table->date_keys=date_keys;
+    int* counters=grow_column(allocator,table->counters,sizeof(*counters)*old_capacity,
+                              sizeof(*counters)*capacity);
+    if(counters==NULL)
+    {
+        return false;
+    }
+    table->counters=counters;
+    unsigned int* name_hashes=grow_column(allocator,table->name_hashes,sizeof(*name_hashes)*old_capacity,
+                                          sizeof(*name_hashes)*capacity);
+    if(name_hashes==NULL)
+    {
+        return false;
+    }
+    table->name_hashes=name_hashes;
+    Node* nodes=grow_column(allocator,table->nodes,sizeof(*nodes)*old_capacity,sizeof(*nodes)*capacity);
+    if(nodes==NULL)
+    {
+        return false;
+    }
+    table->nodes=nodes;
+    Recurrence* rules=grow_column(allocator,table->rules,sizeof(*rules)*old_capacity,sizeof(*rules)*capacity);
+    if(rules==NULL)
+    {
+        return false;
+    }
+    table->rules=rules;
+    table->capacity=capacity;
+    return true;
+}
 
 /**
-* copy_element: creates a new copy of element.
+* add_event_slot: puts an event in a free slot of the event table.
 *
-* @param element - the element to copy.
+* @param table - the table to add to.
+* @param event - the node of the event.
+* @param date_key - the packed date of the event.
+* @param allocator - the allocator of the event manager.
 * @return
-* NULL - if element is null.
-* otherwise a new copy of element.
+* -1 - if allocation fails.
+* otherwise the slot of the event.
 */
-static Event_element copy_element(Event_element element)
+static int add_event_slot(Event_table* table,Node event,int date_key,const Allocator* allocator)
 {
-    if (!element)
+    int slot;
+    if(slotMapInsert(table->slots,event->id,&slot)!=SM_SUCCESS)
     {
-        return NULL;
+        return -1;
     }
-    Event_element new_element=eventElement_create(element->name,element->id,element->counter);
-    new_element->members_head=copy_Node(element->members_head);
-    return new_element;
+    if(slot==table->used)
+    {
+        if(table->used==table->capacity&&!expand_event_table(table,allocator))
+        {
+            slotMapRemove(table->slots,event->id);
+            return -1;
+        }
+        table->used++;
+    }
+    table->ids[slot]=event->id;
+    table->date_keys[slot]=date_key;
+    table->counters[slot]=event->counter;
+    table->name_hashes[slot]=hash_name(event->name);
+    table->nodes[slot]=event;
+    table->rules[slot]=NULL;
+    return slot;
 }
 
 /**
-* free_element: free a given element.
+* remove_event_slot: frees the slot of an event, the node is not destroyed.
+* The date of a free slot is the latest possible so the date scans skip it.
 *
-* @param element - element to free.
+* @param table - the table to remove from.
+* @param slot - the slot of the event.
 */
-static void free_element(Event_element element)
+static void remove_event_slot(Event_table* table,int slot)
 {
-    free(element->name);
-    Destroy_Node(element->members_head);
-    free(element);
+    slotMapRemove(table->slots,table->ids[slot]);
+    table->ids[slot]=FREE_SLOT;
+    table->date_keys[slot]=INT_MAX;
+    table->nodes[slot]=NULL;
+    table->rules[slot]=NULL;
 }
 
 /**
-* equal_element: check if two elements are equal.
+* find_event_slot: looks for the slot of an event by its id.
 *
-* @param element1 - first element.
-* @param element2 - second element.
+* @param em - the event manager to search in.
+* @param event_id - the id of the event.
 * @return
-* FALSE - if one of the elements is NULL or not equal.
-* TRUE - if they are equal.
+* -1 - if there is no such event.
+* otherwise the slot of the event.
 */
-static bool equal_element(Event_element element1,Event_element element2)
+static int find_event_slot(EventManager em,int event_id)
 {
-    if((element1&&!element2)||(!element1&&element2)){
-        return false;
-    }
-    if(strcmp(element1->name,element2->name)==0&&element1->id==element2->id)
-    {
-        return true;
-    }
-    else {
-        return false;
-    }
+    EM_LOOKUP(em);
+    EM_SCAN(em);
+    return slotMapFind(em->events.slots,event_id);
 }
 
-
-
-
-
-
-
-EventManager createEventManager(Date date)
+/**
+* find_member: looks for a member by its id.
+*
+* @param em - the event manager to search in.
+* @param member_id - the id of the member.
+* @return
+* NULL - if there is no such member.
+* otherwise the node of the member.
+*/
+static Node find_member(EventManager em,int member_id)
 {
-
-    if(!date){
-        return NULL;
-    }
-    Date   date2=dateCopy(date);
-    if(date2==NULL)
-    {
-        return NULL;
-    }
-    dateDestroy(date2);
-    EventManager eventManager=malloc(sizeof(*eventManager));
-    eventManager->queue=pqCreate((CopyPQElement) copy_element, (FreePQElement) free_element,
-                                 (EqualPQElements) equal_element, (CopyPQElementPriority) dateCopy,
-                                 (FreePQElementPriority) dateDestroy,
-                                 (ComparePQElementPriorities) date_cmp);
-    // char* a=NULL;
-    eventManager->head_events=create_in_Node(date);
-    eventManager->head_events->next=NULL;
-    eventManager->counter_num_of_events=0;
-    eventManager->begginig_date=dateCopy(date);
-    eventManager->members_in_sysem_head=create_in_Node(date);
-    eventManager->members_in_sysem_head->next=NULL;
-    eventManager->counter=0;
-    eventManager->current_event_id=-1;
-    return eventManager;
+    EM_LOOKUP(em);
+    EM_SCAN(em);
+    int slot=slotMapFind(em->member_slots,member_id);
+    return slot<0 ? NULL : em->member_nodes[slot];
 }
 
-void destroyEventManager(EventManager em)
+/**
+* member_node: returns the node of a member that is linked to an event.
+* Unlike find_member it does not count the lookup, so several threads may
+* call it at once.
+*
+* @param em - the event manager of the member.
+* @param member_id - the id of the member, linked to an event.
+* @return
+* the node of the member.
+*/
+static Node member_node(EventManager em,int member_id)
 {
-    if(em == NULL)
-    {
-        return;
-    }
-    pqDestroy(em->queue);
-    Destroy_Node(em->head_events);
-    dateDestroy(em->begginig_date);
-    Destroy_Node(em->members_in_sysem_head);
-    free(em);
+    return em->member_nodes[slotMapFind(em->member_slots,member_id)];
 }
 
 /**
-* there_is_event_the_same: check if there are two same events.
+* Link_ctx: the state of a visitor of the members of an event, see memberSetForEach.
+* member_id is the member the visit stopped at, or -1.
+*/
+typedef struct link_ctx
+{
+    EventManager em;
+    int event_id;
+    int date_key;
+    int member_id;
+    void* data;
+}Link_ctx;
+
+/**
+* add_member_slot: assigns the next slot of the member table to a new member.
 *
-* @param head - the head to check in.
-* @param date - the date of the events.
-*  @param id - the id of the event.
+* @param em - the event manager of the member.
+* @param member_id - the id of the member.
 * @return
-* FALSE - if there is no two same events.
-* otherwise TRUE.
+* -1 - if allocation fails.
+* otherwise the slot of the member.
 */
-static bool there_is_event_the_same(Node head,int id,Date date)
+static int add_member_slot(EventManager em,int member_id)
 {
-
-    Node current=head;
-    while(current!=NULL){
-        if(current->id==id){
-            break;
-        }
-        current=current->next;
-    }
-    if(!current)
+    int slot;
+    if(slotMapInsert(em->member_slots,member_id,&slot)!=SM_SUCCESS)
     {
-        return false;
+        return -1;
     }
-
-    Node current2=head;
-    while(current2!=NULL){
-        if(strcmp(current->name,current2->name)==0&&date_cmp(date,current2->date)==0){
-            return true;
+    if(slot==em->member_capacity)
+    {
+        int capacity= slot==0 ? INITIAL_MEMBER_SLOTS : slot*EXPAND_FACTOR;
+        Node* nodes=grow_column(&em->allocator,em->member_nodes,sizeof(*nodes)*slot,sizeof(*nodes)*capacity);
+        if(nodes==NULL)
+        {
+            slotMapRemove(em->member_slots,member_id);
+            return -1;
         }
-        current2=current2->next;
+        em->member_nodes=nodes;
+        em->member_capacity=capacity;
     }
-    return false;
+    return slot;
 }
 
-EventManagerResult emAddEventByDate(EventManager em, char* event_name, Date date, int event_id)
+/**
+* Destroy_Node: destroys a given node.
+*
+* @param node - the node to destroy.
+* @param allocator - the allocator the node was created with.
+*/
+static void Destroy_Node(Node node,const Allocator* allocator)
 {
-    if(em==NULL||event_name==NULL)
-    {
-        return EM_NULL_ARGUMENT;
+    if(node==NULL){
+        return;
     }
 
-    if(date==NULL)
-    {
-        return EM_INVALID_DATE;
-    }
-    if(date_cmp(em->begginig_date,date)<0){
-        return EM_INVALID_DATE;
-    }
-    if(event_id<0)
+    if(node->name==NULL&&node->date!=NULL)
     {
-        return EM_INVALID_EVENT_ID;
+        dateDestroyWithAllocator(node->date,allocator);
+        memberSetDestroy(node->members);
+        em_free(allocator,node);
+        return;
     }
 
+    Node current=node;
 
-    if(em->counter_num_of_events==0){
-
-
-        Event_element element=eventElement_create(event_name, event_id, em->counter);
-        pqInsert(em->queue,element,date);
-        free_element(element);
+    if(current->next==NULL){
+        em_free(allocator,node->name);
+        dateDestroyWithAllocator(node->date,allocator);
+        memberSetDestroy(node->members);
+        em_free(allocator,node);
+        return;
 
-        em->head_events->id=event_id;
-        char * new_name=malloc(sizeof(char)*strlen(event_name)+1);
-        strcpy( new_name,event_name);
-        em->head_events->counter=em->counter;
-        em->head_events->name=new_name;
-        if(em->head_events->date){
-            dateDestroy(em->head_events->date);
-        }
-        em->head_events->date=dateCopy(date);
-        em->counter++;
-        em->counter_num_of_events++;
-        return EM_SUCCESS;
     }
+    while (current!=NULL){
+        Node fr=current;
+        current=current->next;
+        em_free(allocator,fr->name);
+        dateDestroyWithAllocator(fr->date,allocator);
+        memberSetDestroy(fr->members);
+        em_free(allocator,fr);
+        fr=NULL;
 
-    Node currrent=em->head_events;
-    while(currrent!=NULL){
-        if(strcmp(currrent->name,event_name)==0&&date_cmp(currrent->date,date)==0)
-        {
-            return EM_EVENT_ALREADY_EXISTS;
-        }
-        if(currrent->id==event_id){
-            return EM_EVENT_ID_ALREADY_EXISTS;
-        }
-        currrent=currrent->next;
     }
 
 
-
-
-    Event_element element=eventElement_create(event_name, event_id, em->counter);
-    pqInsert(em->queue,element,date);
-    free_element(element);
-    Node new=createNode(event_name,event_id,em->counter,date);
-    new->next=em->head_events;
-    em->head_events=new;
-
-    em->counter++;
-    em->counter_num_of_events++;
-    return EM_SUCCESS;
 }
 
-
-
-EventManagerResult emAddEventByDiff(EventManager em, char* event_name, int days, int event_id)
+/**
+* account_node: adds the memory of a node, its name and its date to the
+* footprint of an event manager, or subtracts it.
+*
+* @param em - the event manager the node belongs to.
+* @param node_bytes - the category of the node itself.
+* @param node - the node.
+* @param sign - 1 when the node is added, -1 when it is removed.
+*/
+static void account_node(EventManager em,long* node_bytes,Node node,int sign)
 {
-    if(em == NULL || event_name == NULL)
-    {
-        return EM_NULL_ARGUMENT;
-    }
-    if(days < 0)
-    {
-        return EM_INVALID_DATE;
-    }
-    if(event_id < 0)
+    *node_bytes+=sign*(long)sizeof(*node);
+    if(node->name!=NULL)
     {
-        return EM_INVALID_EVENT_ID;
+        em->memory.name_strings+=sign*(long)(node->name_length+1);
     }
+    em->memory.dates+=sign*dateGetMemoryUsage(node->date);
+}
 
-    Date date_wanted1=dateCopy(em->begginig_date);
-    if(em->counter_num_of_events>0){
-        for(int i=0;i<days;i++)
-            dateTick(date_wanted1);
-        Node currrent1=em->head_events;
-        while(currrent1!=NULL){
-            if(strcmp(currrent1->name,event_name)==0&&dateCompare(currrent1->date,date_wanted1)==0){
-                dateDestroy(date_wanted1);
-                return EM_EVENT_ALREADY_EXISTS;
-            }
-
-            if(currrent1->id==event_id){
-                dateDestroy(date_wanted1);
-                return EM_EVENT_ID_ALREADY_EXISTS;
-            }
-            currrent1=currrent1->next;
+/**
+* account_event: adds the memory of an event and its member set to the
+* footprint of an event manager, or subtracts it.
+*
+* @param em - the event manager the event belongs to.
+* @param event - the event.
+* @param sign - 1 when the event is added, -1 when it is removed.
+*/
+static void account_event(EventManager em,Node event,int sign)
+{
+    account_node(em,&em->memory.event_records,event,sign);
+    em->memory.link_storage+=sign*memberSetGetMemoryUsage(event->members);
+}
+
+/**
+* account_recurrence: adds the memory of a rule and its dates to the
+* footprint of an event manager, or subtracts it.
+*
+* @param em - the event manager the rule belongs to.
+* @param rule - the rule.
+* @param sign - 1 when the rule is added, -1 when it is removed.
+*/
+static void account_recurrence(EventManager em,Recurrence rule,int sign)
+{
+    em->memory.event_records+=sign*(long)sizeof(*rule);
+    em->memory.dates+=sign*(dateGetMemoryUsage(rule->date)+dateGetMemoryUsage(rule->until));
+}
+
+/**
+* destroy_recurrence: destroys the rule of a recurring event.
+*
+* @param em - the event manager the rule belongs to.
+* @param rule - the rule to destroy, may be NULL.
+*/
+static void destroy_recurrence(EventManager em,Recurrence rule)
+{
+    if(rule==NULL)
+    {
+        return;
+    }
+    account_recurrence(em,rule,-1);
+    dateDestroyWithAllocator(rule->date,&em->allocator);
+    dateDestroyWithAllocator(rule->until,&em->allocator);
+    em_free(&em->allocator,rule);
+}
+
+/**
+* hold_views: adds a reference to the versioned views of an event manager.
+*
+* @param references - the reference count of the views.
+*/
+static void hold_views(long* references)
+{
+    __atomic_fetch_add(references,1,__ATOMIC_RELAXED);
+}
+
+/**
+* release_views: drops a reference to the versioned views of an event manager,
+* held by the event manager, by one of its snapshots or while the views are built.
+* The count is freed with its last reference, by whichever thread drops it.
+*
+* @param references - the reference count of the views, may be NULL.
+*/
+static void release_views(long* references)
+{
+    if(references!=NULL&&__atomic_sub_fetch(references,1,__ATOMIC_ACQ_REL)==0)
+    {
+        free(references);
+    }
+}
+
+/**
+* drop_views: destroys the versioned views of an event manager, once no
+* snapshot holds them or after a change could not be applied to them. The
+* snapshots taken so far keep their versions, and the next snapshot builds the
+* views again.
+*
+* @param em - the event manager whose views are destroyed.
+*/
+static void drop_views(EventManager em)
+{
+    versionTableDestroy(em->events_view);
+    versionTableDestroy(em->members_view);
+    release_views(em->view_references);
+    em->events_view=NULL;
+    em->members_view=NULL;
+    em->view_references=NULL;
+}
+
+/**
+* views_in_use: checks if an event manager has versioned views that a live
+* snapshot holds. Views that no snapshot holds any more are dropped here, so
+* changes stop rebuilding their records until the next snapshot.
+*
+* @param em - the event manager.
+* @return
+* TRUE - if the event manager has views and a change must be applied to them.
+* otherwise FALSE.
+*/
+static bool views_in_use(EventManager em)
+{
+    if(em->events_view==NULL)
+    {
+        return false;
+    }
+    if(__atomic_load_n(em->view_references,__ATOMIC_ACQUIRE)==1)
+    {
+        drop_views(em);
+        return false;
+    }
+    return true;
+}
+
+/**
+* view_link: puts the slot of a member in the record of its event in the view of the events.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx whose data is the record.
+* @return
+* TRUE, the visit goes on.
+*/
+static bool view_link(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    Event_view* view=link->data;
+    view->member_slots[view->members_num++]=member_node(link->em,member_id)->view_slot;
+    return true;
+}
+
+/**
+* view_event: puts the current record of a slot of the event table in the
+* view of the events, if a snapshot holds the views of the event manager.
+*
+* @param em - the event manager of the event.
+* @param slot - the slot of the event, a free slot empties its record.
+*/
+static void view_event(EventManager em,int slot)
+{
+    if(!views_in_use(em))
+    {
+        return;
+    }
+    Event_view* view=NULL;
+    Node event=em->events.nodes[slot];
+    if(event!=NULL)
+    {
+        int members_num= event->members==NULL ? 0 : memberSetGetSize(event->members);
+        view=versionRecordCreate(sizeof(*view)+sizeof(*view->member_slots)*members_num+event->name_length+1);
+        if(view==NULL)
+        {
+            drop_views(em);
+            return;
+        }
+        view->id=event->id;
+        view->counter=event->counter;
+        view->date_key=em->events.date_keys[slot];
+        dateGet(event->date,&view->day,&view->month,&view->year);
+        view->name_length=event->name_length;
+        view->members_num=0;
+        Link_ctx link={em,event->id,view->date_key,-1,view};
+        memberSetForEach(event->members,view_link,&link);
+        memcpy(view->member_slots+members_num,event->name,event->name_length+1);
+    }
+    if(versionTableSet(em->events_view,slot,view)!=VT_SUCCESS)
+    {
+        drop_views(em);
+    }
+}
+
+/**
+* view_member: puts the current record of a member in the view of the
+* members, if a snapshot holds the views of the event manager.
+*
+* @param em - the event manager of the member.
+* @param member - the member.
+*/
+static void view_member(EventManager em,Node member)
+{
+    if(!views_in_use(em))
+    {
+        return;
+    }
+    Member_view* view=versionRecordCreate(sizeof(*view)+member->name_length+1);
+    if(view==NULL)
+    {
+        drop_views(em);
+        return;
+    }
+    view->id=member->id;
+    view->counter=member->counter;
+    view->name_length=member->name_length;
+    memcpy(view->name,member->name,member->name_length+1);
+    if(versionTableSet(em->members_view,member->view_slot,view)!=VT_SUCCESS)
+    {
+        drop_views(em);
+    }
+}
+
+/**
+* build_views: creates the versioned views of the events and the members of
+* an event manager. From then on every change is applied to the views too, as
+* long as a snapshot holds them.
+*
+* @param em - the event manager.
+* @return
+* FALSE - if allocation fails, the event manager has no views.
+* otherwise TRUE.
+*/
+static bool build_views(EventManager em)
+{
+    em->events_view=versionTableCreate();
+    em->members_view=versionTableCreate();
+    em->view_references=malloc(sizeof(*em->view_references));
+    if(em->view_references!=NULL)
+    {
+        *em->view_references=1;
+    }
+    if(em->events_view==NULL||em->members_view==NULL||em->view_references==NULL)
+    {
+        drop_views(em);
+        return false;
+    }
+    // the views are held while they are filled, so they do not look unused
+    long* references=em->view_references;
+    hold_views(references);
+    for(int slot=0;slot<em->events.used;slot++){
+        view_event(em,slot);
+    }
+    for(Node member=em->members_in_sysem_head;member!=NULL;member=member->next){
+        if(member->name!=NULL)
+        {
+            view_member(em,member);
+        }
+    }
+    release_views(references);
+    return em->events_view!=NULL;
+}
+
+/**
+* date_cmp: compare between two given dates.
+*
+* @param date1 - the first date.
+* @param date2 - the second date.
+* @return
+* 		A positive integer if date1 occurs first;
+* 		0 if they're equal;
+*		A negative integer if date1 arrives after date2.
+*/
+static int date_cmp(Date date1, Date date2)
+{
+    return -1*dateCompare(date1,date2);
+}
+
+/**
+* date_to_key: packs a date into the number of days it contains, the same
+* way dateCompare orders dates.
+*
+* @param date - the date to pack.
+* @return
+* the date in days.
+*/
+static int date_to_key(Date date)
+{
+    int day=0;
+    int month=0;
+    int year=0;
+    dateGet(date,&day,&month,&year);
+    return day + month*(MAX_DAY - MIN_DAY + 1) + DAYS_IN_YEAR * year;
+}
+
+EventManager createEventManagerWithAllocator(Date date, const Allocator* allocator)
+{
+
+    if(!date){
+        return NULL;
+    }
+    Date   date2=dateCopyWithAllocator(date,allocator);
+    if(date2==NULL)
+    {
+        return NULL;
+    }
+    dateDestroyWithAllocator(date2,allocator);
+    EventManager eventManager=em_malloc(allocator,sizeof(*eventManager));
+    if(eventManager==NULL)
+    {
+        return NULL;
+    }
+    memset(eventManager,0,sizeof(*eventManager));
+    if(allocator!=NULL)
+    {
+        eventManager->allocator=*allocator;
+    }
+    else
+    {
+        memset(&eventManager->allocator,0,sizeof(eventManager->allocator));
+    }
+    eventManager->queue=eventQueueCreateWithAllocator(allocator);
+    // char* a=NULL;
+    eventManager->events.slots=slotMapCreateWithAllocator(allocator);
+    eventManager->counter_num_of_events=0;
+    eventManager->begginig_date=dateCopyWithAllocator(date,allocator);
+    eventManager->members_in_sysem_head=create_in_Node(date,allocator);
+    eventManager->counter=0;
+    eventManager->current_event_id=-1;
+    eventManager->events_index=eventIndexCreateWithAllocator(allocator);
+    eventManager->members_index=memberIndexCreateWithAllocator(allocator);
+    eventManager->export_workers=DEFAULT_EXPORT_WORKERS;
+    eventManager->changes=changeLogCreateWithAllocator(allocator);
+    eventManager->notifications=NULL;
+    eventManager->events_view=NULL;
+    eventManager->members_view=NULL;
+    eventManager->view_references=NULL;
+    eventManager->members_num=0;
+    eventManager->member_slots=slotMapCreateWithAllocator(allocator);
+    eventManager->member_nodes=NULL;
+    eventManager->member_capacity=0;
+    eventManager->bookings=NULL;
+    eventManager->max_event_members=0;
+    eventManager->max_member_events_per_date=0;
+    if(eventManager->queue==NULL||eventManager->events.slots==NULL||eventManager->begginig_date==NULL||
+       eventManager->members_in_sysem_head==NULL||eventManager->events_index==NULL||
+       eventManager->members_index==NULL||eventManager->changes==NULL||eventManager->member_slots==NULL)
+    {
+        destroyEventManager(eventManager);
+        return NULL;
+    }
+    eventManager->memory.dates=dateGetMemoryUsage(eventManager->begginig_date);
+    account_node(eventManager,&eventManager->memory.member_table,eventManager->members_in_sysem_head,1);
+#ifdef ENABLE_STATS
+    memset(&eventManager->stats,0,sizeof(eventManager->stats));
+    eventManager->stats.enabled=true;
+#endif
+    return eventManager;
+}
+
+EventManager createEventManager(Date date)
+{
+    return createEventManagerWithAllocator(date,NULL);
+}
+
+void destroyEventManager(EventManager em)
+{
+    if(em == NULL)
+    {
+        return;
+    }
+    eventQueueDestroy(em->queue);
+    for(int i=0;i<em->events.used;i++){
+        if(em->events.ids[i]!=FREE_SLOT)
+        {
+            Destroy_Node(em->events.nodes[i],&em->allocator);
+            destroy_recurrence(em,em->events.rules[i]);
+        }
+    }
+    Allocator allocator=em->allocator;
+    allocatorFree(&allocator,em->events.ids);
+    allocatorFree(&allocator,em->events.date_keys);
+    allocatorFree(&allocator,em->events.counters);
+    allocatorFree(&allocator,em->events.name_hashes);
+    allocatorFree(&allocator,em->events.nodes);
+    allocatorFree(&allocator,em->events.rules);
+    slotMapDestroy(em->events.slots);
+    allocatorFree(&allocator,em->member_nodes);
+    slotMapDestroy(em->member_slots);
+    dateDestroyWithAllocator(em->begginig_date,&allocator);
+    Destroy_Node(em->members_in_sysem_head,&allocator);
+    changeLogDestroy(em->changes);
+    notificationRingDestroy(em->notifications);
+    drop_views(em);
+    bookingIndexDestroy(em->bookings);
+    eventIndexDestroy(em->events_index);
+    memberIndexDestroy(em->members_index);
+    em_free(&allocator,em);
+}
+
+/**
+* there_is_event_the_same: check if there are two same events.
+*
+* @param em - the event manager to check in.
+* @param id - the id of the event.
+* @param date - the date of the events, NULL matches any date as in dateCompare.
+* @return
+* FALSE - if there is no two same events.
+* otherwise TRUE.
+*/
+static bool there_is_event_the_same(EventManager em,int id,Date date)
+{
+    int slot=find_event_slot(em,id);
+    if(slot<0)
+    {
+        return false;
+    }
+    Event_table* table=&em->events;
+    const char* name=table->nodes[slot]->name;
+    const int* name_hashes=(const int*)table->name_hashes;
+    int name_hash=name_hashes[slot];
+    int date_key= date==NULL ? 0 : date_to_key(date);
+    int i=-1;
+    while(true){
+        if(date==NULL)
+        {
+            i=eventScanFind(name_hashes,i+1,table->used,name_hash);
+        }
+        else
+        {
+            i=eventScanFindPair(table->date_keys,name_hashes,i+1,table->used,date_key,name_hash);
+        }
+        if(i<0)
+        {
+            return false;
+        }
+        if(table->ids[i]!=FREE_SLOT&&strcmp(table->nodes[i]->name,name)==0)
+        {
+            return true;
+        }
+    }
+}
+
+/**
+* check_new_event: checks that an event can be added next to the existing ones.
+* When several events conflict the latest one decides the result, as the
+* events were once checked from the latest to the earliest.
+*
+* @param em - the event manager to check in.
+* @param event_name - the name of the new event.
+* @param date_key - the packed date of the new event.
+* @param event_id - the id of the new event.
+* @return
+* EM_EVENT_ALREADY_EXISTS - if an event with the same name is on the same date.
+* EM_EVENT_ID_ALREADY_EXISTS - if an event has the same id.
+* otherwise EM_SUCCESS.
+*/
+static EventManagerResult check_new_event(EventManager em,char* event_name,int date_key,int event_id)
+{
+    Event_table* table=&em->events;
+    const int* name_hashes=(const int*)table->name_hashes;
+    int name_hash=(int)hash_name(event_name);
+    int same_event=-1;
+    int same_id=-1;
+    EM_LOOKUP(em);
+    EM_STAT_ADD(em,nodes_scanned,table->used);
+    int id_slot=slotMapFind(table->slots,event_id);
+    if(id_slot>=0)
+    {
+        same_id=table->counters[id_slot];
+    }
+    int i=eventScanFindPair(table->date_keys,name_hashes,0,table->used,date_key,name_hash);
+    while(i>=0){
+        if(table->counters[i]>same_event&&strcmp(table->nodes[i]->name,event_name)==0)
+        {
+            same_event=table->counters[i];
+        }
+        i=eventScanFindPair(table->date_keys,name_hashes,i+1,table->used,date_key,name_hash);
+    }
+    if(same_event>=0&&same_event>=same_id)
+    {
+        return EM_EVENT_ALREADY_EXISTS;
+    }
+    if(same_id>=0)
+    {
+        return EM_EVENT_ID_ALREADY_EXISTS;
+    }
+    return EM_SUCCESS;
+}
+
+/**
+* record_change: records in the change log that an event was added, removed,
+* moved to another date, or had its members changed, and publishes the change
+* to the notification ring if there is one. A change that cannot be stored
+* only makes the earlier versions unavailable to emExportDelta.
+*
+* @param em - the event manager the event belongs to.
+* @param kind - the change.
+* @param event_id - the id of the event.
+* @param member_id - the member linked or unlinked, -1 for other changes.
+* @param date - the date of the event after the change.
+*/
+static void record_change(EventManager em,NotificationKind kind,int event_id,int member_id,Date date)
+{
+    changeLogRecord(em->changes,event_id);
+    if(em->notifications==NULL)
+    {
+        return;
+    }
+    Notification notification={changeLogGetVersion(em->changes),kind,event_id,member_id,0,0,0};
+    dateGet(date,&notification.day,&notification.month,&notification.year);
+    notificationRingPublish(em->notifications,&notification);
+}
+
+/**
+* insert_event: adds a new event that was already checked.
+*
+* @param em - the event manager to add to.
+* @param event_name - the name of the event.
+* @param date - the date of the event.
+* @param event_id - the id of the event.
+* @return
+* EM_OUT_OF_MEMORY - if allocation fails.
+* otherwise EM_SUCCESS.
+*/
+static EventManagerResult insert_event(EventManager em,char* event_name,Date date,int event_id)
+{
+    Node event=createNode(event_name,event_id,em->counter,date,&em->allocator);
+    if(event==NULL)
+    {
+        return EM_OUT_OF_MEMORY;
+    }
+    int date_key=date_to_key(date);
+    int slot=add_event_slot(&em->events,event,date_key,&em->allocator);
+    if(slot<0)
+    {
+        Destroy_Node(event,&em->allocator);
+        return EM_OUT_OF_MEMORY;
+    }
+    if(eventQueueInsert(em->queue,slot,date_key)!=PQ_SUCCESS)
+    {
+        remove_event_slot(&em->events,slot);
+        Destroy_Node(event,&em->allocator);
+        return EM_OUT_OF_MEMORY;
+    }
+    if(eventIndexInsert(em->events_index,date_key,em->counter,event)!=EI_SUCCESS)
+    {
+        eventQueueRemoveElement(em->queue,slot);
+        remove_event_slot(&em->events,slot);
+        Destroy_Node(event,&em->allocator);
+        return EM_OUT_OF_MEMORY;
+    }
+    account_event(em,event,1);
+    em->counter++;
+    em->counter_num_of_events++;
+    view_event(em,slot);
+    record_change(em,NOTIFY_EVENT_ADDED,event_id,-1,date);
+    return EM_SUCCESS;
+}
+
+/**
+* add_event_by_date: the implementation of emAddEventByDate, see event_manager.h.
+*/
+static EventManagerResult add_event_by_date(EventManager em, char* event_name, Date date, int event_id)
+{
+    if(em==NULL||event_name==NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+
+    if(date==NULL)
+    {
+        return EM_INVALID_DATE;
+    }
+    if(date_cmp(em->begginig_date,date)<0){
+        return EM_INVALID_DATE;
+    }
+    if(event_id<0)
+    {
+        return EM_INVALID_EVENT_ID;
+    }
+    EventManagerResult result=check_new_event(em,event_name,date_to_key(date),event_id);
+    if(result!=EM_SUCCESS)
+    {
+        return result;
+    }
+    return insert_event(em,event_name,date,event_id);
+}
+
+EventManagerResult emAddEventByDate(EventManager em, char* event_name, Date date, int event_id)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=add_event_by_date(em,event_name,date,event_id);
+    EM_TIMER_RECORD(em,EM_CALL_ADD_EVENT_BY_DATE,timer);
+    return result;
+}
+
+
+
+/**
+* add_event_by_diff: the implementation of emAddEventByDiff, see event_manager.h.
+*/
+static EventManagerResult add_event_by_diff(EventManager em, char* event_name, int days, int event_id)
+{
+    if(em == NULL || event_name == NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+    if(days < 0)
+    {
+        return EM_INVALID_DATE;
+    }
+    if(event_id < 0)
+    {
+        return EM_INVALID_EVENT_ID;
+    }
+
+    Date date_wanted=dateCopyWithAllocator(em->begginig_date,&em->allocator);
+    if(date_wanted==NULL)
+    {
+        return EM_OUT_OF_MEMORY;
+    }
+    for(int i=0;i<days;i++)
+        dateTick(date_wanted);
+    EventManagerResult result=check_new_event(em,event_name,date_to_key(date_wanted),event_id);
+    if(result==EM_SUCCESS)
+    {
+        result=insert_event(em,event_name,date_wanted,event_id);
+    }
+    dateDestroyWithAllocator(date_wanted,&em->allocator);
+    return result;
+}
+
+EventManagerResult emAddEventByDiff(EventManager em, char* event_name, int days, int event_id)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=add_event_by_diff(em,event_name,days,event_id);
+    EM_TIMER_RECORD(em,EM_CALL_ADD_EVENT_BY_DIFF,timer);
+    return result;
+}
+
+
+
+/**
+* dec_one_from_member: remove one member.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx of the event the member is removed from.
+* @return
+* TRUE, the visit goes on.
+*/
+
+static bool dec_one_from_member(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    Node cur=find_member(link->em,member_id);
+    if(cur!=NULL){
+        cur->counter--;
+        view_member(link->em,cur);
+    }
+    return true;
+}
+
+/**
+* unlink_member: removes the link of a member to an event from the member
+* index and the bookings.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx of the event the member is removed from.
+* @return
+* TRUE, the visit goes on.
+*/
+static bool unlink_member(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    memberIndexUnlink(link->em->members_index,member_id,link->event_id);
+    bookingIndexRemove(link->em->bookings,member_id,link->date_key);
+    return true;
+}
+
+/**
+* release_event_members: updates the members of an event that is removed.
+*
+* @param em - event manager the event is removed from.
+* @param event - the event that is removed.
+*/
+static void release_event_members(EventManager em,Node event)
+{
+    Link_ctx link={em,event->id,date_to_key(event->date),-1,NULL};
+    memberSetForEach(event->members,dec_one_from_member,&link);
+    memberSetForEach(event->members,unlink_member,&link);
+}
+
+/**
+* detach_event_at: removes an event from the event table and the date index,
+* leaving its node and its members as they are.
+* The rule of a recurring event is destroyed with it, so a rule that should go
+* on must be taken out of the event table first.
+*
+* @param em - event manager the event is removed from.
+* @param slot - the slot of the event in the event table.
+* @param kind - NOTIFY_EVENT_REMOVED or NOTIFY_EVENT_EXPIRED.
+*/
+static void detach_event_at(EventManager em,int slot,NotificationKind kind)
+{
+    eventIndexRemove(em->events_index,em->events.date_keys[slot],em->events.counters[slot]);
+    record_change(em,kind,em->events.ids[slot],-1,em->events.nodes[slot]->date);
+    destroy_recurrence(em,em->events.rules[slot]);
+    remove_event_slot(&em->events,slot);
+    view_event(em,slot);
+    em->counter_num_of_events--;
+}
+
+/**
+* remove_event_at: removes an event from the event manager, except for the queue.
+* The rule of a recurring event is destroyed with it, see detach_event_at.
+*
+* @param em - event manager the event is removed from.
+* @param slot - the slot of the event in the event table.
+* @param kind - NOTIFY_EVENT_REMOVED or NOTIFY_EVENT_EXPIRED.
+*/
+static void remove_event_at(EventManager em,int slot,NotificationKind kind)
+{
+    Node event=em->events.nodes[slot];
+    release_event_members(em,event);
+    detach_event_at(em,slot,kind);
+    account_event(em,event,-1);
+    Destroy_Node(event,&em->allocator);
+}
+
+/**
+* remove_event: the implementation of emRemoveEvent, see event_manager.h.
+*/
+static EventManagerResult remove_event(EventManager em, int event_id)
+{
+
+    if(em==NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+    if(event_id<0)
+    {
+        return EM_INVALID_EVENT_ID;
+    }
+    int slot=find_event_slot(em,event_id);
+    if(slot<0)
+    {
+        return EM_EVENT_NOT_EXISTS;
+    }
+    eventQueueRemoveElement(em->queue,slot);
+    remove_event_at(em,slot,NOTIFY_EVENT_REMOVED);
+    return EM_SUCCESS;
+}
+
+EventManagerResult emRemoveEvent(EventManager em, int event_id)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=remove_event(em,event_id);
+    EM_TIMER_RECORD(em,EM_CALL_REMOVE_EVENT,timer);
+    return result;
+}
+
+
+
+/**
+* check_booking: checks that a member may get one more event on a date.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx with the date, member_id is set when the member may not.
+* @return
+* FALSE - if the member already has the most events allowed on the date.
+* otherwise TRUE.
+*/
+static bool check_booking(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    if(bookingIndexGetCount(link->em->bookings,member_id,link->date_key)>=link->em->max_member_events_per_date)
+    {
+        link->member_id=member_id;
+        return false;
+    }
+    return true;
+}
+
+/**
+* add_booking: counts one more event of a member on a date.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx with the date, member_id is set when allocation fails.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool add_booking(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    if(bookingIndexAdd(link->em->bookings,member_id,link->date_key)!=BI_SUCCESS)
+    {
+        link->member_id=member_id;
+        return false;
+    }
+    return true;
+}
+
+/**
+* remove_booking: counts one less event of a member on a date, for the
+* members before member_id of the Link_ctx, or all of them if it is -1.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx with the date.
+* @return
+* FALSE - if the member is the member_id of the Link_ctx.
+* otherwise TRUE.
+*/
+static bool remove_booking(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    if(member_id==link->member_id)
+    {
+        return false;
+    }
+    bookingIndexRemove(link->em->bookings,member_id,link->date_key);
+    return true;
+}
+
+/**
+* move_bookings: moves the bookings of the members of an event to a new date,
+* when the number of events per member and date is limited.
+*
+* @param em - the event manager of the event.
+* @param event - the event that is moved.
+* @param old_key - the packed date of the event.
+* @param new_key - the packed new date of the event.
+* @return
+* EM_MEMBER_DATE_CONFLICT - if a member already has the most events allowed on the new date.
+* EM_OUT_OF_MEMORY - if allocation fails.
+* In both cases the bookings are unchanged.
+* otherwise EM_SUCCESS.
+*/
+static EventManagerResult move_bookings(EventManager em,Node event,int old_key,int new_key)
+{
+    if(em->bookings==NULL||old_key==new_key)
+    {
+        return EM_SUCCESS;
+    }
+    Link_ctx link={em,event->id,new_key,-1,NULL};
+    memberSetForEach(event->members,check_booking,&link);
+    if(link.member_id>=0)
+    {
+        return EM_MEMBER_DATE_CONFLICT;
+    }
+    memberSetForEach(event->members,add_booking,&link);
+    if(link.member_id>=0)
+    {
+        memberSetForEach(event->members,remove_booking,&link);
+        return EM_OUT_OF_MEMORY;
+    }
+    link.date_key=old_key;
+    memberSetForEach(event->members,remove_booking,&link);
+    return EM_SUCCESS;
+}
+
+/**
+* move_member_event: moves an event of a member to the date of a Link_ctx in the member index.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx of the event with its new date.
+* @return
+* TRUE, the visit goes on.
+*/
+static bool move_member_event(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    memberIndexMoveEvent(link->em->members_index,member_id,link->event_id,link->date_key);
+    return true;
+}
+
+/**
+* change_event_date: the implementation of emChangeEventDate, see event_manager.h.
+*/
+static EventManagerResult change_event_date(EventManager em, int event_id, Date new_date)
+{
+    if(em == NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+    if(date_cmp(new_date,em->begginig_date) > 0)
+    {
+        return EM_INVALID_DATE;
+    }
+    if(event_id < 0)
+    {
+        return EM_INVALID_EVENT_ID;
+    }
+    if(there_is_event_the_same(em,event_id,new_date))
+    {
+        return EM_EVENT_ALREADY_EXISTS;
+    }
+    int slot=find_event_slot(em,event_id);
+    if(slot<0)
+    {
+        return EM_EVENT_ID_NOT_EXISTS;
+    }
+    Node current=em->events.nodes[slot];
+    int old_key=em->events.date_keys[slot];
+    int new_key=date_to_key(new_date);
+    Date date=dateCopyWithAllocator(new_date,&em->allocator);
+    if(date==NULL)
+    {
+        return EM_OUT_OF_MEMORY;
+    }
+    if(new_key!=old_key&&eventIndexInsert(em->events_index,new_key,current->counter,current)!=EI_SUCCESS)
+    {
+        dateDestroyWithAllocator(date,&em->allocator);
+        return EM_OUT_OF_MEMORY;
+    }
+    EventManagerResult booked=move_bookings(em,current,old_key,new_key);
+    if(booked!=EM_SUCCESS)
+    {
+        if(new_key!=old_key)
+        {
+            eventIndexRemove(em->events_index,new_key,current->counter);
+        }
+        dateDestroyWithAllocator(date,&em->allocator);
+        return booked;
+    }
+    if(new_key!=old_key)
+    {
+        eventIndexRemove(em->events_index,old_key,current->counter);
+    }
+    eventQueueChangePriority(em->queue,slot,old_key,new_key);
+    Link_ctx link={em,event_id,new_key,-1,NULL};
+    memberSetForEach(current->members,move_member_event,&link);
+    em->events.date_keys[slot]=new_key;
+    em->memory.dates-=dateGetMemoryUsage(current->date);
+    dateDestroyWithAllocator(current->date,&em->allocator);
+    current->date = date;
+    em->memory.dates+=dateGetMemoryUsage(current->date);
+    view_event(em,slot);
+    record_change(em,NOTIFY_EVENT_DATE_CHANGED,event_id,-1,new_date);
+    return EM_SUCCESS;
+}
+
+EventManagerResult emChangeEventDate(EventManager em, int event_id, Date new_date)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=change_event_date(em,event_id,new_date);
+    EM_TIMER_RECORD(em,EM_CALL_CHANGE_EVENT_DATE,timer);
+    return result;
+}
+
+/**
+* add_member: the implementation of emAddMember, see event_manager.h.
+*/
+static EventManagerResult add_member(EventManager em, char* member_name, int member_id)
+{
+    if(em==NULL||member_name==NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+    if(member_id<0)
+    {
+        return EM_INVALID_MEMBER_ID;
+    }
+    if(find_member(em,member_id)!=NULL){
+        return EM_MEMBER_ID_ALREADY_EXISTS;
+    }
+    // the first member takes over the empty head of the list, the others get a node
+    bool first=em->members_in_sysem_head->name==NULL;
+    char * new_name=NULL;
+    Node new_mem=NULL;
+    if(first){
+        new_name=em_malloc(&em->allocator,sizeof(char)*(strlen(member_name)+1));
+        if(new_name==NULL){
+            return EM_OUT_OF_MEMORY;
+        }
+        strcpy(new_name,member_name);
+    }
+    else{
+        new_mem=createNode(member_name,member_id,0,em->begginig_date,&em->allocator);
+        if(new_mem==NULL){
+            return EM_OUT_OF_MEMORY;
+        }
+    }
+    int slot=add_member_slot(em,member_id);
+    if(slot>=0&&memberIndexAddMember(em->members_index,member_id)!=MI_SUCCESS){
+        slotMapRemove(em->member_slots,member_id);
+        slot=-1;
+    }
+    if(slot<0){
+        em_free(&em->allocator,new_name);
+        Destroy_Node(new_mem,&em->allocator);
+        return EM_OUT_OF_MEMORY;
+    }
+    if(first){
+        account_node(em,&em->memory.member_table,em->members_in_sysem_head,-1);
+        em->members_in_sysem_head->name=new_name;
+        em->members_in_sysem_head->name_length=(int)strlen(member_name);
+        em->members_in_sysem_head->id=member_id;
+        em->members_in_sysem_head->counter=0;
+        if(em->members_in_sysem_head->date)
+            dateDestroyWithAllocator(em->members_in_sysem_head->date,&em->allocator);
+        em->members_in_sysem_head->date=NULL;
+        em->members_in_sysem_head->next=NULL;
+        em->members_in_sysem_head->view_slot=slot;
+        em->member_nodes[slot]=em->members_in_sysem_head;
+        em->members_num++;
+        account_node(em,&em->memory.member_table,em->members_in_sysem_head,1);
+        view_member(em,em->members_in_sysem_head);
+        return EM_SUCCESS;
+    }
+    new_mem->next=em->members_in_sysem_head;
+    em->members_in_sysem_head=new_mem;
+    new_mem->view_slot=slot;
+    em->member_nodes[slot]=new_mem;
+    em->members_num++;
+    account_node(em,&em->memory.member_table,new_mem,1);
+    //em->members_in_sysem_head->counter++;
+    view_member(em,new_mem);
+    return EM_SUCCESS;
+}
+
+EventManagerResult emAddMember(EventManager em, char* member_name, int member_id)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=add_member(em,member_name,member_id);
+    EM_TIMER_RECORD(em,EM_CALL_ADD_MEMBER,timer);
+    return result;
+}
+
+
+/**
+* add_member_to_event: the implementation of emAddMemberToEvent, see event_manager.h.
+*/
+static EventManagerResult add_member_to_event(EventManager em, int member_id, int event_id)
+{
+    if(em == NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+    if(event_id < 0)
+    {
+        return EM_INVALID_EVENT_ID;
+    }
+    if(member_id < 0)
+    {
+        return EM_INVALID_MEMBER_ID;
+    }
+
+    int slot=find_event_slot(em,event_id);
+    if(slot<0){
+        return EM_EVENT_ID_NOT_EXISTS;
+    }
+    Node cur=em->events.nodes[slot];
+
+
+    Node current = find_member(em,member_id);
+    if(current==NULL){
+        return EM_MEMBER_ID_NOT_EXISTS;
+    }
+    if(memberSetContains(cur->members,member_id)){
+        return EM_EVENT_AND_MEMBER_ALREADY_LINKED;
+    }
+    if(em->max_event_members>0&&memberSetGetSize(cur->members)>=em->max_event_members){
+        return EM_EVENT_MEMBERS_LIMIT_REACHED;
+    }
+    int date_key=em->events.date_keys[slot];
+    if(em->bookings!=NULL){
+        if(bookingIndexGetCount(em->bookings,member_id,date_key)>=em->max_member_events_per_date){
+            return EM_MEMBER_DATE_CONFLICT;
+        }
+        if(bookingIndexAdd(em->bookings,member_id,date_key)!=BI_SUCCESS){
+            return EM_OUT_OF_MEMORY;
+        }
+    }
+    if(memberIndexLink(em->members_index,member_id,event_id,date_key,cur->counter)!=MI_SUCCESS){
+        if(em->bookings!=NULL){
+            bookingIndexRemove(em->bookings,member_id,date_key);
+        }
+        return EM_OUT_OF_MEMORY;
+    }
+    long set_bytes=memberSetGetMemoryUsage(cur->members);
+    if(cur->members==NULL){
+        cur->members=memberSetCreateWithAllocator(&em->allocator);
+    }
+    if(cur->members==NULL||memberSetAdd(cur->members,member_id)!=MS_SUCCESS){
+        // an empty set that was just created is kept, the event may get members later
+        em->memory.link_storage+=memberSetGetMemoryUsage(cur->members)-set_bytes;
+        memberIndexUnlink(em->members_index,member_id,event_id);
+        if(em->bookings!=NULL){
+            bookingIndexRemove(em->bookings,member_id,date_key);
+        }
+        return EM_OUT_OF_MEMORY;
+    }
+    // the event goes behind the other events of its date, as if it was inserted again,
+    // which only emGetNextEvent observes
+    eventQueueChangePriority(em->queue,slot,date_key,date_key);
+    current->counter++;
+    em->memory.link_storage+=memberSetGetMemoryUsage(cur->members)-set_bytes;
+    view_event(em,slot);
+    view_member(em,current);
+    record_change(em,NOTIFY_MEMBER_LINKED,event_id,member_id,cur->date);
+    return EM_SUCCESS;
+}
+
+EventManagerResult emAddMemberToEvent(EventManager em, int member_id, int event_id)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=add_member_to_event(em,member_id,event_id);
+    EM_TIMER_RECORD(em,EM_CALL_ADD_MEMBER_TO_EVENT,timer);
+    return result;
+}
+
+/**
+* remove_member_from_event: the implementation of emRemoveMemberFromEvent, see event_manager.h.
+*/
+static EventManagerResult remove_member_from_event(EventManager em, int member_id, int event_id)
+{
+    if(em==NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+    if(member_id<0)
+    {
+        return EM_INVALID_MEMBER_ID;
+    }
+    if(event_id<0)
+    {
+        return EM_INVALID_EVENT_ID;
+    }
+    Node current=find_member(em,member_id);
+    if(current==NULL){
+        return EM_MEMBER_ID_NOT_EXISTS;
+    }
+    int slot=find_event_slot(em,event_id);
+    if(slot<0){
+        return EM_EVENT_ID_NOT_EXISTS;
+    }
+    Node current_event=em->events.nodes[slot];
+    if(!memberSetContains(current_event->members,member_id))
+    {
+        return EM_EVENT_AND_MEMBER_NOT_LINKED;
+    }
+    eventQueueChangePriority(em->queue,slot,em->events.date_keys[slot],em->events.date_keys[slot]);
+    current->counter--;
+    long set_bytes=memberSetGetMemoryUsage(current_event->members);
+    memberSetRemove(current_event->members,member_id);
+    em->memory.link_storage+=memberSetGetMemoryUsage(current_event->members)-set_bytes;
+    memberIndexUnlink(em->members_index,member_id,event_id);
+    bookingIndexRemove(em->bookings,member_id,em->events.date_keys[slot]);
+    view_event(em,slot);
+    view_member(em,current);
+    record_change(em,NOTIFY_MEMBER_UNLINKED,event_id,member_id,current_event->date);
+    return EM_SUCCESS;
+}
+
+EventManagerResult emRemoveMemberFromEvent(EventManager em, int member_id, int event_id)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=remove_member_from_event(em,member_id,event_id);
+    EM_TIMER_RECORD(em,EM_CALL_REMOVE_MEMBER_FROM_EVENT,timer);
+    return result;
+}
+
+
+
+
+/**
+* has_occurrence: checks if the current occurrence of a rule is in its bounds.
+*
+* @param rule - the rule to check.
+* @return
+* FALSE - if the rule ran out of occurrences or of ids.
+* otherwise TRUE.
+*/
+static bool has_occurrence(Recurrence rule)
+{
+    return (rule->count==0||rule->index<rule->count)&&
+           (rule->until==NULL||dateCompare(rule->date,rule->until)<=0)&&
+           rule->index<=INT_MAX-rule->base_id;
+}
+
+/**
+* relink_member: links a member of an expired occurrence to the next occurrence.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx of the next occurrence.
+* @return
+* TRUE, the visit goes on.
+*/
+static bool relink_member(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    add_member_to_event(link->em,member_id,link->event_id);
+    return true;
+}
+
+/**
+* schedule_next_occurrence: creates the next occurrence of a recurring event
+* whose current occurrence expired, linked to the same members. Occurrences
+* before today, and occurrences whose id or name and date are taken by
+* another event, are skipped. Members whose link would break a limit set by
+* emSetMemberLimits are left out of the new occurrence.
+*
+* @param em - the event manager of the event.
+* @param rule - the rule of the event, taken out of the event table.
+* @param expired - the expired occurrence, still in the event manager.
+* @param today - the packed current date.
+* @return
+* FALSE - if the rule has no more occurrences or allocation fails.
+* otherwise TRUE, the rule belongs to the new occurrence.
+*/
+static bool schedule_next_occurrence(EventManager em,Recurrence rule,Node expired,int today)
+{
+    while(true){
+        for(int i=0;i<rule->period_days;i++)
+            dateTick(rule->date);
+        rule->index++;
+        if(!has_occurrence(rule))
+        {
+            return false;
+        }
+        int date_key=date_to_key(rule->date);
+        int event_id=rule->base_id+rule->index;
+        if(date_key<today||check_new_event(em,expired->name,date_key,event_id)!=EM_SUCCESS)
+        {
+            continue;
+        }
+        if(insert_event(em,expired->name,rule->date,event_id)!=EM_SUCCESS)
+        {
+            return false;
         }
+        em->events.rules[find_event_slot(em,event_id)]=rule;
+        Link_ctx link={em,event_id,date_key,-1,NULL};
+        memberSetForEach(expired->members,relink_member,&link);
+        return true;
     }
-    dateDestroy(date_wanted1);
-
-
-    Node current=em->head_events;
-    if(current->name==NULL&&current->id==0&&current->counter==0){
-        Date date_wanted=dateCopy(em->begginig_date);
-
-        for(int i=0;i<days;i++)
-            dateTick(date_wanted);
-        char * new_name=malloc(sizeof(char)*strlen(event_name)+1);
-        strcpy(new_name,event_name);
-        current->name=new_name;
-        current->id = event_id;
-        current->counter=em->counter;
-        dateDestroy(current->date);
-        current->date=dateCopy(date_wanted);
-        current->next=NULL;
-        Event_element event = eventElement_create(current->name,current->id,em->counter);
-        pqInsert(em->queue,event,date_wanted);
-        free_element(event);
-        dateDestroy(date_wanted);
-        em->counter_num_of_events +=1;
-        em->counter+=1;
-        return EM_SUCCESS;
+}
+
+EventManagerResult emAddRecurringEvent(EventManager em, char* event_name, Date first_date,
+                                       int period_days, int count, Date until, int base_id)
+{
+    if(em==NULL||event_name==NULL)
+    {
+        return EM_NULL_ARGUMENT;
+    }
+    if(first_date==NULL||date_cmp(em->begginig_date,first_date)<0||period_days<=0||
+       (until!=NULL&&dateCompare(first_date,until)>0))
+    {
+        return EM_INVALID_DATE;
+    }
+    if(base_id<0)
+    {
+        return EM_INVALID_EVENT_ID;
+    }
+    if(count<0)
+    {
+        return EM_ERROR;
+    }
+    EventManagerResult result=check_new_event(em,event_name,date_to_key(first_date),base_id);
+    if(result!=EM_SUCCESS)
+    {
+        return result;
+    }
+    Recurrence rule=em_malloc(&em->allocator,sizeof(*rule));
+    if(rule==NULL)
+    {
+        return EM_OUT_OF_MEMORY;
+    }
+    rule->date=dateCopyWithAllocator(first_date,&em->allocator);
+    rule->until= until==NULL ? NULL : dateCopyWithAllocator(until,&em->allocator);
+    rule->period_days=period_days;
+    rule->count=count;
+    rule->index=0;
+    rule->base_id=base_id;
+    account_recurrence(em,rule,1);
+    if(rule->date==NULL||(until!=NULL&&rule->until==NULL))
+    {
+        destroy_recurrence(em,rule);
+        return EM_OUT_OF_MEMORY;
+    }
+    result=insert_event(em,event_name,first_date,base_id);
+    if(result!=EM_SUCCESS)
+    {
+        destroy_recurrence(em,rule);
+        return result;
+    }
+    em->events.rules[find_event_slot(em,base_id)]=rule;
+    return EM_SUCCESS;
+}
+
+/**
+* count_link: counts a link of a member in an array indexed by the slots of the members.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx whose data is the array.
+* @return
+* TRUE, the visit goes on.
+*/
+static bool count_link(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    int* counts=link->data;
+    counts[member_node(link->em,member_id)->view_slot]++;
+    return true;
+}
+
+/**
+* release_links: subtracts the links of a member counted by count_link from
+* its counter, the first time the member is visited.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx whose data is the array of count_link.
+* @return
+* TRUE, the visit goes on.
+*/
+static bool release_links(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    int* counts=link->data;
+    Node member=member_node(link->em,member_id);
+    if(counts[member->view_slot]>0)
+    {
+        member->counter-=counts[member->view_slot];
+        counts[member->view_slot]=0;
+        view_member(link->em,member);
+    }
+    return true;
+}
+
+/**
+* release_expired_members: updates the members of events that expired
+* together. The links are counted per member in an array indexed by the slots
+* of the members, so the counter and the view of every member are updated once.
+*
+* @param em - event manager the events are removed from.
+* @param expired - the expired events.
+* @param expired_num - the number of expired events.
+*/
+static void release_expired_members(EventManager em,Node* expired,int expired_num)
+{
+    int links_num=0;
+    for(int i=0;i<expired_num;i++){
+        Link_ctx link={em,expired[i]->id,date_to_key(expired[i]->date),-1,NULL};
+        memberSetForEach(expired[i]->members,unlink_member,&link);
+        links_num+= expired[i]->members==NULL ? 0 : memberSetGetSize(expired[i]->members);
+    }
+    if(links_num==0)
+    {
+        return;
+    }
+    int* counts=em_malloc(&em->allocator,sizeof(*counts)*em->members_num);
+    Link_ctx link={em,-1,0,-1,counts};
+    if(counts==NULL)
+    {
+        for(int i=0;i<expired_num;i++){
+            memberSetForEach(expired[i]->members,dec_one_from_member,&link);
+        }
+        return;
+    }
+    memset(counts,0,sizeof(*counts)*em->members_num);
+    for(int i=0;i<expired_num;i++){
+        memberSetForEach(expired[i]->members,count_link,&link);
+    }
+    for(int i=0;i<expired_num;i++){
+        memberSetForEach(expired[i]->members,release_links,&link);
+    }
+    em_free(&em->allocator,counts);
+}
+
+/**
+* Expired_ctx: the expired events collected from the date index.
+*/
+typedef struct expired_ctx
+{
+    Node* nodes;
+    int size;
+    int capacity;
+}Expired_ctx;
+
+/**
+* collect_expired: adds an event of the date index to an Expired_ctx.
+*
+* @param date_key - the packed date of the event.
+* @param order - the insertion counter of the event.
+* @param data - the node of the event.
+* @param ctx - the Expired_ctx.
+* @return
+* FALSE if the Expired_ctx is full.
+* otherwise TRUE.
+*/
+static bool collect_expired(int date_key,int order,void* data,void* ctx)
+{
+    Expired_ctx* expired=ctx;
+    expired->nodes[expired->size++]=data;
+    return expired->size<expired->capacity;
+}
+
+/**
+* expire_first_event: removes the earliest event, which expired, on its own.
+* The event is the first of the date index rather than of the queue, where
+* linking members moves events behind the others of their date.
+*
+* @param em - the event manager to remove from.
+* @param today - the packed current date.
+* @param callback - called on the event before it is removed, may be NULL.
+* @param ctx - passed as is to callback.
+*/
+static void expire_first_event(EventManager em,int today,EventExpiryCallback callback,void* ctx)
+{
+    Node event=NULL;
+    Expired_ctx first={&event,0,1};
+    eventIndexForEachRange(em->events_index,INT_MIN,today-1,collect_expired,&first);
+    int slot=find_event_slot(em,event->id);
+    eventQueueRemoveElement(em->queue,slot);
+    Recurrence rule=em->events.rules[slot];
+    em->events.rules[slot]=NULL;
+    if(callback!=NULL)
+    {
+        callback(event->name,event->id,event->date,ctx);
+    }
+    if(rule!=NULL&&!schedule_next_occurrence(em,rule,event,today))
+    {
+        destroy_recurrence(em,rule);
+    }
+    remove_event_at(em,slot,NOTIFY_EVENT_EXPIRED);
+}
+
+/**
+* expire_events: removes all the events earlier than today in one pass. The
+* expired events are at the front of the queue, they are taken out of it and
+* of the event table together, in the order of the date index, their members
+* are released in one batch, and then the next occurrences of the recurring
+* ones are scheduled and the nodes are freed. If the batch cannot be
+* allocated the events are removed one by one.
+*
+* @param em - the event manager to remove from.
+* @param today - the packed current date.
+* @param callback - called on every expired event in date and insertion order,
+*   before it is removed, may be NULL.
+* @param ctx - passed as is to callback.
+*/
+static void expire_events(EventManager em,int today,EventExpiryCallback callback,void* ctx)
+{
+    int expired_num=0;
+    EM_LOOKUP(em);
+    for(int* slot=eventQueueGetFirst(em->queue);slot!=NULL&&em->events.date_keys[*slot]<today;
+        slot=eventQueueGetNext(em->queue)){
+        EM_SCAN(em);
+        expired_num++;
+    }
+    if(expired_num==0)
+    {
+        return;
+    }
+    Node* expired=em_malloc(&em->allocator,sizeof(*expired)*expired_num);
+    Recurrence* rules=em_malloc(&em->allocator,sizeof(*rules)*expired_num);
+    if(expired==NULL||rules==NULL)
+    {
+        em_free(&em->allocator,expired);
+        em_free(&em->allocator,rules);
+        for(int i=0;i<expired_num;i++){
+            expire_first_event(em,today,callback,ctx);
+        }
+        return;
+    }
+    Expired_ctx collected={expired,0,expired_num};
+    eventIndexForEachRange(em->events_index,INT_MIN,today-1,collect_expired,&collected);
+    for(int i=0;i<expired_num;i++){
+        eventQueueRemove(em->queue);
+    }
+    for(int i=0;i<expired_num;i++){
+        int slot=find_event_slot(em,expired[i]->id);
+        rules[i]=em->events.rules[slot];
+        em->events.rules[slot]=NULL;
+        if(callback!=NULL)
+        {
+            callback(expired[i]->name,expired[i]->id,expired[i]->date,ctx);
+        }
+        detach_event_at(em,slot,NOTIFY_EVENT_EXPIRED);
+    }
+    release_expired_members(em,expired,expired_num);
+    for(int i=0;i<expired_num;i++){
+        if(rules[i]!=NULL&&!schedule_next_occurrence(em,rules[i],expired[i],today))
+        {
+            destroy_recurrence(em,rules[i]);
+        }
+    }
+    for(int i=0;i<expired_num;i++){
+        account_event(em,expired[i],-1);
+        Destroy_Node(expired[i],&em->allocator);
+    }
+    em_free(&em->allocator,expired);
+    em_free(&em->allocator,rules);
+}
+
+/**
+* tick: the implementation of emTick and emTickWithCallback.
+* An expired occurrence of a recurring event is replaced by its next one.
+*/
+static EventManagerResult tick(EventManager em, int days, EventExpiryCallback callback, void* ctx)
+{
+    if(em==NULL)
+        return EM_NULL_ARGUMENT;
+    if(days<=0){
+        return EM_INVALID_DATE;
+    }
+    for(int i=0;i<days;i++)
+        dateTick(em->begginig_date);
+
+    expire_events(em,date_to_key(em->begginig_date),callback,ctx);
+    return EM_SUCCESS;
+}
+
+EventManagerResult emTick(EventManager em, int days)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=tick(em,days,NULL,NULL);
+    EM_TIMER_RECORD(em,EM_CALL_TICK,timer);
+    return result;
+}
+
+EventManagerResult emTickWithCallback(EventManager em, int days, EventExpiryCallback callback, void* ctx)
+{
+    EM_TIMER_START(timer);
+    EventManagerResult result=tick(em,days,callback,ctx);
+    EM_TIMER_RECORD(em,EM_CALL_TICK,timer);
+    return result;
+}
+
+int emGetEventsAmount(EventManager em)
+{
+    if(!em){
+        return -1;
+    }
+    return em->counter_num_of_events;
+}
+
+/**
+* get_next_event: the implementation of emGetNextEvent, see event_manager.h.
+*/
+static char* get_next_event(EventManager em)
+{
+    // char* c=NULL;
+    if(!em) {
+        return NULL;
+    }
+    if(em->counter_num_of_events==0) {
+        return NULL;
+    }
+    int* first=eventQueueGetFirst(em->queue);
+    if(!first) {
+        return NULL;
+    }
+
+    return em->events.nodes[*first]->name;
+}
+
+char* emGetNextEvent(EventManager em)
+{
+    EM_TIMER_START(timer);
+    char* result=get_next_event(em);
+    EM_TIMER_RECORD(em,EM_CALL_GET_NEXT_EVENT,timer);
+    return result;
+}
+
+
+/**
+* Export_ctx: the nodes printed by an export in file order, one line each,
+* the packed dates of the events and their event manager. The workers
+* formatting the chunks of the file only read it.
+*/
+typedef struct export_ctx
+{
+    EventManager em;
+    Node* nodes;
+    int* date_keys;
+    int size;
+    int capacity;
+}Export_ctx;
+
+/**
+* Date_text: the text of a date, "day.month.year", cached by its packed date.
+* Every chunk keeps its own cache since the events of a chunk are ordered by
+* date and mostly share a few dates.
+*/
+typedef struct date_text
+{
+    int date_key;
+    int length;
+    char text[DATE_TEXT_LEN];
+}Date_text;
+
+/**
+* export_chunks: returns the number of chunks the lines of an export are split into.
+*/
+static int export_chunks(const Export_ctx* export)
+{
+    return (export->size+EXPORT_CHUNK_LINES-1)/EXPORT_CHUNK_LINES;
+}
+
+/**
+* export_chunk_end: returns the line after the last line of a chunk.
+*/
+static int export_chunk_end(const Export_ctx* export,int chunk)
+{
+    int end=(chunk+1)*EXPORT_CHUNK_LINES;
+    return end<export->size ? end : export->size;
+}
+
+/**
+* compare_member_ids: orders members by their id.
+*/
+static int compare_member_ids(const void* first,const void* second)
+{
+    Node member1=*(const Node*)first;
+    Node member2=*(const Node*)second;
+    return (member1->id>member2->id)-(member1->id<member2->id);
+}
+
+/**
+* compare_responsible_members: orders members by their counter, the largest
+* first, and then by their id.
+*/
+static int compare_responsible_members(const void* first,const void* second)
+{
+    Node member1=*(const Node*)first;
+    Node member2=*(const Node*)second;
+    if(member1->counter!=member2->counter)
+    {
+        return member1->counter<member2->counter ? POSITIVE : NEGATIVE;
+    }
+    return compare_member_ids(first,second);
+}
+
+/**
+* Members_array: the nodes of the members of an event collected by sort_members.
+*/
+typedef struct members_array
+{
+    EventManager em;
+    Node* nodes;
+    int size;
+    int capacity;
+}Members_array;
+
+/**
+* collect_member: appends the node of a member to a Members_array, growing it if it is full.
+*
+* @param member_id - the id of the member.
+* @param ctx - the Members_array.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool collect_member(int member_id,void* ctx)
+{
+    Members_array* members=ctx;
+    if(members->size==members->capacity)
+    {
+        int new_capacity= members->capacity==0 ? INITIAL_EVENT_SLOTS : members->capacity*EXPAND_FACTOR;
+        Node* new_members=realloc(members->nodes,sizeof(*new_members)*new_capacity);
+        if(new_members==NULL)
+        {
+            members->size=-1;
+            return false;
+        }
+        members->nodes=new_members;
+        members->capacity=new_capacity;
     }
+    members->nodes[members->size++]=member_node(members->em,member_id);
+    return true;
+}
 
-    while(current!=NULL)
+/**
+* sort_members: puts the nodes of the members of an event into an array
+* ordered by id, the order of the member set of the event.
+* The array is allocated with malloc since it may be called by several
+* threads, and the allocation counters are not thread safe.
+*
+* @param em - the event manager of the event.
+* @param event - the event.
+* @param members - the array, grown if it is too small.
+* @param capacity - the capacity of the array.
+* @return
+* -1 - if allocation fails.
+* otherwise the number of members.
+*/
+static int sort_members(EventManager em,Node event,Node** members,int* capacity)
+{
+    Members_array array={em,*members,0,*capacity};
+    memberSetForEach(event->members,collect_member,&array);
+    *members=array.nodes;
+    *capacity=array.capacity;
+    return array.size;
+}
+
+/**
+* get_date_text: returns the text of the date of an event, formatting it if
+* it is not in the cache.
+*
+* @param cache - the cache of the dates, DATE_CACHE_SIZE entries.
+* @param date_key - the packed date of the event.
+* @param event - the event.
+* @return
+* the cached text of the date.
+*/
+static const Date_text* get_date_text(Date_text* cache,int date_key,Node event)
+{
+    Date_text* entry=&cache[(unsigned int)date_key%DATE_CACHE_SIZE];
+    if(entry->length==0||entry->date_key!=date_key)
     {
+        int day=0;
+        int month=0;
+        int year=0;
+        dateGet(event->date,&day,&month,&year);
+        int length=exportFormatInt(entry->text,day);
+        entry->text[length++]='.';
+        length+=exportFormatInt(entry->text+length,month);
+        entry->text[length++]='.';
+        length+=exportFormatInt(entry->text+length,year);
+        entry->date_key=date_key;
+        entry->length=length;
+    }
+    return entry;
+}
 
-        if(current->id==event_id)
-        {
-            return EM_EVENT_ID_ALREADY_EXISTS;
-        }
-        current=current->next;
-    }
-    Date date_wanted=dateCopy(em->begginig_date);
+/**
+* format_event: formats the line of an event, its name, its date and the
+* names of its members ordered by id.
+*
+* @param buffer - the buffer to format into.
+* @param event - the event.
+* @param date - the text of the date of the event.
+* @param members - the members of the event ordered by id.
+* @param members_num - the number of members.
+* @return
+* FALSE if allocation fails.
+* otherwise TRUE.
+*/
+static bool format_event(ExportBuffer buffer,Node event,const Date_text* date,Node* members,int members_num)
+{
+    bool appended=exportBufferAppend(buffer,event->name,event->name_length)&&
+                  exportBufferAppend(buffer,",",1)&&
+                  exportBufferAppend(buffer,date->text,date->length);
+    for(int i=0;appended&&i<members_num;i++){
+        appended=exportBufferAppend(buffer,",",1)&&
+                 exportBufferAppend(buffer,members[i]->name,members[i]->name_length);
+    }
+    return appended&&exportBufferAppend(buffer,"\n",1);
+}
 
-    for(int i=0;i<days;i++)
-        dateTick(date_wanted);
+/**
+* format_events_chunk: formats a chunk of the lines of emPrintAllEvents.
+*
+* @param chunk - the chunk to format.
+* @param buffer - the buffer to format into.
+* @param ctx - the export of the events.
+* @return
+* FALSE if allocation fails.
+* otherwise TRUE.
+*/
+static bool format_events_chunk(int chunk,ExportBuffer buffer,void* ctx)
+{
+    const Export_ctx* export=ctx;
+    Date_text cache[DATE_CACHE_SIZE];
+    memset(cache,0,sizeof(cache));
+    Node* members=NULL;
+    int capacity=0;
+    bool appended=true;
+    for(int i=chunk*EXPORT_CHUNK_LINES;appended&&i<export_chunk_end(export,chunk);i++){
+        int members_num=sort_members(export->em,export->nodes[i],&members,&capacity);
+        const Date_text* date=get_date_text(cache,export->date_keys[i],export->nodes[i]);
+        appended= members_num>=0&&format_event(buffer,export->nodes[i],date,members,members_num);
+    }
+    free(members);
+    return appended;
+}
+
+/**
+* format_responsible_members_chunk: formats a chunk of the lines of
+* emPrintAllResponsibleMembers.
+*
+* @param chunk - the chunk to format.
+* @param buffer - the buffer to format into.
+* @param ctx - the export of the members.
+* @return
+* FALSE if allocation fails.
+* otherwise TRUE.
+*/
+static bool format_responsible_members_chunk(int chunk,ExportBuffer buffer,void* ctx)
+{
+    const Export_ctx* export=ctx;
+    bool appended=true;
+    for(int i=chunk*EXPORT_CHUNK_LINES;appended&&i<export_chunk_end(export,chunk);i++){
+        appended=exportBufferAppend(buffer,export->nodes[i]->name,export->nodes[i]->name_length)&&
+                 exportBufferAppend(buffer,",",1)&&
+                 exportBufferAppendInt(buffer,export->nodes[i]->counter)&&
+                 exportBufferAppend(buffer,"\n",1);
+    }
+    return appended;
+}
 
+/**
+* collect_event: adds an event of the index to the lines of an export.
+*
+* @param date_key - the packed date of the event.
+* @param order - the insertion counter of the event.
+* @param data - the node of the event.
+* @param ctx - the export of the events.
+* @return
+* FALSE if the export is full.
+* otherwise TRUE.
+*/
+static bool collect_event(int date_key,int order,void* data,void* ctx)
+{
+    Export_ctx* export=ctx;
+    if(export->size==export->capacity)
+    {
+        return false;
+    }
+    export->nodes[export->size]=data;
+    export->date_keys[export->size++]=date_key;
+    return true;
+}
 
+/**
+* print_all_events: the implementation of emPrintAllEvents, see event_manager.h.
+* The events are printed by date, and events on the same date in the order they were added.
+*/
+static void print_all_events(EventManager em, const char* file_name)
+{
+    Export_ctx export={em,NULL,NULL,0,em->counter_num_of_events};
+    if(export.capacity>0)
+    {
+        export.nodes=em_malloc(&em->allocator,sizeof(*export.nodes)*export.capacity);
+        export.date_keys=em_malloc(&em->allocator,sizeof(*export.date_keys)*export.capacity);
+        if(export.nodes==NULL||export.date_keys==NULL)
+        {
+            em_free(&em->allocator,export.nodes);
+            em_free(&em->allocator,export.date_keys);
+            return;
+        }
+        eventIndexForEachRange(em->events_index,INT_MIN,INT_MAX,collect_event,&export);
+    }
+    exportWriteChunks(file_name,export_chunks(&export),em->export_workers,format_events_chunk,&export);
+    em_free(&em->allocator,export.nodes);
+    em_free(&em->allocator,export.date_keys);
+}
 
+void emPrintAllEvents(EventManager em, const char* file_name)
+{
+    EM_TIMER_START(timer);
+    print_all_events(em,file_name);
+    EM_TIMER_RECORD(em,EM_CALL_PRINT_ALL_EVENTS,timer);
+}
 
-    Event_element event = eventElement_create(event_name,event_id,em->counter);
-    pqInsert(em->queue,event,date_wanted);
-    em->counter_num_of_events +=1;
 
-    Node node_new=createNode(event_name,event_id,em->counter,date_wanted);
-    node_new->next=em->head_events;
-    em->head_events=node_new;
-    em->counter+=1;
-    dateDestroy(date_wanted);
-    free_element(event);
-    return EM_SUCCESS;
+/**
+* print_all_responsible_members: the implementation of emPrintAllResponsibleMembers, see event_manager.h.
+* The members are printed by the number of events they are linked to, the
+* largest first, and members with the same number by id.
+*/
+static void print_all_responsible_members(EventManager em, const char* file_name)
+{
+    Export_ctx export={em,NULL,NULL,0,0};
+    for(Node current=em->members_in_sysem_head;current!=NULL;current=current->next){
+        export.capacity++;
+    }
+    export.nodes=em_malloc(&em->allocator,sizeof(*export.nodes)*export.capacity);
+    if(export.nodes==NULL)
+    {
+        return;
+    }
+    EM_LOOKUP(em);
+    for(Node current=em->members_in_sysem_head;current!=NULL;current=current->next){
+        EM_SCAN(em);
+        if(current->name!=NULL&&current->counter>0)
+        {
+            export.nodes[export.size++]=current;
+        }
+    }
+    if(export.size>1)
+    {
+        qsort(export.nodes,export.size,sizeof(*export.nodes),compare_responsible_members);
+    }
+    exportWriteChunks(file_name,export_chunks(&export),em->export_workers,
+                      format_responsible_members_chunk,&export);
+    em_free(&em->allocator,export.nodes);
 }
 
+void emPrintAllResponsibleMembers(EventManager em, const char* file_name)
+{
+    EM_TIMER_START(timer);
+    print_all_responsible_members(em,file_name);
+    EM_TIMER_RECORD(em,EM_CALL_PRINT_ALL_RESPONSIBLE_MEMBERS,timer);
+}
 
+/**
+* Delta_ctx: the events that changed since a version, ordered by id, and the
+* version of the delta, and their event manager. The node of an event that no
+* longer exists is NULL.
+*/
+typedef struct delta_ctx
+{
+    EventManager em;
+    int* event_ids;
+    Node* nodes;
+    int* date_keys;
+    int size;
+    long version;
+}Delta_ctx;
 
 /**
-* dec_one_from_member: remove one member.
+* find_delta_position: binary searches an event id in the ids of a delta.
 *
-* @param em - event manager we want to remove from.
-* @param current_members - members in the event.
+* @param delta - the delta to search in.
+* @param event_id - the id of the event.
+* @return
+* -1 - if the event did not change.
+* otherwise the position of the event.
 */
+static int find_delta_position(const Delta_ctx* delta,int event_id)
+{
+    int low=0;
+    int high=delta->size;
+    while(low<high){
+        int middle=low+(high-low)/2;
+        if(delta->event_ids[middle]<event_id){
+            low=middle+1;
+        }
+        else{
+            high=middle;
+        }
+    }
+    return low<delta->size&&delta->event_ids[low]==event_id ? low : -1;
+}
 
-static void  dec_one_from_member(EventManager em,Node current_members)
+/**
+* format_delta_chunk: formats a chunk of the lines of emExportDelta, the
+* first chunk starting with the version line.
+*
+* @param chunk - the chunk to format.
+* @param buffer - the buffer to format into.
+* @param ctx - the delta.
+* @return
+* FALSE if allocation fails.
+* otherwise TRUE.
+*/
+static bool format_delta_chunk(int chunk,ExportBuffer buffer,void* ctx)
 {
-    Node cur=em->members_in_sysem_head;
-    while(cur!=NULL){
-        if(strcmp(cur->name,current_members->name)==0&&cur->id==current_members->id){
-            cur->counter--;
-            return;
+    const Delta_ctx* delta=ctx;
+    bool appended=true;
+    if(chunk==0)
+    {
+        char header[DELTA_HEADER_LEN];
+        int length=sprintf(header,"version,%ld\n",delta->version);
+        appended=exportBufferAppend(buffer,header,length);
+    }
+    Date_text cache[DATE_CACHE_SIZE];
+    memset(cache,0,sizeof(cache));
+    Node* members=NULL;
+    int capacity=0;
+    int end= (chunk+1)*EXPORT_CHUNK_LINES<delta->size ? (chunk+1)*EXPORT_CHUNK_LINES : delta->size;
+    for(int i=chunk*EXPORT_CHUNK_LINES;appended&&i<end;i++){
+        Node event=delta->nodes[i];
+        if(event==NULL)
+        {
+            appended=exportBufferAppend(buffer,"removed,",strlen("removed,"))&&
+                     exportBufferAppendInt(buffer,delta->event_ids[i])&&
+                     exportBufferAppend(buffer,"\n",1);
+            continue;
         }
-        cur=cur->next;
+        int members_num=sort_members(delta->em,event,&members,&capacity);
+        appended= members_num>=0&&exportBufferAppend(buffer,"event,",strlen("event,"))&&
+                  exportBufferAppendInt(buffer,delta->event_ids[i])&&exportBufferAppend(buffer,",",1)&&
+                  format_event(buffer,event,get_date_text(cache,delta->date_keys[i],event),members,members_num);
     }
+    free(members);
+    return appended;
+}
 
+/**
+* Binary_export: the columns written by emExportBinary and the memory they
+* are built in.
+*/
+typedef struct binary_export
+{
+    ScheduleColumns columns;
+    Export_ctx events;
+    Node* members;
+    int members_num;
+    char* strings;
+    uint32_t* words;
+}Binary_export;
 
+/**
+* find_member_position: binary searches a member in members ordered by id.
+*
+* @param members - the members ordered by id.
+* @param members_num - the number of members.
+* @param member_id - the id of the member.
+* @return
+* the position of the member, which must be in the members.
+*/
+static int find_member_position(Node* members,int members_num,int member_id)
+{
+    int low=0;
+    int high=members_num;
+    while(low<high){
+        int middle=low+(high-low)/2;
+        if(members[middle]->id<member_id){
+            low=middle+1;
+        }
+        else{
+            high=middle;
+        }
+    }
+    return low;
 }
 
 /**
-* Get_element: search for a specific element.
+* collect_binary_nodes: collects the events in the order of emPrintAllEvents
+* and the members ordered by id.
 *
-* @param queue - queue to search in.
-* @param element - element we are looking for.
+* @param em - the event manager to export.
+* @param export - receives the events and the members.
 * @return
-* returns the element we are looking for.
+* FALSE if allocation fails.
+* otherwise TRUE.
 */
-static Event_element Get_element(PriorityQueue queue,Event_element element){
-    Event_element wanted=(Event_element)pqGetFirst(queue);
-    if(equal_element(element,wanted)){
-        return copy_element(wanted);
+static bool collect_binary_nodes(EventManager em,Binary_export* export)
+{
+    export->events.em=em;
+    export->events.capacity=em->counter_num_of_events;
+    if(export->events.capacity>0)
+    {
+        export->events.nodes=em_malloc(&em->allocator,sizeof(*export->events.nodes)*export->events.capacity);
+        export->events.date_keys=em_malloc(&em->allocator,sizeof(*export->events.date_keys)*export->events.capacity);
+        if(export->events.nodes==NULL||export->events.date_keys==NULL)
+        {
+            return false;
+        }
+        eventIndexForEachRange(em->events_index,INT_MIN,INT_MAX,collect_event,&export->events);
+    }
+    int members_capacity=0;
+    for(Node current=em->members_in_sysem_head;current!=NULL;current=current->next){
+        members_capacity++;
+    }
+    export->members=em_malloc(&em->allocator,sizeof(*export->members)*members_capacity);
+    if(export->members==NULL)
+    {
+        return false;
     }
-    wanted=pqGetNext(queue);
-    while (wanted!=NULL){
-        if(equal_element(element,wanted)){
-            return copy_element(wanted);
+    for(Node current=em->members_in_sysem_head;current!=NULL;current=current->next){
+        if(current->name!=NULL)
+        {
+            export->members[export->members_num++]=current;
         }
-        wanted=pqGetNext(queue);
     }
-    return wanted;
+    if(export->members_num>1)
+    {
+        qsort(export->members,export->members_num,sizeof(*export->members),compare_member_ids);
+    }
+    return true;
+}
 
+/**
+* add_string: copies a name with its null character to the string table.
+*
+* @param export - the export that holds the string table.
+* @param node - the node of the name.
+* @return
+* the offset of the name in the string table.
+*/
+static uint32_t add_string(Binary_export* export,Node node)
+{
+    uint32_t offset=export->columns.strings_size;
+    memcpy(export->strings+offset,node->name,node->name_length+1);
+    export->columns.strings_size+=(uint32_t)node->name_length+1;
+    return offset;
 }
 
-EventManagerResult emRemoveEvent(EventManager em, int event_id)
+/**
+* build_binary_columns: fills the columns of emExportBinary from the
+* collected events and members.
+*
+* @param em - the event manager to export.
+* @param export - the export with the collected nodes.
+* @return
+* FALSE if allocation fails.
+* otherwise TRUE.
+*/
+static bool build_binary_columns(EventManager em,Binary_export* export)
 {
+    size_t strings_size=0;
+    size_t links_num=0;
+    for(int i=0;i<export->events.size;i++){
+        strings_size+=export->events.nodes[i]->name_length+1;
+        MemberSet event_members=export->events.nodes[i]->members;
+        links_num+= event_members==NULL ? 0 : memberSetGetSize(event_members);
+    }
+    for(int i=0;i<export->members_num;i++){
+        strings_size+=export->members[i]->name_length+1;
+    }
+    int events_num=export->events.size;
+    int members_num=export->members_num;
+    export->strings=em_malloc(&em->allocator,strings_size>0 ? strings_size : 1);
+    export->words=em_malloc(&em->allocator,sizeof(*export->words)*(6*events_num+1+3*members_num+links_num));
+    if(export->strings==NULL||export->words==NULL)
+    {
+        return false;
+    }
+    ScheduleColumns* columns=&export->columns;
+    uint32_t* event_names=export->words;
+    int32_t* event_ids=(int32_t*)(event_names+events_num);
+    int32_t* event_days=event_ids+events_num;
+    int32_t* event_months=event_days+events_num;
+    int32_t* event_years=event_months+events_num;
+    uint32_t* member_names=(uint32_t*)(event_years+events_num);
+    int32_t* member_ids=(int32_t*)(member_names+members_num);
+    int32_t* member_counters=member_ids+members_num;
+    uint32_t* event_link_offsets=(uint32_t*)(member_counters+members_num);
+    uint32_t* member_links=event_link_offsets+events_num+1;
+    columns->events_num=(uint32_t)events_num;
+    columns->members_num=(uint32_t)members_num;
+    columns->links_num=(uint32_t)links_num;
+    columns->strings=export->strings;
+    for(int i=0;i<members_num;i++){
+        member_names[i]=add_string(export,export->members[i]);
+        member_ids[i]=export->members[i]->id;
+        member_counters[i]=export->members[i]->counter;
+    }
+    Node* members=NULL;
+    int capacity=0;
+    uint32_t links=0;
+    for(int i=0;i<events_num;i++){
+        Node event=export->events.nodes[i];
+        event_names[i]=add_string(export,event);
+        event_ids[i]=event->id;
+        dateGet(event->date,&event_days[i],&event_months[i],&event_years[i]);
+        event_link_offsets[i]=links;
+        int event_members=sort_members(em,event,&members,&capacity);
+        if(event_members<0)
+        {
+            return false;
+        }
+        for(int j=0;j<event_members;j++){
+            member_links[links++]=(uint32_t)find_member_position(export->members,members_num,members[j]->id);
+        }
+    }
+    free(members);
+    event_link_offsets[events_num]=links;
+    columns->event_names=event_names;
+    columns->event_ids=event_ids;
+    columns->event_days=event_days;
+    columns->event_months=event_months;
+    columns->event_years=event_years;
+    columns->member_names=member_names;
+    columns->member_ids=member_ids;
+    columns->member_counters=member_counters;
+    columns->event_link_offsets=event_link_offsets;
+    columns->member_links=member_links;
+    return true;
+}
 
+EventManagerResult emExportBinary(EventManager em, int fd)
+{
     if(em==NULL)
     {
         return EM_NULL_ARGUMENT;
     }
-    if(event_id<0)
+    Binary_export export;
+    memset(&export,0,sizeof(export));
+    EventManagerResult result=EM_OUT_OF_MEMORY;
+    if(collect_binary_nodes(em,&export)&&build_binary_columns(em,&export))
     {
-        return EM_INVALID_EVENT_ID;
-    }
-    Node current=em->head_events;
-    if(em->counter_num_of_events==0){
-        return EM_EVENT_NOT_EXISTS;
-    }
-    if(current->id==event_id){
-        Event_element element=eventElement_create(current->name,current->id,current->counter);
-        Event_element current1=Get_element(em->queue,element);
-        pqRemoveElement(em->queue,element);
-        em->head_events=em->head_events->next;
-        free(current->name);
-        em->counter_num_of_events--;
-        Node current_members=current1->members_head;
-        while(current_members!=NULL){
-            dec_one_from_member(em,current_members);
-            current_members=current_members->next;
-        }
-        free_element(current1);
-        dateDestroy(current->date);
-        free_element(element);
-        free(current);
-        return EM_SUCCESS;
+        ScheduleFileResult written=scheduleFileWrite(fd,&export.columns);
+        result= written==SF_SUCCESS ? EM_SUCCESS : written==SF_OUT_OF_MEMORY ? EM_OUT_OF_MEMORY : EM_ERROR;
+    }
+    em_free(&em->allocator,export.events.nodes);
+    em_free(&em->allocator,export.events.date_keys);
+    em_free(&em->allocator,export.members);
+    em_free(&em->allocator,export.strings);
+    em_free(&em->allocator,export.words);
+    return result;
+}
 
+EventManagerResult emGetMemoryUsage(EventManager em, EMMemoryUsage* usage)
+{
+    if(em==NULL||usage==NULL)
+    {
+        return EM_NULL_ARGUMENT;
     }
-    Node prev=current;
-    current=current->next;
-    while(current!=NULL){
-        if (current->id==event_id){
-            Event_element element=eventElement_create(current->name,current->id,current->counter);
-            Event_element current1=Get_element(em->queue,element);
-            pqRemoveElement(em->queue,element);
-
-            Node current_members=current1->members_head;
-            while(current_members!=NULL){
-                dec_one_from_member(em,current_members);
-                current_members=current_members->next;
-            }
-            prev->next=current->next;
-            free(current->name);
-            dateDestroy(current->date);
-            free(current);
-            em->counter_num_of_events--;
-            free_element(element);
-            free_element(current1);
-            return EM_SUCCESS;
-        }
-        prev=prev->next;
-        current=current->next;
+    *usage=em->memory;
+    Event_table* table=&em->events;
+    usage->event_records+=(long)(sizeof(*table->ids)+sizeof(*table->date_keys)+sizeof(*table->counters)+
+                                 sizeof(*table->name_hashes)+sizeof(*table->nodes)+
+                                 sizeof(*table->rules))*table->capacity;
+    usage->member_table+=(long)sizeof(*em->member_nodes)*em->member_capacity;
+    usage->queue_nodes=(long)(sizeof(*em->queue)+sizeof(*em->queue->head)*eventQueueGetSize(em->queue));
+    usage->event_index=eventIndexGetMemoryUsage(em->events_index);
+    usage->member_index=memberIndexGetMemoryUsage(em->members_index);
+    usage->slot_maps=slotMapGetMemoryUsage(em->events.slots)+slotMapGetMemoryUsage(em->member_slots);
+    usage->change_log=changeLogGetMemoryUsage(em->changes);
+    usage->booking_index=bookingIndexGetMemoryUsage(em->bookings);
+    usage->views=versionTableGetMemoryUsage(em->events_view)+versionTableGetMemoryUsage(em->members_view);
+    if(em->view_references!=NULL)
+    {
+        usage->views+=(long)sizeof(*em->view_references);
     }
-
-    return EM_EVENT_NOT_EXISTS;
-
-
+    usage->notifications=notificationRingGetMemoryUsage(em->notifications);
+    usage->total=usage->event_records+usage->queue_nodes+usage->member_table+usage->link_storage+
+                 usage->name_strings+usage->dates+usage->event_index+usage->member_index+
+                 usage->slot_maps+usage->change_log+usage->booking_index+usage->views+usage->notifications;
+    return EM_SUCCESS;
 }
 
-
-
-EventManagerResult emChangeEventDate(EventManager em, int event_id, Date new_date)
+EventManagerResult emEnableNotifications(EventManager em, int capacity)
 {
-    if(em == NULL)
+    if(em==NULL)
     {
         return EM_NULL_ARGUMENT;
     }
-    if(date_cmp(new_date,em->begginig_date) > 0)
+    if(em->notifications!=NULL)
     {
-        return EM_INVALID_DATE;
+        return EM_ERROR;
     }
-    if(event_id < 0)
+    NotificationRingResult result=notificationRingCreate(capacity,&em->notifications);
+    if(result==NR_OUT_OF_MEMORY)
     {
-        return EM_INVALID_EVENT_ID;
+        return EM_OUT_OF_MEMORY;
     }
-    if(there_is_event_the_same(em->head_events,event_id,new_date))
+    return result==NR_SUCCESS ? EM_SUCCESS : EM_ERROR;
+}
+
+NotificationRing emGetNotifications(EventManager em)
+{
+    if(em==NULL)
     {
-        return EM_EVENT_ALREADY_EXISTS;
+        return NULL;
     }
-    Node current=em->head_events;
-    while(current!=NULL)
+    return em->notifications;
+}
+
+/**
+* book_member: counts an event of a member on its date in a new booking index.
+*
+* @param member_id - the id of the member.
+* @param ctx - a Link_ctx of the event whose data is the index.
+* @return
+* FALSE - if allocation fails, member_id is set.
+* otherwise TRUE.
+*/
+static bool book_member(int member_id,void* ctx)
+{
+    Link_ctx* link=ctx;
+    if(bookingIndexAdd(link->data,member_id,link->date_key)!=BI_SUCCESS)
     {
+        link->member_id=member_id;
+        return false;
+    }
+    return true;
+}
 
-        if(current->id == event_id)
+/**
+* build_bookings: creates the booking index of an event manager from the
+* members of its events.
+*
+* @param em - the event manager to index.
+* @return
+* NULL - if allocation fails.
+* otherwise the index.
+*/
+static BookingIndex build_bookings(EventManager em)
+{
+    BookingIndex bookings=bookingIndexCreateWithAllocator(&em->allocator);
+    if(bookings==NULL)
+    {
+        return NULL;
+    }
+    for(int i=0;i<em->events.used;i++){
+        if(em->events.ids[i]==FREE_SLOT)
         {
-            Event_element element=eventElement_create(current->name,current->id,current->counter);
-            Event_element el2=Get_element(em->queue,element);
-            element->members_head=copy_Node(el2->members_head);
-            free_element(el2);
-            pqChangePriority(em->queue,element,
-                             current->date, new_date);
-            dateDestroy(current->date);
-            current->date = dateCopy(new_date);
-            free_element(element);
-            return EM_SUCCESS;
+            continue;
+        }
+        Link_ctx link={em,em->events.ids[i],em->events.date_keys[i],-1,bookings};
+        memberSetForEach(em->events.nodes[i]->members,book_member,&link);
+        if(link.member_id>=0)
+        {
+            bookingIndexDestroy(bookings);
+            return NULL;
         }
-        current=current->next;
     }
-    return EM_EVENT_ID_NOT_EXISTS;
+    return bookings;
 }
 
-EventManagerResult emAddMember(EventManager em, char* member_name, int member_id)
+EventManagerResult emSetMemberLimits(EventManager em, int max_members_per_event,
+                                     int max_events_per_member_per_date)
 {
-    if(em==NULL||member_name==NULL)
+    if(em==NULL)
     {
         return EM_NULL_ARGUMENT;
     }
-    if(member_id<0)
+    if(max_members_per_event<0||max_events_per_member_per_date<0)
     {
-        return EM_INVALID_MEMBER_ID;
+        return EM_ERROR;
     }
-    Node current=em->members_in_sysem_head;
-    if(em->members_in_sysem_head->name==NULL){
-        char * new_name=malloc(sizeof(char)*(strlen(member_name)+1));
-        strcpy(new_name,member_name);
-        em->members_in_sysem_head->name=new_name;
-        em->members_in_sysem_head->id=member_id;
-        em->members_in_sysem_head->counter=0;
-        if(em->members_in_sysem_head->date)
-            dateDestroy(em->members_in_sysem_head->date);
-        em->members_in_sysem_head->date=NULL;
-        em->members_in_sysem_head->next=NULL;
-        return EM_SUCCESS;
+    if(max_events_per_member_per_date==0)
+    {
+        bookingIndexDestroy(em->bookings);
+        em->bookings=NULL;
     }
-    while(current!=NULL){
-        if(current->id==member_id){
-            return EM_MEMBER_ID_ALREADY_EXISTS;
+    else if(em->bookings==NULL)
+    {
+        em->bookings=build_bookings(em);
+        if(em->bookings==NULL)
+        {
+            return EM_OUT_OF_MEMORY;
         }
-        current=current->next;
     }
-    Node new_mem=createNode(member_name,member_id,0,em->begginig_date);
-    new_mem->next=em->members_in_sysem_head;
-    em->members_in_sysem_head=new_mem;
-    //em->members_in_sysem_head->counter++;
+    em->max_event_members=max_members_per_event;
+    em->max_member_events_per_date=max_events_per_member_per_date;
     return EM_SUCCESS;
 }
 
+long emGetVersion(EventManager em)
+{
+    if(em==NULL)
+    {
+        return -1;
+    }
+    return changeLogGetVersion(em->changes);
+}
 
-EventManagerResult emAddMemberToEvent(EventManager em, int member_id, int event_id)
+EventManagerResult emExportDelta(EventManager em, long since_version, const char* file_name)
 {
-    if(em == NULL)
+    if(em==NULL||file_name==NULL)
     {
         return EM_NULL_ARGUMENT;
     }
-    if(event_id < 0)
+    Delta_ctx delta={em,NULL,NULL,NULL,0,changeLogGetVersion(em->changes)};
+    ChangeLogResult changed=changeLogGetChanged(em->changes,since_version,&delta.event_ids,&delta.size);
+    if(changed==CL_INVALID_VERSION||changed==CL_NULL_ARGUMENT)
     {
-        return EM_INVALID_EVENT_ID;
+        return EM_ERROR;
     }
-    if(member_id < 0)
+    if(changed==CL_OUT_OF_MEMORY)
     {
-        return EM_INVALID_MEMBER_ID;
+        return EM_OUT_OF_MEMORY;
+    }
+    if(delta.size>0)
+    {
+        delta.nodes=em_malloc(&em->allocator,sizeof(*delta.nodes)*delta.size);
+        delta.date_keys=em_malloc(&em->allocator,sizeof(*delta.date_keys)*delta.size);
+        if(delta.nodes==NULL||delta.date_keys==NULL)
+        {
+            em_free(&em->allocator,delta.nodes);
+            em_free(&em->allocator,delta.date_keys);
+            free(delta.event_ids);
+            return EM_OUT_OF_MEMORY;
+        }
+        for(int i=0;i<delta.size;i++){
+            delta.nodes[i]=NULL;
+        }
+        for(int slot=0;slot<em->events.used;slot++){
+            int position= em->events.ids[slot]==FREE_SLOT ? -1 : find_delta_position(&delta,em->events.ids[slot]);
+            if(position>=0)
+            {
+                delta.nodes[position]=em->events.nodes[slot];
+                delta.date_keys[position]=em->events.date_keys[slot];
+            }
+        }
+    }
+    int chunks= delta.size==0 ? 1 : (delta.size+EXPORT_CHUNK_LINES-1)/EXPORT_CHUNK_LINES;
+    ExportResult result=exportWriteChunks(file_name,chunks,em->export_workers,format_delta_chunk,&delta);
+    em_free(&em->allocator,delta.nodes);
+    em_free(&em->allocator,delta.date_keys);
+    free(delta.event_ids);
+    if(result==EXPORT_OUT_OF_MEMORY)
+    {
+        return EM_OUT_OF_MEMORY;
+    }
+    return result==EXPORT_SUCCESS ? EM_SUCCESS : EM_ERROR;
+}
+
+EMSnapshot emSnapshot(EventManager em)
+{
+    if(em==NULL||(em->events_view==NULL&&!build_views(em)))
+    {
+        return NULL;
+    }
+    EMSnapshot snapshot=malloc(sizeof(*snapshot));
+    if(snapshot==NULL)
+    {
+        return NULL;
+    }
+    snapshot->events=versionTableCopy(em->events_view);
+    snapshot->members=versionTableCopy(em->members_view);
+    snapshot->view_references=em->view_references;
+    hold_views(snapshot->view_references);
+    snapshot->events_num=em->counter_num_of_events;
+    snapshot->version=changeLogGetVersion(em->changes);
+    snapshot->export_workers=em->export_workers;
+    if(snapshot->events==NULL||snapshot->members==NULL)
+    {
+        emSnapshotDestroy(snapshot);
+        return NULL;
     }
+    return snapshot;
+}
 
-    Node cur=em->head_events;
-    while(cur!=NULL){
-        if(cur->id==event_id)break;
-        cur=cur->next;
-    }
-    if(cur==NULL){
-        return EM_EVENT_ID_NOT_EXISTS;
+void emSnapshotDestroy(EMSnapshot snapshot)
+{
+    if(snapshot==NULL)
+    {
+        return;
     }
+    versionTableDestroy(snapshot->events);
+    versionTableDestroy(snapshot->members);
+    release_views(snapshot->view_references);
+    free(snapshot);
+}
 
-
-    Node current = em->members_in_sysem_head;
-    while(current!=NULL){
-        if(current->id==member_id)break;
-        current=current->next;
-    }
-    if(current==NULL){
-        return EM_MEMBER_ID_NOT_EXISTS;
+int emSnapshotGetEventsAmount(EMSnapshot snapshot)
+{
+    if(snapshot==NULL)
+    {
+        return -1;
     }
-    Node current_member_add=createNode(current->name,current->id,current->counter,current->date);
-    Node current_event=em->head_events;
-    while(current_event!=NULL){
-        if(current_event->id==event_id){
-            Event_element element=eventElement_create(current_event->name,current_event->id,current_event->counter);
-            Event_element wanted= Get_element(em->queue,element);
-
-
-            Node current1 = wanted->members_head;
-            while(current1!=NULL){
-
-                if(current1->id==member_id){
-                    free_element(element);
-                    free_element(wanted);
-                    Destroy_Node(current_member_add);
-                    return EM_EVENT_AND_MEMBER_ALREADY_LINKED;
-                }
-                current1=current1->next;
-            }
-
-
-            Date date=dateCopy(current_event->date);
-            pqRemoveElement(em->queue,element);
-            //       Node current_member=wanted->members_head;
-
-            current_member_add->next=wanted->members_head;
-            wanted->members_head=current_member_add;
-            pqInsert(em->queue, wanted, date);
-            current->counter++;
-            // Destroy_Node(current_member_add);
-            free_element(element);
-            free_element(wanted);
-            dateDestroy(date);
-            return EM_SUCCESS;
-
+    return snapshot->events_num;
+}
 
-        }
-        current_event=current_event->next;
+long emSnapshotGetVersion(EMSnapshot snapshot)
+{
+    if(snapshot==NULL)
+    {
+        return -1;
     }
-
-
-    return EM_EVENT_ID_NOT_EXISTS;
+    return snapshot->version;
 }
 
 /**
-* remove_member_from_event_aux: removes a member from an event.
-*
-* @param em - the queue that contains the event we want to remove member from.
-* @param member_id - the id of the member we want to remove.
-* @param current_event - the event we want to remove the member from.
-* @param member_in_sys - member in the system.
+* Snapshot_export: the records printed by an export of a snapshot in file
+* order, one line each. The memory of a snapshot export is allocated with
+* malloc, since snapshots are printed by other threads than the event manager.
 */
-static void remove_member_from_event_aux(EventManager em,int member_id,Node current_event,Node member_in_sys)
+typedef struct snapshot_export
 {
-    Event_element element = eventElement_create(current_event->name, current_event->id, current_event->counter);
-    Event_element wanted = Get_element(em->queue, element);
-    Date date = dateCopy(current_event->date);
-    pqRemoveElement(em->queue, element);
-    Node current_member = wanted->members_head;
+    EMSnapshot snapshot;
+    const void** views;
+    int size;
+}Snapshot_export;
 
-    if (current_member->id == member_id) {
-        wanted->members_head = current_member->next;
-        free(current_member->name);
-        dateDestroy(current_member->date);
-        free(current_member);
-        pqInsert(em->queue, wanted, date);
-        free_element(element);
-        free_element(wanted);
-        dateDestroy(date);
-        member_in_sys->counter--;
-        return;
+/**
+* compare_event_views: orders events by date, and events on the same date by
+* the order they were added.
+*/
+static int compare_event_views(const void* first,const void* second)
+{
+    const Event_view* event1=*(const Event_view* const*)first;
+    const Event_view* event2=*(const Event_view* const*)second;
+    if(event1->date_key!=event2->date_key)
+    {
+        return event1->date_key<event2->date_key ? NEGATIVE : POSITIVE;
     }
-    Node prev_current_mem=current_member;
-    current_member=current_member->next;
-    while (current_member != NULL) {
-        if (current_member->id == member_id) {
-            prev_current_mem->next = current_member->next;
-            free(current_member->name);
-            dateDestroy(current_member->date);
-            free(current_member);
-            free_element(element);
-            pqInsert(em->queue, wanted, date);
-            dateDestroy(date);
-            member_in_sys->counter--;
-            free_element(wanted);
-            return;
-        }
-        prev_current_mem = prev_current_mem->next;
-        current_member = current_member->next;
+    return (event1->counter>event2->counter)-(event1->counter<event2->counter);
+}
+
+/**
+* compare_member_view_ids: orders members by their id.
+*/
+static int compare_member_view_ids(const void* first,const void* second)
+{
+    const Member_view* member1=*(const Member_view* const*)first;
+    const Member_view* member2=*(const Member_view* const*)second;
+    return (member1->id>member2->id)-(member1->id<member2->id);
+}
 
+/**
+* compare_responsible_member_views: orders members by their counter, the
+* largest first, and then by their id.
+*/
+static int compare_responsible_member_views(const void* first,const void* second)
+{
+    const Member_view* member1=*(const Member_view* const*)first;
+    const Member_view* member2=*(const Member_view* const*)second;
+    if(member1->counter!=member2->counter)
+    {
+        return member1->counter<member2->counter ? POSITIVE : NEGATIVE;
     }
+    return compare_member_view_ids(first,second);
 }
 
 /**
-* find_member_in_event: check if a member is in an event.
+* format_event_view: formats the line of an event of a snapshot, as
+* format_event does for an event of the event manager.
 *
-* @param em - the queue that contains the event we are looking for.
-* @param member_id - the id of the member we want to find.
-* @param event_id - the event id that we want to find the member in.
-* @param name - name of element.
+* @param buffer - the buffer to format into.
+* @param event - the record of the event.
+* @param members - the records of the members of the event ordered by id.
 * @return
-* TRUE if member is found .
-* otherwise FALSE.
+* FALSE if allocation fails.
+* otherwise TRUE.
 */
-static bool find_member_in_event(EventManager em,int member_id,int event_id,char* name)
+static bool format_event_view(ExportBuffer buffer,const Event_view* event,const Member_view** members)
 {
-    Event_element element = eventElement_create(name,event_id, 0);
-    Event_element wanted = Get_element(em->queue, element);
-
-    Node current_member=wanted->members_head;
-    while(current_member!=NULL){
-        if(current_member->id==member_id){
-            free_element(element);
-            free_element(wanted);
-            return true;
-        }
-        current_member=current_member->next;
-    }
-    free_element(element);
-    free_element(wanted);
-    return false;
+    bool appended=exportBufferAppend(buffer,(const char*)(event->member_slots+event->members_num),
+                                     event->name_length)&&
+                  exportBufferAppend(buffer,",",1)&&
+                  exportBufferAppendInt(buffer,event->day)&&
+                  exportBufferAppend(buffer,".",1)&&
+                  exportBufferAppendInt(buffer,event->month)&&
+                  exportBufferAppend(buffer,".",1)&&
+                  exportBufferAppendInt(buffer,event->year);
+    for(int i=0;appended&&i<event->members_num;i++){
+        appended=exportBufferAppend(buffer,",",1)&&
+                 exportBufferAppend(buffer,members[i]->name,members[i]->name_length);
+    }
+    return appended&&exportBufferAppend(buffer,"\n",1);
 }
 
-EventManagerResult emRemoveMemberFromEvent (EventManager em, int member_id, int event_id)
+/**
+* format_event_views_chunk: formats a chunk of the lines of emSnapshotPrintAllEvents.
+*
+* @param chunk - the chunk to format.
+* @param buffer - the buffer to format into.
+* @param ctx - the export of the snapshot.
+* @return
+* FALSE if allocation fails.
+* otherwise TRUE.
+*/
+static bool format_event_views_chunk(int chunk,ExportBuffer buffer,void* ctx)
 {
-    if(em==NULL)
-    {
-        return EM_NULL_ARGUMENT;
-    }
-    if(member_id<0)
-    {
-        return EM_INVALID_MEMBER_ID;
-    }
-    if(event_id<0)
-    {
-        return EM_INVALID_EVENT_ID;
-    }
-    Node current=em->members_in_sysem_head;
-    while(current!=NULL){
-        if(current->id==member_id)break;
-        current=current->next;
-    }
-    if(current==NULL){
-        return EM_MEMBER_ID_NOT_EXISTS;
-    }
-    Node current_event=em->head_events;
-    while(current_event!=NULL){
-        if(current_event->id==event_id){
-            if(!find_member_in_event(em,member_id,event_id,current_event->name))
+    const Snapshot_export* export=ctx;
+    const Member_view** members=NULL;
+    int capacity=0;
+    bool appended=true;
+    int end= (chunk+1)*EXPORT_CHUNK_LINES<export->size ? (chunk+1)*EXPORT_CHUNK_LINES : export->size;
+    for(int i=chunk*EXPORT_CHUNK_LINES;appended&&i<end;i++){
+        const Event_view* event=export->views[i];
+        if(event->members_num>capacity)
+        {
+            const Member_view** new_members=realloc(members,sizeof(*new_members)*event->members_num);
+            if(new_members==NULL)
             {
-                return EM_EVENT_AND_MEMBER_NOT_LINKED;
+                appended=false;
+                break;
             }
-            remove_member_from_event_aux(em,member_id,current_event,current);
-            return EM_SUCCESS;
+            members=new_members;
+            capacity=event->members_num;
+        }
+        for(int j=0;j<event->members_num;j++){
+            members[j]=versionTableGet(export->snapshot->members,event->member_slots[j]);
+        }
+        if(event->members_num>1)
+        {
+            qsort(members,event->members_num,sizeof(*members),compare_member_view_ids);
         }
-        current_event=current_event->next;
+        appended=format_event_view(buffer,event,members);
     }
-
-    return EM_EVENT_ID_NOT_EXISTS;
+    free(members);
+    return appended;
 }
 
-
-
-
 /**
-* bring_date: brings the date.
+* format_member_views_chunk: formats a chunk of the lines of
+* emSnapshotPrintAllResponsibleMembers.
 *
-* @param element - element that has date.
-* @param head_events - all the events.
+* @param chunk - the chunk to format.
+* @param buffer - the buffer to format into.
+* @param ctx - the export of the snapshot.
 * @return
-* returns NULL.
+* FALSE if allocation fails.
+* otherwise TRUE.
 */
-static Date bring_date( Event_element element,Node head_events)
+static bool format_member_views_chunk(int chunk,ExportBuffer buffer,void* ctx)
 {
-    Node current_event=head_events;
-    while(current_event!=NULL){
-        if(current_event->id==element->id)
-            return dateCopy(current_event->date);
-        current_event=current_event->next;
-    }
-    return NULL;
-
+    const Snapshot_export* export=ctx;
+    bool appended=true;
+    int end= (chunk+1)*EXPORT_CHUNK_LINES<export->size ? (chunk+1)*EXPORT_CHUNK_LINES : export->size;
+    for(int i=chunk*EXPORT_CHUNK_LINES;appended&&i<end;i++){
+        const Member_view* member=export->views[i];
+        appended=exportBufferAppend(buffer,member->name,member->name_length)&&
+                 exportBufferAppend(buffer,",",1)&&
+                 exportBufferAppendInt(buffer,member->counter)&&
+                 exportBufferAppend(buffer,"\n",1);
+    }
+    return appended;
 }
 
 /**
-* Remove_from_node: remove element from the node.
+* print_snapshot: prints the records of a table of a snapshot in the order of
+* a comparison, skipping the ones a filter rejects.
 *
-* @param head_events - events we want to remove element from.
-* @param element - element we want to remove.
+* @param snapshot - the snapshot to print.
+* @param table - the table of the snapshot to print.
+* @param responsible_only - TRUE to print only the members linked to events.
+* @param compare - the order of the lines.
+* @param formatter - formats the chunks of the lines.
+* @param file_name - the file to print to.
 * @return
-* returns events without the element we removed.
-*/
-static Node Remove_from_node(Node head_events, Event_element element)
-{
-    if(element->id==head_events->id){
-        if(head_events->next==NULL){
-            Node current=head_events;
-            dateDestroy(current->date);
-            free(current->name);
-            current->name=NULL;
-            current->date=NULL;
-            current->id=0;
-            current->counter=0;
-
-            //free(current);
-            return head_events;
-        }
-        else{
-
-            Node current=head_events;
-            head_events=head_events->next;
-            dateDestroy(current->date);
-            free(current->name);
-            //  current->name=NULL;
-            // current->date=NULL;
-            free(current);
-            return head_events;
+* EM_OUT_OF_MEMORY - if allocation fails.
+* EM_ERROR - if the file cannot be written.
+* otherwise EM_SUCCESS.
+*/
+static EventManagerResult print_snapshot(EMSnapshot snapshot,VersionTable table,bool responsible_only,
+                                         int (*compare)(const void*,const void*),
+                                         ExportChunkFormatter formatter,const char* file_name)
+{
+    Snapshot_export export={snapshot,NULL,0};
+    int slots=versionTableGetSize(table);
+    if(slots>0)
+    {
+        export.views=malloc(sizeof(*export.views)*slots);
+        if(export.views==NULL)
+        {
+            return EM_OUT_OF_MEMORY;
         }
     }
-    Node current=head_events->next;
-    Node prev=head_events;
-    while(current!=NULL){
-        if(current->id==element->id){
-            prev->next=current->next;
-            dateDestroy(current->date);
-            free(current->name);
-            free(current);
-            break;
+    for(int slot=0;slot<slots;slot++){
+        const void* view=versionTableGet(table,slot);
+        if(view!=NULL&&(!responsible_only||((const Member_view*)view)->counter>0))
+        {
+            export.views[export.size++]=view;
         }
-        prev=prev->next;
-        current=current->next;
     }
-    return head_events;
-
+    if(export.size>1)
+    {
+        qsort(export.views,export.size,sizeof(*export.views),compare);
+    }
+    int chunks=(export.size+EXPORT_CHUNK_LINES-1)/EXPORT_CHUNK_LINES;
+    ExportResult result=exportWriteChunks(file_name,chunks,snapshot->export_workers,formatter,&export);
+    free(export.views);
+    if(result==EXPORT_OUT_OF_MEMORY)
+    {
+        return EM_OUT_OF_MEMORY;
+    }
+    return result==EXPORT_SUCCESS ? EM_SUCCESS : EM_ERROR;
 }
 
-
-
-EventManagerResult emTick(EventManager em, int days)
+EventManagerResult emSnapshotPrintAllEvents(EMSnapshot snapshot, const char* file_name)
 {
-    if(em==NULL)
+    if(snapshot==NULL||file_name==NULL)
+    {
         return EM_NULL_ARGUMENT;
-    if(days<=0){
-        return EM_INVALID_DATE;
-    }
-    for(int i=0;i<days;i++)
-        dateTick(em->begginig_date);
-
-    Event_element current=pqGetFirst(em->queue);
-    Date current_date=NULL;
-    Node current_Event=em->head_events;
-
-
-    while(current_Event!=NULL){
-        if(current->id==current_Event->id){
-            current_date=dateCopy(current_Event->date);
-            if(date_cmp(em->begginig_date,current_Event->date)>0){
-                if(current_date){
-                    dateDestroy(current_date);
-                }
-
-                return EM_SUCCESS;
-            }
-        }
-        current_Event=current_Event->next;
     }
+    return print_snapshot(snapshot,snapshot->events,false,compare_event_views,
+                          format_event_views_chunk,file_name);
+}
 
-    while(current&&date_cmp(em->begginig_date,current_date)<0){
-        em->head_events=Remove_from_node(em->head_events,current);
-        Node current_members=current->members_head;
-        while(current_members!=NULL){
-            dec_one_from_member(em,current_members);
-            current_members=current_members->next;
-        }
-        pqRemoveElement(em->queue, current);
-        em->counter_num_of_events--;
-        current=pqGetFirst(em->queue);
-        if(current){
-            if(current_date){
-                dateDestroy(current_date);
-            }
-
-            current_date=bring_date(current,em->head_events);}
-
-
-
+EventManagerResult emSnapshotPrintAllResponsibleMembers(EMSnapshot snapshot, const char* file_name)
+{
+    if(snapshot==NULL||file_name==NULL)
+    {
+        return EM_NULL_ARGUMENT;
     }
-    if(current_date){dateDestroy(current_date);}
-
-    return EM_SUCCESS;
-
-
+    return print_snapshot(snapshot,snapshot->members,true,compare_responsible_member_views,
+                          format_member_views_chunk,file_name);
 }
 
 /**
-* if_still_in_p: check if elements still in queue.
+* Range_ctx: the callback of emForEachEventInRange and its context.
+*/
+typedef struct range_ctx
+{
+    EventRangeCallback callback;
+    void* ctx;
+}Range_ctx;
+
+/**
+* visit_event_in_range: passes an event of the index to the user callback.
 *
-* @param element1 - first element.
-* @param element2 - second element.
-* @param node - the node to check in.
+* @param date_key - the packed date of the event.
+* @param order - the insertion counter of the event.
+* @param data - the node of the event.
+* @param ctx - the callback and its context.
 * @return
-* FALSE - if one of the arguments is NULL or is not still in p.
-* otherwise TRUE.
+* TRUE to continue the iteration.
 */
-static bool if_still_in_p( Event_element element1,Event_element element2,Node node)
+static bool visit_event_in_range(int date_key,int order,void* data,void* ctx)
 {
-    if(element1==NULL||element2==NULL) {
-        return false;
-    }
-    Node current1=node;
-    while(current1!=NULL){
-        if(element1->id==current1->id)break;
-        current1=current1->next;
-    }
-    Node current2=node;
-    while(current2!=NULL){
-        if(element2->id==current2->id)break;
-        current2=current2->next;
+    Node event=data;
+    Range_ctx* range=ctx;
+    range->callback(event->name,event->id,event->date,range->ctx);
+    return true;
+}
+
+EventManagerResult emForEachEventInRange(EventManager em, Date from, Date to,
+                                         EventRangeCallback callback, void* ctx)
+{
+    if(em==NULL||callback==NULL)
+    {
+        return EM_NULL_ARGUMENT;
     }
-    if(current1!=NULL&&current2!=NULL){
-        if(dateCompare(current1->date,current2->date)==0){
-            return true;
-        }
+    if(from==NULL||to==NULL)
+    {
+        return EM_INVALID_DATE;
     }
-
-    return false;
-
-
+    Range_ctx range={callback,ctx};
+    eventIndexForEachRange(em->events_index,date_to_key(from),date_to_key(to),
+                           visit_event_in_range,&range);
+    return EM_SUCCESS;
 }
 
-int emGetEventsAmount(EventManager em)
+int emCountEventsInRange(EventManager em, Date from, Date to)
 {
-    if(!em){
+    if(em==NULL||from==NULL||to==NULL)
+    {
         return -1;
     }
-    return em->counter_num_of_events;
+    return eventIndexCountRange(em->events_index,date_to_key(from),date_to_key(to));
 }
 
-char* emGetNextEvent(EventManager em)
+int emCountEventsBefore(EventManager em, Date date)
 {
-    // char* c=NULL;
-    if(!em) {
-        return NULL;
-    }
-    if(em->counter_num_of_events==0) {
-        return NULL;
+    if(em==NULL||date==NULL)
+    {
+        return -1;
     }
-    Event_element element_check=pqGetFirst(em->queue);
-    if(!element_check) {
-        return NULL;
+    return eventScanCountLess(em->events.date_keys,em->events.used,date_to_key(date));
+}
+
+EventManagerResult emSetExportWorkers(EventManager em, int workers)
+{
+    if(em==NULL)
+    {
+        return EM_NULL_ARGUMENT;
     }
+    em->export_workers= workers<1 ? 1 : workers;
+    return EM_SUCCESS;
+}
 
-    return element_check->name;
+int emGetMemberEvents(EventManager em, int member_id, int* out, int cap)
+{
+    if(em==NULL||member_id<0||cap<0||(out==NULL&&cap>0))
+    {
+        return -1;
+    }
+    return memberIndexGetEvents(em->members_index,member_id,out,cap);
 }
 
+/**
+* Next_events_ctx: the arrays emGetNextEvents fills and their capacity.
+*/
+typedef struct next_events_ctx
+{
+    int* ids;
+    Date* dates;
+    int size;
+    int cap;
+}Next_events_ctx;
 
 /**
-* print_members: print the members.
+* collect_next_event: copies the id and the date of an event of the index.
 *
-* @param fid - the given file.
-* @param node_head - node we want to print.
+* @param date_key - the packed date of the event.
+* @param order - the insertion counter of the event.
+* @param data - the node of the event.
+* @param ctx - the arrays to fill.
+* @return
+* FALSE if the arrays are full.
+* otherwise TRUE.
 */
-static void print_members(FILE* fid,Node node_head)
+static bool collect_next_event(int date_key,int order,void* data,void* ctx)
 {
-    if (node_head==NULL){
-        return;
-    }
-    int max_id=0;
-    Node current=node_head;
-    while(current!=NULL){
-        if(current->id>max_id)max_id=current->id;
-        current=current->next;
-    }
-    char * members_names[max_id+1];
-    for (int i=0;i<max_id+1;i++)members_names[i]=NULL;
-
-    current=node_head;
-    while(current!=NULL){
-        char* new_name=  malloc(sizeof(char)*strlen(current->name)+1);
-        strcpy(new_name,current->name);
-        members_names[current->id]=new_name;
-        current=current->next;
+    Node event=data;
+    Next_events_ctx* next=ctx;
+    next->ids[next->size]=event->id;
+    if(next->dates!=NULL)
+    {
+        next->dates[next->size]=event->date;
     }
-    for (int i=0;i<max_id+1;i++) {
-        if (members_names[i] != NULL) {
-
-            //printf(",%s", members_names[i]);
-            fprintf(fid, ",%s", members_names[i]);
-        }
+    next->size++;
+    return next->size<next->cap;
+}
 
+int emGetNextEvents(EventManager em, int k, int* out_ids, Date* out_dates)
+{
+    if(em==NULL||k<0||(out_ids==NULL&&k>0))
+    {
+        return -1;
     }
-    fprintf( fid, "\n");
-    for(int i=0;i<max_id+1;i++){
-        if(members_names[i]){
-            free(members_names[i]);
-        }
+    Next_events_ctx next={out_ids,out_dates,0,k};
+    if(k>0)
+    {
+        eventIndexForEachRange(em->events_index,INT_MIN,INT_MAX,collect_next_event,&next);
     }
-    //free(members_names);
+    return next.size;
 }
 
-
-
 /**
-* print_members_by_counter: print the members but now according to the counter.
+* add_event_members: adds the members of an event of the index to a set.
 *
-* @param fid - the given file.
-* @param node_head - node we want to print.
-* @param counter - counter we want to print according to.
+* @param date_key - the packed date of the event.
+* @param order - the insertion counter of the event.
+* @param data - the node of the event.
+* @param ctx - the set of members.
+* @return
+* FALSE if allocation fails.
+* otherwise TRUE.
 */
-static void print_members_by_counter(FILE* fid,Node node_head,int counter)
+static bool add_event_members(int date_key,int order,void* data,void* ctx)
 {
-    if(!node_head){
-        return;
-    }
-    if(!node_head->name){
-        return;
-    }
-    int max_id=0;
-    Node current=node_head;
-    while(current!=NULL){
-        if(current->id>max_id)max_id=current->id;
-        current=current->next;
-    }
-    char *members_names[max_id+1];
-    for (int i=0;i<max_id+1;i++)members_names[i]=NULL;
-
-    current=node_head;
-    while(current!=NULL){
-        char* new_name=malloc(sizeof(char)*strlen(current->name)+1);
-        strcpy(new_name,current->name);
-        members_names[current->id]=new_name;
-        current=current->next;
-    }
-    for (int i=0;i<max_id+1;i++){
-        if(members_names[i]==NULL)continue;
-        fprintf(fid,"%s,%d\n",members_names[i], counter);
-    }
-    for (int i=0;i<max_id+1;i++){
-        if(members_names[i]){free(members_names[i]);}
-
+    Node event=data;
+    if(event->members==NULL)
+    {
+        return true;
     }
-//free(members_names);
+    return memberSetUnion(ctx,event->members)==MS_SUCCESS;
 }
 
-void emPrintAllEvents(EventManager em, const char* file_name)
+int emCountMembersInRange(EventManager em, Date from, Date to)
 {
-    int counter_tot = 0;
-    FILE* fid;
-    PriorityQueue queue_for_func =pqCopy(em->queue);
-    fid=fopen(file_name,"w");
-    Event_element element_lift =copy_element(pqGetFirst(queue_for_func)) ;
-    counter_tot=element_lift->counter;
-    Event_element element_right =copy_element( pqGetNext(queue_for_func));
-    while (pqGetSize(queue_for_func) != 0&&element_lift!=NULL){
-        if (if_still_in_p(element_lift, element_right,em->head_events)) {
-
-            if (element_right->counter < counter_tot)counter_tot = element_right->counter;
-            free_element(element_right);
-            element_right = copy_element(pqGetNext(queue_for_func));
-
-        }
-        else {
-            Node current=em->head_events;
-            while(current!=NULL){
-                if(current->counter==counter_tot)break;
-                current=current->next;
-            }
-
-            if(!current){
-                return;
-            }
-            int day=0;
-            int month=0;
-            int year=0;
-
-            dateGet(current->date,&day,&month,&year);
-
-            fprintf(fid,"%s,%d.%d.%d",current->name,day,month,year);
-            Event_element element=eventElement_create(current->name,current->id,current->counter);
-            Event_element wanted=Get_element(queue_for_func,element);
-
-            print_members(fid, wanted->members_head);
-            if(!wanted->members_head){
-                fprintf( fid, "\n");
-            }
-            pqRemoveElement(queue_for_func,element);
-            free_element(wanted);
-            free_element(element);
-
-            free_element(element_lift);
-            if(element_right){
-                free_element(element_right);
-            }
-
-            element_lift =copy_element(pqGetFirst(queue_for_func));
-            element_right = copy_element(pqGetNext(queue_for_func));
-            if(element_lift){
-                counter_tot=element_lift->counter;}
-        }
-
-
-    }
-    fclose(fid);
-    if(element_lift){
-        free_element(element_lift);
+    if(em==NULL||from==NULL||to==NULL)
+    {
+        return -1;
     }
-    if(element_right){
-        free_element(element_right);
+    MemberSet members=memberSetCreateWithAllocator(&em->allocator);
+    if(members==NULL)
+    {
+        return -1;
     }
-    pqDestroy(queue_for_func);
+    eventIndexForEachRange(em->events_index,date_to_key(from),date_to_key(to),
+                           add_event_members,members);
+    int count=memberSetGetSize(members);
+    memberSetDestroy(members);
+    return count;
 }
 
-
-void emPrintAllResponsibleMembers(EventManager em, const char* file_name)
+EventManagerResult emGetStats(EventManager em, EMStats* stats)
 {
-    FILE* fid=fopen(file_name,"w");
-    Node hash[em->counter_num_of_events+1];
-    for(int i=0;i<em->counter_num_of_events+1;i++)hash[i]=NULL;
-    Node current=em->members_in_sysem_head;
-    if(!em->members_in_sysem_head->name){
-        fclose(fid);
-        return;
-    }
-    while(current!=NULL){
-        Node   current_copied=createNode(current->name,current->id,current->counter,NULL);
-        current_copied->next=hash[current->counter];
-        hash[current->counter]=current_copied;
-        current=current->next;
-
+    if(em==NULL||stats==NULL)
+    {
+        return EM_NULL_ARGUMENT;
     }
-    for(int i=em->counter_num_of_events;i>0;i--) {
-        if(hash[i]){  print_members_by_counter(fid, hash[i], i);}
+#ifdef ENABLE_STATS
+    *stats=em->stats;
+    stats->allocations=alloc_stats.allocations;
+    stats->frees=alloc_stats.frees;
+    stats->bytes_live=alloc_stats.bytes_live;
+    stats->bytes_peak=alloc_stats.bytes_peak;
+#else
+    memset(stats,0,sizeof(*stats));
+    stats->enabled=false;
+#endif
+    eventQueueGetStats(em->queue,&stats->queue);
+    return EM_SUCCESS;
+}
 
+EventManagerResult emPrintStats(EventManager em, FILE* stream)
+{
+    static const char* const call_names[EM_CALLS_NUM]={
+            "emAddEventByDate","emAddEventByDiff","emRemoveEvent","emChangeEventDate",
+            "emAddMember","emAddMemberToEvent","emRemoveMemberFromEvent","emTick",
+            "emGetNextEvent","emPrintAllEvents","emPrintAllResponsibleMembers"};
+    if(em==NULL||stream==NULL)
+    {
+        return EM_NULL_ARGUMENT;
     }
-
-    fclose(fid);
-
-
-    for(int i=0;i<em->counter_num_of_events+1;i++){
-        if(hash[i]){
-            Destroy_Node(hash[i]);
+    EMStats stats;
+    emGetStats(em,&stats);
+    fprintf(stream,"em_stats_enabled %d\n",stats.enabled);
+    fprintf(stream,"em_lookups %ld\n",stats.lookups);
+    fprintf(stream,"em_nodes_scanned %ld\n",stats.nodes_scanned);
+    fprintf(stream,"em_allocations %ld\n",stats.allocations);
+    fprintf(stream,"em_frees %ld\n",stats.frees);
+    fprintf(stream,"em_bytes_live %ld\n",stats.bytes_live);
+    fprintf(stream,"em_bytes_peak %ld\n",stats.bytes_peak);
+    for(int i=0;i<EM_CALLS_NUM;i++){
+        EMLatency* latency=&stats.calls[i];
+        if(latency->calls==0)
+        {
+            continue;
         }
+        fprintf(stream,"em_call %s calls %ld total_ns %ld max_ns %ld histogram",call_names[i],
+                latency->calls,latency->total_ns,latency->max_ns);
+        for(int j=0;j<EM_LATENCY_BUCKETS;j++){
+            fprintf(stream," %ld",latency->buckets[j]);
+        }
+        fprintf(stream,"\n");
     }
+    pqWriteStats(&stats.queue,stream);
+    return EM_SUCCESS;
 }
\ No newline at end of file
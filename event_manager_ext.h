@@ -0,0 +1,560 @@
+#ifndef EVENT_MANAGER_EXT_H
+#define EVENT_MANAGER_EXT_H
+
+#include "event_manager.h"
+#include "priority_queue_ext.h"
+#include "date.h"
+#include "allocator.h"
+#include "notification_ring.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+* Result codes of the limits set by emSetMemberLimits, which follow the codes
+* declared in event_manager.h.
+*/
+#define EM_EVENT_MEMBERS_LIMIT_REACHED ((EventManagerResult)(EM_ERROR + 1))
+#define EM_MEMBER_DATE_CONFLICT ((EventManagerResult)(EM_ERROR + 2))
+
+/**
+* Event Manager extensions
+*
+* Additional queries over an EventManager that are not part of the basic
+* interface declared in event_manager.h.
+*
+* The following functions are available:
+*   createEventManagerWithAllocator - Creates an event manager whose memory is allocated by an allocator.
+*   emAddRecurringEvent     - Adds an event that repeats every given number of days.
+*   emTickWithCallback      - Advances the date and reports every event that expired.
+*   emForEachEventInRange   - Visits the events between two dates in order.
+*   emCountEventsInRange    - Counts the events between two dates.
+*   emCountEventsBefore     - Counts the events earlier than a date.
+*   emGetMemberEvents       - Returns the events a member is linked to in date order.
+*   emGetNextEvents         - Returns the k earliest events.
+*   emCountMembersInRange   - Counts the distinct members of the events between two dates.
+*   emSetExportWorkers      - Sets the number of threads formatting the printed files.
+*   emGetVersion            - Returns the version of the latest change of the events.
+*   emExportDelta           - Prints the events that changed since a version.
+*   emExportBinary          - Writes the events and the members in the binary columnar format.
+*   emGetMemoryUsage        - Returns the memory footprint of an event manager by category.
+*   emEnableNotifications   - Starts publishing every change to a notification ring.
+*   emGetNotifications      - Returns the notification ring of an event manager.
+*   emSetMemberLimits       - Limits the members of an event and the events of a member on a date.
+*   emSnapshot              - Takes a read-only snapshot of the events and the members.
+*   emSnapshotDestroy       - Deletes a snapshot.
+*   emSnapshotGetEventsAmount - Returns the number of events in a snapshot.
+*   emSnapshotGetVersion    - Returns the version of the latest change a snapshot includes.
+*   emSnapshotPrintAllEvents - Prints the events of a snapshot as emPrintAllEvents.
+*   emSnapshotPrintAllResponsibleMembers - Prints the members of a snapshot as emPrintAllResponsibleMembers.
+*   emGetStats              - Returns the instrumentation counters of an event manager.
+*   emPrintStats            - Writes the instrumentation counters of an event manager as text.
+*/
+
+/**
+* createEventManagerWithAllocator: Allocates a new event manager, as
+* createEventManager, whose events, members, their names and dates, the event
+* queue, the event table, the member sets of the events, the date and member
+* indexes, the slot maps, the change log and the booking index are allocated
+* and freed through allocator. The versioned views and the snapshots still use
+* malloc, since snapshots may be released on other threads, and so do the
+* notification ring and the temporary buffers of exports and queries.
+* Dates passed to the event manager are copied, so the caller keeps its own.
+* The functions of the allocator are only called by the thread that calls the
+* event manager.
+*
+* @param date - The date the event manager starts at.
+* @param allocator - The allocator, copied into the event manager. NULL for malloc.
+* @return
+*   NULL - if date is NULL or allocation failed.
+*   A new event manager in case of success.
+*/
+EventManager createEventManagerWithAllocator(Date date, const Allocator* allocator);
+
+/**
+* emAddRecurringEvent: Adds an event that repeats every period_days days,
+* stored as a single rule. Occurrence k, counting from 0, falls period_days*k
+* days after first_date and has the id base_id+k. Only the current occurrence
+* is an event: it is found, printed, changed and linked to members like any
+* other event. When emTick expires it, the next occurrence is created with the
+* same name and members. Occurrences that would already be expired, or whose
+* id or name and date belong to another event at that time, are skipped.
+* Removing the current occurrence with emRemoveEvent ends the series.
+*
+* @param em - The event manager to add to.
+* @param event_name - The name of the occurrences.
+* @param first_date - The date of the first occurrence.
+* @param period_days - The number of days between two occurrences.
+* @param count - The number of occurrences, 0 for no limit.
+* @param until - The last date an occurrence may fall on, NULL for no limit.
+* @param base_id - The id of the first occurrence.
+* @return
+*   EM_NULL_ARGUMENT if em or event_name is NULL.
+*   EM_INVALID_DATE if first_date is NULL or earlier than the current date,
+*     period_days is not positive, or until is earlier than first_date.
+*   EM_INVALID_EVENT_ID if base_id is negative.
+*   EM_ERROR if count is negative.
+*   EM_EVENT_ALREADY_EXISTS if an event with the same name is on first_date.
+*   EM_EVENT_ID_ALREADY_EXISTS if an event has the id base_id.
+*   EM_OUT_OF_MEMORY if an allocation failed.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emAddRecurringEvent(EventManager em, char* event_name, Date first_date,
+                                       int period_days, int count, Date until, int base_id);
+
+/**
+* Type of function called by emTickWithCallback for every expired event.
+* The name and the date belong to the event manager and must not be changed or
+* freed, and the event manager must not be changed from the callback.
+*/
+typedef void (*EventExpiryCallback)(char* event_name, int event_id, Date date, void* ctx);
+
+/**
+* emTickWithCallback: Advances the current date as emTick does, and calls
+* callback on every event that expired, ordered by date and then by insertion
+* order, just before it is removed. The expired events are removed in one
+* pass: the counters of their members are updated in a single walk over the
+* members and their storage is released together.
+*
+* @param em - The event manager to advance.
+* @param days - The number of days to advance.
+* @param callback - Function called for every expired event, may be NULL.
+* @param ctx - Passed as is to callback.
+* @return
+*   EM_NULL_ARGUMENT if em is NULL.
+*   EM_INVALID_DATE if days is not positive.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emTickWithCallback(EventManager em, int days, EventExpiryCallback callback, void* ctx);
+
+/**
+* Type of function called by emForEachEventInRange for every event in the range.
+* The name and the date belong to the event manager and must not be changed or freed.
+*/
+typedef void (*EventRangeCallback)(char* event_name, int event_id, Date date, void* ctx);
+
+/**
+* emForEachEventInRange: Calls callback on every event whose date is between
+* from and to (both inclusive), ordered by date and then by insertion order.
+* Runs in O(log n + number of events in the range).
+*
+* @param em - The event manager to query.
+* @param from - The first date of the range.
+* @param to - The last date of the range.
+* @param callback - Function called for every event in the range.
+* @param ctx - Passed as is to callback.
+* @return
+*   EM_NULL_ARGUMENT if em or callback is NULL.
+*   EM_INVALID_DATE if from or to is NULL.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emForEachEventInRange(EventManager em, Date from, Date to,
+                                         EventRangeCallback callback, void* ctx);
+
+/**
+* emCountEventsInRange: Counts the events whose date is between from and to
+* (both inclusive). Runs in O(log n).
+*
+* @param em - The event manager to query.
+* @param from - The first date of the range.
+* @param to - The last date of the range.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the number of events in the range.
+*/
+int emCountEventsInRange(EventManager em, Date from, Date to);
+
+/**
+* emCountEventsBefore: Counts the events whose date is earlier than date, i.e.
+* the events the next emTick to date would remove. Scans the packed dates of
+* the events with the widest vector kernel the CPU supports.
+*
+* @param em - The event manager to query.
+* @param date - The date to compare to, not included.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the number of events earlier than date.
+*/
+int emCountEventsBefore(EventManager em, Date date);
+
+/**
+* emGetMemberEvents: Copies the ids of the events a member is linked to into
+* out, ordered by date and then by insertion order. At most cap ids are copied.
+* Runs in O(number of events of the member).
+*
+* @param em - The event manager to query.
+* @param member_id - The id of the member.
+* @param out - Array that receives the event ids. May be NULL if cap is 0.
+* @param cap - The number of ids out can hold.
+* @return
+*   -1 if a NULL pointer was sent, or the member does not exist.
+*   Otherwise the number of events linked to the member, which may be larger than cap.
+*/
+int emGetMemberEvents(EventManager em, int member_id, int* out, int cap);
+
+/**
+* emGetNextEvents: Copies the ids and the dates of the k earliest events,
+* ordered by date and then by the order they were added, as emPrintAllEvents
+* orders them. Nothing is copied but the ids and the date handles, and it runs
+* in O(log n + k).
+* emGetNextEvent may return another event of the earliest date: it keeps the
+* order of the original event queue, where linking a member to an event or
+* unlinking one moves the event behind the other events of its date.
+*
+* @param em - The event manager to query.
+* @param k - The number of events out_ids and out_dates can hold.
+* @param out_ids - Array that receives the event ids. May be NULL if k is 0.
+* @param out_dates - Array that receives the dates of the events, or NULL. The
+*   dates belong to the event manager and stay valid until it changes.
+* @return
+*   -1 if a NULL pointer was sent or k is negative.
+*   Otherwise the number of events copied, the smaller of k and the number of events.
+*/
+int emGetNextEvents(EventManager em, int k, int* out_ids, Date* out_dates);
+
+/**
+* emCountMembersInRange: Counts the distinct members linked to at least one
+* event whose date is between from and to (both inclusive).
+*
+* @param em - The event manager to query.
+* @param from - The first date of the range.
+* @param to - The last date of the range.
+* @return
+*   -1 if a NULL pointer was sent or a memory allocation failed.
+*   Otherwise the number of distinct members.
+*/
+int emCountMembersInRange(EventManager em, Date from, Date to);
+
+/**
+* emSetExportWorkers: Sets the number of threads emPrintAllEvents and
+* emPrintAllResponsibleMembers format the file with. The lines of the file
+* are split into chunks that the threads format in parallel, and the chunks
+* are written in order, so the file does not depend on the number of threads.
+* An event manager starts with a single thread, the calling one.
+*
+* @param em - The event manager to configure.
+* @param workers - The number of threads, values smaller than 1 are treated as 1.
+* @return
+*   EM_NULL_ARGUMENT if em is NULL.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emSetExportWorkers(EventManager em, int workers);
+
+/**
+* emGetVersion: Returns the version of the events of an event manager. The
+* version starts at 0 and grows by one on every change of an event: adding
+* or removing it (emTick included), changing its date, and linking or
+* unlinking a member.
+*
+* @param em - The event manager to query.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the current version.
+*/
+long emGetVersion(EventManager em);
+
+/**
+* emExportDelta: Prints the events that changed after since_version, so a
+* reader of the file printed by emPrintAllEvents at since_version can update
+* it. The first line is "version,<current version>", followed by one line for
+* every changed event ordered by event id:
+*   "event,<id>,<name>,<day>.<month>.<year>[,<member name>...]" if the event
+*   exists, with its members ordered as in emPrintAllEvents.
+*   "removed,<id>" if the event does not exist any more. An event that was
+*   added and removed after since_version is reported as removed too.
+* Runs in O(k log k + n log k) for k changed events out of n.
+*
+* @param em - The event manager to print.
+* @param since_version - The version the reader is up to date with.
+* @param file_name - The name of the file to write.
+* @return
+*   EM_NULL_ARGUMENT if em or file_name is NULL.
+*   EM_ERROR if since_version is negative, later than the current version or
+*     no longer available, or if the file could not be written.
+*   EM_OUT_OF_MEMORY if an allocation failed.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emExportDelta(EventManager em, long since_version, const char* file_name);
+
+/**
+* emExportBinary: Writes the events and the members to a file descriptor in
+* the columnar format of schedule_file.h, to be loaded with scheduleFileRead
+* or scheduleFileMap. The events are in the order of emPrintAllEvents and
+* the members are ordered by id. Each event links to its members in id order.
+* The descriptor is not closed.
+*
+* @param em - The event manager to export.
+* @param fd - The file descriptor to write to.
+* @return
+*   EM_NULL_ARGUMENT if em is NULL.
+*   EM_OUT_OF_MEMORY if an allocation failed.
+*   EM_ERROR if writing failed.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emExportBinary(EventManager em, int fd);
+
+/**
+* Memory footprint of an event manager in bytes, by category. Every byte is
+* counted in a single category, and total is their sum. Allocator overhead,
+* the event manager structure itself and snapshots are not included.
+*   event_records   - the event nodes, the rules of the recurring events and
+*                     the columns of the event table.
+*   queue_nodes     - the event queue and its nodes.
+*   member_table    - the nodes of the members added to the event manager,
+*                     and the table of the members indexed by their slots.
+*   link_storage    - the member sets of the events, which are the only record
+*                     of the links of the events to their members.
+*   name_strings    - the names of the events and the members.
+*   dates           - the dates of the events, the members and the rules, and
+*                     the current date.
+*   event_index     - the skip list of the events ordered by date.
+*   member_index    - the events of every member ordered by date.
+*   slot_maps       - the slot maps of the event table and the member table.
+*   change_log      - the log of the changed events.
+*   booking_index   - the events of every member per date, kept while
+*                     emSetMemberLimits limits them.
+*   views           - the versioned views of the events and the members, with
+*                     the pages and records they share with snapshots. The
+*                     views are kept from the first snapshot until the first
+*                     change after the last snapshot is destroyed.
+*   notifications   - the notification ring, when notifications are enabled.
+*/
+typedef struct EMMemoryUsage_t {
+    long event_records;
+    long queue_nodes;
+    long member_table;
+    long link_storage;
+    long name_strings;
+    long dates;
+    long event_index;
+    long member_index;
+    long slot_maps;
+    long change_log;
+    long booking_index;
+    long views;
+    long notifications;
+    long total;
+} EMMemoryUsage;
+
+/**
+* emGetMemoryUsage: Returns the memory footprint of an event manager. The
+* categories are updated where their memory is allocated and freed, so the
+* query runs in O(1).
+*
+* @param em - The event manager to measure.
+* @param usage - Receives the footprint.
+* @return
+*   EM_NULL_ARGUMENT if em or usage is NULL.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emGetMemoryUsage(EventManager em, EMMemoryUsage* usage);
+
+/**
+* emEnableNotifications: Creates a notification ring for an event manager and
+* starts publishing every change to it: events added, removed, moved or
+* expired, and members linked to or unlinked from events. The version of a
+* notification is the version emGetVersion returns after the change.
+* Publishing never blocks the event manager, when the ring is full the
+* notification is dropped, see notificationRingGetDropped. The ring is
+* destroyed with the event manager.
+*
+* @param em - The event manager to publish from.
+* @param capacity - The number of notifications the ring holds, a power of 2.
+* @return
+*   EM_NULL_ARGUMENT if em is NULL.
+*   EM_ERROR if capacity is not a power of 2 or notifications are already enabled.
+*   EM_OUT_OF_MEMORY if an allocation failed.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emEnableNotifications(EventManager em, int capacity);
+
+/**
+* emGetNotifications: Returns the notification ring of an event manager.
+* Any number of threads may take notifications out of it with
+* notificationRingConsume while the event manager is used by its own thread.
+*
+* @param em - The event manager.
+* @return
+*   NULL if em is NULL or notifications are not enabled.
+*   Otherwise the ring.
+*/
+NotificationRing emGetNotifications(EventManager em);
+
+/**
+* emSetMemberLimits: Limits the number of members linked to an event, and the
+* number of events a member is linked to on the same date. The limits are
+* checked by emAddMemberToEvent and emChangeEventDate, and by the next
+* occurrence of a recurring event, which leaves out the members it cannot
+* take. The events of every member on every date are counted in a hash index
+* while the second limit is set, so the check takes O(1). Links made before
+* the limits were set are kept even if they break them.
+* An event manager starts with no limits.
+*
+* @param em - The event manager to configure.
+* @param max_members_per_event - The most members of an event, 0 for no limit.
+* @param max_events_per_member_per_date - The most events of a member on a date, 0 for no limit.
+* @return
+*   EM_NULL_ARGUMENT if em is NULL.
+*   EM_ERROR if a limit is negative.
+*   EM_OUT_OF_MEMORY if an allocation failed, the limits are unchanged.
+*   EM_SUCCESS otherwise.
+*   Once set, emAddMemberToEvent returns EM_EVENT_MEMBERS_LIMIT_REACHED when the
+*   event is full, and emAddMemberToEvent and emChangeEventDate return
+*   EM_MEMBER_DATE_CONFLICT when a member would have too many events on a date.
+*/
+EventManagerResult emSetMemberLimits(EventManager em, int max_members_per_event,
+                                     int max_events_per_member_per_date);
+
+/** Type for defining a snapshot of an event manager */
+typedef struct EMSnapshot_t *EMSnapshot;
+
+/**
+* emSnapshot: Takes a read-only snapshot of the events and the members of an
+* event manager. Snapshots share their memory with the event manager, which
+* copies a small page of records before it changes a record a snapshot holds,
+* so a snapshot keeps the state it was taken at however the event manager
+* changes, and survives its destruction.
+* The first snapshot of an event manager builds its versioned records in
+* O(n), after which the records are kept up to date by every change and a
+* snapshot is taken in O(1). Once every snapshot has been destroyed, the next
+* change drops the records, so changes cost nothing extra until the next
+* snapshot builds them again.
+* emSnapshot must be called by the thread that changes the event manager. The
+* snapshot may then be printed and destroyed by any other single thread while
+* the event manager goes on changing.
+*
+* @param em - The event manager.
+* @return
+*   NULL - if a NULL was sent or allocation failed.
+*   A new snapshot in case of success.
+*/
+EMSnapshot emSnapshot(EventManager em);
+
+/**
+* emSnapshotDestroy: Deallocates a snapshot.
+*
+* @param snapshot - Target snapshot to be deallocated. If snapshot is NULL nothing will be done.
+*/
+void emSnapshotDestroy(EMSnapshot snapshot);
+
+/**
+* emSnapshotGetEventsAmount: Returns the number of events in a snapshot.
+*
+* @param snapshot - The snapshot.
+* @return
+*   -1 if a NULL was sent.
+*   Otherwise the number of events.
+*/
+int emSnapshotGetEventsAmount(EMSnapshot snapshot);
+
+/**
+* emSnapshotGetVersion: Returns the version of the latest change included in a
+* snapshot, as emGetVersion returned when the snapshot was taken.
+*
+* @param snapshot - The snapshot.
+* @return
+*   -1 if a NULL was sent.
+*   Otherwise the version.
+*/
+long emSnapshotGetVersion(EMSnapshot snapshot);
+
+/**
+* emSnapshotPrintAllEvents: Prints the events of a snapshot to a file in the
+* format and the order of emPrintAllEvents, on the number of threads set by
+* emSetExportWorkers when the snapshot was taken.
+*
+* @param snapshot - The snapshot to print.
+* @param file_name - The file to print to.
+* @return
+*   EM_NULL_ARGUMENT if a NULL was sent.
+*   EM_OUT_OF_MEMORY if allocation failed.
+*   EM_ERROR if the file could not be written.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emSnapshotPrintAllEvents(EMSnapshot snapshot, const char* file_name);
+
+/**
+* emSnapshotPrintAllResponsibleMembers: Prints the members of a snapshot that
+* are linked to events to a file in the format and the order of
+* emPrintAllResponsibleMembers.
+*
+* @param snapshot - The snapshot to print.
+* @param file_name - The file to print to.
+* @return
+*   EM_NULL_ARGUMENT if a NULL was sent.
+*   EM_OUT_OF_MEMORY if allocation failed.
+*   EM_ERROR if the file could not be written.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emSnapshotPrintAllResponsibleMembers(EMSnapshot snapshot, const char* file_name);
+
+/** Number of buckets of a latency histogram, bucket i counts calls of [2^i, 2^(i+1)) ns */
+#define EM_LATENCY_BUCKETS 32
+
+/** The API calls whose latency is measured */
+typedef enum EMCall_t {
+    EM_CALL_ADD_EVENT_BY_DATE,
+    EM_CALL_ADD_EVENT_BY_DIFF,
+    EM_CALL_REMOVE_EVENT,
+    EM_CALL_CHANGE_EVENT_DATE,
+    EM_CALL_ADD_MEMBER,
+    EM_CALL_ADD_MEMBER_TO_EVENT,
+    EM_CALL_REMOVE_MEMBER_FROM_EVENT,
+    EM_CALL_TICK,
+    EM_CALL_GET_NEXT_EVENT,
+    EM_CALL_PRINT_ALL_EVENTS,
+    EM_CALL_PRINT_ALL_RESPONSIBLE_MEMBERS,
+    EM_CALLS_NUM
+} EMCall;
+
+/** Latency histogram of one API call */
+typedef struct EMLatency_t {
+    long calls;
+    long total_ns;
+    long max_ns;
+    long buckets[EM_LATENCY_BUCKETS];
+} EMLatency;
+
+/**
+* Instrumentation counters of an event manager. The counters are only
+* maintained when event_manager.c is compiled with ENABLE_STATS defined,
+* otherwise enabled is false and all the counters are 0.
+* The allocation counters cover every allocation made by event_manager.c
+* in the process, the other counters belong to the given event manager.
+*/
+typedef struct EMStats_t {
+    bool enabled;
+    long lookups;
+    long nodes_scanned;
+    long allocations;
+    long frees;
+    long bytes_live;
+    long bytes_peak;
+    EMLatency calls[EM_CALLS_NUM];
+    PQStats queue;
+} EMStats;
+
+/**
+* emGetStats: Copies the instrumentation counters of an event manager,
+* including the counters of its priority queue.
+*
+* @param em - The event manager whose counters are requested.
+* @param stats - Receives the counters.
+* @return
+*   EM_NULL_ARGUMENT if a NULL was sent.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emGetStats(EventManager em, EMStats* stats);
+
+/**
+* emPrintStats: Writes the instrumentation counters of an event manager as
+* "name value" lines, followed by the counters of its priority queue.
+*
+* @param em - The event manager whose counters are printed.
+* @param stream - The stream to write to.
+* @return
+*   EM_NULL_ARGUMENT if a NULL was sent.
+*   EM_SUCCESS otherwise.
+*/
+EventManagerResult emPrintStats(EventManager em, FILE* stream);
+
+#endif /* EVENT_MANAGER_EXT_H */
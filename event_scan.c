@@ -0,0 +1,326 @@
+#include "event_scan.h"
+#include <stdbool.h>
+#include <stddef.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define HAS_X86_KERNELS 0
+#endif
+#define SSE2_LANES 4
+#define AVX2_LANES 8
+
+typedef struct scan_kernels
+{
+    EventScanKernel kernel;
+    int (*find)(const int* column,int from,int size,int value);
+    int (*find_pair)(const int* column1,const int* column2,int from,int size,int value1,int value2);
+    int (*count_less)(const int* column,int size,int value);
+}Scan_kernels;
+
+/**
+* find_scalar: looks for the first value of a column, one element at a time.
+*
+* @param column - the column to search in.
+* @param from - the first index to check.
+* @param size - the number of elements in the column.
+* @param value - the value to look for.
+* @return
+* -1 - if no element from the index on equals the value.
+* otherwise the index of the first one.
+*/
+static int find_scalar(const int* column,int from,int size,int value)
+{
+    for(int i=from;i<size;i++){
+        if(column[i]==value)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+* find_pair_scalar: looks for the first index where two columns hold two
+* values, one element at a time.
+*
+* @param column1 - the first column to search in.
+* @param column2 - the second column, of the same size.
+* @param from - the first index to check.
+* @param size - the number of elements in the columns.
+* @param value1 - the value to look for in the first column.
+* @param value2 - the value to look for in the second column.
+* @return
+* -1 - if there is no such index from the index on.
+* otherwise the first such index.
+*/
+static int find_pair_scalar(const int* column1,const int* column2,int from,int size,int value1,int value2)
+{
+    for(int i=from;i<size;i++){
+        if(column1[i]==value1&&column2[i]==value2)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+* count_less_scalar: counts the elements of a column that are smaller than a
+* value, one element at a time.
+*
+* @param column - the column to count in.
+* @param size - the number of elements in the column.
+* @param value - the value to compare to.
+* @return
+* the number of smaller elements.
+*/
+static int count_less_scalar(const int* column,int size,int value)
+{
+    int count=0;
+    for(int i=0;i<size;i++){
+        count+=column[i]<value;
+    }
+    return count;
+}
+
+static const Scan_kernels scalar_kernels={ES_KERNEL_SCALAR,find_scalar,find_pair_scalar,count_less_scalar};
+
+#if HAS_X86_KERNELS
+/**
+* find_sse2: find_scalar comparing 4 elements at a time, the elements left
+* after the last full group are checked by find_scalar.
+*/
+__attribute__((target("sse2")))
+static int find_sse2(const int* column,int from,int size,int value)
+{
+    __m128i target=_mm_set1_epi32(value);
+    int i=from;
+    for(;i+SSE2_LANES<=size;i+=SSE2_LANES){
+        __m128i lanes=_mm_loadu_si128((const __m128i*)(column+i));
+        int mask=_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(lanes,target)));
+        if(mask!=0)
+        {
+            return i+__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return find_scalar(column,i,size,value);
+}
+
+/**
+* find_pair_sse2: find_pair_scalar comparing 4 elements of each column at a
+* time, the elements left after the last full group are checked by
+* find_pair_scalar.
+*/
+__attribute__((target("sse2")))
+static int find_pair_sse2(const int* column1,const int* column2,int from,int size,int value1,int value2)
+{
+    __m128i target1=_mm_set1_epi32(value1);
+    __m128i target2=_mm_set1_epi32(value2);
+    int i=from;
+    for(;i+SSE2_LANES<=size;i+=SSE2_LANES){
+        __m128i lanes1=_mm_loadu_si128((const __m128i*)(column1+i));
+        __m128i lanes2=_mm_loadu_si128((const __m128i*)(column2+i));
+        __m128i equal=_mm_and_si128(_mm_cmpeq_epi32(lanes1,target1),_mm_cmpeq_epi32(lanes2,target2));
+        int mask=_mm_movemask_ps(_mm_castsi128_ps(equal));
+        if(mask!=0)
+        {
+            return i+__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return find_pair_scalar(column1,column2,i,size,value1,value2);
+}
+
+/**
+* count_less_sse2: count_less_scalar keeping 4 counts, one per lane, which
+* are summed at the end together with the count of the elements left.
+*/
+__attribute__((target("sse2")))
+static int count_less_sse2(const int* column,int size,int value)
+{
+    __m128i target=_mm_set1_epi32(value);
+    __m128i counts=_mm_setzero_si128();
+    int i=0;
+    for(;i+SSE2_LANES<=size;i+=SSE2_LANES){
+        __m128i lanes=_mm_loadu_si128((const __m128i*)(column+i));
+        counts=_mm_sub_epi32(counts,_mm_cmplt_epi32(lanes,target));
+    }
+    int lane_counts[SSE2_LANES];
+    _mm_storeu_si128((__m128i*)lane_counts,counts);
+    int count=0;
+    for(int j=0;j<SSE2_LANES;j++){
+        count+=lane_counts[j];
+    }
+    return count+count_less_scalar(column+i,size-i,value);
+}
+
+/**
+* find_avx2: find_scalar comparing 8 elements at a time, the elements left
+* after the last full group are checked by find_scalar.
+*/
+__attribute__((target("avx2")))
+static int find_avx2(const int* column,int from,int size,int value)
+{
+    __m256i target=_mm256_set1_epi32(value);
+    int i=from;
+    for(;i+AVX2_LANES<=size;i+=AVX2_LANES){
+        __m256i lanes=_mm256_loadu_si256((const __m256i*)(column+i));
+        int mask=_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lanes,target)));
+        if(mask!=0)
+        {
+            return i+__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return find_scalar(column,i,size,value);
+}
+
+/**
+* find_pair_avx2: find_pair_scalar comparing 8 elements of each column at a
+* time, the elements left after the last full group are checked by
+* find_pair_scalar.
+*/
+__attribute__((target("avx2")))
+static int find_pair_avx2(const int* column1,const int* column2,int from,int size,int value1,int value2)
+{
+    __m256i target1=_mm256_set1_epi32(value1);
+    __m256i target2=_mm256_set1_epi32(value2);
+    int i=from;
+    for(;i+AVX2_LANES<=size;i+=AVX2_LANES){
+        __m256i lanes1=_mm256_loadu_si256((const __m256i*)(column1+i));
+        __m256i lanes2=_mm256_loadu_si256((const __m256i*)(column2+i));
+        __m256i equal=_mm256_and_si256(_mm256_cmpeq_epi32(lanes1,target1),
+                                       _mm256_cmpeq_epi32(lanes2,target2));
+        int mask=_mm256_movemask_ps(_mm256_castsi256_ps(equal));
+        if(mask!=0)
+        {
+            return i+__builtin_ctz((unsigned int)mask);
+        }
+    }
+    return find_pair_scalar(column1,column2,i,size,value1,value2);
+}
+
+/**
+* count_less_avx2: count_less_scalar keeping 8 counts, one per lane, which
+* are summed at the end together with the count of the elements left.
+*/
+__attribute__((target("avx2")))
+static int count_less_avx2(const int* column,int size,int value)
+{
+    __m256i target=_mm256_set1_epi32(value);
+    __m256i counts=_mm256_setzero_si256();
+    int i=0;
+    for(;i+AVX2_LANES<=size;i+=AVX2_LANES){
+        __m256i lanes=_mm256_loadu_si256((const __m256i*)(column+i));
+        counts=_mm256_sub_epi32(counts,_mm256_cmpgt_epi32(target,lanes));
+    }
+    int lane_counts[AVX2_LANES];
+    _mm256_storeu_si256((__m256i*)lane_counts,counts);
+    int count=0;
+    for(int j=0;j<AVX2_LANES;j++){
+        count+=lane_counts[j];
+    }
+    return count+count_less_scalar(column+i,size-i,value);
+}
+
+static const Scan_kernels sse2_kernels={ES_KERNEL_SSE2,find_sse2,find_pair_sse2,count_less_sse2};
+static const Scan_kernels avx2_kernels={ES_KERNEL_AVX2,find_avx2,find_pair_avx2,count_less_avx2};
+#endif
+
+/**
+* The kernels in use, NULL until they are selected. Scans may run on several
+* threads at once, so the pointer is only read and written atomically.
+*/
+static const Scan_kernels* kernels=NULL;
+
+/**
+* kernels_of: returns the kernels of a kind if the CPU supports them.
+*
+* @param kernel - the kind of kernels.
+* @return
+* NULL - if the CPU does not support the kernels.
+* otherwise the kernels.
+*/
+static const Scan_kernels* kernels_of(EventScanKernel kernel)
+{
+    switch(kernel)
+    {
+        case ES_KERNEL_SCALAR:
+            return &scalar_kernels;
+#if HAS_X86_KERNELS
+        case ES_KERNEL_SSE2:
+            return __builtin_cpu_supports("sse2") ? &sse2_kernels : NULL;
+        case ES_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+/**
+* get_kernels: returns the kernels in use, selecting the best supported ones
+* on the first call. Threads that make the first call at the same time all
+* select the same kernels, so it does not matter which one stores them.
+*/
+static const Scan_kernels* get_kernels(void)
+{
+    const Scan_kernels* selected=__atomic_load_n(&kernels,__ATOMIC_ACQUIRE);
+    if(selected==NULL)
+    {
+        selected=kernels_of(ES_KERNEL_AVX2);
+        if(selected==NULL)
+        {
+            selected=kernels_of(ES_KERNEL_SSE2);
+        }
+        if(selected==NULL)
+        {
+            selected=&scalar_kernels;
+        }
+        __atomic_store_n(&kernels,selected,__ATOMIC_RELEASE);
+    }
+    return selected;
+}
+
+int eventScanFind(const int* column, int from, int size, int value)
+{
+    if(column==NULL||from<0||from>=size)
+    {
+        return -1;
+    }
+    return get_kernels()->find(column,from,size,value);
+}
+
+int eventScanFindPair(const int* column1, const int* column2, int from, int size,
+                      int value1, int value2)
+{
+    if(column1==NULL||column2==NULL||from<0||from>=size)
+    {
+        return -1;
+    }
+    return get_kernels()->find_pair(column1,column2,from,size,value1,value2);
+}
+
+int eventScanCountLess(const int* column, int size, int value)
+{
+    if(column==NULL||size<=0)
+    {
+        return 0;
+    }
+    return get_kernels()->count_less(column,size,value);
+}
+
+EventScanKernel eventScanGetKernel(void)
+{
+    return get_kernels()->kernel;
+}
+
+bool eventScanSetKernel(EventScanKernel kernel)
+{
+    const Scan_kernels* selected=kernels_of(kernel);
+    if(selected==NULL)
+    {
+        return false;
+    }
+    __atomic_store_n(&kernels,selected,__ATOMIC_RELEASE);
+    return true;
+}
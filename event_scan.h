@@ -0,0 +1,86 @@
+#ifndef EVENT_SCAN_H_
+#define EVENT_SCAN_H_
+
+#include <stdbool.h>
+
+/**
+* Event Scan
+*
+* Scan kernels over packed int32 columns, such as the ids and the packed
+* dates of the events. Every scan has an AVX2 kernel, an SSE2 kernel and a
+* scalar fallback. The best kernel the CPU supports is selected at runtime on
+* the first scan, and all the kernels return the same results.
+*
+* The following functions are available:
+*   eventScanFind           - Finds the next entry of a column equal to a value.
+*   eventScanFindPair       - Finds the next entry of two columns equal to two values.
+*   eventScanCountLess      - Counts the entries of a column smaller than a value.
+*   eventScanGetKernel      - Returns the kernel that is used.
+*   eventScanSetKernel      - Forces a kernel, e.g. to compare kernels.
+*/
+
+/** The kernels of the scans */
+typedef enum EventScanKernel_t {
+    ES_KERNEL_SCALAR,
+    ES_KERNEL_SSE2,
+    ES_KERNEL_AVX2
+} EventScanKernel;
+
+/**
+* eventScanFind: Finds the first entry in column[from..size-1] equal to value.
+*
+* @param column - The column to scan.
+* @param from - The first position to scan.
+* @param size - The number of entries of the column.
+* @param value - The value to look for.
+* @return
+*   -1 if no such entry exists.
+*   Otherwise the position of the entry.
+*/
+int eventScanFind(const int* column, int from, int size, int value);
+
+/**
+* eventScanFindPair: Finds the first position i in [from, size) where
+* column1[i] equals value1 and column2[i] equals value2.
+*
+* @param column1 - The first column to scan.
+* @param column2 - The second column to scan, with the same size.
+* @param from - The first position to scan.
+* @param size - The number of entries of the columns.
+* @param value1 - The value to look for in column1.
+* @param value2 - The value to look for in column2.
+* @return
+*   -1 if no such position exists.
+*   Otherwise the position.
+*/
+int eventScanFindPair(const int* column1, const int* column2, int from, int size,
+                      int value1, int value2);
+
+/**
+* eventScanCountLess: Counts the entries of a column that are smaller than value.
+*
+* @param column - The column to scan.
+* @param size - The number of entries of the column.
+* @param value - The bound, not included.
+* @return
+*   The number of entries smaller than value.
+*/
+int eventScanCountLess(const int* column, int size, int value);
+
+/**
+* eventScanGetKernel: Returns the kernel used by the scans.
+*/
+EventScanKernel eventScanGetKernel(void);
+
+/**
+* eventScanSetKernel: Forces the scans to use a kernel. Scans that run on
+* other threads at the same time use either the old or the new kernel.
+*
+* @param kernel - The kernel to use.
+* @return
+*   false if the CPU does not support the kernel, the kernel is not changed.
+*   true otherwise.
+*/
+bool eventScanSetKernel(EventScanKernel kernel);
+
+#endif /* EVENT_SCAN_H_ */
@@ -0,0 +1,343 @@
+#define _POSIX_C_SOURCE 200112L
+#include "export_writer.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#define INITIAL_CAPACITY 65536
+#define EXPAND_FACTOR 2
+#define DIGITS_BASE 10
+#define PAIRS_BASE 100
+#define MIN_VECTORS 16
+#define FILE_MODE 0666
+
+struct ExportBuffer_t{
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+/**
+* Export_job: the chunks of a file and the state shared by its workers.
+*/
+typedef struct export_job{
+    ExportChunkFormatter formatter;
+    void* ctx;
+    struct ExportBuffer_t* buffers;
+    int chunks;
+    int next_chunk;
+    bool failed;
+    pthread_mutex_t lock;
+}Export_job;
+
+/** The decimal digits of 00 to 99 */
+static const char digit_pairs[]=
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+/**
+* reserve: grows a buffer so that length more bytes fit in it.
+*
+* @param buffer - the buffer to grow.
+* @param length - the number of bytes to add.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool reserve(ExportBuffer buffer,size_t length)
+{
+    if(buffer->size+length>buffer->capacity)
+    {
+        size_t capacity= buffer->capacity==0 ? INITIAL_CAPACITY : buffer->capacity*EXPAND_FACTOR;
+        while(capacity<buffer->size+length){
+            capacity*=EXPAND_FACTOR;
+        }
+        char* data=realloc(buffer->data,capacity);
+        if(data==NULL)
+        {
+            return false;
+        }
+        buffer->data=data;
+        buffer->capacity=capacity;
+    }
+    return true;
+}
+
+bool exportBufferAppend(ExportBuffer buffer, const char* text, size_t length)
+{
+    if(!reserve(buffer,length))
+    {
+        return false;
+    }
+    memcpy(buffer->data+buffer->size,text,length);
+    buffer->size+=length;
+    return true;
+}
+
+bool exportBufferAppendString(ExportBuffer buffer, const char* text)
+{
+    return exportBufferAppend(buffer,text,strlen(text));
+}
+
+bool exportBufferAppendInt(ExportBuffer buffer, int value)
+{
+    if(!reserve(buffer,EXPORT_INT_TEXT_LEN))
+    {
+        return false;
+    }
+    buffer->size+=(size_t)exportFormatInt(buffer->data+buffer->size,value);
+    return true;
+}
+
+int exportFormatInt(char* text, int value)
+{
+    char digits[EXPORT_INT_TEXT_LEN];
+    unsigned int magnitude= value<0 ? 0u-(unsigned int)value : (unsigned int)value;
+    int position=EXPORT_INT_TEXT_LEN;
+    while(magnitude>=PAIRS_BASE){
+        position-=2;
+        memcpy(digits+position,digit_pairs+2*(magnitude%PAIRS_BASE),2);
+        magnitude/=PAIRS_BASE;
+    }
+    if(magnitude>=DIGITS_BASE)
+    {
+        position-=2;
+        memcpy(digits+position,digit_pairs+2*magnitude,2);
+    }
+    else
+    {
+        digits[--position]=(char)('0'+magnitude);
+    }
+    if(value<0)
+    {
+        digits[--position]='-';
+    }
+    memcpy(text,digits+position,EXPORT_INT_TEXT_LEN-position);
+    return EXPORT_INT_TEXT_LEN-position;
+}
+
+/**
+* take_chunk: takes the next chunk no worker formatted yet.
+*
+* @param job - the job of the chunks.
+* @return
+* -1 - if all the chunks were taken or a chunk failed.
+* otherwise the chunk.
+*/
+static int take_chunk(Export_job* job)
+{
+    pthread_mutex_lock(&job->lock);
+    int chunk= job->failed||job->next_chunk>=job->chunks ? -1 : job->next_chunk++;
+    pthread_mutex_unlock(&job->lock);
+    return chunk;
+}
+
+/**
+* format_chunks: formats chunks until none is left, the loop of every worker.
+*
+* @param data - the job of the chunks.
+* @return
+* NULL.
+*/
+static void* format_chunks(void* data)
+{
+    Export_job* job=data;
+    int chunk=take_chunk(job);
+    while(chunk>=0){
+        if(!job->formatter(chunk,&job->buffers[chunk],job->ctx))
+        {
+            pthread_mutex_lock(&job->lock);
+            job->failed=true;
+            pthread_mutex_unlock(&job->lock);
+        }
+        chunk=take_chunk(job);
+    }
+    return NULL;
+}
+
+/**
+* run_workers: formats all the chunks of a job on up to workers threads, the
+* calling thread included. Threads that cannot be started are not replaced,
+* the remaining ones format their chunks.
+*
+* @param job - the job of the chunks.
+* @param workers - the number of threads.
+* @return
+* FALSE if a chunk failed.
+* otherwise TRUE.
+*/
+static bool run_workers(Export_job* job,int workers)
+{
+    int threads_num= workers<job->chunks ? workers-1 : job->chunks-1;
+    pthread_t* threads=NULL;
+    int started=0;
+    if(threads_num>0)
+    {
+        threads=malloc(sizeof(*threads)*threads_num);
+    }
+    if(threads!=NULL)
+    {
+        while(started<threads_num&&pthread_create(&threads[started],NULL,format_chunks,job)==0){
+            started++;
+        }
+    }
+    format_chunks(job);
+    for(int i=0;i<started;i++){
+        pthread_join(threads[i],NULL);
+    }
+    free(threads);
+    return !job->failed;
+}
+
+/**
+* write_vectors: writes vectors to a file, resuming after partial writes.
+*
+* @param fd - the file to write to.
+* @param vectors - the vectors to write, changed by partial writes.
+* @param count - the number of vectors.
+* @return
+* FALSE if a write failed.
+* otherwise TRUE.
+*/
+static bool write_vectors(int fd,struct iovec* vectors,int count)
+{
+    while(count>0){
+        ssize_t written=writev(fd,vectors,count);
+        if(written<0)
+        {
+            if(errno==EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        while(count>0&&(size_t)written>=vectors->iov_len){
+            written-=(ssize_t)vectors->iov_len;
+            vectors++;
+            count--;
+        }
+        if(count>0)
+        {
+            vectors->iov_base=(char*)vectors->iov_base+written;
+            vectors->iov_len-=(size_t)written;
+        }
+    }
+    return true;
+}
+
+/**
+* max_vectors: returns the number of vectors a single writev accepts.
+*/
+static int max_vectors(void)
+{
+    long max=sysconf(_SC_IOV_MAX);
+    return max<MIN_VECTORS ? MIN_VECTORS : (int)max;
+}
+
+/**
+* write_buffers: writes the buffers of the chunks in order, as many buffers
+* in every writev as the system allows.
+*
+* @param fd - the file to write to.
+* @param buffers - the buffers of the chunks.
+* @param chunks - the number of chunks.
+* @return
+* FALSE if allocation or a write failed.
+* otherwise TRUE.
+*/
+static bool write_buffers(int fd,struct ExportBuffer_t* buffers,int chunks)
+{
+    int capacity= chunks<max_vectors() ? chunks : max_vectors();
+    if(capacity==0)
+    {
+        return true;
+    }
+    struct iovec* vectors=malloc(sizeof(*vectors)*capacity);
+    if(vectors==NULL)
+    {
+        return false;
+    }
+    int chunk=0;
+    bool written=true;
+    while(written&&chunk<chunks){
+        int count=0;
+        for(;chunk<chunks&&count<capacity;chunk++){
+            if(buffers[chunk].size>0)
+            {
+                vectors[count].iov_base=buffers[chunk].data;
+                vectors[count].iov_len=buffers[chunk].size;
+                count++;
+            }
+        }
+        written=write_vectors(fd,vectors,count);
+    }
+    free(vectors);
+    return written;
+}
+
+ExportResult exportWriteVectors(int fd, struct iovec* vectors, int count)
+{
+    if(vectors==NULL&&count>0)
+    {
+        return EXPORT_NULL_ARGUMENT;
+    }
+    int batch=max_vectors();
+    for(int i=0;i<count;i+=batch){
+        if(!write_vectors(fd,vectors+i,count-i<batch ? count-i : batch))
+        {
+            return EXPORT_IO_ERROR;
+        }
+    }
+    return EXPORT_SUCCESS;
+}
+
+ExportResult exportWriteChunks(const char* file_name, int chunks, int workers,
+                               ExportChunkFormatter formatter, void* ctx)
+{
+    if(file_name==NULL||formatter==NULL)
+    {
+        return EXPORT_NULL_ARGUMENT;
+    }
+    int fd=open(file_name,O_WRONLY|O_CREAT|O_TRUNC,FILE_MODE);
+    if(fd<0)
+    {
+        return EXPORT_IO_ERROR;
+    }
+    if(chunks<=0)
+    {
+        return close(fd)==0 ? EXPORT_SUCCESS : EXPORT_IO_ERROR;
+    }
+    Export_job job={formatter,ctx,calloc(chunks,sizeof(struct ExportBuffer_t)),chunks,0,false};
+    if(job.buffers==NULL||pthread_mutex_init(&job.lock,NULL)!=0)
+    {
+        free(job.buffers);
+        close(fd);
+        return EXPORT_OUT_OF_MEMORY;
+    }
+    ExportResult result=EXPORT_SUCCESS;
+    if(!run_workers(&job,workers<1 ? 1 : workers))
+    {
+        result=EXPORT_OUT_OF_MEMORY;
+    }
+    else if(!write_buffers(fd,job.buffers,chunks))
+    {
+        result=EXPORT_IO_ERROR;
+    }
+    if(close(fd)!=0&&result==EXPORT_SUCCESS)
+    {
+        result=EXPORT_IO_ERROR;
+    }
+    pthread_mutex_destroy(&job.lock);
+    for(int i=0;i<chunks;i++){
+        free(job.buffers[i].data);
+    }
+    free(job.buffers);
+    return result;
+}
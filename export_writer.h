@@ -0,0 +1,129 @@
+#ifndef EXPORT_WRITER_H_
+#define EXPORT_WRITER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+* Export Writer
+*
+* Writes a text file made of consecutive chunks. Every chunk is formatted into
+* its own buffer by a formatter function, the chunks are formatted on a pool of
+* worker threads, and the buffers are then written in chunk order with writev.
+* The file is the same whatever the number of workers is.
+*
+* The following functions are available:
+*   exportBufferAppend        - Appends bytes to a chunk buffer.
+*   exportBufferAppendString  - Appends a string to a chunk buffer.
+*   exportBufferAppendInt     - Appends an int in decimal to a chunk buffer.
+*   exportFormatInt           - Formats an int in decimal into a character array.
+*   exportWriteChunks         - Formats the chunks of a file and writes them in order.
+*   exportWriteVectors        - Writes vectors to a file descriptor with writev.
+*/
+
+struct iovec;
+
+/** The length of the longest int in decimal, "-2147483648" */
+#define EXPORT_INT_TEXT_LEN 11
+
+/** Type of the buffer a chunk is formatted into */
+typedef struct ExportBuffer_t *ExportBuffer;
+
+/** Type used for returning error codes from export functions */
+typedef enum ExportResult_t {
+    EXPORT_SUCCESS,
+    EXPORT_OUT_OF_MEMORY,
+    EXPORT_NULL_ARGUMENT,
+    EXPORT_IO_ERROR
+} ExportResult;
+
+/**
+* Type of function formatting a chunk of the file. The function is called once
+* for every chunk, possibly from several threads at the same time, so it must
+* only read the data it shares with other chunks.
+* It returns false if it failed, e.g. when an append failed.
+*/
+typedef bool (*ExportChunkFormatter)(int chunk, ExportBuffer buffer, void* ctx);
+
+/**
+* exportBufferAppend: Appends bytes to a chunk buffer.
+*
+* @param buffer - The buffer to append to.
+* @param text - The bytes to append.
+* @param length - The number of bytes to append.
+* @return
+*   false if allocation failed.
+*   true otherwise.
+*/
+bool exportBufferAppend(ExportBuffer buffer, const char* text, size_t length);
+
+/**
+* exportBufferAppendString: Appends a string, without its terminating null
+* character, to a chunk buffer.
+*
+* @param buffer - The buffer to append to.
+* @param text - The string to append.
+* @return
+*   false if allocation failed.
+*   true otherwise.
+*/
+bool exportBufferAppendString(ExportBuffer buffer, const char* text);
+
+/**
+* exportBufferAppendInt: Appends an int to a chunk buffer, as printf("%d") does.
+*
+* @param buffer - The buffer to append to.
+* @param value - The value to append.
+* @return
+*   false if allocation failed.
+*   true otherwise.
+*/
+bool exportBufferAppendInt(ExportBuffer buffer, int value);
+
+/**
+* exportFormatInt: Formats an int as printf("%d") does, two digits at a time
+* from a table. No null character is written.
+*
+* @param text - Receives the digits, holds at least EXPORT_INT_TEXT_LEN characters.
+* @param value - The value to format.
+* @return
+*   The number of characters written.
+*/
+int exportFormatInt(char* text, int value);
+
+/**
+* exportWriteChunks: Creates a file, or truncates it, and fills it with the
+* chunks formatted by formatter, in chunk order. The chunks are formatted by
+* up to workers threads, the calling thread included.
+*
+* @param file_name - The name of the file to write.
+* @param chunks - The number of chunks of the file.
+* @param workers - The number of threads formatting the chunks, 1 or less
+*   formats all the chunks in the calling thread.
+* @param formatter - Function formatting a chunk.
+* @param ctx - Passed as is to formatter.
+* @return
+*   EXPORT_NULL_ARGUMENT if file_name or formatter is NULL.
+*   EXPORT_IO_ERROR if the file could not be opened or written.
+*   EXPORT_OUT_OF_MEMORY if an allocation or a formatter failed.
+*   EXPORT_SUCCESS otherwise.
+*/
+ExportResult exportWriteChunks(const char* file_name, int chunks, int workers,
+                               ExportChunkFormatter formatter, void* ctx);
+
+/**
+* exportWriteVectors: Writes vectors to a file descriptor in order, with as
+* many vectors in every writev as the system allows, resuming after partial
+* writes. The vectors are changed by partial writes.
+*
+* @param fd - The file descriptor to write to.
+* @param vectors - The vectors to write.
+* @param count - The number of vectors.
+* @return
+*   EXPORT_NULL_ARGUMENT if vectors is NULL and count is positive.
+*   EXPORT_IO_ERROR if a write failed.
+*   EXPORT_SUCCESS otherwise.
+*/
+ExportResult exportWriteVectors(int fd, struct iovec* vectors, int count);
+
+#endif /* EXPORT_WRITER_H_ */
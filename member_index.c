@@ -0,0 +1,359 @@
+#include "member_index.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#define INITIAL_BUCKETS 16
+#define INITIAL_EVENTS 4
+#define EXPAND_FACTOR 2
+
+typedef struct linked_event{
+
+    int event_id;
+    int date_key;
+    int order;
+
+}Linked_event;
+
+typedef struct member_entry{
+
+    int member_id;
+    Linked_event* events;
+    int size;
+    int capacity;
+    struct member_entry *next;
+
+}*Member_entry;
+
+struct MemberIndex_t{
+    Member_entry* buckets;
+    int buckets_num;
+    int size;
+    long bytes;
+    Allocator allocator;
+};
+
+/**
+* hash_id: maps a member id to a bucket.
+*
+* @param index - the index that owns the buckets.
+* @param member_id - the id to hash.
+* @return
+* the bucket of the id.
+*/
+static int hash_id(MemberIndex index,int member_id)
+{
+    unsigned int hash=(unsigned int)member_id*2654435761u;
+    return (int)(hash&(unsigned int)(index->buckets_num-1));
+}
+
+/**
+* find_member: looks for the entry of a member.
+*
+* @param index - the index to search in.
+* @param member_id - the id of the member.
+* @return
+* NULL - if the member is not in the index.
+* otherwise the entry of the member.
+*/
+static Member_entry find_member(MemberIndex index,int member_id)
+{
+    Member_entry current=index->buckets[hash_id(index,member_id)];
+    while(current!=NULL){
+        if(current->member_id==member_id){
+            return current;
+        }
+        current=current->next;
+    }
+    return NULL;
+}
+
+/**
+* find_event: looks for the position of an event in the events of a member.
+*
+* @param entry - the entry of the member.
+* @param event_id - the id of the event.
+* @return
+* -1 - if the event is not linked to the member.
+* otherwise the position of the event.
+*/
+static int find_event(Member_entry entry,int event_id)
+{
+    for(int i=0;i<entry->size;i++){
+        if(entry->events[i].event_id==event_id){
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+* event_before: checks if an event comes before another one.
+*
+* @param event1 - the first event.
+* @param event2 - the second event.
+* @return
+* TRUE if event1 is earlier, or on the same date and inserted before event2.
+* otherwise FALSE.
+*/
+static bool event_before(Linked_event* event1,Linked_event* event2)
+{
+    if(event1->date_key!=event2->date_key){
+        return event1->date_key<event2->date_key;
+    }
+    return event1->order<event2->order;
+}
+
+/**
+* place_event: moves the event at a given position to its place in date order,
+* assuming all the other events of the member are ordered.
+*
+* @param entry - the entry of the member.
+* @param position - the position of the event to place.
+*/
+static void place_event(Member_entry entry,int position)
+{
+    Linked_event event=entry->events[position];
+    while(position>0&&event_before(&event,&entry->events[position-1])){
+        entry->events[position]=entry->events[position-1];
+        position--;
+    }
+    while(position<entry->size-1&&event_before(&entry->events[position+1],&event)){
+        entry->events[position]=entry->events[position+1];
+        position++;
+    }
+    entry->events[position]=event;
+}
+
+/**
+* expand_buckets: doubles the number of buckets and rehashes all the members.
+*
+* @param index - the index to expand.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool expand_buckets(MemberIndex index)
+{
+    int old_num=index->buckets_num;
+    Member_entry* old_buckets=index->buckets;
+    Member_entry* new_buckets=allocatorAlloc(&index->allocator,sizeof(*new_buckets)*old_num*EXPAND_FACTOR);
+    if(new_buckets==NULL)
+    {
+        return false;
+    }
+    memset(new_buckets,0,sizeof(*new_buckets)*old_num*EXPAND_FACTOR);
+    index->buckets=new_buckets;
+    index->buckets_num=old_num*EXPAND_FACTOR;
+    for(int i=0;i<old_num;i++){
+        Member_entry current=old_buckets[i];
+        while(current!=NULL){
+            Member_entry next=current->next;
+            int bucket=hash_id(index,current->member_id);
+            current->next=new_buckets[bucket];
+            new_buckets[bucket]=current;
+            current=next;
+        }
+    }
+    allocatorFree(&index->allocator,old_buckets);
+    index->bytes+=(long)(sizeof(*new_buckets)*(index->buckets_num-old_num));
+    return true;
+}
+
+MemberIndex memberIndexCreate(void)
+{
+    return memberIndexCreateWithAllocator(NULL);
+}
+
+MemberIndex memberIndexCreateWithAllocator(const Allocator* allocator)
+{
+    MemberIndex index=allocatorAlloc(allocator,sizeof(*index));
+    if(index==NULL)
+    {
+        return NULL;
+    }
+    if(allocator!=NULL)
+    {
+        index->allocator=*allocator;
+    }
+    else
+    {
+        memset(&index->allocator,0,sizeof(index->allocator));
+    }
+    index->buckets=allocatorAlloc(allocator,sizeof(*index->buckets)*INITIAL_BUCKETS);
+    if(index->buckets==NULL)
+    {
+        allocatorFree(allocator,index);
+        return NULL;
+    }
+    memset(index->buckets,0,sizeof(*index->buckets)*INITIAL_BUCKETS);
+    index->buckets_num=INITIAL_BUCKETS;
+    index->size=0;
+    index->bytes=(long)(sizeof(*index)+sizeof(*index->buckets)*INITIAL_BUCKETS);
+    return index;
+}
+
+void memberIndexDestroy(MemberIndex index)
+{
+    if(index==NULL)
+    {
+        return;
+    }
+    for(int i=0;i<index->buckets_num;i++){
+        Member_entry current=index->buckets[i];
+        while(current!=NULL){
+            Member_entry to_free=current;
+            current=current->next;
+            allocatorFree(&index->allocator,to_free->events);
+            allocatorFree(&index->allocator,to_free);
+        }
+    }
+    allocatorFree(&index->allocator,index->buckets);
+    Allocator allocator=index->allocator;
+    allocatorFree(&allocator,index);
+}
+
+MemberIndexResult memberIndexAddMember(MemberIndex index, int member_id)
+{
+    if(index==NULL)
+    {
+        return MI_NULL_ARGUMENT;
+    }
+    if(find_member(index,member_id)!=NULL)
+    {
+        return MI_MEMBER_ALREADY_EXISTS;
+    }
+    if(index->size>=index->buckets_num&&!expand_buckets(index))
+    {
+        return MI_OUT_OF_MEMORY;
+    }
+    Member_entry entry=allocatorAlloc(&index->allocator,sizeof(*entry));
+    if(entry==NULL)
+    {
+        return MI_OUT_OF_MEMORY;
+    }
+    entry->member_id=member_id;
+    entry->events=NULL;
+    entry->size=0;
+    entry->capacity=0;
+    int bucket=hash_id(index,member_id);
+    entry->next=index->buckets[bucket];
+    index->buckets[bucket]=entry;
+    index->size++;
+    index->bytes+=(long)sizeof(*entry);
+    return MI_SUCCESS;
+}
+
+bool memberIndexContains(MemberIndex index, int member_id)
+{
+    if(index==NULL)
+    {
+        return false;
+    }
+    return find_member(index,member_id)!=NULL;
+}
+
+MemberIndexResult memberIndexLink(MemberIndex index, int member_id, int event_id,
+                                  int date_key, int order)
+{
+    if(index==NULL)
+    {
+        return MI_NULL_ARGUMENT;
+    }
+    Member_entry entry=find_member(index,member_id);
+    if(entry==NULL)
+    {
+        return MI_MEMBER_NOT_EXISTS;
+    }
+    if(entry->size==entry->capacity)
+    {
+        int new_capacity= entry->capacity==0 ? INITIAL_EVENTS : entry->capacity*EXPAND_FACTOR;
+        Linked_event* new_events=allocatorAlloc(&index->allocator,sizeof(*new_events)*new_capacity);
+        if(new_events==NULL)
+        {
+            return MI_OUT_OF_MEMORY;
+        }
+        if(entry->size>0)
+        {
+            memcpy(new_events,entry->events,sizeof(*new_events)*entry->size);
+        }
+        allocatorFree(&index->allocator,entry->events);
+        index->bytes+=(long)(sizeof(*new_events)*(new_capacity-entry->capacity));
+        entry->events=new_events;
+        entry->capacity=new_capacity;
+    }
+    entry->events[entry->size].event_id=event_id;
+    entry->events[entry->size].date_key=date_key;
+    entry->events[entry->size].order=order;
+    entry->size++;
+    place_event(entry,entry->size-1);
+    return MI_SUCCESS;
+}
+
+MemberIndexResult memberIndexUnlink(MemberIndex index, int member_id, int event_id)
+{
+    if(index==NULL)
+    {
+        return MI_NULL_ARGUMENT;
+    }
+    Member_entry entry=find_member(index,member_id);
+    if(entry==NULL)
+    {
+        return MI_MEMBER_NOT_EXISTS;
+    }
+    int position=find_event(entry,event_id);
+    if(position<0)
+    {
+        return MI_EVENT_NOT_LINKED;
+    }
+    memmove(&entry->events[position],&entry->events[position+1],
+            sizeof(*entry->events)*(entry->size-position-1));
+    entry->size--;
+    return MI_SUCCESS;
+}
+
+MemberIndexResult memberIndexMoveEvent(MemberIndex index, int member_id, int event_id, int date_key)
+{
+    if(index==NULL)
+    {
+        return MI_NULL_ARGUMENT;
+    }
+    Member_entry entry=find_member(index,member_id);
+    if(entry==NULL)
+    {
+        return MI_MEMBER_NOT_EXISTS;
+    }
+    int position=find_event(entry,event_id);
+    if(position<0)
+    {
+        return MI_EVENT_NOT_LINKED;
+    }
+    entry->events[position].date_key=date_key;
+    place_event(entry,position);
+    return MI_SUCCESS;
+}
+
+int memberIndexGetEvents(MemberIndex index, int member_id, int* out, int cap)
+{
+    if(index==NULL)
+    {
+        return -1;
+    }
+    Member_entry entry=find_member(index,member_id);
+    if(entry==NULL)
+    {
+        return -1;
+    }
+    for(int i=0;i<entry->size&&i<cap;i++){
+        out[i]=entry->events[i].event_id;
+    }
+    return entry->size;
+}
+
+long memberIndexGetMemoryUsage(MemberIndex index)
+{
+    if(index==NULL)
+    {
+        return 0;
+    }
+    return index->bytes;
+}
@@ -0,0 +1,166 @@
+#ifndef MEMBER_INDEX_H_
+#define MEMBER_INDEX_H_
+
+#include <stdbool.h>
+#include "allocator.h"
+
+/**
+* Member Index
+*
+* A reverse adjacency index from members to the events they are linked to.
+* Members are kept in a hash table keyed on their id, and every member holds
+* its events in an array ordered by the packed date of the event and then by
+* its insertion counter. The index, its members and their events may be
+* allocated through an Allocator.
+*
+* The following functions are available:
+*   memberIndexCreate       - Creates a new empty index.
+*   memberIndexCreateWithAllocator - Creates a new empty index whose memory is allocated by an allocator.
+*   memberIndexDestroy      - Deletes an existing index and frees all its resources.
+*   memberIndexAddMember    - Adds a member without events.
+*   memberIndexContains     - Checks if a member is in the index.
+*   memberIndexLink         - Links an event to a member.
+*   memberIndexUnlink       - Unlinks an event from a member.
+*   memberIndexMoveEvent    - Updates the date of an event linked to a member.
+*   memberIndexGetEvents    - Returns the events of a member in date order.
+*   memberIndexGetMemoryUsage - Returns the number of bytes the index takes.
+*/
+
+/** Type for defining the index */
+typedef struct MemberIndex_t *MemberIndex;
+
+/** Type used for returning error codes from index functions */
+typedef enum MemberIndexResult_t {
+    MI_SUCCESS,
+    MI_OUT_OF_MEMORY,
+    MI_NULL_ARGUMENT,
+    MI_MEMBER_ALREADY_EXISTS,
+    MI_MEMBER_NOT_EXISTS,
+    MI_EVENT_NOT_LINKED
+} MemberIndexResult;
+
+/**
+* memberIndexCreate: Allocates a new empty index.
+*
+* @return
+*   NULL - if allocation failed.
+*   A new index in case of success.
+*/
+MemberIndex memberIndexCreate(void);
+
+/**
+* memberIndexCreateWithAllocator: Allocates a new empty index whose
+* structure, members and events are allocated and freed through allocator.
+*
+* @param allocator - The allocator, copied into the index. NULL for malloc.
+* @return
+*   NULL - if allocation failed.
+*   A new index in case of success.
+*/
+MemberIndex memberIndexCreateWithAllocator(const Allocator* allocator);
+
+/**
+* memberIndexDestroy: Deallocates an existing index.
+*
+* @param index - Target index to be deallocated. If index is NULL nothing will be done.
+*/
+void memberIndexDestroy(MemberIndex index);
+
+/**
+* memberIndexAddMember: Adds a member with no linked events.
+*
+* @param index - The index to add to.
+* @param member_id - The id of the member.
+* @return
+*   MI_NULL_ARGUMENT if a NULL was sent as index.
+*   MI_MEMBER_ALREADY_EXISTS if the member is already in the index.
+*   MI_OUT_OF_MEMORY if an allocation failed.
+*   MI_SUCCESS the member had been added successfully.
+*/
+MemberIndexResult memberIndexAddMember(MemberIndex index, int member_id);
+
+/**
+* memberIndexContains: Checks if a member is in the index.
+*
+* @param index - The index to search in.
+* @param member_id - The id of the member.
+* @return
+*   false if index is NULL or the member is not in the index.
+*   true otherwise.
+*/
+bool memberIndexContains(MemberIndex index, int member_id);
+
+/**
+* memberIndexLink: Links an event to a member.
+*
+* @param index - The index to update.
+* @param member_id - The id of the member.
+* @param event_id - The id of the event.
+* @param date_key - The packed date of the event.
+* @param order - The insertion counter of the event.
+* @return
+*   MI_NULL_ARGUMENT if a NULL was sent as index.
+*   MI_MEMBER_NOT_EXISTS if the member is not in the index.
+*   MI_OUT_OF_MEMORY if an allocation failed.
+*   MI_SUCCESS the event had been linked successfully.
+*/
+MemberIndexResult memberIndexLink(MemberIndex index, int member_id, int event_id,
+                                  int date_key, int order);
+
+/**
+* memberIndexUnlink: Unlinks an event from a member.
+*
+* @param index - The index to update.
+* @param member_id - The id of the member.
+* @param event_id - The id of the event.
+* @return
+*   MI_NULL_ARGUMENT if a NULL was sent as index.
+*   MI_MEMBER_NOT_EXISTS if the member is not in the index.
+*   MI_EVENT_NOT_LINKED if the event is not linked to the member.
+*   MI_SUCCESS the event had been unlinked successfully.
+*/
+MemberIndexResult memberIndexUnlink(MemberIndex index, int member_id, int event_id);
+
+/**
+* memberIndexMoveEvent: Updates the date of an event linked to a member and
+* keeps the events of the member in date order.
+*
+* @param index - The index to update.
+* @param member_id - The id of the member.
+* @param event_id - The id of the event.
+* @param date_key - The new packed date of the event.
+* @return
+*   MI_NULL_ARGUMENT if a NULL was sent as index.
+*   MI_MEMBER_NOT_EXISTS if the member is not in the index.
+*   MI_EVENT_NOT_LINKED if the event is not linked to the member.
+*   MI_SUCCESS the event had been moved successfully.
+*/
+MemberIndexResult memberIndexMoveEvent(MemberIndex index, int member_id, int event_id, int date_key);
+
+/**
+* memberIndexGetEvents: Copies the ids of the events of a member, in date order,
+* into out. At most cap ids are copied.
+*
+* @param index - The index to search in.
+* @param member_id - The id of the member.
+* @param out - Array that receives the event ids. May be NULL if cap is 0.
+* @param cap - The number of ids out can hold.
+* @return
+*   -1 if index is NULL or the member is not in the index.
+*   Otherwise the number of events linked to the member, which may be larger than cap.
+*/
+int memberIndexGetEvents(MemberIndex index, int member_id, int* out, int cap);
+
+/**
+* memberIndexGetMemoryUsage: Returns the number of bytes allocated for an
+* index, its members and their events. Runs in O(1), the index adds up the
+* bytes whenever it allocates.
+*
+* @param index - The index to measure.
+* @return
+*   0 if a NULL pointer was sent.
+*   Otherwise the number of bytes.
+*/
+long memberIndexGetMemoryUsage(MemberIndex index);
+
+#endif /* MEMBER_INDEX_H_ */
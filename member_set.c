@@ -0,0 +1,687 @@
+#include "member_set.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#define KEY_BITS 16
+#define LOW_MASK 0xFFFF
+#define CONTAINER_RANGE 65536
+#define WORD_BITS 64
+#define BITMAP_WORDS (CONTAINER_RANGE/WORD_BITS)
+#define ARRAY_MAX 4096
+#define INITIAL_CAPACITY 4
+#define EXPAND_FACTOR 2
+
+typedef struct container{
+
+    int key;
+    bool is_bitmap;
+    int cardinality;
+    int capacity;
+    uint16_t* array;
+    uint64_t* bitmap;
+
+}Container;
+
+struct MemberSet_t{
+    Container* containers;
+    int size;
+    int capacity;
+    int cardinality;
+    Allocator allocator;
+};
+
+/**
+* count_bits: counts the set bits of a word.
+*
+* @param word - the word to count.
+* @return
+* the number of set bits.
+*/
+static int count_bits(uint64_t word)
+{
+    word=word-((word>>1)&0x5555555555555555ULL);
+    word=(word&0x3333333333333333ULL)+((word>>2)&0x3333333333333333ULL);
+    word=(word+(word>>4))&0x0F0F0F0F0F0F0F0FULL;
+    return (int)((word*0x0101010101010101ULL)>>56);
+}
+
+/**
+* find_container: binary searches the container of a key.
+*
+* @param set - the set to search in.
+* @param key - the upper bits of an id.
+* @param position - receives the position of the container, or where it should be inserted.
+* @return
+* TRUE if the container exists.
+* otherwise FALSE.
+*/
+static bool find_container(MemberSet set,int key,int* position)
+{
+    int low=0;
+    int high=set->size;
+    while(low<high){
+        int middle=low+(high-low)/2;
+        if(set->containers[middle].key<key){
+            low=middle+1;
+        }
+        else{
+            high=middle;
+        }
+    }
+    *position=low;
+    return low<set->size&&set->containers[low].key==key;
+}
+
+/**
+* find_in_array: binary searches a value in an array container.
+*
+* @param container - the container to search in.
+* @param value - the lower bits of an id.
+* @param position - receives the position of the value, or where it should be inserted.
+* @return
+* TRUE if the value exists.
+* otherwise FALSE.
+*/
+static bool find_in_array(Container* container,uint16_t value,int* position)
+{
+    int low=0;
+    int high=container->cardinality;
+    while(low<high){
+        int middle=low+(high-low)/2;
+        if(container->array[middle]<value){
+            low=middle+1;
+        }
+        else{
+            high=middle;
+        }
+    }
+    *position=low;
+    return low<container->cardinality&&container->array[low]==value;
+}
+
+/**
+* container_contains: checks if a value is in a container.
+*
+* @param container - the container to search in.
+* @param value - the lower bits of an id.
+* @return
+* TRUE if the value exists.
+* otherwise FALSE.
+*/
+static bool container_contains(Container* container,uint16_t value)
+{
+    if(container->is_bitmap){
+        return (container->bitmap[value/WORD_BITS]>>(value%WORD_BITS))&1;
+    }
+    int position=0;
+    return find_in_array(container,value,&position);
+}
+
+/**
+* array_to_bitmap: converts an array container to a bitmap container.
+*
+* @param allocator - the allocator of the set.
+* @param container - the container to convert.
+* @return
+* FALSE - if allocation fails, the container is left unchanged.
+* otherwise TRUE.
+*/
+static bool array_to_bitmap(const Allocator* allocator,Container* container)
+{
+    uint64_t* bitmap=allocatorAlloc(allocator,sizeof(*bitmap)*BITMAP_WORDS);
+    if(bitmap==NULL)
+    {
+        return false;
+    }
+    memset(bitmap,0,sizeof(*bitmap)*BITMAP_WORDS);
+    for(int i=0;i<container->cardinality;i++){
+        uint16_t value=container->array[i];
+        bitmap[value/WORD_BITS]|=(uint64_t)1<<(value%WORD_BITS);
+    }
+    allocatorFree(allocator,container->array);
+    container->array=NULL;
+    container->capacity=0;
+    container->bitmap=bitmap;
+    container->is_bitmap=true;
+    return true;
+}
+
+/**
+* bitmap_to_array: converts a bitmap container to an array container.
+*
+* @param allocator - the allocator of the set.
+* @param container - the container to convert.
+* @return
+* FALSE - if allocation fails, the container is left unchanged.
+* otherwise TRUE.
+*/
+static bool bitmap_to_array(const Allocator* allocator,Container* container)
+{
+    int capacity=container->cardinality>0 ? container->cardinality : INITIAL_CAPACITY;
+    uint16_t* array=allocatorAlloc(allocator,sizeof(*array)*capacity);
+    if(array==NULL)
+    {
+        return false;
+    }
+    int size=0;
+    for(int i=0;i<BITMAP_WORDS;i++){
+        uint64_t word=container->bitmap[i];
+        for(int bit=0;word!=0;bit++,word>>=1){
+            if(word&1){
+                array[size++]=(uint16_t)(i*WORD_BITS+bit);
+            }
+        }
+    }
+    allocatorFree(allocator,container->bitmap);
+    container->bitmap=NULL;
+    container->array=array;
+    container->capacity=capacity;
+    container->is_bitmap=false;
+    return true;
+}
+
+/**
+* insert_container: inserts a new empty array container.
+*
+* @param set - the set to insert to.
+* @param position - the position of the new container.
+* @param key - the upper bits of the ids of the container.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool insert_container(MemberSet set,int position,int key)
+{
+    if(set->size==set->capacity)
+    {
+        int new_capacity=set->capacity==0 ? INITIAL_CAPACITY : set->capacity*EXPAND_FACTOR;
+        Container* containers=allocatorAlloc(&set->allocator,sizeof(*containers)*new_capacity);
+        if(containers==NULL)
+        {
+            return false;
+        }
+        if(set->size>0)
+        {
+            memcpy(containers,set->containers,sizeof(*containers)*set->size);
+        }
+        allocatorFree(&set->allocator,set->containers);
+        set->containers=containers;
+        set->capacity=new_capacity;
+    }
+    memmove(&set->containers[position+1],&set->containers[position],
+            sizeof(*set->containers)*(set->size-position));
+    Container* container=&set->containers[position];
+    container->key=key;
+    container->is_bitmap=false;
+    container->cardinality=0;
+    container->capacity=0;
+    container->array=NULL;
+    container->bitmap=NULL;
+    set->size++;
+    return true;
+}
+
+/**
+* remove_container: removes the container at a given position.
+*
+* @param set - the set to remove from.
+* @param position - the position of the container.
+*/
+static void remove_container(MemberSet set,int position)
+{
+    allocatorFree(&set->allocator,set->containers[position].array);
+    allocatorFree(&set->allocator,set->containers[position].bitmap);
+    memmove(&set->containers[position],&set->containers[position+1],
+            sizeof(*set->containers)*(set->size-position-1));
+    set->size--;
+}
+
+/**
+* container_add: adds a value to a container.
+*
+* @param allocator - the allocator of the set.
+* @param container - the container to add to.
+* @param value - the lower bits of an id.
+* @return
+* MS_ID_ALREADY_EXISTS - if the value is already in the container.
+* MS_OUT_OF_MEMORY - if allocation fails.
+* otherwise MS_SUCCESS.
+*/
+static MemberSetResult container_add(const Allocator* allocator,Container* container,uint16_t value)
+{
+    if(!container->is_bitmap&&container->cardinality==ARRAY_MAX)
+    {
+        if(container_contains(container,value))
+        {
+            return MS_ID_ALREADY_EXISTS;
+        }
+        if(!array_to_bitmap(allocator,container))
+        {
+            return MS_OUT_OF_MEMORY;
+        }
+    }
+    if(container->is_bitmap)
+    {
+        uint64_t mask=(uint64_t)1<<(value%WORD_BITS);
+        if(container->bitmap[value/WORD_BITS]&mask)
+        {
+            return MS_ID_ALREADY_EXISTS;
+        }
+        container->bitmap[value/WORD_BITS]|=mask;
+        container->cardinality++;
+        return MS_SUCCESS;
+    }
+    int position=0;
+    if(find_in_array(container,value,&position))
+    {
+        return MS_ID_ALREADY_EXISTS;
+    }
+    if(container->cardinality==container->capacity)
+    {
+        int new_capacity=container->capacity==0 ? INITIAL_CAPACITY : container->capacity*EXPAND_FACTOR;
+        if(new_capacity>ARRAY_MAX)
+        {
+            new_capacity=ARRAY_MAX;
+        }
+        uint16_t* array=allocatorAlloc(allocator,sizeof(*array)*new_capacity);
+        if(array==NULL)
+        {
+            return MS_OUT_OF_MEMORY;
+        }
+        if(container->cardinality>0)
+        {
+            memcpy(array,container->array,sizeof(*array)*container->cardinality);
+        }
+        allocatorFree(allocator,container->array);
+        container->array=array;
+        container->capacity=new_capacity;
+    }
+    memmove(&container->array[position+1],&container->array[position],
+            sizeof(*container->array)*(container->cardinality-position));
+    container->array[position]=value;
+    container->cardinality++;
+    return MS_SUCCESS;
+}
+
+/**
+* copy_container: copies a container into a given place.
+*
+* @param allocator - the allocator of the set that receives the copy.
+* @param target - receives the copy.
+* @param source - the container to copy.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool copy_container(const Allocator* allocator,Container* target,Container* source)
+{
+    *target=*source;
+    if(source->is_bitmap)
+    {
+        target->bitmap=allocatorAlloc(allocator,sizeof(*target->bitmap)*BITMAP_WORDS);
+        if(target->bitmap==NULL)
+        {
+            return false;
+        }
+        memcpy(target->bitmap,source->bitmap,sizeof(*target->bitmap)*BITMAP_WORDS);
+        return true;
+    }
+    target->capacity=source->cardinality>0 ? source->cardinality : INITIAL_CAPACITY;
+    target->array=allocatorAlloc(allocator,sizeof(*target->array)*target->capacity);
+    if(target->array==NULL)
+    {
+        return false;
+    }
+    memcpy(target->array,source->array,sizeof(*target->array)*source->cardinality);
+    return true;
+}
+
+/**
+* union_arrays: merges two sorted array containers into target.
+*
+* @param allocator - the allocator of the target set.
+* @param target - the container that receives the union.
+* @param source - the container whose values are added.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool union_arrays(const Allocator* allocator,Container* target,Container* source)
+{
+    int capacity=target->cardinality+source->cardinality;
+    uint16_t* merged=allocatorAlloc(allocator,sizeof(*merged)*capacity);
+    if(merged==NULL)
+    {
+        return false;
+    }
+    int i=0;
+    int j=0;
+    int size=0;
+    while(i<target->cardinality&&j<source->cardinality){
+        if(target->array[i]<source->array[j]){
+            merged[size++]=target->array[i++];
+        }
+        else if(target->array[i]>source->array[j]){
+            merged[size++]=source->array[j++];
+        }
+        else{
+            merged[size++]=target->array[i++];
+            j++;
+        }
+    }
+    while(i<target->cardinality){
+        merged[size++]=target->array[i++];
+    }
+    while(j<source->cardinality){
+        merged[size++]=source->array[j++];
+    }
+    allocatorFree(allocator,target->array);
+    target->array=merged;
+    target->capacity=capacity;
+    target->cardinality=size;
+    if(size>ARRAY_MAX)
+    {
+        return array_to_bitmap(allocator,target);
+    }
+    return true;
+}
+
+/**
+* union_containers: adds all the values of source to target.
+*
+* @param allocator - the allocator of the target set.
+* @param target - the container that receives the union.
+* @param source - the container whose values are added.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool union_containers(const Allocator* allocator,Container* target,Container* source)
+{
+    if(!target->is_bitmap&&!source->is_bitmap)
+    {
+        return union_arrays(allocator,target,source);
+    }
+    if(!target->is_bitmap&&!array_to_bitmap(allocator,target))
+    {
+        return false;
+    }
+    if(source->is_bitmap)
+    {
+        int cardinality=0;
+        for(int i=0;i<BITMAP_WORDS;i++){
+            target->bitmap[i]|=source->bitmap[i];
+            cardinality+=count_bits(target->bitmap[i]);
+        }
+        target->cardinality=cardinality;
+        return true;
+    }
+    for(int i=0;i<source->cardinality;i++){
+        uint16_t value=source->array[i];
+        uint64_t mask=(uint64_t)1<<(value%WORD_BITS);
+        if(!(target->bitmap[value/WORD_BITS]&mask)){
+            target->bitmap[value/WORD_BITS]|=mask;
+            target->cardinality++;
+        }
+    }
+    return true;
+}
+
+MemberSet memberSetCreate(void)
+{
+    return memberSetCreateWithAllocator(NULL);
+}
+
+MemberSet memberSetCreateWithAllocator(const Allocator* allocator)
+{
+    MemberSet set=allocatorAlloc(allocator,sizeof(*set));
+    if(set==NULL)
+    {
+        return NULL;
+    }
+    if(allocator!=NULL)
+    {
+        set->allocator=*allocator;
+    }
+    else
+    {
+        memset(&set->allocator,0,sizeof(set->allocator));
+    }
+    set->containers=NULL;
+    set->size=0;
+    set->capacity=0;
+    set->cardinality=0;
+    return set;
+}
+
+void memberSetDestroy(MemberSet set)
+{
+    if(set==NULL)
+    {
+        return;
+    }
+    for(int i=0;i<set->size;i++){
+        allocatorFree(&set->allocator,set->containers[i].array);
+        allocatorFree(&set->allocator,set->containers[i].bitmap);
+    }
+    allocatorFree(&set->allocator,set->containers);
+    Allocator allocator=set->allocator;
+    allocatorFree(&allocator,set);
+}
+
+MemberSet memberSetCopy(MemberSet set)
+{
+    if(set==NULL)
+    {
+        return NULL;
+    }
+    MemberSet new_set=memberSetCreateWithAllocator(&set->allocator);
+    if(new_set==NULL)
+    {
+        return NULL;
+    }
+    if(set->size==0)
+    {
+        return new_set;
+    }
+    new_set->containers=allocatorAlloc(&set->allocator,sizeof(*new_set->containers)*set->size);
+    if(new_set->containers==NULL)
+    {
+        memberSetDestroy(new_set);
+        return NULL;
+    }
+    new_set->capacity=set->size;
+    for(int i=0;i<set->size;i++){
+        if(!copy_container(&new_set->allocator,&new_set->containers[i],&set->containers[i]))
+        {
+            memberSetDestroy(new_set);
+            return NULL;
+        }
+        new_set->size++;
+    }
+    new_set->cardinality=set->cardinality;
+    return new_set;
+}
+
+int memberSetGetSize(MemberSet set)
+{
+    if(set==NULL)
+    {
+        return -1;
+    }
+    return set->cardinality;
+}
+
+bool memberSetContains(MemberSet set, int member_id)
+{
+    if(set==NULL||member_id<0)
+    {
+        return false;
+    }
+    int position=0;
+    if(!find_container(set,member_id>>KEY_BITS,&position))
+    {
+        return false;
+    }
+    return container_contains(&set->containers[position],(uint16_t)(member_id&LOW_MASK));
+}
+
+MemberSetResult memberSetAdd(MemberSet set, int member_id)
+{
+    if(set==NULL)
+    {
+        return MS_NULL_ARGUMENT;
+    }
+    if(member_id<0)
+    {
+        return MS_INVALID_ID;
+    }
+    int position=0;
+    if(!find_container(set,member_id>>KEY_BITS,&position))
+    {
+        if(!insert_container(set,position,member_id>>KEY_BITS))
+        {
+            return MS_OUT_OF_MEMORY;
+        }
+    }
+    MemberSetResult result=container_add(&set->allocator,&set->containers[position],(uint16_t)(member_id&LOW_MASK));
+    if(result==MS_SUCCESS)
+    {
+        set->cardinality++;
+    }
+    if(set->containers[position].cardinality==0)
+    {
+        remove_container(set,position);
+    }
+    return result;
+}
+
+MemberSetResult memberSetRemove(MemberSet set, int member_id)
+{
+    if(set==NULL)
+    {
+        return MS_NULL_ARGUMENT;
+    }
+    int position=0;
+    if(member_id<0||!find_container(set,member_id>>KEY_BITS,&position))
+    {
+        return MS_ID_NOT_EXISTS;
+    }
+    Container* container=&set->containers[position];
+    uint16_t value=(uint16_t)(member_id&LOW_MASK);
+    if(container->is_bitmap)
+    {
+        uint64_t mask=(uint64_t)1<<(value%WORD_BITS);
+        if(!(container->bitmap[value/WORD_BITS]&mask))
+        {
+            return MS_ID_NOT_EXISTS;
+        }
+        container->bitmap[value/WORD_BITS]&=~mask;
+        container->cardinality--;
+        if(container->cardinality<=ARRAY_MAX)
+        {
+            bitmap_to_array(&set->allocator,container);
+        }
+    }
+    else
+    {
+        int index=0;
+        if(!find_in_array(container,value,&index))
+        {
+            return MS_ID_NOT_EXISTS;
+        }
+        memmove(&container->array[index],&container->array[index+1],
+                sizeof(*container->array)*(container->cardinality-index-1));
+        container->cardinality--;
+    }
+    set->cardinality--;
+    if(container->cardinality==0)
+    {
+        remove_container(set,position);
+    }
+    return MS_SUCCESS;
+}
+
+MemberSetResult memberSetUnion(MemberSet target, MemberSet source)
+{
+    if(target==NULL||source==NULL)
+    {
+        return MS_NULL_ARGUMENT;
+    }
+    for(int i=0;i<source->size;i++){
+        Container* source_container=&source->containers[i];
+        int position=0;
+        if(find_container(target,source_container->key,&position))
+        {
+            Container* target_container=&target->containers[position];
+            int old_cardinality=target_container->cardinality;
+            if(!union_containers(&target->allocator,target_container,source_container))
+            {
+                return MS_OUT_OF_MEMORY;
+            }
+            target->cardinality+=target_container->cardinality-old_cardinality;
+            continue;
+        }
+        if(!insert_container(target,position,source_container->key))
+        {
+            return MS_OUT_OF_MEMORY;
+        }
+        if(!copy_container(&target->allocator,&target->containers[position],source_container))
+        {
+            target->containers[position].array=NULL;
+            target->containers[position].bitmap=NULL;
+            remove_container(target,position);
+            return MS_OUT_OF_MEMORY;
+        }
+        target->cardinality+=source_container->cardinality;
+    }
+    return MS_SUCCESS;
+}
+
+MemberSetResult memberSetForEach(MemberSet set, MemberSetVisitor visitor, void* ctx)
+{
+    if(set==NULL||visitor==NULL)
+    {
+        return MS_NULL_ARGUMENT;
+    }
+    for(int i=0;i<set->size;i++){
+        Container* container=&set->containers[i];
+        int high=container->key<<KEY_BITS;
+        if(!container->is_bitmap)
+        {
+            for(int j=0;j<container->cardinality;j++){
+                if(!visitor(high|container->array[j],ctx))
+                {
+                    return MS_SUCCESS;
+                }
+            }
+            continue;
+        }
+        for(int j=0;j<BITMAP_WORDS;j++){
+            uint64_t word=container->bitmap[j];
+            for(int bit=0;word!=0;bit++,word>>=1){
+                if((word&1)&&!visitor(high|(j*WORD_BITS+bit),ctx))
+                {
+                    return MS_SUCCESS;
+                }
+            }
+        }
+    }
+    return MS_SUCCESS;
+}
+
+long memberSetGetMemoryUsage(MemberSet set)
+{
+    if(set==NULL)
+    {
+        return 0;
+    }
+    long bytes=(long)(sizeof(*set)+sizeof(*set->containers)*set->capacity);
+    for(int i=0;i<set->size;i++){
+        Container* container=&set->containers[i];
+        bytes+= container->is_bitmap ? (long)(sizeof(*container->bitmap)*BITMAP_WORDS)
+                                     : (long)(sizeof(*container->array)*container->capacity);
+    }
+    return bytes;
+}
@@ -0,0 +1,176 @@
+#ifndef MEMBER_SET_H_
+#define MEMBER_SET_H_
+
+#include <stdbool.h>
+#include "allocator.h"
+
+/**
+* Member Set
+*
+* A compressed set of non-negative member ids in the style of roaring bitmaps.
+* Ids are split by their upper 16 bits into containers. A container holds
+* a sorted array of the lower 16 bits while it is small, and switches to a
+* bitmap of 2^16 bits once the array would take more memory than the bitmap.
+*
+* Membership tests are O(log k) on array containers and O(1) on bitmap
+* containers, and iteration always visits the ids in increasing order.
+*
+* A set and its containers may be allocated through an Allocator, which the
+* copies of the set use too.
+*
+* The following functions are available:
+*   memberSetCreate     - Creates a new empty set.
+*   memberSetCreateWithAllocator - Creates a new empty set whose memory is allocated by an allocator.
+*   memberSetDestroy    - Deletes an existing set and frees all its resources.
+*   memberSetCopy       - Copies an existing set.
+*   memberSetGetSize    - Returns the number of ids in the set.
+*   memberSetContains   - Checks if an id is in the set.
+*   memberSetAdd        - Adds an id to the set.
+*   memberSetRemove     - Removes an id from the set.
+*   memberSetUnion      - Adds all the ids of one set to another.
+*   memberSetForEach    - Visits the ids of the set in increasing order.
+*   memberSetGetMemoryUsage - Returns the number of bytes the set takes.
+*/
+
+/** Type for defining the set */
+typedef struct MemberSet_t *MemberSet;
+
+/** Type used for returning error codes from set functions */
+typedef enum MemberSetResult_t {
+    MS_SUCCESS,
+    MS_OUT_OF_MEMORY,
+    MS_NULL_ARGUMENT,
+    MS_INVALID_ID,
+    MS_ID_ALREADY_EXISTS,
+    MS_ID_NOT_EXISTS
+} MemberSetResult;
+
+/**
+* Type of function used by memberSetForEach to visit an id.
+* Returns false to stop the iteration.
+*/
+typedef bool (*MemberSetVisitor)(int member_id, void* ctx);
+
+/**
+* memberSetCreate: Allocates a new empty set.
+*
+* @return
+*   NULL - if allocation failed.
+*   A new set in case of success.
+*/
+MemberSet memberSetCreate(void);
+
+/**
+* memberSetCreateWithAllocator: Allocates a new empty set whose structure and
+* containers are allocated and freed through allocator.
+*
+* @param allocator - The allocator, copied into the set. NULL for malloc.
+* @return
+*   NULL - if allocation failed.
+*   A new set in case of success.
+*/
+MemberSet memberSetCreateWithAllocator(const Allocator* allocator);
+
+/**
+* memberSetDestroy: Deallocates an existing set.
+*
+* @param set - Target set to be deallocated. If set is NULL nothing will be done.
+*/
+void memberSetDestroy(MemberSet set);
+
+/**
+* memberSetCopy: Creates a copy of target set, allocated through the
+* allocator of the set.
+*
+* @param set - Target set.
+* @return
+*   NULL if a NULL was sent or a memory allocation failed.
+*   A set containing the same ids as set otherwise.
+*/
+MemberSet memberSetCopy(MemberSet set);
+
+/**
+* memberSetGetSize: Returns the number of ids in a set.
+*
+* @param set - The set whose size is requested.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the number of ids in the set.
+*/
+int memberSetGetSize(MemberSet set);
+
+/**
+* memberSetContains: Checks if an id is in the set.
+*
+* @param set - The set to search in.
+* @param member_id - The id to look for.
+* @return
+*   false if set is NULL or the id is not in the set.
+*   true otherwise.
+*/
+bool memberSetContains(MemberSet set, int member_id);
+
+/**
+* memberSetAdd: Adds an id to the set.
+*
+* @param set - The set to add to.
+* @param member_id - The id to add.
+* @return
+*   MS_NULL_ARGUMENT if a NULL was sent as set.
+*   MS_INVALID_ID if member_id is negative.
+*   MS_ID_ALREADY_EXISTS if the id is already in the set.
+*   MS_OUT_OF_MEMORY if an allocation failed.
+*   MS_SUCCESS the id had been added successfully.
+*/
+MemberSetResult memberSetAdd(MemberSet set, int member_id);
+
+/**
+* memberSetRemove: Removes an id from the set.
+*
+* @param set - The set to remove from.
+* @param member_id - The id to remove.
+* @return
+*   MS_NULL_ARGUMENT if a NULL was sent as set.
+*   MS_ID_NOT_EXISTS if the id is not in the set.
+*   MS_SUCCESS the id had been removed successfully.
+*/
+MemberSetResult memberSetRemove(MemberSet set, int member_id);
+
+/**
+* memberSetUnion: Adds all the ids of source to target.
+* Containers are merged word by word where possible.
+*
+* @param target - The set to add to.
+* @param source - The set whose ids are added.
+* @return
+*   MS_NULL_ARGUMENT if a NULL was sent.
+*   MS_OUT_OF_MEMORY if an allocation failed, target may be partially updated.
+*   MS_SUCCESS otherwise.
+*/
+MemberSetResult memberSetUnion(MemberSet target, MemberSet source);
+
+/**
+* memberSetForEach: Calls visitor on every id of the set in increasing order.
+*
+* @param set - The set to iterate over.
+* @param visitor - Function called for every id. Returning false stops the iteration.
+* @param ctx - Passed as is to visitor.
+* @return
+*   MS_NULL_ARGUMENT if a NULL was sent as set or visitor.
+*   MS_SUCCESS otherwise.
+*/
+MemberSetResult memberSetForEach(MemberSet set, MemberSetVisitor visitor, void* ctx);
+
+/**
+* memberSetGetMemoryUsage: Returns the number of bytes allocated for a set and
+* its containers. Runs in O(number of containers), which is 1 for sets of ids
+* below 2^16.
+*
+* @param set - The set to measure.
+* @return
+*   0 if a NULL pointer was sent, a set that was never created takes no memory.
+*   Otherwise the number of bytes.
+*/
+long memberSetGetMemoryUsage(MemberSet set);
+
+#endif /* MEMBER_SET_H_ */
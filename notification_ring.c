@@ -0,0 +1,134 @@
+#include "notification_ring.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define CACHE_LINE 64
+
+/**
+* Cell: a notification and its sequence. A cell at position p of the ring is
+* free for the producer when its sequence is p, and holds a notification
+* for the consumers when its sequence is p+1.
+*/
+typedef struct cell{
+    size_t sequence;
+    Notification notification;
+}Cell;
+
+struct NotificationRing_t{
+    Cell* cells;
+    size_t mask;
+    char head_padding[CACHE_LINE];
+    size_t head;
+    char tail_padding[CACHE_LINE];
+    size_t tail;
+    long dropped;
+};
+
+NotificationRingResult notificationRingCreate(int capacity, NotificationRing* ring)
+{
+    if(ring==NULL)
+    {
+        return NR_NULL_ARGUMENT;
+    }
+    *ring=NULL;
+    if(capacity<=0||(capacity&(capacity-1))!=0)
+    {
+        return NR_INVALID_CAPACITY;
+    }
+    NotificationRing new_ring=malloc(sizeof(*new_ring));
+    if(new_ring==NULL)
+    {
+        return NR_OUT_OF_MEMORY;
+    }
+    new_ring->cells=malloc(sizeof(*new_ring->cells)*capacity);
+    if(new_ring->cells==NULL)
+    {
+        free(new_ring);
+        return NR_OUT_OF_MEMORY;
+    }
+    for(int i=0;i<capacity;i++){
+        new_ring->cells[i].sequence=(size_t)i;
+    }
+    new_ring->mask=(size_t)capacity-1;
+    new_ring->head=0;
+    new_ring->tail=0;
+    new_ring->dropped=0;
+    *ring=new_ring;
+    return NR_SUCCESS;
+}
+
+void notificationRingDestroy(NotificationRing ring)
+{
+    if(ring==NULL)
+    {
+        return;
+    }
+    free(ring->cells);
+    free(ring);
+}
+
+NotificationRingResult notificationRingPublish(NotificationRing ring, const Notification* notification)
+{
+    if(ring==NULL||notification==NULL)
+    {
+        return NR_NULL_ARGUMENT;
+    }
+    size_t position=ring->tail;
+    Cell* cell=&ring->cells[position&ring->mask];
+    if(__atomic_load_n(&cell->sequence,__ATOMIC_ACQUIRE)!=position)
+    {
+        __atomic_fetch_add(&ring->dropped,1,__ATOMIC_RELAXED);
+        return NR_FULL;
+    }
+    cell->notification=*notification;
+    __atomic_store_n(&cell->sequence,position+1,__ATOMIC_RELEASE);
+    ring->tail=position+1;
+    return NR_SUCCESS;
+}
+
+NotificationRingResult notificationRingConsume(NotificationRing ring, Notification* notification)
+{
+    if(ring==NULL||notification==NULL)
+    {
+        return NR_NULL_ARGUMENT;
+    }
+    size_t position=__atomic_load_n(&ring->head,__ATOMIC_RELAXED);
+    while(true){
+        Cell* cell=&ring->cells[position&ring->mask];
+        size_t sequence=__atomic_load_n(&cell->sequence,__ATOMIC_ACQUIRE);
+        if(sequence!=position+1)
+        {
+            if(sequence==position)
+            {
+                return NR_EMPTY;
+            }
+            position=__atomic_load_n(&ring->head,__ATOMIC_RELAXED);
+            continue;
+        }
+        if(__atomic_compare_exchange_n(&ring->head,&position,position+1,true,
+                                       __ATOMIC_RELAXED,__ATOMIC_RELAXED))
+        {
+            *notification=cell->notification;
+            __atomic_store_n(&cell->sequence,position+ring->mask+1,__ATOMIC_RELEASE);
+            return NR_SUCCESS;
+        }
+    }
+}
+
+long notificationRingGetDropped(NotificationRing ring)
+{
+    if(ring==NULL)
+    {
+        return -1;
+    }
+    return __atomic_load_n(&ring->dropped,__ATOMIC_RELAXED);
+}
+
+long notificationRingGetMemoryUsage(NotificationRing ring)
+{
+    if(ring==NULL)
+    {
+        return 0;
+    }
+    return (long)(sizeof(*ring)+sizeof(*ring->cells)*(ring->mask+1));
+}
@@ -0,0 +1,135 @@
+#ifndef NOTIFICATION_RING_H_
+#define NOTIFICATION_RING_H_
+
+#include <stdbool.h>
+
+/**
+* Notification Ring
+*
+* A bounded lock-free ring of fixed-size change notifications with a single
+* producer and any number of consumers. The producer never blocks: when the
+* ring is full the notification is dropped and counted, and consumers can
+* tell that they missed notifications by a gap in their versions. Every
+* notification is consumed by exactly one consumer.
+*
+* Every cell of the ring carries a sequence number that tells the producer
+* and the consumers whose turn it is, so publishing takes no lock and
+* consuming takes a single compare and swap.
+*
+* The following functions are available:
+*   notificationRingCreate      - Creates a new empty ring.
+*   notificationRingDestroy     - Deletes an existing ring and frees all its resources.
+*   notificationRingPublish     - Adds a notification, called by the producer only.
+*   notificationRingConsume     - Takes the oldest notification, called by any consumer.
+*   notificationRingGetDropped  - Returns the number of notifications dropped on a full ring.
+*   notificationRingGetMemoryUsage - Returns the number of bytes the ring takes.
+*/
+
+/** Type for defining the ring */
+typedef struct NotificationRing_t *NotificationRing;
+
+/** Type used for returning error codes from ring functions */
+typedef enum NotificationRingResult_t {
+    NR_SUCCESS,
+    NR_OUT_OF_MEMORY,
+    NR_NULL_ARGUMENT,
+    NR_INVALID_CAPACITY,
+    NR_FULL,
+    NR_EMPTY
+} NotificationRingResult;
+
+/** The change a notification reports */
+typedef enum NotificationKind_t {
+    NOTIFY_EVENT_ADDED,
+    NOTIFY_EVENT_REMOVED,
+    NOTIFY_EVENT_DATE_CHANGED,
+    NOTIFY_MEMBER_LINKED,
+    NOTIFY_MEMBER_UNLINKED,
+    NOTIFY_EVENT_EXPIRED
+} NotificationKind;
+
+/**
+* A change notification. version is the version of the change, consecutive
+* changes have consecutive versions. member_id is -1 unless the change links
+* or unlinks a member. The date is the date of the event after the change.
+*/
+typedef struct Notification_t {
+    long version;
+    NotificationKind kind;
+    int event_id;
+    int member_id;
+    int day;
+    int month;
+    int year;
+} Notification;
+
+/**
+* notificationRingCreate: Allocates a new empty ring.
+*
+* @param capacity - The number of notifications the ring holds, a power of 2.
+* @param ring - Receives the new ring.
+* @return
+*   NR_NULL_ARGUMENT if ring is NULL.
+*   NR_INVALID_CAPACITY if capacity is not a positive power of 2.
+*   NR_OUT_OF_MEMORY if allocation failed.
+*   NR_SUCCESS otherwise.
+*/
+NotificationRingResult notificationRingCreate(int capacity, NotificationRing* ring);
+
+/**
+* notificationRingDestroy: Deallocates an existing ring. No thread may use the
+* ring once it is destroyed.
+*
+* @param ring - Target ring to be deallocated. If ring is NULL nothing will be done.
+*/
+void notificationRingDestroy(NotificationRing ring);
+
+/**
+* notificationRingPublish: Adds a notification to the ring. Must only be
+* called by one thread at a time.
+*
+* @param ring - The ring to publish to.
+* @param notification - The notification, copied into the ring.
+* @return
+*   NR_NULL_ARGUMENT if a NULL was sent.
+*   NR_FULL if the ring is full, the notification is dropped and counted.
+*   NR_SUCCESS otherwise.
+*/
+NotificationRingResult notificationRingPublish(NotificationRing ring, const Notification* notification);
+
+/**
+* notificationRingConsume: Takes the oldest notification out of the ring. May
+* be called by any number of threads at once.
+*
+* @param ring - The ring to consume from.
+* @param notification - Receives the notification.
+* @return
+*   NR_NULL_ARGUMENT if a NULL was sent.
+*   NR_EMPTY if there is no notification to take.
+*   NR_SUCCESS otherwise.
+*/
+NotificationRingResult notificationRingConsume(NotificationRing ring, Notification* notification);
+
+/**
+* notificationRingGetDropped: Returns the number of notifications that were
+* dropped because the ring was full.
+*
+* @param ring - The ring to query.
+* @return
+*   -1 if a NULL was sent as ring.
+*   Otherwise the number of dropped notifications.
+*/
+long notificationRingGetDropped(NotificationRing ring);
+
+/**
+* notificationRingGetMemoryUsage: Returns the number of bytes allocated for a
+* ring and its cells, which is fixed when the ring is created.
+*
+* @param ring - The ring to measure.
+* @return
+*   0 if a NULL was sent as ring.
+*   Otherwise the number of bytes.
+*/
+long notificationRingGetMemoryUsage(NotificationRing ring);
+
+#endif /* NOTIFICATION_RING_H_ */
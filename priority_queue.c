@@ -1,8 +1,35 @@
 #include "priority_queue.h"
+#include "priority_queue_ext.h"
+#include "allocator.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef ENABLE_STATS
+#define PQ_STAT_ADD(queue,field,amount) ((queue)->stats.field+=(amount))
+#else
+#define PQ_STAT_ADD(queue,field,amount) ((void)0)
+#endif
+#define PQ_CMP(queue,priority1,priority2) \
+    (PQ_STAT_ADD(queue,comparisons,1),(queue)->cmp(priority1,priority2))
+#define PQ_INSERT_CMP(queue,priority1,priority2) \
+    (PQ_STAT_ADD(queue,insert_comparisons,1),PQ_CMP(queue,priority1,priority2))
+#define PQ_COPY(queue,element) (PQ_STAT_ADD(queue,element_copies,1),(queue)->copy(element))
+#define PQ_COPY_P(queue,priority) (PQ_STAT_ADD(queue,priority_copies,1),(queue)->copy_P(priority))
+#define PQ_SCAN(queue) PQ_STAT_ADD(queue,nodes_scanned,1)
+#define PQ_NODE_ALLOCATED(queue) \
+    (PQ_STAT_ADD(queue,allocations,1),PQ_STAT_ADD(queue,bytes_live,(long)sizeof(struct node)))
+#define PQ_NODE_FREED(queue) \
+    (PQ_STAT_ADD(queue,frees,1),PQ_STAT_ADD(queue,bytes_live,-(long)sizeof(struct node)))
+#define PQ_FREE(queue,element) \
+    ((queue)->arena_owned&PQ_ARENA_OWNS_ELEMENTS ? (void)0 : (queue)->free(element))
+#define PQ_FREE_P(queue,priority) \
+    ((queue)->arena_owned&PQ_ARENA_OWNS_PRIORITIES ? (void)0 : (queue)->free_P(priority))
+#define SLAB_NODES 1024
+#define COPY_CHUNK_NODES 1024
 
 
 typedef struct node{
@@ -14,6 +41,13 @@ typedef struct node{
 
 }*Node;
 
+typedef struct slab{
+
+    struct slab *next;
+    struct node nodes[SLAB_NODES];
+
+}*Slab;
+
 struct PriorityQueue_t{
     Node head;
     Node it;
@@ -26,51 +60,236 @@ struct PriorityQueue_t{
     FreePQElementPriority free_P;
     EqualPQElements equal;
     ComparePQElementPriorities  cmp;
+    bool in_arena;
+    int arena_owned;
+    Slab slabs;
+    Slab current_slab;
+    int slab_used;
+    Node free_nodes;
+    Allocator allocator;
+#ifdef ENABLE_STATS
+    PQStats stats;
+#endif
 };
 
 /**
-* createNode1: Allocates a new node.
+* allocate_node: allocates a node, from the slabs of the queue when it is in an arena.
 *
-* @param queue - the priority queue that we want to make a copy of.
-* @param element - the element that we want to put in node.
-* @param priority - the priority of the elemnt that we want to put in node.
-* @param counter - the counter in the priority queue that we want to put in node.
+* @param queue - the priority queue the node belongs to.
 * @return
 * NULL - if allocation failed.
 * otherwise a new node.
 */
-static Node createNode1(PriorityQueue queue,PQElement element,PQElementPriority priority,int counter)
+static Node allocate_node(PriorityQueue queue)
 {
-    Node ptr = malloc(sizeof(*ptr));
-    if(!ptr) {
-        return NULL;
+    Node node=NULL;
+    if(!queue->in_arena)
+    {
+        node=allocatorAlloc(&queue->allocator,sizeof(*node));
+    }
+    else if(queue->free_nodes!=NULL)
+    {
+        node=queue->free_nodes;
+        queue->free_nodes=node->next;
+    }
+    else
+    {
+        if(queue->current_slab==NULL||queue->slab_used==SLAB_NODES)
+        {
+            Slab next= queue->current_slab==NULL ? queue->slabs : queue->current_slab->next;
+            if(next==NULL)
+            {
+                next=allocatorAlloc(&queue->allocator,sizeof(*next));
+                if(next==NULL)
+                {
+                    return NULL;
+                }
+                next->next=NULL;
+                if(queue->current_slab==NULL)
+                {
+                    queue->slabs=next;
+                }
+                else
+                {
+                    queue->current_slab->next=next;
+                }
+            }
+            queue->current_slab=next;
+            queue->slab_used=0;
+        }
+        node=&queue->current_slab->nodes[queue->slab_used++];
+    }
+    if(node!=NULL)
+    {
+        PQ_NODE_ALLOCATED(queue);
     }
-    assert(ptr!=NULL);
-    ptr->element=queue->copy(element);
-    ptr->priority=queue->copy_P(priority);
-    ptr->counter_node=counter;
-    return ptr;
+    return node;
 }
 
-PriorityQueue pqCreate(CopyPQElement copy_element,
-                       FreePQElement free_element,
-                       EqualPQElements equal_elements,
-                       CopyPQElementPriority copy_priority,
-                       FreePQElementPriority free_priority,
-                       ComparePQElementPriorities compare_priorities)
+/**
+* release_node: frees a node, or keeps it for reuse when the queue is in an arena.
+*
+* @param queue - the priority queue the node belongs to.
+* @param node - the node to release.
+*/
+static void release_node(PriorityQueue queue,Node node)
+{
+    PQ_NODE_FREED(queue);
+    if(!queue->in_arena)
+    {
+        allocatorFree(&queue->allocator,node);
+        return;
+    }
+    node->next=queue->free_nodes;
+    queue->free_nodes=node;
+}
+
+/**
+* reset_arena: releases all the nodes of an arena queue at once and gives it
+* a new empty head. The slabs are kept for reuse.
+*
+* @param queue - the priority queue to reset.
+*/
+static void reset_arena(PriorityQueue queue)
+{
+#ifdef ENABLE_STATS
+    queue->stats.frees=queue->stats.allocations;
+    queue->stats.bytes_live=0;
+#endif
+    queue->current_slab=NULL;
+    queue->slab_used=0;
+    queue->free_nodes=NULL;
+    queue->head=allocate_node(queue);
+    queue->head->element=NULL;
+    queue->head->priority=NULL;
+    queue->head->next=NULL;
+}
+
+/**
+* link_node: puts a node in its place in the list of a queue, after the
+* elements with the same priority.
+*
+* @param queue - the priority queue to link to.
+* @param node - the node, with its element and priority set.
+*/
+static void link_node(PriorityQueue queue,Node node)
+{
+    Node prev=NULL;
+    Node current=queue->head;
+    while(current!=NULL&&PQ_INSERT_CMP(queue,node->priority,current->priority)<=0){
+        PQ_SCAN(queue);
+        prev=current;
+        current=current->next;
+    }
+    node->next=current;
+    if(prev==NULL)
+    {
+        queue->head=node;
+    }
+    else
+    {
+        prev->next=node;
+    }
+}
+
+/**
+* insert_owned: puts an element and a priority that belong to the queue in
+* their place, after the elements with the same priority.
+*
+* @param queue - the priority queue to insert to.
+* @param element - the element, owned by the queue on success.
+* @param priority - the priority of the element, owned by the queue on success.
+* @return
+* PQ_OUT_OF_MEMORY - if allocation failed, element and priority are not taken.
+* otherwise PQ_SUCCESS.
+*/
+static PriorityQueueResult insert_owned(PriorityQueue queue,PQElement element,PQElementPriority priority)
+{
+    PQ_STAT_ADD(queue,inserts,1);
+    if(queue->size==0&&queue->head!=NULL)
+    {
+        queue->head->element=element;
+        queue->head->priority=priority;
+        queue->head->counter_node=queue->counter;
+    }
+    else
+    {
+        Node new=allocate_node(queue);
+        if(new==NULL)
+        {
+            return PQ_OUT_OF_MEMORY;
+        }
+        new->element=element;
+        new->priority=priority;
+        new->counter_node=queue->counter;
+        link_node(queue,new);
+    }
+    queue->size++;
+    queue->counter++;
+    queue->it=NULL;
+    return PQ_SUCCESS;
+}
+
+/**
+* create_queue: allocates a new empty queue.
+*
+* @param in_arena - TRUE to allocate the nodes of the queue from slabs.
+* @param arena_owned - the values the queue never frees, see PQArenaOwnership.
+* @param allocator - the allocator of the queue and its nodes, NULL for malloc.
+* @return
+* NULL - if allocation failed or a needed function is NULL.
+* otherwise a new queue.
+*/
+static PriorityQueue create_queue(CopyPQElement copy_element,
+                                  FreePQElement free_element,
+                                  EqualPQElements equal_elements,
+                                  CopyPQElementPriority copy_priority,
+                                  FreePQElementPriority free_priority,
+                                  ComparePQElementPriorities compare_priorities,
+                                  bool in_arena,int arena_owned,
+                                  const Allocator* allocator)
 {
-    if(copy_element==NULL||free_element==NULL||equal_elements==NULL||copy_priority==NULL||free_priority==NULL
-    ||compare_priorities==NULL)
+    if(copy_element==NULL||equal_elements==NULL||copy_priority==NULL||compare_priorities==NULL
+    ||(free_element==NULL&&!(arena_owned&PQ_ARENA_OWNS_ELEMENTS))
+    ||(free_priority==NULL&&!(arena_owned&PQ_ARENA_OWNS_PRIORITIES)))
+    {
+        return NULL;
+    }
+    PriorityQueue queue= allocatorAlloc(allocator,sizeof(*queue));
+    if(queue==NULL)
     {
         return NULL;
     }
-    PriorityQueue queue= malloc(sizeof(*queue));
-    Node first=malloc(sizeof(*first));
+    if(allocator!=NULL)
+    {
+        queue->allocator=*allocator;
+    }
+    else
+    {
+        memset(&queue->allocator,0,sizeof(queue->allocator));
+    }
+    queue->in_arena=in_arena;
+    queue->arena_owned=arena_owned;
+    queue->slabs=NULL;
+    queue->current_slab=NULL;
+    queue->slab_used=0;
+    queue->free_nodes=NULL;
+#ifdef ENABLE_STATS
+    memset(&queue->stats,0,sizeof(queue->stats));
+    queue->stats.enabled=true;
+#endif
+    Node first=allocate_node(queue);
+    if(first==NULL)
+    {
+        allocatorFree(allocator,queue);
+        return NULL;
+    }
     queue->head= first;
     first->next=NULL;
     first->element=NULL;
     first->priority=NULL;
     queue-> iterator=NULL;
+    queue->it=NULL;
     queue->size=0;
     queue->counter=0;
     queue->copy=copy_element;
@@ -81,51 +300,339 @@ PriorityQueue pqCreate(CopyPQElement copy_element,
     queue->equal=equal_elements;
     return queue;
 }
+
+PriorityQueue pqCreate(CopyPQElement copy_element,
+                       FreePQElement free_element,
+                       EqualPQElements equal_elements,
+                       CopyPQElementPriority copy_priority,
+                       FreePQElementPriority free_priority,
+                       ComparePQElementPriorities compare_priorities)
+{
+    if(free_element==NULL||free_priority==NULL)
+    {
+        return NULL;
+    }
+    return create_queue(copy_element,free_element,equal_elements,copy_priority,free_priority,
+                        compare_priorities,false,PQ_ARENA_OWNS_NOTHING,NULL);
+}
+
+PriorityQueue pqCreateWithAllocator(CopyPQElement copy_element,
+                                    FreePQElement free_element,
+                                    EqualPQElements equal_elements,
+                                    CopyPQElementPriority copy_priority,
+                                    FreePQElementPriority free_priority,
+                                    ComparePQElementPriorities compare_priorities,
+                                    const Allocator* allocator)
+{
+    if(free_element==NULL||free_priority==NULL)
+    {
+        return NULL;
+    }
+    return create_queue(copy_element,free_element,equal_elements,copy_priority,free_priority,
+                        compare_priorities,false,PQ_ARENA_OWNS_NOTHING,allocator);
+}
+
+PriorityQueue pqCreateArena(CopyPQElement copy_element,
+                            FreePQElement free_element,
+                            EqualPQElements equal_elements,
+                            CopyPQElementPriority copy_priority,
+                            FreePQElementPriority free_priority,
+                            ComparePQElementPriorities compare_priorities,
+                            int arena_owned)
+{
+    return create_queue(copy_element,free_element,equal_elements,copy_priority,free_priority,
+                        compare_priorities,true,arena_owned,NULL);
+}
+
+/**
+* free_values: frees the elements and priorities of all the nodes of a queue,
+* except for the ones that are owned by an arena.
+*
+* @param queue - the priority queue whose values are freed.
+*/
+static void free_values(PriorityQueue queue)
+{
+    if((queue->arena_owned&PQ_ARENA_OWNS_ELEMENTS)&&(queue->arena_owned&PQ_ARENA_OWNS_PRIORITIES))
+    {
+        return;
+    }
+    for(Node current=queue->head;current!=NULL;current=current->next){
+        if(current->element)
+        {
+            PQ_FREE(queue,current->element);
+        }
+        if(current->priority)
+        {
+            PQ_FREE_P(queue,current->priority);
+        }
+    }
+}
+
 void pqDestroy(PriorityQueue queue)
 {
     if(queue==NULL){
         return;
     }
+    if(queue->in_arena)
+    {
+        free_values(queue);
+        if(queue->iterator!=NULL)
+        {
+            PQ_FREE(queue,queue->iterator);
+        }
+        while(queue->slabs!=NULL)
+        {
+            Slab next=queue->slabs->next;
+            allocatorFree(&queue->allocator,queue->slabs);
+            queue->slabs=next;
+        }
+        Allocator allocator=queue->allocator;
+        allocatorFree(&allocator,queue);
+        return;
+    }
     Node current=queue->head;
     while (current!=NULL)
     {
         if(current->element)
         {
-            queue->free(current->element);
+            PQ_FREE(queue,current->element);
         }
         if(current->priority)
         {
-            queue->free_P(current->priority);
+            PQ_FREE_P(queue,current->priority);
         }
         Node s=current;
         current=current->next;
-        free(s);
+        release_node(queue,s);
     }
     if(queue->iterator!=NULL)
     {
-        queue->free(queue->iterator);
+        PQ_FREE(queue,queue->iterator);
     }
-    free(queue);
+    Allocator allocator=queue->allocator;
+    allocatorFree(&allocator,queue);
 }
 
-PriorityQueue pqCopy(PriorityQueue queue)
+/**
+* copy_nodes: links a node in a copy of a queue for every element of the
+* queue, with the same insertion counters and no values yet.
+*
+* @param queue - the priority queue being copied.
+* @param newqueue - the empty copy, its head becomes the first node.
+* @return
+* FALSE - if allocation failed, the nodes that were allocated stay linked.
+* otherwise TRUE.
+*/
+static bool copy_nodes(PriorityQueue queue,PriorityQueue newqueue)
 {
-    if(queue==NULL)
+    Node target=newqueue->head;
+    Node source=queue->head;
+    for(int i=0;i<queue->size;i++){
+        if(i>0)
+        {
+            Node next=allocate_node(newqueue);
+            if(next==NULL)
+            {
+                return false;
+            }
+            next->element=NULL;
+            next->priority=NULL;
+            next->next=NULL;
+            target->next=next;
+            target=next;
+        }
+        target->counter_node=source->counter_node;
+        source=source->next;
+    }
+    return true;
+}
+
+/**
+* copy_values: copies the elements and priorities of consecutive nodes into
+* the matching nodes of a copy of the queue. Stops at the first failed copy,
+* the values that were copied stay in the nodes.
+*
+* @param queue - the priority queue being copied, whose copy functions are used.
+* @param source - the first node to copy from.
+* @param target - the first node to copy to.
+* @param count - the number of nodes.
+* @return
+* FALSE - if a copy failed.
+* otherwise TRUE.
+*/
+static bool copy_values(PriorityQueue queue,Node source,Node target,int count)
+{
+    for(int i=0;i<count;i++){
+        target->element=queue->copy(source->element);
+        target->priority=queue->copy_P(source->priority);
+        if(target->element==NULL||target->priority==NULL)
+        {
+            return false;
+        }
+        source=source->next;
+        target=target->next;
+    }
+    return true;
+}
+
+/**
+* Copy_job: the chunks of a parallel copy and the state shared by its workers.
+*/
+typedef struct copy_job{
+    PriorityQueue queue;
+    Node* sources;
+    Node* targets;
+    int chunks;
+    int next_chunk;
+    bool failed;
+    pthread_mutex_t lock;
+}Copy_job;
+
+/**
+* take_copy_chunk: takes the next chunk no worker copied yet.
+*
+* @param job - the job of the chunks.
+* @return
+* -1 - if all the chunks were taken or a copy failed.
+* otherwise the chunk.
+*/
+static int take_copy_chunk(Copy_job* job)
+{
+    pthread_mutex_lock(&job->lock);
+    int chunk= job->failed||job->next_chunk>=job->chunks ? -1 : job->next_chunk++;
+    pthread_mutex_unlock(&job->lock);
+    return chunk;
+}
+
+/**
+* copy_chunks: copies chunks until none is left, the loop of every worker.
+* A worker that is done with its chunk takes the next free one, so slow copy
+* functions on one chunk do not hold up the other workers.
+*
+* @param data - the job of the chunks.
+* @return
+* NULL.
+*/
+static void* copy_chunks(void* data)
+{
+    Copy_job* job=data;
+    int chunk=take_copy_chunk(job);
+    while(chunk>=0){
+        int count= chunk==job->chunks-1 ? job->queue->size-chunk*COPY_CHUNK_NODES : COPY_CHUNK_NODES;
+        if(!copy_values(job->queue,job->sources[chunk],job->targets[chunk],count))
+        {
+            pthread_mutex_lock(&job->lock);
+            job->failed=true;
+            pthread_mutex_unlock(&job->lock);
+        }
+        chunk=take_copy_chunk(job);
+    }
+    return NULL;
+}
+
+/**
+* copy_values_parallel: copies the values of a queue into the nodes of its
+* copy in chunks of COPY_CHUNK_NODES nodes, on up to workers threads, the
+* calling thread included. Threads that cannot be started are not replaced,
+* the remaining ones copy their chunks.
+*
+* @param queue - the priority queue being copied.
+* @param newqueue - the copy, linked by copy_nodes.
+* @param workers - the number of threads.
+* @return
+* FALSE - if a copy failed.
+* otherwise TRUE.
+*/
+static bool copy_values_parallel(PriorityQueue queue,PriorityQueue newqueue,int workers)
+{
+    Copy_job job={queue,NULL,NULL,(queue->size+COPY_CHUNK_NODES-1)/COPY_CHUNK_NODES,0,false};
+    job.sources=allocatorAlloc(&queue->allocator,sizeof(*job.sources)*job.chunks);
+    job.targets=allocatorAlloc(&queue->allocator,sizeof(*job.targets)*job.chunks);
+    if(job.sources==NULL||job.targets==NULL||pthread_mutex_init(&job.lock,NULL)!=0)
+    {
+        allocatorFree(&queue->allocator,job.sources);
+        allocatorFree(&queue->allocator,job.targets);
+        return copy_values(queue,queue->head,newqueue->head,queue->size);
+    }
+    Node source=queue->head;
+    Node target=newqueue->head;
+    for(int i=0;i<queue->size;i++){
+        if(i%COPY_CHUNK_NODES==0)
+        {
+            job.sources[i/COPY_CHUNK_NODES]=source;
+            job.targets[i/COPY_CHUNK_NODES]=target;
+        }
+        source=source->next;
+        target=target->next;
+    }
+    int threads_num= workers<job.chunks ? workers-1 : job.chunks-1;
+    pthread_t* threads=NULL;
+    int started=0;
+    if(threads_num>0)
+    {
+        threads=allocatorAlloc(&queue->allocator,sizeof(*threads)*threads_num);
+    }
+    if(threads!=NULL)
+    {
+        while(started<threads_num&&pthread_create(&threads[started],NULL,copy_chunks,&job)==0){
+            started++;
+        }
+    }
+    copy_chunks(&job);
+    for(int i=0;i<started;i++){
+        pthread_join(threads[i],NULL);
+    }
+    allocatorFree(&queue->allocator,threads);
+    pthread_mutex_destroy(&job.lock);
+    allocatorFree(&queue->allocator,job.sources);
+    allocatorFree(&queue->allocator,job.targets);
+    return !job.failed;
+}
+
+/**
+* copy_queue: the implementation of pqCopy and pqCopyWithWorkers. The nodes of
+* the copy are linked in the order of the queue, so no priority is compared,
+* and the values are copied on workers threads when the queue is large enough.
+* pqCopy copies on the calling thread only, since its copy functions were
+* never required to be thread-safe.
+*
+* @param queue - the priority queue to copy.
+* @param workers - the number of threads that copy the values.
+* @return
+* NULL - if allocation or a copy failed.
+* otherwise the copy.
+*/
+static PriorityQueue copy_queue(PriorityQueue queue,int workers)
+{
+    PriorityQueue  newqueue= create_queue(queue->copy,
+                                          queue->free,
+                                          queue->equal,
+                                          queue->copy_P,
+                                          queue->free_P,
+                                          queue->cmp,
+                                          queue->in_arena,
+                                          queue->arena_owned,
+                                          &queue->allocator);
+    if(newqueue==NULL)
     {
         return NULL;
     }
-    PriorityQueue  newqueue= pqCreate(queue->copy,
-                                      queue->free,
-                                      queue->equal,
-                                      queue->copy_P,
-                                      queue->free_P,
-                                      queue->cmp);
-    Node current_node= queue->head;
-    while(current_node!=NULL)
+    bool copied=copy_nodes(queue,newqueue);
+    if(copied&&workers>1&&queue->size>=PQ_PARALLEL_COPY_MIN_SIZE)
     {
-        pqInsert(newqueue,current_node->element,current_node->priority);
-        current_node=current_node->next;
+        copied=copy_values_parallel(queue,newqueue,workers);
+    }
+    else if(copied)
+    {
+        copied=copy_values(queue,queue->head,newqueue->head,queue->size);
     }
+    if(!copied)
+    {
+        pqDestroy(newqueue);
+        return NULL;
+    }
+    PQ_STAT_ADD(newqueue,element_copies,queue->size);
+    PQ_STAT_ADD(newqueue,priority_copies,queue->size);
     queue->it=NULL;
     newqueue->it=NULL;
     newqueue->size=queue->size;
@@ -133,6 +640,24 @@ PriorityQueue pqCopy(PriorityQueue queue)
     return newqueue;
 }
 
+PriorityQueue pqCopy(PriorityQueue queue)
+{
+    if(queue==NULL)
+    {
+        return NULL;
+    }
+    return copy_queue(queue,1);
+}
+
+PriorityQueue pqCopyWithWorkers(PriorityQueue queue, int workers)
+{
+    if(queue==NULL)
+    {
+        return NULL;
+    }
+    return copy_queue(queue,workers);
+}
+
 int pqGetSize(PriorityQueue queue)
 {
     if(!queue)
@@ -146,8 +671,10 @@ bool pqContains(PriorityQueue queue, PQElement element)
 {
     if(!element)
     {return false;}
+    PQ_STAT_ADD(queue,lookups,1);
     Node current_node= queue->head;
     while(current_node!=NULL){
+        PQ_SCAN(queue);
         if(queue->equal(current_node->element,element))
             return true;
         current_node=current_node->next;
@@ -160,54 +687,52 @@ PriorityQueueResult pqInsert(PriorityQueue queue, PQElement element, PQElementPr
     {
         return PQ_NULL_ARGUMENT;
     }
-    if(queue->size==0)
+    PQElement new_element=PQ_COPY(queue,element);
+    if(new_element==NULL)
     {
-        queue->head->element=queue->copy(element);
-        queue->head->priority=queue->copy_P(priority);
-        queue->head->counter_node=queue->counter;
-        queue->size++;
-        queue->counter++;
-        queue->it=NULL;
-        return PQ_SUCCESS;
+        return PQ_OUT_OF_MEMORY;
     }
-    Node current=queue->head;
-    if(queue->cmp(priority,current->priority)>0){
-        queue->head=createNode1(queue,element,priority,queue->counter);
-        if(queue->head==NULL)
-        {
-            return PQ_OUT_OF_MEMORY;
-        }
-        queue->head->next=current;
-        queue->size++;
-        queue->counter++;
-        queue->it=NULL;
-        return PQ_SUCCESS;
+    PQElementPriority new_priority=PQ_COPY_P(queue,priority);
+    if(new_priority==NULL)
+    {
+        PQ_FREE(queue,new_element);
+        return PQ_OUT_OF_MEMORY;
+    }
+    PriorityQueueResult result=insert_owned(queue,new_element,new_priority);
+    if(result!=PQ_SUCCESS)
+    {
+        PQ_FREE(queue,new_element);
+        PQ_FREE_P(queue,new_priority);
+    }
+    return result;
+}
+
+PriorityQueueResult pqInsertTake(PriorityQueue queue, PQElement element, PQElementPriority priority)
+{
+    if(queue==NULL||element==NULL||priority==NULL)
+    {
+        return PQ_NULL_ARGUMENT;
+    }
+    return insert_owned(queue,element,priority);
+}
+
+PriorityQueueResult pqPushMove(PriorityQueue queue, PQElement element, PQElementPriority priority)
+{
+    if(queue==NULL||element==NULL||priority==NULL)
+    {
+        return PQ_NULL_ARGUMENT;
     }
-    Node new=createNode1(queue,element,priority,queue->counter);
-    if(new==NULL)
+    PQElementPriority new_priority=PQ_COPY_P(queue,priority);
+    if(new_priority==NULL)
+    {
         return PQ_OUT_OF_MEMORY;
-    Node prev=current;
-    current=current->next;
-    while(current!=NULL){
-        if(queue->cmp(priority,prev->priority)<=0&&queue->cmp(priority,current->priority)>0){
-            prev->next=new;
-            new->next=current;
-            queue->size++;
-            queue->counter++;
-            queue->it=NULL;
-            return  PQ_SUCCESS;
-        }
-        prev=prev->next;
-        current=current->next;
     }
-    if(current==NULL){
-        prev->next=new;
-        new->next=NULL;
+    PriorityQueueResult result=insert_owned(queue,element,new_priority);
+    if(result!=PQ_SUCCESS)
+    {
+        PQ_FREE_P(queue,new_priority);
     }
-    queue->size++;
-    queue->counter++;
-    queue->it=NULL;
-    return PQ_SUCCESS;
+    return result;
 }
 
 
@@ -225,27 +750,28 @@ static void pqRemoveElement_priorty(PriorityQueue queue, PQElement element,
     Node current=queue->head;
     Node prev=current;
     Node prev_to_remove=current;
-    if(queue->equal(queue->head->element,element)&&queue->cmp(queue->head->priority,
+    if(queue->equal(queue->head->element,element)&&PQ_CMP(queue,queue->head->priority,
             priority)==0&&queue->size>=2)
     {
         Node cur=queue->head;
         queue->head=queue->head->next;
-        queue->free(cur->element);
-        queue->free_P(cur->priority);
-        free(cur);
+        PQ_FREE(queue,cur->element);
+        PQ_FREE_P(queue,cur->priority);
+        release_node(queue,cur);
         return;
     }
     if(current->next==NULL)
     {
-        queue->free(current->element);
-        queue->free_P(current->priority);
+        PQ_FREE(queue,current->element);
+        PQ_FREE_P(queue,current->priority);
         current->element=NULL;
         current->priority=NULL;
         return;
     }
     while(current!=NULL)
     {
-        if (queue->equal(element,current->element)&&queue->cmp(priority,current->priority)==0)
+        PQ_SCAN(queue);
+        if (queue->equal(element,current->element)&&PQ_CMP(queue,priority,current->priority)==0)
         {
             break;
         }
@@ -261,7 +787,7 @@ static void pqRemoveElement_priorty(PriorityQueue queue, PQElement element,
     prev_to_remove=prev;
     prev=current;
     current=current->next;
-    while(current!=NULL&&queue->equal(element,current->element)&&queue->cmp(priority,current)==0)
+    while(current!=NULL&&queue->equal(element,current->element)&&PQ_CMP(queue,priority,current)==0)
     {
         if(current->counter_node<prev->counter_node&&current->counter_node<counter)
         {
@@ -275,48 +801,20 @@ static void pqRemoveElement_priorty(PriorityQueue queue, PQElement element,
     if(prev_to_remove==node_to_remove&&node_to_remove==queue->head)
     {
         queue->head=node_to_remove->next;
-        queue->free(node_to_remove->element);
-        queue->free_P(node_to_remove->priority);
-        free(node_to_remove);
+        PQ_FREE(queue,node_to_remove->element);
+        PQ_FREE_P(queue,node_to_remove->priority);
+        release_node(queue,node_to_remove);
         return;
     }
     if(prev_to_remove!=NULL&&node_to_remove!=NULL)
     {
         prev_to_remove->next=node_to_remove->next;
-        queue->free(node_to_remove->element);
-        queue->free_P(node_to_remove->priority);
-        free(node_to_remove);
+        PQ_FREE(queue,node_to_remove->element);
+        PQ_FREE_P(queue,node_to_remove->priority);
+        release_node(queue,node_to_remove);
     }
 }
 
-/**
-* pqContains_P: check if the priority queue contains a priority.
-*
-* @param queue - the priority queue that we want to search in.
-* @param element - the element that we want to find its priority.
-* @param priority - the priority of the element we are looking for.
-* @return
-* returns true if the queue contains the priority.
-* otherwise false.
-*/
-static bool pqContains_P(PriorityQueue queue, PQElement element,
-                  PQElementPriority priority)
-{
-    if(!element)
-    {
-        return false;
-    }
-    Node current_node= queue->head;
-    while(current_node!=NULL){
-        if(queue->equal(current_node->element,element)&&queue->cmp(priority,current_node->priority)==0)
-        {
-            return true;
-        }
-        current_node=current_node->next;
-    }
-    return false;
-}
-
 PriorityQueueResult pqChangePriority(PriorityQueue queue, PQElement element,
                                      PQElementPriority old_priority, PQElementPriority new_priority)
 {
@@ -324,20 +822,41 @@ PriorityQueueResult pqChangePriority(PriorityQueue queue, PQElement element,
     {
         return PQ_NULL_ARGUMENT;
     }
-    if(!pqContains_P(queue, element, old_priority))
+    if(queue->size==0)
     {
         return PQ_ELEMENT_DOES_NOT_EXISTS;
     }
-    if(queue->size==1)
+    PQ_STAT_ADD(queue,lookups,1);
+    Node prev=NULL;
+    Node moved=queue->head;
+    while(moved!=NULL&&!(queue->equal(moved->element,element)&&PQ_CMP(queue,old_priority,moved->priority)==0)){
+        PQ_SCAN(queue);
+        prev=moved;
+        moved=moved->next;
+    }
+    if(moved==NULL)
     {
-        queue->free_P(queue->head->priority);
-        queue->head->priority= queue->copy_P(new_priority);
-        return PQ_SUCCESS;
+        return PQ_ELEMENT_DOES_NOT_EXISTS;
+    }
+    PQElementPriority priority=PQ_COPY_P(queue,new_priority);
+    if(priority==NULL)
+    {
+        return PQ_OUT_OF_MEMORY;
+    }
+    // the node keeps its element and moves behind the elements of its new priority
+    if(prev==NULL)
+    {
+        queue->head=moved->next;
+    }
+    else
+    {
+        prev->next=moved->next;
     }
-    PQElement new_element=queue->copy(element);
-    pqRemoveElement_priorty(queue, element,old_priority);
-    pqInsert(queue,new_element,new_priority);
-    queue->free(new_element);
+    PQ_FREE_P(queue,moved->priority);
+    moved->priority=priority;
+    moved->counter_node=queue->counter++;
+    PQ_STAT_ADD(queue,inserts,1);
+    link_node(queue,moved);
     queue->it=NULL;
     return PQ_SUCCESS;
 }
@@ -350,9 +869,9 @@ PriorityQueueResult pqRemove(PriorityQueue queue)
     }
     Node current=queue->head;
     queue->head=current->next;
-    queue->free(current->element);
-    queue->free_P(current->priority);
-    free(current);
+    PQ_FREE(queue,current->element);
+    PQ_FREE_P(queue,current->priority);
+    release_node(queue,current);
     queue->size--;
     queue->it=NULL;
     return PQ_SUCCESS;
@@ -380,6 +899,7 @@ PriorityQueueResult pqRemoveElement(PriorityQueue queue, PQElement element)
     current=current->next;
     while (current!=NULL)
     {
+        PQ_SCAN(queue);
         if(queue->equal(current->element,element))
         {
             pqRemoveElement_priorty(queue,element,current->priority);
@@ -394,6 +914,49 @@ PriorityQueueResult pqRemoveElement(PriorityQueue queue, PQElement element)
 }
 
 
+PriorityQueueResult pqPopTake(PriorityQueue queue, PQElement* element, PQElementPriority* priority)
+{
+    if(queue==NULL)
+    {
+        return PQ_NULL_ARGUMENT;
+    }
+    if(queue->size==0||queue->head==NULL||queue->head->element==NULL)
+    {
+        return PQ_ELEMENT_DOES_NOT_EXISTS;
+    }
+    Node first=queue->head;
+    if(element!=NULL)
+    {
+        *element=first->element;
+    }
+    else
+    {
+        PQ_FREE(queue,first->element);
+    }
+    if(priority!=NULL)
+    {
+        *priority=first->priority;
+    }
+    else
+    {
+        PQ_FREE_P(queue,first->priority);
+    }
+    if(first->next==NULL)
+    {
+        first->element=NULL;
+        first->priority=NULL;
+    }
+    else
+    {
+        queue->head=first->next;
+        release_node(queue,first);
+    }
+    queue->size--;
+    queue->it=NULL;
+    return PQ_SUCCESS;
+}
+
+
 PQElement pqGetFirst(PriorityQueue queue)
 {
     if(!queue->head)
@@ -407,9 +970,9 @@ PQElement pqGetFirst(PriorityQueue queue)
     queue->it=queue->head;
     if(queue->iterator)
     {
-        queue->free(queue->iterator);
+        PQ_FREE(queue,queue->iterator);
     }
-    queue->iterator=queue->copy(queue->head->element);
+    queue->iterator=PQ_COPY(queue,queue->head->element);
     return queue->iterator;
 }
 
@@ -422,34 +985,72 @@ PQElement pqGetNext(PriorityQueue queue)
     }
     queue->it=queue->it->next;
     if(queue->iterator) {
-        queue->free(queue->iterator);
+        PQ_FREE(queue,queue->iterator);
     }
-    queue->iterator=queue->copy(queue->it->element);
+    queue->iterator=PQ_COPY(queue,queue->it->element);
     return queue->iterator;
 }
 
 
+int pqPeekTopK(PriorityQueue queue, int k, PQElement* elements, PQElementPriority* priorities)
+{
+    if(queue==NULL||k<0||(elements==NULL&&k>0))
+    {
+        return -1;
+    }
+    int count=0;
+    for(Node current=queue->head;count<k&&count<queue->size;current=current->next){
+        PQ_SCAN(queue);
+        elements[count]=current->element;
+        if(priorities!=NULL)
+        {
+            priorities[count]=current->priority;
+        }
+        count++;
+    }
+    return count;
+}
+
+
 PriorityQueueResult pqClear(PriorityQueue queue)
 {
     if(queue==NULL)
     {
         return PQ_NULL_ARGUMENT;
     }
+    if(queue->in_arena)
+    {
+        free_values(queue);
+        reset_arena(queue);
+        if(queue->iterator!=NULL)
+        {
+            PQ_FREE(queue,queue->iterator);
+        }
+        queue->iterator=NULL;
+        queue->it=queue->head;
+        queue->counter=0;
+        queue->size=0;
+        return PQ_SUCCESS;
+    }
     Node current=queue->head;
-    queue->free(current->element);
-    queue->free_P(current->priority);
+    PQ_FREE(queue,current->element);
+    PQ_FREE_P(queue,current->priority);
     current->element=NULL;
     current->priority=NULL;
     current=current->next;
     while(current!=NULL)
     {
-        queue->free(current->element);
-        queue->free_P(current->priority);
+        PQ_FREE(queue,current->element);
+        PQ_FREE_P(queue,current->priority);
         Node p1=current;
         current=current->next;
-        free(p1);
+        release_node(queue,p1);
     }
     queue->head->next=NULL;
+    if(queue->iterator!=NULL)
+    {
+        PQ_FREE(queue,queue->iterator);
+    }
     queue->iterator=NULL;
     queue->it=queue->head;
     queue->counter=0;
@@ -462,3 +1063,49 @@ PriorityQueueResult pqClear(PriorityQueue queue)
 
 
 
+
+
+PriorityQueueResult pqGetStats(PriorityQueue queue, PQStats* stats)
+{
+    if(queue==NULL||stats==NULL)
+    {
+        return PQ_NULL_ARGUMENT;
+    }
+#ifdef ENABLE_STATS
+    *stats=queue->stats;
+#else
+    memset(stats,0,sizeof(*stats));
+    stats->enabled=false;
+#endif
+    return PQ_SUCCESS;
+}
+
+PriorityQueueResult pqPrintStats(PriorityQueue queue, FILE* stream)
+{
+    PQStats stats;
+    if(pqGetStats(queue,&stats)!=PQ_SUCCESS)
+    {
+        return PQ_NULL_ARGUMENT;
+    }
+    return pqWriteStats(&stats,stream);
+}
+
+PriorityQueueResult pqWriteStats(const PQStats* stats, FILE* stream)
+{
+    if(stats==NULL||stream==NULL)
+    {
+        return PQ_NULL_ARGUMENT;
+    }
+    fprintf(stream,"pq_stats_enabled %d\n",stats->enabled);
+    fprintf(stream,"pq_inserts %ld\n",stats->inserts);
+    fprintf(stream,"pq_insert_comparisons %ld\n",stats->insert_comparisons);
+    fprintf(stream,"pq_comparisons %ld\n",stats->comparisons);
+    fprintf(stream,"pq_lookups %ld\n",stats->lookups);
+    fprintf(stream,"pq_nodes_scanned %ld\n",stats->nodes_scanned);
+    fprintf(stream,"pq_element_copies %ld\n",stats->element_copies);
+    fprintf(stream,"pq_priority_copies %ld\n",stats->priority_copies);
+    fprintf(stream,"pq_allocations %ld\n",stats->allocations);
+    fprintf(stream,"pq_frees %ld\n",stats->frees);
+    fprintf(stream,"pq_bytes_live %ld\n",stats->bytes_live);
+    return PQ_SUCCESS;
+}
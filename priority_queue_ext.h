@@ -0,0 +1,241 @@
+#ifndef PRIORITY_QUEUE_EXT_H_
+#define PRIORITY_QUEUE_EXT_H_
+
+#include "priority_queue.h"
+#include "allocator.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+* Priority Queue extensions
+*
+* Additional functions over a PriorityQueue that are not part of the basic
+* interface declared in priority_queue.h.
+*
+* The following functions are available:
+*   pqCreateArena   - Creates a new empty queue whose nodes are allocated from slabs.
+*   pqCreateWithAllocator - Creates a new empty queue whose nodes are allocated by an allocator.
+*   pqCopyWithWorkers - Copies a queue, copying its values on a given number of threads.
+*   pqInsertTake    - Inserts an element and a priority that the queue takes ownership of.
+*   pqPushMove      - Inserts an element that the queue takes ownership of, copying its priority.
+*   pqPopTake       - Removes the highest priority element and hands it to the caller.
+*   pqPeekTopK      - Returns the k highest priority elements without copying them.
+*   pqGetStats      - Returns the instrumentation counters of a queue.
+*   pqPrintStats    - Writes the instrumentation counters of a queue as text.
+*   pqWriteStats    - Writes a set of queue counters as text.
+*/
+
+/**
+* Values that pqCreateArena can register as owned by an arena outside of the
+* queue. The queue never frees such values, the owner of the arena releases
+* them all at once. The flags may be combined with |.
+*/
+typedef enum PQArenaOwnership_t {
+    PQ_ARENA_OWNS_NOTHING = 0,
+    PQ_ARENA_OWNS_ELEMENTS = 1,
+    PQ_ARENA_OWNS_PRIORITIES = 2
+} PQArenaOwnership;
+
+/**
+* pqCreateArena: Allocates a new empty priority queue whose nodes are carved
+* from slabs instead of being allocated one by one. Removed nodes are reused,
+* and pqClear and pqDestroy drop all the nodes at once instead of freeing them
+* one by one. When both the elements and the priorities are arena-owned their
+* free functions are never called, so clearing takes constant time.
+*
+* @param copy_element - Function pointer to be used for copying data elements into
+*  	the priority queue or when copying the priority queue.
+* @param free_element - Function pointer to be used for removing data elements from
+* 		the priority queue. May be NULL if the elements are arena-owned.
+* @param equal_elements - Function pointer to be used for comparing elements.
+* @param copy_priority - Function pointer to be used for copying priorities into
+*  	the priority queue or when copying the priority queue.
+* @param free_priority - Function pointer to be used for removing priorities from
+* 		the priority queue. May be NULL if the priorities are arena-owned.
+* @param compare_priorities - Function pointer to be used for comparing priorities.
+* @param arena_owned - The PQArenaOwnership flags of the values the queue never frees.
+* @return
+* 	NULL - if a needed function is NULL or allocation failed.
+* 	A new priority queue in case of success.
+*/
+PriorityQueue pqCreateArena(CopyPQElement copy_element,
+                            FreePQElement free_element,
+                            EqualPQElements equal_elements,
+                            CopyPQElementPriority copy_priority,
+                            FreePQElementPriority free_priority,
+                            ComparePQElementPriorities compare_priorities,
+                            int arena_owned);
+
+/**
+* pqCreateWithAllocator: Allocates a new empty priority queue whose structure
+* and nodes are allocated and freed through allocator. The elements and the
+* priorities are still copied and freed by the given functions. A copy of the
+* queue made by pqCopy uses the same allocator.
+*
+* @param copy_element - Function pointer to be used for copying data elements into
+*  	the priority queue or when copying the priority queue.
+* @param free_element - Function pointer to be used for removing data elements from
+* 		the priority queue.
+* @param equal_elements - Function pointer to be used for comparing elements.
+* @param copy_priority - Function pointer to be used for copying priorities into
+*  	the priority queue or when copying the priority queue.
+* @param free_priority - Function pointer to be used for removing priorities from
+* 		the priority queue.
+* @param compare_priorities - Function pointer to be used for comparing priorities.
+* @param allocator - The allocator, copied into the queue. NULL for malloc.
+* @return
+* 	NULL - if one of the functions is NULL or allocation failed.
+* 	A new priority queue in case of success.
+*/
+PriorityQueue pqCreateWithAllocator(CopyPQElement copy_element,
+                                    FreePQElement free_element,
+                                    EqualPQElements equal_elements,
+                                    CopyPQElementPriority copy_priority,
+                                    FreePQElementPriority free_priority,
+                                    ComparePQElementPriorities compare_priorities,
+                                    const Allocator* allocator);
+
+/**
+* The size from which pqCopyWithWorkers copies the elements and the
+* priorities of a queue on several threads. The copy functions of such a
+* queue are then called from several threads at once, each on other values.
+* pqCopy always copies on the calling thread.
+*/
+#define PQ_PARALLEL_COPY_MIN_SIZE 4096
+
+/**
+* pqCopyWithWorkers: Creates a copy of a queue like pqCopy, with the elements
+* and the priorities copied on up to workers threads, the calling thread
+* included, when the queue holds PQ_PARALLEL_COPY_MIN_SIZE elements or more.
+* The copy takes linear time, its nodes are linked in the order of the queue
+* without comparing priorities.
+* With more than one worker the copy functions of the queue must be
+* thread-safe: they are called from several threads at once, so copy
+* functions that allocate from a shared arena of the caller, as the values of
+* queues made by pqCreateArena often do, need a single worker. The functions
+* of the allocator of the queue are only called by the calling thread.
+*
+* @param queue - The priority queue to copy.
+* @param workers - The number of threads, 1 or less to copy on the calling thread.
+* @return
+* 	NULL - if a NULL was sent, or allocation or a copy failed.
+* 	A new priority queue with the same elements in the same order otherwise.
+*/
+PriorityQueue pqCopyWithWorkers(PriorityQueue queue, int workers);
+
+/**
+* pqInsertTake: Inserts an element with a given priority without copying them.
+* The queue takes ownership of both and frees them with the functions it was
+* created with, so they must have been allocated the way those functions expect.
+*
+* @param queue - The priority queue to insert to.
+* @param element - The element to insert.
+* @param priority - The priority of the element.
+* @return
+*   PQ_NULL_ARGUMENT if a NULL was sent.
+*   PQ_OUT_OF_MEMORY if an allocation failed, the caller still owns element and priority.
+*   PQ_SUCCESS the element had been inserted successfully.
+*/
+PriorityQueueResult pqInsertTake(PriorityQueue queue, PQElement element, PQElementPriority priority);
+
+/**
+* pqPushMove: Inserts an element with a given priority, taking ownership of
+* the element and copying the priority, which stays with the caller.
+*
+* @param queue - The priority queue to insert to.
+* @param element - The element to insert.
+* @param priority - The priority of the element.
+* @return
+*   PQ_NULL_ARGUMENT if a NULL was sent.
+*   PQ_OUT_OF_MEMORY if an allocation failed, the caller still owns element.
+*   PQ_SUCCESS the element had been inserted successfully.
+*/
+PriorityQueueResult pqPushMove(PriorityQueue queue, PQElement element, PQElementPriority priority);
+
+/**
+* pqPopTake: Removes the highest priority element of the queue without
+* freeing it. The element and its priority are handed to the caller, who
+* becomes responsible for freeing them.
+*
+* @param queue - The priority queue to remove from.
+* @param element - Receives the element. If NULL the element is freed instead.
+* @param priority - Receives the priority. If NULL the priority is freed instead.
+* @return
+*   PQ_NULL_ARGUMENT if a NULL was sent as queue.
+*   PQ_ELEMENT_DOES_NOT_EXISTS if the queue is empty.
+*   PQ_SUCCESS the element had been removed successfully.
+*/
+PriorityQueueResult pqPopTake(PriorityQueue queue, PQElement* element, PQElementPriority* priority);
+
+/**
+* pqPeekTopK: Returns the k highest priority elements of the queue in the
+* order pqGetFirst and pqGetNext would return them, elements with the same
+* priority in insertion order. The elements and the priorities are not copied,
+* they belong to the queue and stay valid until it changes. Runs in O(k) and
+* does not move the iterator of the queue.
+*
+* @param queue - The priority queue to read.
+* @param k - The number of elements the arrays can hold.
+* @param elements - Array that receives the elements. May be NULL if k is 0.
+* @param priorities - Array that receives the priorities of the elements, or NULL.
+* @return
+*   -1 if a NULL was sent as queue or elements, or k is negative.
+*   Otherwise the number of elements returned, the smaller of k and the size of the queue.
+*/
+int pqPeekTopK(PriorityQueue queue, int k, PQElement* elements, PQElementPriority* priorities);
+
+/**
+* Instrumentation counters of a queue. The counters are only maintained when
+* priority_queue.c is compiled with ENABLE_STATS defined, otherwise enabled
+* is false and all the counters are 0.
+*/
+typedef struct PQStats_t {
+    bool enabled;
+    long inserts;
+    long insert_comparisons;
+    long comparisons;
+    long lookups;
+    long nodes_scanned;
+    long element_copies;
+    long priority_copies;
+    long allocations;
+    long frees;
+    long bytes_live;
+} PQStats;
+
+/**
+* pqGetStats: Copies the instrumentation counters of a queue.
+*
+* @param queue - The queue whose counters are requested.
+* @param stats - Receives the counters.
+* @return
+*   PQ_NULL_ARGUMENT if a NULL was sent.
+*   PQ_SUCCESS otherwise.
+*/
+PriorityQueueResult pqGetStats(PriorityQueue queue, PQStats* stats);
+
+/**
+* pqPrintStats: Writes the instrumentation counters of a queue as
+* "name value" lines.
+*
+* @param queue - The queue whose counters are printed.
+* @param stream - The stream to write to.
+* @return
+*   PQ_NULL_ARGUMENT if a NULL was sent.
+*   PQ_SUCCESS otherwise.
+*/
+PriorityQueueResult pqPrintStats(PriorityQueue queue, FILE* stream);
+
+/**
+* pqWriteStats: Writes queue counters that were already collected, e.g. by
+* pqGetStats or by a typed queue, in the same format as pqPrintStats.
+*
+* @param stats - The counters to print.
+* @param stream - The stream to write to.
+* @return
+*   PQ_NULL_ARGUMENT if a NULL was sent.
+*   PQ_SUCCESS otherwise.
+*/
+PriorityQueueResult pqWriteStats(const PQStats* stats, FILE* stream);
+
+#endif /* PRIORITY_QUEUE_EXT_H_ */
@@ -0,0 +1,358 @@
+#define _POSIX_C_SOURCE 200112L
+#include "schedule_file.h"
+#include "export_writer.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#define HEADER_WORDS 6
+#define COLUMNS_NUM 11
+#define ALIGNMENT 4
+#define VECTORS_NUM (1+3*COLUMNS_NUM)
+#define INITIAL_CAPACITY 65536
+#define EXPAND_FACTOR 2
+#define WORD_SIZE ((uint64_t)sizeof(uint32_t))
+
+struct ScheduleFile_t{
+    ScheduleColumns columns;
+    void* data;
+    size_t size;
+    bool mapped;
+};
+
+/**
+* Section: the data of a column and its length in bytes.
+*/
+typedef struct section{
+    const void* data;
+    uint64_t length;
+}Section;
+
+/**
+* get_sections: lists the columns in file order with their lengths in bytes.
+*
+* @param columns - the columns.
+* @param sections - receives COLUMNS_NUM sections.
+*/
+static void get_sections(const ScheduleColumns* columns,Section* sections)
+{
+    uint64_t events=columns->events_num*WORD_SIZE;
+    uint64_t members=columns->members_num*WORD_SIZE;
+    sections[0]=(Section){columns->strings,columns->strings_size};
+    sections[1]=(Section){columns->event_ids,events};
+    sections[2]=(Section){columns->event_names,events};
+    sections[3]=(Section){columns->event_days,events};
+    sections[4]=(Section){columns->event_months,events};
+    sections[5]=(Section){columns->event_years,events};
+    sections[6]=(Section){columns->member_ids,members};
+    sections[7]=(Section){columns->member_names,members};
+    sections[8]=(Section){columns->member_counters,members};
+    sections[9]=(Section){columns->event_link_offsets,events+WORD_SIZE};
+    sections[10]=(Section){columns->member_links,columns->links_num*WORD_SIZE};
+}
+
+/**
+* padding_of: returns the number of zero bytes that follow a section.
+*/
+static uint64_t padding_of(uint64_t length)
+{
+    return (ALIGNMENT-length%ALIGNMENT)%ALIGNMENT;
+}
+
+ScheduleFileResult scheduleFileWrite(int fd, const ScheduleColumns* columns)
+{
+    static const char padding[ALIGNMENT];
+    if(columns==NULL)
+    {
+        return SF_NULL_ARGUMENT;
+    }
+    uint32_t header[HEADER_WORDS]={SCHEDULE_FILE_MAGIC,SCHEDULE_FILE_VERSION,columns->events_num,
+                                   columns->members_num,columns->links_num,columns->strings_size};
+    Section sections[COLUMNS_NUM];
+    get_sections(columns,sections);
+    uint32_t lengths[COLUMNS_NUM];
+    struct iovec vectors[VECTORS_NUM];
+    int count=0;
+    vectors[count++]=(struct iovec){header,sizeof(header)};
+    for(int i=0;i<COLUMNS_NUM;i++){
+        if(sections[i].length>UINT32_MAX)
+        {
+            return SF_BAD_FORMAT;
+        }
+        lengths[i]=(uint32_t)sections[i].length;
+        vectors[count++]=(struct iovec){&lengths[i],sizeof(lengths[i])};
+        if(lengths[i]>0)
+        {
+            vectors[count++]=(struct iovec){(void*)sections[i].data,lengths[i]};
+        }
+        if(padding_of(lengths[i])>0)
+        {
+            vectors[count++]=(struct iovec){(void*)padding,padding_of(lengths[i])};
+        }
+    }
+    return exportWriteVectors(fd,vectors,count)==EXPORT_SUCCESS ? SF_SUCCESS : SF_IO_ERROR;
+}
+
+/**
+* check_columns: checks that the names and the links of columns stay inside
+* the string table and the member columns.
+*
+* @param columns - the columns to check.
+* @return
+* FALSE - if a name or a link is out of range.
+* otherwise TRUE.
+*/
+static bool check_columns(const ScheduleColumns* columns)
+{
+    if(columns->strings_size>0&&columns->strings[columns->strings_size-1]!='\0')
+    {
+        return false;
+    }
+    for(uint32_t i=0;i<columns->events_num;i++){
+        if(columns->event_names[i]>=columns->strings_size||
+           columns->event_link_offsets[i]>columns->event_link_offsets[i+1])
+        {
+            return false;
+        }
+    }
+    for(uint32_t i=0;i<columns->members_num;i++){
+        if(columns->member_names[i]>=columns->strings_size)
+        {
+            return false;
+        }
+    }
+    for(uint32_t i=0;i<columns->links_num;i++){
+        if(columns->member_links[i]>=columns->members_num)
+        {
+            return false;
+        }
+    }
+    return columns->event_link_offsets[0]==0&&
+           columns->event_link_offsets[columns->events_num]==columns->links_num;
+}
+
+/**
+* load_columns: points the columns of a file into its data, checking the
+* header, the lengths of the sections and the ranges of the columns.
+*
+* @param file - the file whose data was read or mapped.
+* @return
+* SF_BAD_FORMAT - if the data is not a valid schedule file.
+* otherwise SF_SUCCESS.
+*/
+static ScheduleFileResult load_columns(ScheduleFile file)
+{
+    const unsigned char* data=file->data;
+    uint32_t header[HEADER_WORDS];
+    if(file->size<sizeof(header))
+    {
+        return SF_BAD_FORMAT;
+    }
+    memcpy(header,data,sizeof(header));
+    if(header[0]!=SCHEDULE_FILE_MAGIC||header[1]!=SCHEDULE_FILE_VERSION)
+    {
+        return SF_BAD_FORMAT;
+    }
+    ScheduleColumns* columns=&file->columns;
+    memset(columns,0,sizeof(*columns));
+    columns->events_num=header[2];
+    columns->members_num=header[3];
+    columns->links_num=header[4];
+    columns->strings_size=header[5];
+    Section sections[COLUMNS_NUM];
+    get_sections(columns,sections);
+    const unsigned char* starts[COLUMNS_NUM];
+    uint64_t position=sizeof(header);
+    for(int i=0;i<COLUMNS_NUM;i++){
+        uint32_t length=0;
+        if(file->size-position<sizeof(length))
+        {
+            return SF_BAD_FORMAT;
+        }
+        memcpy(&length,data+position,sizeof(length));
+        position+=sizeof(length);
+        if(length!=sections[i].length||file->size-position<length+padding_of(length))
+        {
+            return SF_BAD_FORMAT;
+        }
+        starts[i]=data+position;
+        position+=length+padding_of(length);
+    }
+    columns->strings=(const char*)starts[0];
+    columns->event_ids=(const int32_t*)starts[1];
+    columns->event_names=(const uint32_t*)starts[2];
+    columns->event_days=(const int32_t*)starts[3];
+    columns->event_months=(const int32_t*)starts[4];
+    columns->event_years=(const int32_t*)starts[5];
+    columns->member_ids=(const int32_t*)starts[6];
+    columns->member_names=(const uint32_t*)starts[7];
+    columns->member_counters=(const int32_t*)starts[8];
+    columns->event_link_offsets=(const uint32_t*)starts[9];
+    columns->member_links=(const uint32_t*)starts[10];
+    return check_columns(columns) ? SF_SUCCESS : SF_BAD_FORMAT;
+}
+
+/**
+* read_all: reads a file descriptor to its end into a buffer.
+*
+* @param fd - the file descriptor to read.
+* @param file - the file that receives the buffer and its size.
+* @return
+* SF_IO_ERROR - if reading fails.
+* SF_OUT_OF_MEMORY - if allocation fails.
+* otherwise SF_SUCCESS.
+*/
+static ScheduleFileResult read_all(int fd,ScheduleFile file)
+{
+    size_t capacity=0;
+    while(true){
+        if(file->size==capacity)
+        {
+            capacity= capacity==0 ? INITIAL_CAPACITY : capacity*EXPAND_FACTOR;
+            void* data=realloc(file->data,capacity);
+            if(data==NULL)
+            {
+                return SF_OUT_OF_MEMORY;
+            }
+            file->data=data;
+        }
+        ssize_t bytes=read(fd,(char*)file->data+file->size,capacity-file->size);
+        if(bytes<0&&errno!=EINTR)
+        {
+            return SF_IO_ERROR;
+        }
+        if(bytes==0)
+        {
+            return SF_SUCCESS;
+        }
+        if(bytes>0)
+        {
+            file->size+=(size_t)bytes;
+        }
+    }
+}
+
+/**
+* create_file: allocates an empty loaded file.
+*/
+static ScheduleFile create_file(void)
+{
+    ScheduleFile file=malloc(sizeof(*file));
+    if(file==NULL)
+    {
+        return NULL;
+    }
+    memset(&file->columns,0,sizeof(file->columns));
+    file->data=NULL;
+    file->size=0;
+    file->mapped=false;
+    return file;
+}
+
+ScheduleFileResult scheduleFileRead(int fd, ScheduleFile* file)
+{
+    if(file==NULL)
+    {
+        return SF_NULL_ARGUMENT;
+    }
+    *file=NULL;
+    ScheduleFile loaded=create_file();
+    if(loaded==NULL)
+    {
+        return SF_OUT_OF_MEMORY;
+    }
+    ScheduleFileResult result=read_all(fd,loaded);
+    if(result==SF_SUCCESS)
+    {
+        result=load_columns(loaded);
+    }
+    if(result!=SF_SUCCESS)
+    {
+        scheduleFileDestroy(loaded);
+        return result;
+    }
+    *file=loaded;
+    return SF_SUCCESS;
+}
+
+ScheduleFileResult scheduleFileMap(const char* path, ScheduleFile* file)
+{
+    if(path==NULL||file==NULL)
+    {
+        return SF_NULL_ARGUMENT;
+    }
+    *file=NULL;
+    int fd=open(path,O_RDONLY);
+    if(fd<0)
+    {
+        return SF_IO_ERROR;
+    }
+    struct stat status;
+    if(fstat(fd,&status)!=0)
+    {
+        close(fd);
+        return SF_IO_ERROR;
+    }
+    if(status.st_size<(off_t)(sizeof(uint32_t)*HEADER_WORDS))
+    {
+        close(fd);
+        return SF_BAD_FORMAT;
+    }
+    ScheduleFile loaded=create_file();
+    if(loaded==NULL)
+    {
+        close(fd);
+        return SF_OUT_OF_MEMORY;
+    }
+    void* data=mmap(NULL,(size_t)status.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(data==MAP_FAILED)
+    {
+        scheduleFileDestroy(loaded);
+        return SF_IO_ERROR;
+    }
+    loaded->data=data;
+    loaded->size=(size_t)status.st_size;
+    loaded->mapped=true;
+    ScheduleFileResult result=load_columns(loaded);
+    if(result!=SF_SUCCESS)
+    {
+        scheduleFileDestroy(loaded);
+        return result;
+    }
+    *file=loaded;
+    return SF_SUCCESS;
+}
+
+const ScheduleColumns* scheduleFileGetColumns(ScheduleFile file)
+{
+    if(file==NULL)
+    {
+        return NULL;
+    }
+    return &file->columns;
+}
+
+void scheduleFileDestroy(ScheduleFile file)
+{
+    if(file==NULL)
+    {
+        return;
+    }
+    if(file->mapped)
+    {
+        munmap(file->data,file->size);
+    }
+    else
+    {
+        free(file->data);
+    }
+    free(file);
+}
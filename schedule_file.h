@@ -0,0 +1,137 @@
+#ifndef SCHEDULE_FILE_H_
+#define SCHEDULE_FILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+* Schedule File
+*
+* A binary columnar format for the events and the members of a schedule, and
+* the functions writing and loading it. A loaded file is used in place: the
+* columns point into the file, so nothing is parsed or copied, and a file can
+* also be mapped into memory instead of read.
+*
+* The file is a header followed by length-prefixed sections:
+*   header      - uint32 magic "EMSB", format version, events_num,
+*                 members_num, links_num and strings_size.
+*   sections    - for every column, in the order of ScheduleColumns, a uint32
+*                 length in bytes, the column data, and zero padding up to a
+*                 multiple of 4 bytes.
+* All the numbers are in the byte order of the machine that wrote the file, a
+* file of the other byte order is rejected by its magic.
+*
+* The following functions are available:
+*   scheduleFileWrite       - Writes columns to a file descriptor.
+*   scheduleFileRead        - Loads a file by reading it into memory.
+*   scheduleFileMap         - Loads a file by mapping it into memory.
+*   scheduleFileGetColumns  - Returns the columns of a loaded file.
+*   scheduleFileDestroy     - Unloads a file.
+*/
+
+/** The magic number of a schedule file, "EMSB" */
+#define SCHEDULE_FILE_MAGIC 0x42534D45u
+
+/** The version of the format */
+#define SCHEDULE_FILE_VERSION 1u
+
+/** Type for defining a loaded file */
+typedef struct ScheduleFile_t *ScheduleFile;
+
+/** Type used for returning error codes from schedule file functions */
+typedef enum ScheduleFileResult_t {
+    SF_SUCCESS,
+    SF_OUT_OF_MEMORY,
+    SF_NULL_ARGUMENT,
+    SF_IO_ERROR,
+    SF_BAD_FORMAT
+} ScheduleFileResult;
+
+/**
+* The columns of a schedule. Event i has the id event_ids[i], the name that
+* starts at strings+event_names[i] and the date event_days[i].event_months[i].
+* event_years[i]. Its members are member_links[event_link_offsets[i]] to
+* member_links[event_link_offsets[i+1]-1], indices into the member columns.
+* Names are null-terminated strings in the string table.
+*/
+typedef struct ScheduleColumns_t {
+    uint32_t events_num;
+    uint32_t members_num;
+    uint32_t links_num;
+    uint32_t strings_size;
+    const char* strings;
+    const int32_t* event_ids;
+    const uint32_t* event_names;
+    const int32_t* event_days;
+    const int32_t* event_months;
+    const int32_t* event_years;
+    const int32_t* member_ids;
+    const uint32_t* member_names;
+    const int32_t* member_counters;
+    const uint32_t* event_link_offsets;
+    const uint32_t* member_links;
+} ScheduleColumns;
+
+/**
+* scheduleFileWrite: Writes columns to a file descriptor at its current
+* position. The descriptor is not closed.
+*
+* @param fd - The file descriptor to write to.
+* @param columns - The columns to write, event_link_offsets holds events_num+1 entries.
+* @return
+*   SF_NULL_ARGUMENT if columns is NULL.
+*   SF_IO_ERROR if writing failed.
+*   SF_OUT_OF_MEMORY if an allocation failed.
+*   SF_SUCCESS otherwise.
+*/
+ScheduleFileResult scheduleFileWrite(int fd, const ScheduleColumns* columns);
+
+/**
+* scheduleFileRead: Loads a file by reading a file descriptor from its
+* current position to its end. The descriptor is not closed.
+*
+* @param fd - The file descriptor to read.
+* @param file - Receives the loaded file, to be unloaded with scheduleFileDestroy.
+* @return
+*   SF_NULL_ARGUMENT if file is NULL.
+*   SF_IO_ERROR if reading failed.
+*   SF_BAD_FORMAT if the data is not a valid schedule file.
+*   SF_OUT_OF_MEMORY if an allocation failed.
+*   SF_SUCCESS otherwise.
+*/
+ScheduleFileResult scheduleFileRead(int fd, ScheduleFile* file);
+
+/**
+* scheduleFileMap: Loads a file by mapping it read only into memory. The
+* pages are read by the system when the columns are first used.
+*
+* @param path - The path of the file.
+* @param file - Receives the loaded file, to be unloaded with scheduleFileDestroy.
+* @return
+*   SF_NULL_ARGUMENT if path or file is NULL.
+*   SF_IO_ERROR if the file could not be opened or mapped.
+*   SF_BAD_FORMAT if the file is not a valid schedule file.
+*   SF_OUT_OF_MEMORY if an allocation failed.
+*   SF_SUCCESS otherwise.
+*/
+ScheduleFileResult scheduleFileMap(const char* path, ScheduleFile* file);
+
+/**
+* scheduleFileGetColumns: Returns the columns of a loaded file. The columns
+* are valid until the file is unloaded.
+*
+* @param file - The loaded file.
+* @return
+*   NULL if file is NULL.
+*   Otherwise the columns.
+*/
+const ScheduleColumns* scheduleFileGetColumns(ScheduleFile file);
+
+/**
+* scheduleFileDestroy: Unloads a file and frees or unmaps its memory.
+*
+* @param file - The file to unload. If file is NULL nothing will be done.
+*/
+void scheduleFileDestroy(ScheduleFile file);
+
+#endif /* SCHEDULE_FILE_H_ */
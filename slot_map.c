@@ -0,0 +1,323 @@
+#include "slot_map.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#define INITIAL_ENTRIES 32
+#define INITIAL_SLOTS 16
+#define EXPAND_FACTOR 2
+#define MAX_LOAD_PERCENT 50
+#define PERCENT 100
+#define EMPTY -1
+#define FREE_SLOT -1
+
+/**
+* Entry: an id and its slot in the hash table. An entry whose id is EMPTY is empty.
+*/
+typedef struct entry{
+    int id;
+    int slot;
+}Entry;
+
+struct SlotMap_t{
+    Entry* entries;
+    int entries_num;
+    int size;
+    int* ids;
+    int* free_slots;
+    int free_num;
+    int slots_num;
+    int capacity;
+    Allocator allocator;
+};
+
+/**
+* hash_id: maps an id to its home entry.
+*
+* @param entries_num - the number of entries, a power of 2.
+* @param id - the id.
+* @return
+* the home entry of the id.
+*/
+static int hash_id(int entries_num,int id)
+{
+    unsigned int hash=(unsigned int)id*2654435761u;
+    hash^=hash>>15;
+    return (int)(hash&(unsigned int)(entries_num-1));
+}
+
+/**
+* find_entry: looks for the entry of an id, or the empty entry where it would be put.
+*
+* @param entries - the entries to search in.
+* @param entries_num - the number of entries, a power of 2.
+* @param id - the id, not negative.
+* @return
+* the entry of the id, or the first empty entry on its probe sequence.
+*/
+static Entry* find_entry(Entry* entries,int entries_num,int id)
+{
+    int position=hash_id(entries_num,id);
+    while(entries[position].id!=EMPTY&&entries[position].id!=id){
+        position=(position+1)&(entries_num-1);
+    }
+    return &entries[position];
+}
+
+/**
+* create_entries: allocates empty entries.
+*
+* @param allocator - the allocator of the slot map.
+* @param entries_num - the number of entries.
+* @return
+* NULL - if allocation fails.
+* otherwise the entries.
+*/
+static Entry* create_entries(const Allocator* allocator,int entries_num)
+{
+    Entry* entries=allocatorAlloc(allocator,sizeof(*entries)*entries_num);
+    if(entries==NULL)
+    {
+        return NULL;
+    }
+    for(int i=0;i<entries_num;i++){
+        entries[i].id=EMPTY;
+    }
+    return entries;
+}
+
+/**
+* expand_entries: doubles the number of entries and rehashes all the ids.
+*
+* @param map - the slot map to expand.
+* @return
+* FALSE - if allocation fails.
+* otherwise TRUE.
+*/
+static bool expand_entries(SlotMap map)
+{
+    int entries_num=map->entries_num*EXPAND_FACTOR;
+    Entry* entries=create_entries(&map->allocator,entries_num);
+    if(entries==NULL)
+    {
+        return false;
+    }
+    for(int i=0;i<map->entries_num;i++){
+        if(map->entries[i].id!=EMPTY)
+        {
+            *find_entry(entries,entries_num,map->entries[i].id)=map->entries[i];
+        }
+    }
+    allocatorFree(&map->allocator,map->entries);
+    map->entries=entries;
+    map->entries_num=entries_num;
+    return true;
+}
+
+/**
+* expand_slots: grows the arrays indexed by slot.
+*
+* @param map - the slot map to expand.
+* @return
+* FALSE - if allocation fails, the arrays are unchanged.
+* otherwise TRUE.
+*/
+static bool expand_slots(SlotMap map)
+{
+    int capacity=map->capacity*EXPAND_FACTOR;
+    int* ids=allocatorAlloc(&map->allocator,sizeof(*ids)*capacity);
+    int* free_slots=allocatorAlloc(&map->allocator,sizeof(*free_slots)*capacity);
+    if(ids==NULL||free_slots==NULL)
+    {
+        allocatorFree(&map->allocator,ids);
+        allocatorFree(&map->allocator,free_slots);
+        return false;
+    }
+    memcpy(ids,map->ids,sizeof(*ids)*map->slots_num);
+    memcpy(free_slots,map->free_slots,sizeof(*free_slots)*map->free_num);
+    allocatorFree(&map->allocator,map->ids);
+    allocatorFree(&map->allocator,map->free_slots);
+    map->ids=ids;
+    map->free_slots=free_slots;
+    map->capacity=capacity;
+    return true;
+}
+
+/**
+* remove_entry: empties an entry and moves the ids that follow it on their
+* probe sequences back, so no probe sequence has a hole.
+*
+* @param map - the slot map to remove from.
+* @param position - the entry to empty.
+*/
+static void remove_entry(SlotMap map,int position)
+{
+    int mask=map->entries_num-1;
+    int next=(position+1)&mask;
+    while(map->entries[next].id!=EMPTY){
+        int home=hash_id(map->entries_num,map->entries[next].id);
+        if(((next-home)&mask)>=((next-position)&mask))
+        {
+            map->entries[position]=map->entries[next];
+            position=next;
+        }
+        next=(next+1)&mask;
+    }
+    map->entries[position].id=EMPTY;
+}
+
+SlotMap slotMapCreate(void)
+{
+    return slotMapCreateWithAllocator(NULL);
+}
+
+SlotMap slotMapCreateWithAllocator(const Allocator* allocator)
+{
+    SlotMap map=allocatorAlloc(allocator,sizeof(*map));
+    if(map==NULL)
+    {
+        return NULL;
+    }
+    if(allocator!=NULL)
+    {
+        map->allocator=*allocator;
+    }
+    else
+    {
+        memset(&map->allocator,0,sizeof(map->allocator));
+    }
+    map->entries=create_entries(allocator,INITIAL_ENTRIES);
+    map->ids=allocatorAlloc(allocator,sizeof(*map->ids)*INITIAL_SLOTS);
+    map->free_slots=allocatorAlloc(allocator,sizeof(*map->free_slots)*INITIAL_SLOTS);
+    map->entries_num=INITIAL_ENTRIES;
+    map->size=0;
+    map->free_num=0;
+    map->slots_num=0;
+    map->capacity=INITIAL_SLOTS;
+    if(map->entries==NULL||map->ids==NULL||map->free_slots==NULL)
+    {
+        slotMapDestroy(map);
+        return NULL;
+    }
+    return map;
+}
+
+void slotMapDestroy(SlotMap map)
+{
+    if(map==NULL)
+    {
+        return;
+    }
+    allocatorFree(&map->allocator,map->entries);
+    allocatorFree(&map->allocator,map->ids);
+    allocatorFree(&map->allocator,map->free_slots);
+    Allocator allocator=map->allocator;
+    allocatorFree(&allocator,map);
+}
+
+SlotMapResult slotMapInsert(SlotMap map, int id, int* slot)
+{
+    if(map==NULL)
+    {
+        return SM_NULL_ARGUMENT;
+    }
+    if(id<0)
+    {
+        return SM_INVALID_ID;
+    }
+    Entry* entry=find_entry(map->entries,map->entries_num,id);
+    if(entry->id!=EMPTY)
+    {
+        return SM_ID_ALREADY_EXISTS;
+    }
+    if(map->free_num==0&&map->slots_num==map->capacity&&!expand_slots(map))
+    {
+        return SM_OUT_OF_MEMORY;
+    }
+    if((map->size+1)*PERCENT>map->entries_num*MAX_LOAD_PERCENT)
+    {
+        if(!expand_entries(map))
+        {
+            return SM_OUT_OF_MEMORY;
+        }
+        entry=find_entry(map->entries,map->entries_num,id);
+    }
+    int new_slot;
+    if(map->free_num>0)
+    {
+        new_slot=map->free_slots[--map->free_num];
+    }
+    else
+    {
+        new_slot=map->slots_num++;
+    }
+    entry->id=id;
+    entry->slot=new_slot;
+    map->ids[new_slot]=id;
+    map->size++;
+    if(slot!=NULL)
+    {
+        *slot=new_slot;
+    }
+    return SM_SUCCESS;
+}
+
+SlotMapResult slotMapRemove(SlotMap map, int id)
+{
+    if(map==NULL)
+    {
+        return SM_NULL_ARGUMENT;
+    }
+    if(id<0)
+    {
+        return SM_ID_NOT_EXISTS;
+    }
+    Entry* entry=find_entry(map->entries,map->entries_num,id);
+    if(entry->id==EMPTY)
+    {
+        return SM_ID_NOT_EXISTS;
+    }
+    int slot=entry->slot;
+    remove_entry(map,(int)(entry-map->entries));
+    map->ids[slot]=FREE_SLOT;
+    map->free_slots[map->free_num++]=slot;
+    map->size--;
+    return SM_SUCCESS;
+}
+
+int slotMapFind(SlotMap map, int id)
+{
+    if(map==NULL||id<0)
+    {
+        return -1;
+    }
+    Entry* entry=find_entry(map->entries,map->entries_num,id);
+    return entry->id==EMPTY ? -1 : entry->slot;
+}
+
+int slotMapGetId(SlotMap map, int slot)
+{
+    if(map==NULL||slot<0||slot>=map->slots_num)
+    {
+        return -1;
+    }
+    return map->ids[slot];
+}
+
+int slotMapGetSlots(SlotMap map)
+{
+    if(map==NULL)
+    {
+        return -1;
+    }
+    return map->slots_num;
+}
+
+long slotMapGetMemoryUsage(SlotMap map)
+{
+    if(map==NULL)
+    {
+        return 0;
+    }
+    return (long)(sizeof(*map)+sizeof(*map->entries)*map->entries_num+
+                  (sizeof(*map->ids)+sizeof(*map->free_slots))*map->capacity);
+}
@@ -0,0 +1,143 @@
+#ifndef SLOT_MAP_H_
+#define SLOT_MAP_H_
+
+#include "allocator.h"
+
+/**
+* Slot Map
+*
+* Assigns every id, an arbitrary non-negative int, a dense slot: the slots of
+* n ids are taken from 0..n-1, and a slot freed by a removed id is given to
+* the next id that is inserted. Arrays indexed by slot therefore grow with the
+* number of live ids and not with the largest id. The ids are found in an open
+* addressing hash table, so inserting, removing and finding an id take O(1) on
+* average. The slot map and its arrays may be allocated through an Allocator.
+*
+* A slot identifies its id only until the id is removed, after which the slot
+* may be given to another id. Callers drop the slot together with the id.
+*
+* The following functions are available:
+*   slotMapCreate           - Creates a new empty slot map.
+*   slotMapCreateWithAllocator - Creates a new empty slot map whose memory is allocated by an allocator.
+*   slotMapDestroy          - Deletes an existing slot map and frees all its resources.
+*   slotMapInsert           - Assigns a slot to an id.
+*   slotMapRemove           - Frees the slot of an id.
+*   slotMapFind             - Returns the slot of an id.
+*   slotMapGetId            - Returns the id in a slot.
+*   slotMapGetSlots         - Returns the number of slots ever given.
+*   slotMapGetMemoryUsage   - Returns the number of bytes the slot map takes.
+*/
+
+/** Type for defining the slot map */
+typedef struct SlotMap_t *SlotMap;
+
+/** Type used for returning error codes from slot map functions */
+typedef enum SlotMapResult_t {
+    SM_SUCCESS,
+    SM_OUT_OF_MEMORY,
+    SM_NULL_ARGUMENT,
+    SM_INVALID_ID,
+    SM_ID_ALREADY_EXISTS,
+    SM_ID_NOT_EXISTS
+} SlotMapResult;
+
+/**
+* slotMapCreate: Allocates a new empty slot map.
+*
+* @return
+*   NULL - if allocation failed.
+*   A new slot map in case of success.
+*/
+SlotMap slotMapCreate(void);
+
+/**
+* slotMapCreateWithAllocator: Allocates a new empty slot map whose structure
+* and arrays are allocated and freed through allocator.
+*
+* @param allocator - The allocator, copied into the slot map. NULL for malloc.
+* @return
+*   NULL - if allocation failed.
+*   A new slot map in case of success.
+*/
+SlotMap slotMapCreateWithAllocator(const Allocator* allocator);
+
+/**
+* slotMapDestroy: Deallocates an existing slot map.
+*
+* @param map - Target slot map to be deallocated. If map is NULL nothing will be done.
+*/
+void slotMapDestroy(SlotMap map);
+
+/**
+* slotMapInsert: Assigns a slot to an id, the slot freed last if there is one
+* and otherwise the first slot that was never given.
+*
+* @param map - The slot map to insert to.
+* @param id - The id, not negative.
+* @param slot - Receives the slot of the id. May be NULL.
+* @return
+*   SM_NULL_ARGUMENT if a NULL was sent as map.
+*   SM_INVALID_ID if id is negative.
+*   SM_ID_ALREADY_EXISTS if the id already has a slot.
+*   SM_OUT_OF_MEMORY if an allocation failed, the slot map is unchanged.
+*   SM_SUCCESS otherwise.
+*/
+SlotMapResult slotMapInsert(SlotMap map, int id, int* slot);
+
+/**
+* slotMapRemove: Frees the slot of an id.
+*
+* @param map - The slot map to remove from.
+* @param id - The id.
+* @return
+*   SM_NULL_ARGUMENT if a NULL was sent as map.
+*   SM_ID_NOT_EXISTS if the id has no slot.
+*   SM_SUCCESS otherwise.
+*/
+SlotMapResult slotMapRemove(SlotMap map, int id);
+
+/**
+* slotMapFind: Returns the slot of an id.
+*
+* @param map - The slot map to search in.
+* @param id - The id.
+* @return
+*   -1 if a NULL was sent as map or the id has no slot.
+*   Otherwise the slot of the id.
+*/
+int slotMapFind(SlotMap map, int id);
+
+/**
+* slotMapGetId: Returns the id a slot is assigned to.
+*
+* @param map - The slot map to search in.
+* @param slot - The slot.
+* @return
+*   -1 if a NULL was sent as map, or the slot is out of range or free.
+*   Otherwise the id in the slot.
+*/
+int slotMapGetId(SlotMap map, int slot);
+
+/**
+* slotMapGetSlots: Returns the number of slots ever given, which is the
+* largest number of ids the slot map held at once. Every slot given is smaller.
+*
+* @param map - The slot map whose slots are counted.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the number of slots.
+*/
+int slotMapGetSlots(SlotMap map);
+
+/**
+* slotMapGetMemoryUsage: Returns the number of bytes allocated for a slot map,
+* its hash table and its arrays indexed by slot. Runs in O(1).
+*
+* @param map - The slot map to measure.
+* @return
+*   0 if a NULL pointer was sent.
+*   Otherwise the number of bytes.
+*/
+long slotMapGetMemoryUsage(SlotMap map);
+
+#endif /* SLOT_MAP_H_ */
@@ -0,0 +1,139 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../booking_index.h"
+#include "test_utilities.h"
+
+#define MEMBERS 200
+#define DATES 25
+#define STEPS 200000
+
+/**
+* next_random: a xorshift generator, so every run checks the same steps.
+*/
+static unsigned int next_random(unsigned int* seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+bool testBookingIndexAddRemove() {
+    bool result = true;
+    BookingIndex index = bookingIndexCreate();
+    ASSERT_TEST(index != NULL, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(NULL, 1, 20210101) == -1, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexAdd(NULL, 1, 20210101) == BI_NULL_ARGUMENT, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexRemove(NULL, 1, 20210101) == BI_NULL_ARGUMENT, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 1, 20210101) == 0, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexRemove(index, 1, 20210101) == BI_NOT_BOOKED, destroyBookingIndexAddRemove);
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TEST(bookingIndexAdd(index, 1, 20210101) == BI_SUCCESS, destroyBookingIndexAddRemove);
+    }
+    ASSERT_TEST(bookingIndexAdd(index, 1, 20210102) == BI_SUCCESS, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexAdd(index, 2, 20210101) == BI_SUCCESS, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 1, 20210101) == 3, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 1, 20210102) == 1, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 2, 20210101) == 1, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 2, 20210102) == 0, destroyBookingIndexAddRemove);
+    // a pair is booked until its count drops to 0
+    ASSERT_TEST(bookingIndexRemove(index, 1, 20210101) == BI_SUCCESS, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexRemove(index, 1, 20210101) == BI_SUCCESS, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 1, 20210101) == 1, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexRemove(index, 1, 20210101) == BI_SUCCESS, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 1, 20210101) == 0, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexRemove(index, 1, 20210101) == BI_NOT_BOOKED, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 1, 20210102) == 1, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 2, 20210101) == 1, destroyBookingIndexAddRemove);
+    // a removed pair can be booked again
+    ASSERT_TEST(bookingIndexAdd(index, 1, 20210101) == BI_SUCCESS, destroyBookingIndexAddRemove);
+    ASSERT_TEST(bookingIndexGetCount(index, 1, 20210101) == 1, destroyBookingIndexAddRemove);
+
+destroyBookingIndexAddRemove:
+    bookingIndexDestroy(index);
+    return result;
+}
+
+bool testBookingIndexBackwardShift() {
+    bool result = true;
+    BookingIndex index = bookingIndexCreate();
+    int* counts = calloc(MEMBERS * DATES, sizeof(*counts));
+    unsigned int seed = 88172645u;
+    ASSERT_TEST(index != NULL && counts != NULL, destroyBookingIndexBackwardShift);
+    long initial_usage = bookingIndexGetMemoryUsage(index);
+    // random adds and removes keep long probe sequences in the table, and every
+    // pair whose count drops to 0 shifts the pairs after it back
+    for (int step = 0; step < STEPS; step++) {
+        int member = (int)(next_random(&seed) % MEMBERS);
+        int date = (int)(next_random(&seed) % DATES);
+        int* count = &counts[member * DATES + date];
+        if (*count > 0 && next_random(&seed) % 2 == 0) {
+            ASSERT_TEST(bookingIndexRemove(index, member, 20210101 + date) == BI_SUCCESS,
+                        destroyBookingIndexBackwardShift);
+            (*count)--;
+        } else if (*count == 0 || next_random(&seed) % 4 == 0) {
+            ASSERT_TEST(bookingIndexAdd(index, member, 20210101 + date) == BI_SUCCESS,
+                        destroyBookingIndexBackwardShift);
+            (*count)++;
+        }
+        if (step % 1000 == 0) {
+            for (int i = 0; i < MEMBERS * DATES; i++) {
+                ASSERT_TEST(bookingIndexGetCount(index, i / DATES, 20210101 + i % DATES) == counts[i],
+                            destroyBookingIndexBackwardShift);
+            }
+        }
+    }
+    ASSERT_TEST(bookingIndexGetMemoryUsage(index) > initial_usage, destroyBookingIndexBackwardShift);
+    // emptying the index leaves no pair behind
+    for (int i = 0; i < MEMBERS * DATES; i++) {
+        for (; counts[i] > 0; counts[i]--) {
+            ASSERT_TEST(bookingIndexRemove(index, i / DATES, 20210101 + i % DATES) == BI_SUCCESS,
+                        destroyBookingIndexBackwardShift);
+        }
+        ASSERT_TEST(bookingIndexRemove(index, i / DATES, 20210101 + i % DATES) == BI_NOT_BOOKED,
+                    destroyBookingIndexBackwardShift);
+    }
+    for (int i = 0; i < MEMBERS * DATES; i++) {
+        ASSERT_TEST(bookingIndexGetCount(index, i / DATES, 20210101 + i % DATES) == 0,
+                    destroyBookingIndexBackwardShift);
+    }
+
+destroyBookingIndexBackwardShift:
+    bookingIndexDestroy(index);
+    free(counts);
+    return result;
+}
+
+#define NUMBER_TESTS 2
+
+bool (*tests[]) (void) = {
+        testBookingIndexAddRemove,
+        testBookingIndexBackwardShift
+};
+
+const char* testNames[] = {
+        "testBookingIndexAddRemove",
+        "testBookingIndexBackwardShift"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: booking_index_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "../event_index.h"
+#include "test_utilities.h"
+
+#define DATES 50
+#define PER_DATE 4
+#define MAX_VISITS 256
+
+/**
+* Visits: the keys an iteration visited, and how many entries to visit before stopping.
+*/
+typedef struct visits {
+    int date_keys[MAX_VISITS];
+    int orders[MAX_VISITS];
+    int count;
+    int limit;
+} Visits;
+
+static bool record_visit(int date_key, int order, void* data, void* ctx)
+{
+    Visits* visits = ctx;
+    (void)data;
+    visits->date_keys[visits->count] = date_key;
+    visits->orders[visits->count] = order;
+    visits->count++;
+    return visits->count < visits->limit;
+}
+
+/**
+* visit_range: visits the entries of a range, up to limit of them.
+*/
+static EventIndexResult visit_range(EventIndex index, int from_key, int to_key, int limit, Visits* visits)
+{
+    visits->count = 0;
+    visits->limit = limit;
+    return eventIndexForEachRange(index, from_key, to_key, record_visit, visits);
+}
+
+/**
+* fill_index: inserts PER_DATE entries on every even date in [0, 2 * DATES),
+* newest order first, so the index has to sort them.
+*/
+static bool fill_index(EventIndex index)
+{
+    for (int order = PER_DATE * DATES - 1; order >= 0; order--) {
+        if (eventIndexInsert(index, (order / PER_DATE) * 2, order, NULL) != EI_SUCCESS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool testEventIndexInsertRemove() {
+    bool result = true;
+    EventIndex index = eventIndexCreate();
+    int data = 7;
+    Visits visits;
+    ASSERT_TEST(index != NULL, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexGetSize(index) == 0, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexInsert(NULL, 1, 1, NULL) == EI_NULL_ARGUMENT, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexRemove(NULL, 1, 1) == EI_NULL_ARGUMENT, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexCountRange(NULL, 0, 1) == -1, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexForEachRange(NULL, 0, 1, record_visit, &visits) == EI_NULL_ARGUMENT,
+                destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexForEachRange(index, 0, 1, NULL, &visits) == EI_NULL_ARGUMENT,
+                destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexInsert(index, 10, 1, &data) == EI_SUCCESS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexInsert(index, 10, 1, NULL) == EI_KEY_ALREADY_EXISTS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexInsert(index, 10, 2, NULL) == EI_SUCCESS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexInsert(index, 11, 1, NULL) == EI_SUCCESS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexGetSize(index) == 3, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexRemove(index, 10, 3) == EI_KEY_NOT_EXISTS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexRemove(index, 12, 1) == EI_KEY_NOT_EXISTS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexRemove(index, 10, 2) == EI_SUCCESS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexRemove(index, 10, 2) == EI_KEY_NOT_EXISTS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexGetSize(index) == 2, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexCountRange(index, 10, 10) == 1, destroyEventIndexInsertRemove);
+    ASSERT_TEST(visit_range(index, 10, 10, MAX_VISITS, &visits) == EI_SUCCESS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(visits.count == 1 && visits.orders[0] == 1, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexRemove(index, 10, 1) == EI_SUCCESS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexRemove(index, 11, 1) == EI_SUCCESS, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexGetSize(index) == 0, destroyEventIndexInsertRemove);
+    ASSERT_TEST(eventIndexCountRange(index, INT_MIN, INT_MAX) == 0, destroyEventIndexInsertRemove);
+
+destroyEventIndexInsertRemove:
+    eventIndexDestroy(index);
+    return result;
+}
+
+bool testEventIndexRangeEdges() {
+    bool result = true;
+    EventIndex index = eventIndexCreate();
+    Visits visits;
+    ASSERT_TEST(index != NULL && fill_index(index), destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexGetSize(index) == PER_DATE * DATES, destroyEventIndexRangeEdges);
+    // both ends of a range are included
+    ASSERT_TEST(eventIndexCountRange(index, 0, 0) == PER_DATE, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, 4, 8) == 3 * PER_DATE, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, 3, 9) == 3 * PER_DATE, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, 5, 7) == PER_DATE, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, 2 * DATES - 2, 2 * DATES - 2) == PER_DATE, destroyEventIndexRangeEdges);
+    // ranges with no entries in them
+    ASSERT_TEST(eventIndexCountRange(index, 5, 5) == 0, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, 8, 4) == 0, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, INT_MIN, -1) == 0, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, 2 * DATES - 1, INT_MAX) == 0, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visit_range(index, 5, 5, MAX_VISITS, &visits) == EI_SUCCESS && visits.count == 0,
+                destroyEventIndexRangeEdges);
+    ASSERT_TEST(visit_range(index, 8, 4, MAX_VISITS, &visits) == EI_SUCCESS && visits.count == 0,
+                destroyEventIndexRangeEdges);
+    ASSERT_TEST(visit_range(index, 2 * DATES - 1, INT_MAX, MAX_VISITS, &visits) == EI_SUCCESS && visits.count == 0,
+                destroyEventIndexRangeEdges);
+    // open ended ranges
+    ASSERT_TEST(eventIndexCountRange(index, INT_MIN, INT_MAX) == PER_DATE * DATES, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, 10, INT_MAX) == PER_DATE * (DATES - 5), destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, INT_MIN, 9) == PER_DATE * 5, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visit_range(index, INT_MIN, INT_MAX, MAX_VISITS, &visits) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.count == PER_DATE * DATES, destroyEventIndexRangeEdges);
+    // entries are visited by date, and entries on the same date by their order
+    for (int i = 0; i < visits.count; i++) {
+        ASSERT_TEST(visits.orders[i] == i, destroyEventIndexRangeEdges);
+        ASSERT_TEST(visits.date_keys[i] == (i / PER_DATE) * 2, destroyEventIndexRangeEdges);
+    }
+    ASSERT_TEST(visit_range(index, 3, 9, MAX_VISITS, &visits) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.count == 3 * PER_DATE, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.date_keys[0] == 4 && visits.orders[0] == 2 * PER_DATE, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.date_keys[visits.count - 1] == 8, destroyEventIndexRangeEdges);
+    // a visitor returning false stops the iteration
+    ASSERT_TEST(visit_range(index, 0, INT_MAX, PER_DATE + 1, &visits) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.count == PER_DATE + 1, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.date_keys[PER_DATE] == 2, destroyEventIndexRangeEdges);
+    // dates at the ends of int
+    ASSERT_TEST(eventIndexInsert(index, INT_MIN, 0, NULL) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexInsert(index, INT_MAX, 0, NULL) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, INT_MIN, INT_MIN) == 1, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, INT_MAX, INT_MAX) == 1, destroyEventIndexRangeEdges);
+    ASSERT_TEST(eventIndexCountRange(index, INT_MIN, INT_MAX) == PER_DATE * DATES + 2, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visit_range(index, INT_MAX, INT_MAX, MAX_VISITS, &visits) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.count == 1 && visits.date_keys[0] == INT_MAX, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visit_range(index, INT_MIN, -1, MAX_VISITS, &visits) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.count == 1 && visits.date_keys[0] == INT_MIN, destroyEventIndexRangeEdges);
+    // removing the entries at the edge of a range moves the edge
+    for (int order = 0; order < PER_DATE; order++) {
+        ASSERT_TEST(eventIndexRemove(index, 4, 2 * PER_DATE + order) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    }
+    ASSERT_TEST(eventIndexCountRange(index, 3, 9) == 2 * PER_DATE, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visit_range(index, 3, 9, MAX_VISITS, &visits) == EI_SUCCESS, destroyEventIndexRangeEdges);
+    ASSERT_TEST(visits.count == 2 * PER_DATE && visits.date_keys[0] == 6, destroyEventIndexRangeEdges);
+
+destroyEventIndexRangeEdges:
+    eventIndexDestroy(index);
+    return result;
+}
+
+#define NUMBER_TESTS 2
+
+bool (*tests[]) (void) = {
+        testEventIndexInsertRemove,
+        testEventIndexRangeEdges
+};
+
+const char* testNames[] = {
+        "testEventIndexInsertRemove",
+        "testEventIndexRangeEdges"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: event_index_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
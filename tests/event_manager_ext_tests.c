@@ -0,0 +1,802 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../event_manager_ext.h"
+#include "test_utilities.h"
+
+#define EVENTS_FILE "event_manager_ext_tests_events.txt"
+#define MEMBERS_FILE "event_manager_ext_tests_members.txt"
+#define DELTA_FILE "event_manager_ext_tests_delta.txt"
+#define MAX_FILE_SIZE 4096
+#define MAX_EVENTS 16
+#define MAX_NAME_SIZE 16
+#define RELINK_ROUNDS 100
+// the number of changes the change log holds before it first grows
+#define CHANGE_LOG_CAPACITY 64
+// the number of lines in every chunk of a printed file
+#define EXPORT_CHUNK_LINES 4096
+#define MANY_EVENTS (3 * EXPORT_CHUNK_LINES + 5)
+#define MANY_MEMBERS (EXPORT_CHUNK_LINES + 10)
+#define MANY_DATES 400
+#define MANY_WORKERS 4
+
+static bool fail_allocations = false;
+static int allocations_left = -1;
+
+/**
+* failing_alloc: allocates with malloc unless fail_allocations is set or the
+* allocations_left allocations allowed, if not negative, were made.
+*/
+static void* failing_alloc(size_t size, void* ctx)
+{
+    (void)ctx;
+    if (fail_allocations || allocations_left == 0) {
+        return NULL;
+    }
+    if (allocations_left > 0) {
+        allocations_left--;
+    }
+    return malloc(size);
+}
+
+/**
+* failing_free: frees memory of failing_alloc.
+*/
+static void failing_free(void* ptr, void* ctx)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+/**
+* file_equals: checks that a file holds exactly the expected text.
+*/
+static bool file_equals(const char* file_name, const char* expected)
+{
+    char text[MAX_FILE_SIZE];
+    FILE* file = fopen(file_name, "r");
+    if (file == NULL) {
+        return false;
+    }
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    text[length] = '\0';
+    return strcmp(text, expected) == 0;
+}
+
+/**
+* create_schedule: creates an event manager starting at 1.1.2021 with three
+* members and three events:
+*   meet on 1.1.2021 (id 7) with bob,
+*   party on 3.1.2021 (id 100) with bob and alice,
+*   talk on 3.1.2021 (id 8) with nobody.
+*/
+static EventManager create_schedule()
+{
+    Date date = dateCreate(1, 1, 2021);
+    EventManager em = createEventManager(date);
+    dateDestroy(date);
+    if (em == NULL) {
+        return NULL;
+    }
+    if (emAddMember(em, "alice", 12) != EM_SUCCESS || emAddMember(em, "bob", 3) != EM_SUCCESS ||
+        emAddMember(em, "carol", 40) != EM_SUCCESS || emAddEventByDiff(em, "party", 2, 100) != EM_SUCCESS ||
+        emAddEventByDiff(em, "meet", 0, 7) != EM_SUCCESS || emAddEventByDiff(em, "talk", 2, 8) != EM_SUCCESS ||
+        emAddMemberToEvent(em, 12, 100) != EM_SUCCESS || emAddMemberToEvent(em, 3, 100) != EM_SUCCESS ||
+        emAddMemberToEvent(em, 3, 7) != EM_SUCCESS) {
+        destroyEventManager(em);
+        return NULL;
+    }
+    return em;
+}
+
+/**
+* Text: a growing string the expected content of a file is built in.
+*/
+typedef struct text {
+    char* data;
+    size_t length;
+    size_t capacity;
+} Text;
+
+/**
+* text_append: appends formatted text to a Text, as printf formats it.
+*/
+static bool text_append(Text* text, const char* format, ...)
+{
+    va_list arguments;
+    va_start(arguments, format);
+    int length = vsnprintf(NULL, 0, format, arguments);
+    va_end(arguments);
+    if (length < 0) {
+        return false;
+    }
+    if (text->length + length + 1 > text->capacity) {
+        size_t capacity = 2 * (text->length + length + 1);
+        char* data = realloc(text->data, capacity);
+        if (data == NULL) {
+            return false;
+        }
+        text->data = data;
+        text->capacity = capacity;
+    }
+    va_start(arguments, format);
+    vsnprintf(text->data + text->length, length + 1, format, arguments);
+    va_end(arguments);
+    text->length += length;
+    return true;
+}
+
+/**
+* file_matches: checks that a file holds exactly the text of a Text, for
+* files too long for file_equals.
+*/
+static bool file_matches(const char* file_name, const Text* expected)
+{
+    FILE* file = fopen(file_name, "r");
+    char* data = malloc(expected->length + 1);
+    bool matches = file != NULL && data != NULL && fread(data, 1, expected->length + 1, file) == expected->length &&
+                   memcmp(data, expected->data, expected->length) == 0;
+    if (file != NULL) {
+        fclose(file);
+    }
+    free(data);
+    return matches;
+}
+
+/**
+* has_member_events: checks that emGetMemberEvents returns exactly the
+* expected event ids of a member, in order.
+*/
+static bool has_member_events(EventManager em, int member_id, const int* expected, int size)
+{
+    int out[MAX_EVENTS];
+    if (emGetMemberEvents(em, member_id, out, MAX_EVENTS) != size) {
+        return false;
+    }
+    for (int i = 0; i < size; i++) {
+        if (out[i] != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+* change_date: moves an event to the given date with emChangeEventDate.
+*/
+static EventManagerResult change_date(EventManager em, int event_id, int day, int month, int year)
+{
+    Date date = dateCreate(day, month, year);
+    if (date == NULL) {
+        return EM_OUT_OF_MEMORY;
+    }
+    EventManagerResult result = emChangeEventDate(em, event_id, date);
+    dateDestroy(date);
+    return result;
+}
+
+bool testGetMemberEvents() {
+    bool result = true;
+    Date date = dateCreate(1, 1, 2021);
+    EventManager em = createEventManager(date);
+    int out[MAX_EVENTS] = {0};
+    ASSERT_TEST(em != NULL, destroyGetMemberEvents);
+    ASSERT_TEST(emAddMember(em, "alice", 9) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddMember(em, "bob", 10) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emGetMemberEvents(em, 9, NULL, 0) == 0, destroyGetMemberEvents);
+    ASSERT_TEST(emAddEventByDiff(em, "one", 5, 1) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddEventByDiff(em, "two", 3, 2) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddEventByDiff(em, "three", 3, 3) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddEventByDiff(em, "four", 1, 4) == EM_SUCCESS, destroyGetMemberEvents);
+    // the order of the links does not matter, only the dates and the order the events were added
+    ASSERT_TEST(emAddMemberToEvent(em, 9, 1) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddMemberToEvent(em, 9, 3) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddMemberToEvent(em, 9, 2) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddMemberToEvent(em, 9, 4) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(emAddMemberToEvent(em, 10, 3) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(has_member_events(em, 9, (int[]){4, 2, 3, 1}, 4), destroyGetMemberEvents);
+    // an event moved to the date of later added events goes before them
+    ASSERT_TEST(change_date(em, 1, 4, 1, 2021) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(has_member_events(em, 9, (int[]){4, 1, 2, 3}, 4), destroyGetMemberEvents);
+    // and an event moved to the date of earlier added events goes after them
+    ASSERT_TEST(change_date(em, 4, 4, 1, 2021) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(has_member_events(em, 9, (int[]){1, 2, 3, 4}, 4), destroyGetMemberEvents);
+    ASSERT_TEST(change_date(em, 2, 6, 1, 2021) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(has_member_events(em, 9, (int[]){1, 3, 4, 2}, 4), destroyGetMemberEvents);
+    ASSERT_TEST(emRemoveMemberFromEvent(em, 9, 3) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(has_member_events(em, 9, (int[]){1, 4, 2}, 3), destroyGetMemberEvents);
+    ASSERT_TEST(has_member_events(em, 10, (int[]){3}, 1), destroyGetMemberEvents);
+    ASSERT_TEST(emRemoveEvent(em, 4) == EM_SUCCESS, destroyGetMemberEvents);
+    ASSERT_TEST(has_member_events(em, 9, (int[]){1, 2}, 2), destroyGetMemberEvents);
+    // a smaller cap copies the first events and still returns the count
+    ASSERT_TEST(emAddMemberToEvent(em, 9, 3) == EM_SUCCESS, destroyGetMemberEvents);
+    out[1] = -1;
+    ASSERT_TEST(emGetMemberEvents(em, 9, out, 1) == 3, destroyGetMemberEvents);
+    ASSERT_TEST(out[0] == 1 && out[1] == -1, destroyGetMemberEvents);
+    ASSERT_TEST(emGetMemberEvents(em, 9, NULL, 0) == 3, destroyGetMemberEvents);
+    ASSERT_TEST(emGetMemberEvents(em, 11, out, MAX_EVENTS) == -1, destroyGetMemberEvents);
+    ASSERT_TEST(emGetMemberEvents(NULL, 9, out, MAX_EVENTS) == -1, destroyGetMemberEvents);
+
+destroyGetMemberEvents:
+    destroyEventManager(em);
+    dateDestroy(date);
+    return result;
+}
+
+/**
+* delta_equals: checks that DELTA_FILE holds the version line of a version
+* followed by the expected lines.
+*/
+static bool delta_equals(long version, const char* lines)
+{
+    char expected[MAX_FILE_SIZE];
+    int length = snprintf(expected, sizeof(expected), "version,%ld\n%s", version, lines);
+    return length > 0 && length < (int)sizeof(expected) && file_equals(DELTA_FILE, expected);
+}
+
+bool testExportDelta() {
+    bool result = true;
+    EventManager em = create_schedule();
+    Date date = dateCreate(9, 1, 2021);
+    long start = 0;
+    long middle = 0;
+    long version = 0;
+    ASSERT_TEST(em != NULL && date != NULL, destroyExportDelta);
+    start = emGetVersion(em);
+    ASSERT_TEST(start > 0, destroyExportDelta);
+    ASSERT_TEST(emExportDelta(em, start, DELTA_FILE) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(delta_equals(start, ""), destroyExportDelta);
+    ASSERT_TEST(emAddEventByDiff(em, "lunch", 1, 50) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(emAddMemberToEvent(em, 40, 50) == EM_SUCCESS, destroyExportDelta);
+    middle = emGetVersion(em);
+    ASSERT_TEST(middle == start + 2, destroyExportDelta);
+    ASSERT_TEST(emChangeEventDate(em, 100, date) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(emRemoveEvent(em, 8) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(emAddEventByDiff(em, "late", 4, 60) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(emRemoveEvent(em, 60) == EM_SUCCESS, destroyExportDelta);
+    // enough changes of one event for the log to drop the superseded ones
+    for (int i = 0; i < RELINK_ROUNDS; i++) {
+        ASSERT_TEST(emAddMemberToEvent(em, 12, 7) == EM_SUCCESS, destroyExportDelta);
+        ASSERT_TEST(emRemoveMemberFromEvent(em, 12, 7) == EM_SUCCESS, destroyExportDelta);
+    }
+    version = emGetVersion(em);
+    ASSERT_TEST(version == middle + 4 + 2 * RELINK_ROUNDS, destroyExportDelta);
+    ASSERT_TEST(emExportDelta(em, start, DELTA_FILE) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(delta_equals(version, "event,7,meet,1.1.2021,bob\n"
+                                      "removed,8\n"
+                                      "event,50,lunch,2.1.2021,carol\n"
+                                      "removed,60\n"
+                                      "event,100,party,9.1.2021,bob,alice\n"), destroyExportDelta);
+    ASSERT_TEST(emExportDelta(em, middle, DELTA_FILE) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(delta_equals(version, "event,7,meet,1.1.2021,bob\n"
+                                      "removed,8\n"
+                                      "removed,60\n"
+                                      "event,100,party,9.1.2021,bob,alice\n"), destroyExportDelta);
+    ASSERT_TEST(emExportDelta(em, version, DELTA_FILE) == EM_SUCCESS, destroyExportDelta);
+    ASSERT_TEST(delta_equals(version, ""), destroyExportDelta);
+    ASSERT_TEST(emExportDelta(em, -1, DELTA_FILE) == EM_ERROR, destroyExportDelta);
+    ASSERT_TEST(emExportDelta(em, version + 1, DELTA_FILE) == EM_ERROR, destroyExportDelta);
+    ASSERT_TEST(emExportDelta(em, start, NULL) == EM_NULL_ARGUMENT, destroyExportDelta);
+
+destroyExportDelta:
+    destroyEventManager(em);
+    dateDestroy(date);
+    remove(DELTA_FILE);
+    return result;
+}
+
+bool testExportDeltaAfterLostChange() {
+    bool result = true;
+    Allocator allocator = {failing_alloc, failing_free, NULL};
+    Date date = dateCreate(1, 1, 2021);
+    EventManager em = NULL;
+    long start = 0;
+    long version = 0;
+    char name[MAX_NAME_SIZE];
+    ASSERT_TEST(date != NULL, destroyExportDeltaAfterLostChange);
+    em = createEventManagerWithAllocator(date, &allocator);
+    ASSERT_TEST(em != NULL, destroyExportDeltaAfterLostChange);
+    // fill the log with changes of distinct events, so it cannot make room by dropping any
+    for (int i = 0; i < CHANGE_LOG_CAPACITY; i++) {
+        snprintf(name, sizeof(name), "event%d", i);
+        ASSERT_TEST(emAddEventByDiff(em, name, 1, i) == EM_SUCCESS, destroyExportDeltaAfterLostChange);
+    }
+    start = emGetVersion(em);
+    fail_allocations = true;
+    ASSERT_TEST(emRemoveEvent(em, 0) == EM_SUCCESS, destroyExportDeltaAfterLostChange);
+    fail_allocations = false;
+    version = emGetVersion(em);
+    ASSERT_TEST(version == start + 1, destroyExportDeltaAfterLostChange);
+    // the removal is not in the log, so no version before it can be exported
+    ASSERT_TEST(emExportDelta(em, 0, DELTA_FILE) == EM_ERROR, destroyExportDeltaAfterLostChange);
+    ASSERT_TEST(emExportDelta(em, start, DELTA_FILE) == EM_ERROR, destroyExportDeltaAfterLostChange);
+    ASSERT_TEST(emExportDelta(em, version, DELTA_FILE) == EM_SUCCESS, destroyExportDeltaAfterLostChange);
+    ASSERT_TEST(delta_equals(version, ""), destroyExportDeltaAfterLostChange);
+    ASSERT_TEST(emRemoveEvent(em, 1) == EM_SUCCESS, destroyExportDeltaAfterLostChange);
+    ASSERT_TEST(emExportDelta(em, version, DELTA_FILE) == EM_SUCCESS, destroyExportDeltaAfterLostChange);
+    ASSERT_TEST(delta_equals(version + 1, "removed,1\n"), destroyExportDeltaAfterLostChange);
+
+destroyExportDeltaAfterLostChange:
+    fail_allocations = false;
+    destroyEventManager(em);
+    dateDestroy(date);
+    remove(DELTA_FILE);
+    return result;
+}
+
+bool testPrintManyChunks() {
+    bool result = true;
+    Date date = dateCreate(1, 1, 2021);
+    EventManager em = createEventManager(date);
+    char dates[MANY_DATES][sizeof("dd.mm.yyyy")];
+    int* counts = calloc(MANY_MEMBERS, sizeof(*counts));
+    Text events = {NULL, 0, 0};
+    Text members = {NULL, 0, 0};
+    char name[MAX_NAME_SIZE];
+    ASSERT_TEST(em != NULL && counts != NULL, destroyPrintManyChunks);
+    for (int d = 0; d < MANY_DATES; d++) {
+        int day, month, year;
+        ASSERT_TEST(dateGet(date, &day, &month, &year), destroyPrintManyChunks);
+        snprintf(dates[d], sizeof(dates[d]), "%d.%d.%d", day, month, year);
+        dateTick(date);
+    }
+    // members with six digit ids, added from the largest id down
+    for (int j = MANY_MEMBERS - 1; j >= 0; j--) {
+        snprintf(name, sizeof(name), "member%d", j);
+        ASSERT_TEST(emAddMember(em, name, 100000 + j) == EM_SUCCESS, destroyPrintManyChunks);
+    }
+    // events with seven digit ids spread over the dates, every third one with two members
+    for (int i = 0; i < MANY_EVENTS; i++) {
+        snprintf(name, sizeof(name), "event%d", i);
+        ASSERT_TEST(emAddEventByDiff(em, name, i % MANY_DATES, 1000000 + 7 * i) == EM_SUCCESS,
+                    destroyPrintManyChunks);
+        ASSERT_TEST(emAddMemberToEvent(em, 100000 + i % MANY_MEMBERS, 1000000 + 7 * i) == EM_SUCCESS,
+                    destroyPrintManyChunks);
+        counts[i % MANY_MEMBERS]++;
+        if (i % 3 == 0 && (7 * i) % MANY_MEMBERS != i % MANY_MEMBERS) {
+            ASSERT_TEST(emAddMemberToEvent(em, 100000 + (7 * i) % MANY_MEMBERS, 1000000 + 7 * i) == EM_SUCCESS,
+                        destroyPrintManyChunks);
+            counts[(7 * i) % MANY_MEMBERS]++;
+        }
+    }
+    // the events by date and then in the order they were added, their members by id
+    for (int d = 0; d < MANY_DATES; d++) {
+        for (int i = d; i < MANY_EVENTS; i += MANY_DATES) {
+            int first = i % MANY_MEMBERS;
+            int second = i % 3 == 0 && (7 * i) % MANY_MEMBERS != first ? (7 * i) % MANY_MEMBERS : -1;
+            if (second < 0) {
+                ASSERT_TEST(text_append(&events, "event%d,%s,member%d\n", i, dates[d], first), destroyPrintManyChunks);
+            } else {
+                ASSERT_TEST(text_append(&events, "event%d,%s,member%d,member%d\n", i, dates[d],
+                                        second < first ? second : first, second < first ? first : second),
+                            destroyPrintManyChunks);
+            }
+        }
+    }
+    // the members by count and then by id
+    for (int count = MANY_EVENTS; count > 0; count--) {
+        for (int j = 0; j < MANY_MEMBERS; j++) {
+            if (counts[j] == count) {
+                ASSERT_TEST(text_append(&members, "member%d,%d\n", j, count), destroyPrintManyChunks);
+            }
+        }
+    }
+    for (int workers = 1; workers <= MANY_WORKERS; workers += MANY_WORKERS - 1) {
+        ASSERT_TEST(emSetExportWorkers(em, workers) == EM_SUCCESS, destroyPrintManyChunks);
+        emPrintAllEvents(em, EVENTS_FILE);
+        ASSERT_TEST(file_matches(EVENTS_FILE, &events), destroyPrintManyChunks);
+        emPrintAllResponsibleMembers(em, MEMBERS_FILE);
+        ASSERT_TEST(file_matches(MEMBERS_FILE, &members), destroyPrintManyChunks);
+    }
+
+destroyPrintManyChunks:
+    destroyEventManager(em);
+    dateDestroy(date);
+    free(counts);
+    free(events.data);
+    free(members.data);
+    remove(EVENTS_FILE);
+    remove(MEMBERS_FILE);
+    return result;
+}
+
+bool testRecurringEvent() {
+    bool result = true;
+    Date date = dateCreate(1, 1, 2021);
+    Date until = dateCreate(29, 1, 2021);
+    Date conflict = dateCreate(15, 1, 2021);
+    Date review = dateCreate(30, 1, 2021);
+    EventManager em = createEventManager(date);
+    int out[MAX_EVENTS];
+    ASSERT_TEST(em != NULL && until != NULL && conflict != NULL && review != NULL, destroyRecurringEvent);
+    ASSERT_TEST(emAddMember(em, "alice", 1) == EM_SUCCESS, destroyRecurringEvent);
+    ASSERT_TEST(emAddMember(em, "bob", 2) == EM_SUCCESS, destroyRecurringEvent);
+    // weekly from 1.1.2021 to 29.1.2021, occurrence k has the id 500+k
+    ASSERT_TEST(emAddRecurringEvent(em, "standup", date, 7, 0, until, 500) == EM_SUCCESS, destroyRecurringEvent);
+    ASSERT_TEST(emAddRecurringEvent(em, "standup", date, 7, 0, until, 600) == EM_EVENT_ALREADY_EXISTS,
+                destroyRecurringEvent);
+    ASSERT_TEST(emAddRecurringEvent(em, "sync", date, 7, 0, until, 500) == EM_EVENT_ID_ALREADY_EXISTS,
+                destroyRecurringEvent);
+    ASSERT_TEST(emAddRecurringEvent(em, "sync", date, 0, 0, until, 600) == EM_INVALID_DATE, destroyRecurringEvent);
+    ASSERT_TEST(emAddRecurringEvent(em, "sync", until, 7, 0, date, 600) == EM_INVALID_DATE, destroyRecurringEvent);
+    ASSERT_TEST(emAddRecurringEvent(em, "sync", date, 7, -1, until, 600) == EM_ERROR, destroyRecurringEvent);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 500) == EM_SUCCESS, destroyRecurringEvent);
+    ASSERT_TEST(emAddMemberToEvent(em, 2, 500) == EM_SUCCESS, destroyRecurringEvent);
+    // the third occurrence clashes with another standup on its date, the fourth with the id of review
+    ASSERT_TEST(emAddEventByDate(em, "standup", conflict, 900) == EM_SUCCESS, destroyRecurringEvent);
+    ASSERT_TEST(emAddEventByDate(em, "review", review, 503) == EM_SUCCESS, destroyRecurringEvent);
+    ASSERT_TEST(emGetEventsAmount(em) == 3, destroyRecurringEvent);
+    // the next occurrence takes the members of the expired one
+    ASSERT_TEST(emTick(em, 1) == EM_SUCCESS, destroyRecurringEvent);
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "standup,8.1.2021,alice,bob\n"
+                                         "standup,15.1.2021\n"
+                                         "review,30.1.2021\n"), destroyRecurringEvent);
+    emPrintAllResponsibleMembers(em, MEMBERS_FILE);
+    ASSERT_TEST(file_equals(MEMBERS_FILE, "alice,1\n"
+                                          "bob,1\n"), destroyRecurringEvent);
+    ASSERT_TEST(emGetMemberEvents(em, 1, out, MAX_EVENTS) == 1 && out[0] == 501, destroyRecurringEvent);
+    // as it is when it expires, so a member unlinked from the current occurrence is left out
+    ASSERT_TEST(emRemoveMemberFromEvent(em, 2, 501) == EM_SUCCESS, destroyRecurringEvent);
+    ASSERT_TEST(emTick(em, 7) == EM_SUCCESS, destroyRecurringEvent);
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "standup,15.1.2021\n"
+                                         "standup,29.1.2021,alice\n"
+                                         "review,30.1.2021\n"), destroyRecurringEvent);
+    ASSERT_TEST(has_member_events(em, 1, (int[]){504}, 1), destroyRecurringEvent);
+    ASSERT_TEST(has_member_events(em, 2, NULL, 0), destroyRecurringEvent);
+    emPrintAllResponsibleMembers(em, MEMBERS_FILE);
+    ASSERT_TEST(file_equals(MEMBERS_FILE, "alice,1\n"), destroyRecurringEvent);
+    // the occurrence after 29.1.2021 is past until, so the series ends
+    ASSERT_TEST(emTick(em, 21) == EM_SUCCESS, destroyRecurringEvent);
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "review,30.1.2021\n"), destroyRecurringEvent);
+    ASSERT_TEST(has_member_events(em, 1, NULL, 0), destroyRecurringEvent);
+
+destroyRecurringEvent:
+    destroyEventManager(em);
+    dateDestroy(date);
+    dateDestroy(until);
+    dateDestroy(conflict);
+    dateDestroy(review);
+    remove(EVENTS_FILE);
+    remove(MEMBERS_FILE);
+    return result;
+}
+
+/**
+* Expiry_log: the events reported by emTickWithCallback, in the order they
+* were reported.
+*/
+typedef struct expiry_log {
+    int ids[MAX_EVENTS];
+    char names[MAX_EVENTS][MAX_NAME_SIZE];
+    int days[MAX_EVENTS];
+    int size;
+} Expiry_log;
+
+/**
+* log_expiry: an EventExpiryCallback adding the event to an Expiry_log.
+*/
+static void log_expiry(char* event_name, int event_id, Date date, void* ctx)
+{
+    Expiry_log* log = ctx;
+    int month, year;
+    if (log->size == MAX_EVENTS) {
+        return;
+    }
+    log->ids[log->size] = event_id;
+    snprintf(log->names[log->size], MAX_NAME_SIZE, "%s", event_name);
+    if (!dateGet(date, &log->days[log->size], &month, &year)) {
+        log->days[log->size] = -1;
+    }
+    log->size++;
+}
+
+/**
+* has_expired: checks that an Expiry_log holds exactly the expected events,
+* given by id, name and day of the month, in order.
+*/
+static bool has_expired(const Expiry_log* log, const int* ids, const char** names, const int* days, int size)
+{
+    if (log->size != size) {
+        return false;
+    }
+    for (int i = 0; i < size; i++) {
+        if (log->ids[i] != ids[i] || strcmp(log->names[i], names[i]) != 0 || log->days[i] != days[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool testTickWithCallback() {
+    bool result = true;
+    Date date = dateCreate(1, 1, 2021);
+    Date first = dateCreate(2, 1, 2021);
+    EventManager em = createEventManager(date);
+    Expiry_log log = {{0}, {{0}}, {0}, 0};
+    ASSERT_TEST(em != NULL && first != NULL, destroyTickWithCallback);
+    ASSERT_TEST(emAddMember(em, "alice", 1) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddMember(em, "bob", 2) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddEventByDiff(em, "c", 2, 30) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddEventByDiff(em, "a", 0, 10) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddEventByDiff(em, "b", 2, 20) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddEventByDiff(em, "d", 5, 40) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddRecurringEvent(em, "daily", first, 1, 0, NULL, 100) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 10) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddMemberToEvent(em, 2, 20) == EM_SUCCESS, destroyTickWithCallback);
+    // the last link moves c behind b in the queue, which must not change the order of the callbacks
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 30) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(strcmp(emGetNextEvent(em), "a") == 0, destroyTickWithCallback);
+    ASSERT_TEST(emAddMemberToEvent(em, 2, 40) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 100) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(emTickWithCallback(NULL, 1, log_expiry, &log) == EM_NULL_ARGUMENT, destroyTickWithCallback);
+    ASSERT_TEST(emTickWithCallback(em, 0, log_expiry, &log) == EM_INVALID_DATE, destroyTickWithCallback);
+    ASSERT_TEST(log.size == 0 && emGetEventsAmount(em) == 5, destroyTickWithCallback);
+    // one tick expires four events over three dates, c before b as it was added first
+    ASSERT_TEST(emTickWithCallback(em, 3, log_expiry, &log) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(has_expired(&log, (int[]){10, 100, 30, 20}, (const char*[]){"a", "daily", "c", "b"},
+                            (int[]){1, 2, 3, 3}, 4), destroyTickWithCallback);
+    // the daily occurrence of 3.1.2021 was already expired, so the series goes on from 4.1.2021
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "daily,4.1.2021,alice\n"
+                                         "d,6.1.2021,bob\n"), destroyTickWithCallback);
+    emPrintAllResponsibleMembers(em, MEMBERS_FILE);
+    ASSERT_TEST(file_equals(MEMBERS_FILE, "alice,1\n"
+                                          "bob,1\n"), destroyTickWithCallback);
+    // without a callback the events still expire
+    ASSERT_TEST(emTickWithCallback(em, 1, NULL, NULL) == EM_SUCCESS, destroyTickWithCallback);
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "daily,5.1.2021,alice\n"
+                                         "d,6.1.2021,bob\n"), destroyTickWithCallback);
+    log.size = 0;
+    ASSERT_TEST(emTickWithCallback(em, 1, log_expiry, &log) == EM_SUCCESS, destroyTickWithCallback);
+    ASSERT_TEST(has_expired(&log, (int[]){103}, (const char*[]){"daily"}, (int[]){5}, 1), destroyTickWithCallback);
+
+destroyTickWithCallback:
+    destroyEventManager(em);
+    dateDestroy(date);
+    dateDestroy(first);
+    remove(EVENTS_FILE);
+    remove(MEMBERS_FILE);
+    return result;
+}
+
+bool testMemberLimits() {
+    bool result = true;
+    Allocator allocator = {failing_alloc, failing_free, NULL};
+    Date date = dateCreate(1, 1, 2021);
+    Date later = dateCreate(2, 1, 2021);
+    EventManager em = NULL;
+    EventManagerResult linked = EM_OUT_OF_MEMORY;
+    ASSERT_TEST(date != NULL && later != NULL, destroyMemberLimits);
+    em = createEventManagerWithAllocator(date, &allocator);
+    ASSERT_TEST(em != NULL, destroyMemberLimits);
+    ASSERT_TEST(emAddMember(em, "alice", 1) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMember(em, "bob", 2) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMember(em, "carol", 3) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMember(em, "dave", 4) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddEventByDiff(em, "one", 1, 1) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddEventByDiff(em, "two", 1, 2) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddEventByDiff(em, "three", 1, 3) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddEventByDiff(em, "four", 2, 4) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 1) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 2) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emSetMemberLimits(NULL, 2, 1) == EM_NULL_ARGUMENT, destroyMemberLimits);
+    ASSERT_TEST(emSetMemberLimits(em, -1, 1) == EM_ERROR, destroyMemberLimits);
+    ASSERT_TEST(emSetMemberLimits(em, 2, -1) == EM_ERROR, destroyMemberLimits);
+    // two members an event, one event a member on a date, alice keeps the two she had before
+    ASSERT_TEST(emSetMemberLimits(em, 2, 1) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(has_member_events(em, 1, (int[]){1, 2}, 2), destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 3) == EM_MEMBER_DATE_CONFLICT, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 2, 1) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 3, 1) == EM_EVENT_MEMBERS_LIMIT_REACHED, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 2, 2) == EM_MEMBER_DATE_CONFLICT, destroyMemberLimits);
+    // the refused links left nothing behind, so carol is still free on 2.1.2021
+    ASSERT_TEST(has_member_events(em, 3, NULL, 0) && has_member_events(em, 2, (int[]){1}, 1), destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 3, 2) == EM_SUCCESS, destroyMemberLimits);
+    // a date change that would give carol two events on 2.1.2021 is refused and changes nothing
+    ASSERT_TEST(emAddMemberToEvent(em, 3, 4) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emChangeEventDate(em, 4, later) == EM_MEMBER_DATE_CONFLICT, destroyMemberLimits);
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "one,2.1.2021,alice,bob\n"
+                                         "two,2.1.2021,alice,carol\n"
+                                         "three,2.1.2021\n"
+                                         "four,3.1.2021,carol\n"), destroyMemberLimits);
+    ASSERT_TEST(emRemoveMemberFromEvent(em, 3, 2) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emChangeEventDate(em, 4, later) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 3, 2) == EM_MEMBER_DATE_CONFLICT, destroyMemberLimits);
+    // a link that fails at any allocation leaves the member and its bookings as they were
+    for (int allowed = 0; linked == EM_OUT_OF_MEMORY; allowed++) {
+        allocations_left = allowed;
+        linked = emAddMemberToEvent(em, 4, 3);
+        allocations_left = -1;
+        ASSERT_TEST(linked == EM_SUCCESS || linked == EM_OUT_OF_MEMORY, destroyMemberLimits);
+        if (linked == EM_OUT_OF_MEMORY) {
+            ASSERT_TEST(has_member_events(em, 4, NULL, 0), destroyMemberLimits);
+        }
+    }
+    ASSERT_TEST(has_member_events(em, 4, (int[]){3}, 1), destroyMemberLimits);
+    emPrintAllResponsibleMembers(em, MEMBERS_FILE);
+    ASSERT_TEST(file_equals(MEMBERS_FILE, "alice,2\n"
+                                          "bob,1\n"
+                                          "carol,1\n"
+                                          "dave,1\n"), destroyMemberLimits);
+    // without the date limit only the size of the events is checked
+    ASSERT_TEST(emSetMemberLimits(em, 2, 0) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 3) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 2, 3) == EM_EVENT_MEMBERS_LIMIT_REACHED, destroyMemberLimits);
+    ASSERT_TEST(emSetMemberLimits(em, 0, 0) == EM_SUCCESS, destroyMemberLimits);
+    ASSERT_TEST(emAddMemberToEvent(em, 2, 3) == EM_SUCCESS, destroyMemberLimits);
+
+destroyMemberLimits:
+    allocations_left = -1;
+    destroyEventManager(em);
+    dateDestroy(date);
+    dateDestroy(later);
+    remove(EVENTS_FILE);
+    remove(MEMBERS_FILE);
+    return result;
+}
+
+bool testGetNextEvents() {
+    bool result = true;
+    Date date = dateCreate(1, 1, 2021);
+    EventManager em = createEventManager(date);
+    int ids[MAX_EVENTS];
+    Date dates[MAX_EVENTS];
+    int day, month, year;
+    ASSERT_TEST(em != NULL, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(em, MAX_EVENTS, ids, dates) == 0, destroyGetNextEvents);
+    ASSERT_TEST(emAddMember(em, "alice", 7) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(emAddEventByDiff(em, "x", 1, 1) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(emAddEventByDiff(em, "z", 2, 3) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(emAddEventByDiff(em, "y", 1, 2) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(em, MAX_EVENTS, ids, dates) == 3, destroyGetNextEvents);
+    ASSERT_TEST(ids[0] == 1 && ids[1] == 2 && ids[2] == 3, destroyGetNextEvents);
+    ASSERT_TEST(dateGet(dates[1], &day, &month, &year) && day == 2 && month == 1 && year == 2021,
+                destroyGetNextEvents);
+    ASSERT_TEST(dateGet(dates[2], &day, &month, &year) && day == 3 && month == 1 && year == 2021,
+                destroyGetNextEvents);
+    ASSERT_TEST(strcmp(emGetNextEvent(em), "x") == 0, destroyGetNextEvents);
+    // linking moves x behind y for emGetNextEvent only
+    ASSERT_TEST(emAddMemberToEvent(em, 7, 1) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(strcmp(emGetNextEvent(em), "y") == 0, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(em, MAX_EVENTS, ids, NULL) == 3, destroyGetNextEvents);
+    ASSERT_TEST(ids[0] == 1 && ids[1] == 2 && ids[2] == 3, destroyGetNextEvents);
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "x,2.1.2021,alice\n"
+                                         "y,2.1.2021\n"
+                                         "z,3.1.2021\n"), destroyGetNextEvents);
+    // and so does unlinking, while emGetNextEvents keeps the order of the file
+    ASSERT_TEST(emAddMemberToEvent(em, 7, 2) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(strcmp(emGetNextEvent(em), "x") == 0, destroyGetNextEvents);
+    ASSERT_TEST(emRemoveMemberFromEvent(em, 7, 1) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(strcmp(emGetNextEvent(em), "y") == 0, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(em, 2, ids, NULL) == 2 && ids[0] == 1 && ids[1] == 2, destroyGetNextEvents);
+    // the earliest date decides before the order on a date does
+    ASSERT_TEST(emAddEventByDiff(em, "w", 0, 4) == EM_SUCCESS, destroyGetNextEvents);
+    ASSERT_TEST(strcmp(emGetNextEvent(em), "w") == 0, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(em, 1, ids, NULL) == 1 && ids[0] == 4, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(em, 0, NULL, NULL) == 0, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(em, -1, ids, NULL) == -1, destroyGetNextEvents);
+    ASSERT_TEST(emGetNextEvents(NULL, 1, ids, NULL) == -1, destroyGetNextEvents);
+
+destroyGetNextEvents:
+    destroyEventManager(em);
+    dateDestroy(date);
+    remove(EVENTS_FILE);
+    return result;
+}
+
+bool testSnapshotKeepsOldState() {
+    bool result = true;
+    EventManager em = create_schedule();
+    EMSnapshot snapshot = NULL;
+    EMSnapshot later = NULL;
+    Date date = dateCreate(9, 1, 2021);
+    EMMemoryUsage usage;
+    ASSERT_TEST(em != NULL && date != NULL, destroySnapshotKeepsOldState);
+    snapshot = emSnapshot(em);
+    ASSERT_TEST(snapshot != NULL, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emSnapshotGetEventsAmount(snapshot) == 3, destroySnapshotKeepsOldState);
+    // every kind of change after the snapshot
+    ASSERT_TEST(emAddEventByDiff(em, "lunch", 1, 50) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emAddMemberToEvent(em, 40, 50) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emAddMemberToEvent(em, 12, 8) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emRemoveMemberFromEvent(em, 3, 100) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emChangeEventDate(em, 100, date) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emRemoveEvent(em, 8) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emAddMember(em, "dave", 1) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emAddMemberToEvent(em, 1, 50) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emTick(em, 1) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emGetEventsAmount(em) == 2, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emSnapshotGetEventsAmount(snapshot) == 3, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emSnapshotPrintAllEvents(snapshot, EVENTS_FILE) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "meet,1.1.2021,bob\n"
+                                         "party,3.1.2021,bob,alice\n"
+                                         "talk,3.1.2021\n"), destroySnapshotKeepsOldState);
+    ASSERT_TEST(emSnapshotPrintAllResponsibleMembers(snapshot, MEMBERS_FILE) == EM_SUCCESS,
+                destroySnapshotKeepsOldState);
+    ASSERT_TEST(file_equals(MEMBERS_FILE, "bob,2\n"
+                                          "alice,1\n"), destroySnapshotKeepsOldState);
+    // the event manager itself has moved on
+    emPrintAllEvents(em, EVENTS_FILE);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "lunch,2.1.2021,dave,carol\n"
+                                         "party,9.1.2021,alice\n"), destroySnapshotKeepsOldState);
+    // once the last snapshot is gone the next change drops the views
+    emSnapshotDestroy(snapshot);
+    snapshot = NULL;
+    ASSERT_TEST(emAddMemberToEvent(em, 3, 50) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emGetMemoryUsage(em, &usage) == EM_SUCCESS && usage.views == 0, destroySnapshotKeepsOldState);
+    // and a new snapshot builds them again from the current state
+    later = emSnapshot(em);
+    ASSERT_TEST(later != NULL, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emGetMemoryUsage(em, &usage) == EM_SUCCESS && usage.views > 0, destroySnapshotKeepsOldState);
+    ASSERT_TEST(emRemoveEvent(em, 50) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    destroyEventManager(em);
+    em = NULL;
+    ASSERT_TEST(emSnapshotPrintAllEvents(later, EVENTS_FILE) == EM_SUCCESS, destroySnapshotKeepsOldState);
+    ASSERT_TEST(file_equals(EVENTS_FILE, "lunch,2.1.2021,dave,bob,carol\n"
+                                         "party,9.1.2021,alice\n"), destroySnapshotKeepsOldState);
+
+destroySnapshotKeepsOldState:
+    emSnapshotDestroy(snapshot);
+    emSnapshotDestroy(later);
+    destroyEventManager(em);
+    dateDestroy(date);
+    remove(EVENTS_FILE);
+    remove(MEMBERS_FILE);
+    return result;
+}
+
+#define NUMBER_TESTS 9
+
+bool (*tests[]) (void) = {
+        testGetMemberEvents,
+        testExportDelta,
+        testExportDeltaAfterLostChange,
+        testPrintManyChunks,
+        testRecurringEvent,
+        testTickWithCallback,
+        testMemberLimits,
+        testGetNextEvents,
+        testSnapshotKeepsOldState
+};
+
+const char* testNames[] = {
+        "testGetMemberEvents",
+        "testExportDelta",
+        "testExportDeltaAfterLostChange",
+        "testPrintManyChunks",
+        "testRecurringEvent",
+        "testTickWithCallback",
+        "testMemberLimits",
+        "testGetNextEvents",
+        "testSnapshotKeepsOldState"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: event_manager_ext_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
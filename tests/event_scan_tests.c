@@ -0,0 +1,210 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "../event_scan.h"
+#include "test_utilities.h"
+
+#define KERNELS_NUM 3
+#define MAX_LENGTH 67
+#define ROUNDS 40
+#define SPECIAL_VALUES 7
+
+static const EventScanKernel kernels[KERNELS_NUM] = {ES_KERNEL_SCALAR, ES_KERNEL_SSE2, ES_KERNEL_AVX2};
+
+static const int special_values[SPECIAL_VALUES] = {INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX};
+
+/**
+* next_random: a xorshift generator, so every run checks the same arrays.
+*/
+static unsigned int next_random(unsigned int* seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+/**
+* random_value: returns one of the special values most of the time, so values
+* repeat and the extremes show up in every array, and any int otherwise.
+*/
+static int random_value(unsigned int* seed)
+{
+    unsigned int random = next_random(seed);
+    if (random % 4 != 0) {
+        return special_values[(random / 4) % SPECIAL_VALUES];
+    }
+    return (int)next_random(seed);
+}
+
+/**
+* fill_random: fills a column with random values.
+*/
+static void fill_random(int* column, int size, unsigned int* seed)
+{
+    for (int i = 0; i < size; i++) {
+        column[i] = random_value(seed);
+    }
+}
+
+/**
+* count_less: eventScanCountLess one element at a time.
+*/
+static int count_less(const int* column, int size, int value)
+{
+    int count = 0;
+    for (int i = 0; i < size; i++) {
+        count += column[i] < value;
+    }
+    return count;
+}
+
+/**
+* find_pair: eventScanFindPair one element at a time.
+*/
+static int find_pair(const int* column1, const int* column2, int from, int size, int value1, int value2)
+{
+    for (int i = from; i < size; i++) {
+        if (column1[i] == value1 && column2[i] == value2) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+* find: eventScanFind one element at a time.
+*/
+static int find(const int* column, int from, int size, int value)
+{
+    for (int i = from; i < size; i++) {
+        if (column[i] == value) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool testEventScanSetKernel() {
+    bool result = true;
+    EventScanKernel selected = eventScanGetKernel();
+    ASSERT_TEST(eventScanSetKernel(ES_KERNEL_SCALAR), destroyEventScanSetKernel);
+    ASSERT_TEST(eventScanGetKernel() == ES_KERNEL_SCALAR, destroyEventScanSetKernel);
+    // an unknown kernel is refused and the kernel in use is kept
+    ASSERT_TEST(!eventScanSetKernel((EventScanKernel)KERNELS_NUM), destroyEventScanSetKernel);
+    ASSERT_TEST(eventScanGetKernel() == ES_KERNEL_SCALAR, destroyEventScanSetKernel);
+    // the kernel selected at first is the widest supported one
+    for (int k = KERNELS_NUM - 1; k >= 0; k--) {
+        if (eventScanSetKernel(kernels[k])) {
+            ASSERT_TEST(kernels[k] == selected, destroyEventScanSetKernel);
+            break;
+        }
+    }
+
+destroyEventScanSetKernel:
+    eventScanSetKernel(selected);
+    return result;
+}
+
+bool testEventScanCountLess() {
+    bool result = true;
+    EventScanKernel selected = eventScanGetKernel();
+    unsigned int seed = 2463534242u;
+    // one more entry, so the columns also start off the alignment of the array
+    int column[MAX_LENGTH + 1];
+    for (int round = 0; round < ROUNDS; round++) {
+        fill_random(column, MAX_LENGTH + 1, &seed);
+        for (int size = 0; size <= MAX_LENGTH; size++) {
+            for (int offset = 0; offset < 2; offset++) {
+                int value = round % 2 == 0 ? special_values[(size + offset) % SPECIAL_VALUES] : random_value(&seed);
+                int expected = count_less(column + offset, size, value);
+                for (int k = 0; k < KERNELS_NUM; k++) {
+                    if (!eventScanSetKernel(kernels[k])) {
+                        ASSERT_TEST(kernels[k] != ES_KERNEL_SCALAR, destroyEventScanCountLess);
+                        continue;
+                    }
+                    ASSERT_TEST(eventScanCountLess(column + offset, size, value) == expected,
+                                destroyEventScanCountLess);
+                }
+            }
+        }
+    }
+    ASSERT_TEST(eventScanCountLess(NULL, MAX_LENGTH, 0) == 0, destroyEventScanCountLess);
+
+destroyEventScanCountLess:
+    eventScanSetKernel(selected);
+    return result;
+}
+
+bool testEventScanFind() {
+    bool result = true;
+    EventScanKernel selected = eventScanGetKernel();
+    unsigned int seed = 88172645u;
+    int column1[MAX_LENGTH];
+    int column2[MAX_LENGTH];
+    for (int round = 0; round < ROUNDS; round++) {
+        fill_random(column1, MAX_LENGTH, &seed);
+        fill_random(column2, MAX_LENGTH, &seed);
+        for (int size = 1; size <= MAX_LENGTH; size++) {
+            int from = (int)(next_random(&seed) % (unsigned int)size);
+            int value1 = random_value(&seed);
+            int value2 = random_value(&seed);
+            int expected = find(column1, from, size, value1);
+            int expected_pair = find_pair(column1, column2, from, size, value1, value2);
+            for (int k = 0; k < KERNELS_NUM; k++) {
+                if (!eventScanSetKernel(kernels[k])) {
+                    ASSERT_TEST(kernels[k] != ES_KERNEL_SCALAR, destroyEventScanFind);
+                    continue;
+                }
+                ASSERT_TEST(eventScanFind(column1, from, size, value1) == expected, destroyEventScanFind);
+                ASSERT_TEST(eventScanFindPair(column1, column2, from, size, value1, value2) == expected_pair,
+                            destroyEventScanFind);
+                // the last entry, which is past the last full vector for most sizes
+                ASSERT_TEST(eventScanFind(column1, from, size, column1[size - 1]) ==
+                            find(column1, from, size, column1[size - 1]), destroyEventScanFind);
+            }
+        }
+    }
+    ASSERT_TEST(eventScanFind(column1, MAX_LENGTH, MAX_LENGTH, column1[0]) == -1, destroyEventScanFind);
+    ASSERT_TEST(eventScanFindPair(column1, NULL, 0, MAX_LENGTH, 0, 0) == -1, destroyEventScanFind);
+
+destroyEventScanFind:
+    eventScanSetKernel(selected);
+    return result;
+}
+
+#define NUMBER_TESTS 3
+
+bool (*tests[]) (void) = {
+        testEventScanSetKernel,
+        testEventScanCountLess,
+        testEventScanFind
+};
+
+const char* testNames[] = {
+        "testEventScanSetKernel",
+        "testEventScanCountLess",
+        "testEventScanFind"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: event_scan_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
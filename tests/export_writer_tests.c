@@ -0,0 +1,266 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "../export_writer.h"
+#include "test_utilities.h"
+
+#define EXPORT_FILE "export_writer_tests_export.txt"
+#define MIN_VECTORS 16
+#define MAX_WORKERS 4
+#define EMPTY_CHUNK_PERIOD 7
+#define FAILED_CHUNK 5
+#define LINE_SIZE 32
+#define RANDOM_VALUES 100000
+
+/**
+* next_random: a xorshift generator, so every run checks the same values.
+*/
+static unsigned int next_random(unsigned int* seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+/**
+* formats_as_printf: checks that exportFormatInt formats a value as
+* printf("%d") does.
+*/
+static bool formats_as_printf(int value)
+{
+    char expected[LINE_SIZE];
+    char text[EXPORT_INT_TEXT_LEN + 1];
+    int length = snprintf(expected, sizeof(expected), "%d", value);
+    memset(text, '#', sizeof(text));
+    return exportFormatInt(text, value) == length && memcmp(text, expected, length) == 0 &&
+           (length == EXPORT_INT_TEXT_LEN || text[length] == '#');
+}
+
+/**
+* Text: the expected content of a file.
+*/
+typedef struct text {
+    char* data;
+    size_t length;
+} Text;
+
+/**
+* batches_of_vectors: returns a number of vectors that takes more than two
+* writev calls, whatever the number the system accepts in one call.
+*/
+static int batches_of_vectors()
+{
+    long max = sysconf(_SC_IOV_MAX);
+    return 2 * (max < MIN_VECTORS ? MIN_VECTORS : (int)max) + 3;
+}
+
+/**
+* format_line: formats the line of a chunk, "chunk <number>" for most chunks
+* and nothing for every EMPTY_CHUNK_PERIOD-th one.
+*
+* @return
+* the length of the line.
+*/
+static int format_line(int chunk, char* line)
+{
+    if (chunk % EMPTY_CHUNK_PERIOD == EMPTY_CHUNK_PERIOD - 1) {
+        line[0] = '\0';
+        return 0;
+    }
+    return snprintf(line, LINE_SIZE, "chunk %d\n", chunk);
+}
+
+/**
+* format_chunk: an ExportChunkFormatter appending the line of format_line
+* for a chunk through the buffer functions.
+*/
+static bool format_chunk(int chunk, ExportBuffer buffer, void* ctx)
+{
+    (void)ctx;
+    if (chunk % EMPTY_CHUNK_PERIOD == EMPTY_CHUNK_PERIOD - 1) {
+        return true;
+    }
+    return exportBufferAppendString(buffer, "chunk ") && exportBufferAppendInt(buffer, chunk) &&
+           exportBufferAppend(buffer, "\n", 1);
+}
+
+/**
+* format_chunk_failing: format_chunk that fails on FAILED_CHUNK.
+*/
+static bool format_chunk_failing(int chunk, ExportBuffer buffer, void* ctx)
+{
+    return chunk != FAILED_CHUNK && format_chunk(chunk, buffer, ctx);
+}
+
+/**
+* expected_text: builds the text of the lines of chunks chunks.
+*/
+static bool expected_text(int chunks, Text* text)
+{
+    text->data = malloc((size_t)chunks * LINE_SIZE + 1);
+    text->length = 0;
+    if (text->data == NULL) {
+        return false;
+    }
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        text->length += format_line(chunk, text->data + text->length);
+    }
+    return true;
+}
+
+/**
+* file_matches: checks that a file holds exactly the text of a Text.
+*/
+static bool file_matches(const char* file_name, const Text* expected)
+{
+    FILE* file = fopen(file_name, "r");
+    char* data = malloc(expected->length + 1);
+    bool matches = file != NULL && data != NULL && fread(data, 1, expected->length + 1, file) == expected->length &&
+                   memcmp(data, expected->data, expected->length) == 0;
+    if (file != NULL) {
+        fclose(file);
+    }
+    free(data);
+    return matches;
+}
+
+bool testWriteChunks() {
+    bool result = true;
+    int chunks = batches_of_vectors();
+    Text text = {NULL, 0};
+    ASSERT_TEST(expected_text(chunks, &text), destroyWriteChunks);
+    for (int workers = 0; workers <= MAX_WORKERS; workers++) {
+        ASSERT_TEST(exportWriteChunks(EXPORT_FILE, chunks, workers, format_chunk, NULL) == EXPORT_SUCCESS,
+                    destroyWriteChunks);
+        ASSERT_TEST(file_matches(EXPORT_FILE, &text), destroyWriteChunks);
+    }
+    // a file without chunks is created empty
+    text.length = 0;
+    ASSERT_TEST(exportWriteChunks(EXPORT_FILE, 0, MAX_WORKERS, format_chunk, NULL) == EXPORT_SUCCESS,
+                destroyWriteChunks);
+    ASSERT_TEST(file_matches(EXPORT_FILE, &text), destroyWriteChunks);
+    ASSERT_TEST(exportWriteChunks(NULL, chunks, 1, format_chunk, NULL) == EXPORT_NULL_ARGUMENT, destroyWriteChunks);
+    ASSERT_TEST(exportWriteChunks(EXPORT_FILE, chunks, 1, NULL, NULL) == EXPORT_NULL_ARGUMENT, destroyWriteChunks);
+
+destroyWriteChunks:
+    free(text.data);
+    remove(EXPORT_FILE);
+    return result;
+}
+
+bool testWriteChunksFailure() {
+    bool result = true;
+    int chunks = batches_of_vectors();
+    for (int workers = 1; workers <= MAX_WORKERS; workers++) {
+        ASSERT_TEST(exportWriteChunks(EXPORT_FILE, chunks, workers, format_chunk_failing, NULL) ==
+                    EXPORT_OUT_OF_MEMORY, destroyWriteChunksFailure);
+    }
+
+destroyWriteChunksFailure:
+    remove(EXPORT_FILE);
+    return result;
+}
+
+bool testWriteVectors() {
+    bool result = true;
+    int count = batches_of_vectors();
+    Text text = {NULL, 0};
+    struct iovec* vectors = malloc(sizeof(*vectors) * count);
+    int fd = -1;
+    ASSERT_TEST(vectors != NULL && expected_text(count, &text), destroyWriteVectors);
+    // every vector points at the line of its chunk in the expected text, empty lines included
+    size_t position = 0;
+    for (int i = 0; i < count; i++) {
+        char line[LINE_SIZE];
+        vectors[i].iov_base = text.data + position;
+        vectors[i].iov_len = format_line(i, line);
+        position += vectors[i].iov_len;
+    }
+    fd = open(EXPORT_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    ASSERT_TEST(fd >= 0, destroyWriteVectors);
+    ASSERT_TEST(exportWriteVectors(fd, vectors, count) == EXPORT_SUCCESS, destroyWriteVectors);
+    ASSERT_TEST(close(fd) == 0, destroyWriteVectors);
+    fd = -1;
+    ASSERT_TEST(file_matches(EXPORT_FILE, &text), destroyWriteVectors);
+    ASSERT_TEST(exportWriteVectors(1, NULL, 1) == EXPORT_NULL_ARGUMENT, destroyWriteVectors);
+    ASSERT_TEST(exportWriteVectors(-1, vectors, count) == EXPORT_IO_ERROR, destroyWriteVectors);
+
+destroyWriteVectors:
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(vectors);
+    free(text.data);
+    remove(EXPORT_FILE);
+    return result;
+}
+
+bool testFormatInt() {
+    bool result = true;
+    unsigned int seed = 2463534242u;
+    ASSERT_TEST(formats_as_printf(0), destroyFormatInt);
+    ASSERT_TEST(formats_as_printf(INT_MIN), destroyFormatInt);
+    ASSERT_TEST(formats_as_printf(INT_MIN + 1), destroyFormatInt);
+    ASSERT_TEST(formats_as_printf(INT_MAX), destroyFormatInt);
+    // every number of digits, odd and even, at both of its ends
+    for (int power = 1; power <= INT_MAX / 10; power *= 10) {
+        for (int delta = -1; delta <= 1; delta++) {
+            ASSERT_TEST(formats_as_printf(power + delta), destroyFormatInt);
+            ASSERT_TEST(formats_as_printf(-(power + delta)), destroyFormatInt);
+            ASSERT_TEST(formats_as_printf(power * 10 + delta), destroyFormatInt);
+            ASSERT_TEST(formats_as_printf(-(power * 10 + delta)), destroyFormatInt);
+        }
+    }
+    for (int i = 0; i < RANDOM_VALUES; i++) {
+        unsigned int random = next_random(&seed);
+        // values of every length, not only the long ones most random ints have
+        ASSERT_TEST(formats_as_printf((int)random >> (random % 31)), destroyFormatInt);
+    }
+
+destroyFormatInt:
+    return result;
+}
+
+#define NUMBER_TESTS 4
+
+bool (*tests[]) (void) = {
+        testWriteChunks,
+        testWriteChunksFailure,
+        testWriteVectors,
+        testFormatInt
+};
+
+const char* testNames[] = {
+        "testWriteChunks",
+        "testWriteChunksFailure",
+        "testWriteVectors",
+        "testFormatInt"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: export_writer_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../member_set.h"
+#include "test_utilities.h"
+
+#define ARRAY_MAX 4096
+#define CONTAINER_RANGE 65536
+#define BITMAP_BYTES 8192
+
+/**
+* Counting_ctx: the allocations and frees made through a counting allocator,
+* and the size of the last allocation.
+*/
+typedef struct counting_ctx {
+    int allocs;
+    int frees;
+    size_t last_size;
+} Counting_ctx;
+
+static void* counting_alloc(size_t size, void* ctx)
+{
+    Counting_ctx* counts = ctx;
+    counts->allocs++;
+    counts->last_size = size;
+    return malloc(size);
+}
+
+static void counting_free(void* ptr, void* ctx)
+{
+    Counting_ctx* counts = ctx;
+    counts->frees++;
+    free(ptr);
+}
+
+/**
+* Order_ctx: the ids visited by memberSetForEach and whether they came in increasing order.
+*/
+typedef struct order_ctx {
+    int visited;
+    int last;
+    bool ordered;
+} Order_ctx;
+
+static bool check_order(int member_id, void* ctx)
+{
+    Order_ctx* order = ctx;
+    if (order->visited > 0 && member_id <= order->last) {
+        order->ordered = false;
+    }
+    order->last = member_id;
+    order->visited++;
+    return true;
+}
+
+/**
+* is_ordered: checks that a set visits as many ids as its size, in increasing order.
+*/
+static bool is_ordered(MemberSet set)
+{
+    Order_ctx order = {0, 0, true};
+    return memberSetForEach(set, check_order, &order) == MS_SUCCESS && order.ordered &&
+           order.visited == memberSetGetSize(set);
+}
+
+bool testMemberSetAddRemove() {
+    bool result = true;
+    MemberSet set = memberSetCreate();
+    ASSERT_TEST(set != NULL, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetGetSize(set) == 0, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetAdd(NULL, 1) == MS_NULL_ARGUMENT, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetAdd(set, -1) == MS_INVALID_ID, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetAdd(set, 7) == MS_SUCCESS, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetAdd(set, 7) == MS_ID_ALREADY_EXISTS, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetAdd(set, CONTAINER_RANGE + 7) == MS_SUCCESS, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetAdd(set, 3) == MS_SUCCESS, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetGetSize(set) == 3, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetContains(set, 7), destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetContains(set, CONTAINER_RANGE + 7), destroyMemberSetAddRemove);
+    ASSERT_TEST(!memberSetContains(set, 2 * CONTAINER_RANGE + 7), destroyMemberSetAddRemove);
+    ASSERT_TEST(is_ordered(set), destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetRemove(set, 8) == MS_ID_NOT_EXISTS, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetRemove(set, -8) == MS_ID_NOT_EXISTS, destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetRemove(set, CONTAINER_RANGE + 7) == MS_SUCCESS, destroyMemberSetAddRemove);
+    ASSERT_TEST(!memberSetContains(set, CONTAINER_RANGE + 7), destroyMemberSetAddRemove);
+    ASSERT_TEST(memberSetGetSize(set) == 2, destroyMemberSetAddRemove);
+
+destroyMemberSetAddRemove:
+    memberSetDestroy(set);
+    return result;
+}
+
+bool testMemberSetArrayToBitmap() {
+    bool result = true;
+    Counting_ctx counts = {0, 0, 0};
+    Allocator allocator = {counting_alloc, counting_free, &counts};
+    MemberSet set = memberSetCreateWithAllocator(&allocator);
+    ASSERT_TEST(set != NULL, destroyMemberSetArrayToBitmap);
+    // every other id, so the container is never full of consecutive ids
+    for (int i = 0; i < ARRAY_MAX; i++) {
+        ASSERT_TEST(memberSetAdd(set, 2 * i) == MS_SUCCESS, destroyMemberSetArrayToBitmap);
+    }
+    ASSERT_TEST(memberSetGetSize(set) == ARRAY_MAX, destroyMemberSetArrayToBitmap);
+    // a full array takes as much memory as a bitmap, one more id switches to the bitmap
+    ASSERT_TEST(counts.last_size == BITMAP_BYTES, destroyMemberSetArrayToBitmap);
+    int allocs = counts.allocs;
+    int frees = counts.frees;
+    ASSERT_TEST(memberSetAdd(set, 0) == MS_ID_ALREADY_EXISTS, destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(counts.allocs == allocs, destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(memberSetAdd(set, 1) == MS_SUCCESS, destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(counts.allocs == allocs + 1 && counts.frees == frees + 1, destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(counts.last_size == BITMAP_BYTES, destroyMemberSetArrayToBitmap);
+    // the bitmap takes every later id of its container without allocating
+    for (int i = 1; i < ARRAY_MAX; i++) {
+        ASSERT_TEST(memberSetAdd(set, 2 * i + 1) == MS_SUCCESS, destroyMemberSetArrayToBitmap);
+    }
+    ASSERT_TEST(counts.allocs == allocs + 1, destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(memberSetGetSize(set) == 2 * ARRAY_MAX, destroyMemberSetArrayToBitmap);
+    for (int id = 0; id < 2 * ARRAY_MAX; id++) {
+        ASSERT_TEST(memberSetContains(set, id), destroyMemberSetArrayToBitmap);
+    }
+    ASSERT_TEST(!memberSetContains(set, 2 * ARRAY_MAX), destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(is_ordered(set), destroyMemberSetArrayToBitmap);
+    // removing ids down to ARRAY_MAX switches back to an array
+    for (int i = 0; i < ARRAY_MAX - 1; i++) {
+        ASSERT_TEST(memberSetRemove(set, 2 * i + 1) == MS_SUCCESS, destroyMemberSetArrayToBitmap);
+    }
+    allocs = counts.allocs;
+    ASSERT_TEST(memberSetRemove(set, 2 * ARRAY_MAX - 1) == MS_SUCCESS, destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(counts.allocs == allocs + 1, destroyMemberSetArrayToBitmap);
+    ASSERT_TEST(memberSetGetSize(set) == ARRAY_MAX, destroyMemberSetArrayToBitmap);
+    for (int id = 0; id < 2 * ARRAY_MAX; id++) {
+        ASSERT_TEST(memberSetContains(set, id) == (id % 2 == 0), destroyMemberSetArrayToBitmap);
+    }
+    ASSERT_TEST(is_ordered(set), destroyMemberSetArrayToBitmap);
+
+destroyMemberSetArrayToBitmap:
+    memberSetDestroy(set);
+    ASSERT_TEST(counts.allocs == counts.frees, returnMemberSetArrayToBitmap);
+returnMemberSetArrayToBitmap:
+    return result;
+}
+
+bool testMemberSetUnionArrays() {
+    bool result = true;
+    MemberSet target = memberSetCreate();
+    MemberSet source = memberSetCreate();
+    ASSERT_TEST(target != NULL && source != NULL, destroyMemberSetUnionArrays);
+    ASSERT_TEST(memberSetUnion(NULL, source) == MS_NULL_ARGUMENT, destroyMemberSetUnionArrays);
+    ASSERT_TEST(memberSetUnion(target, NULL) == MS_NULL_ARGUMENT, destroyMemberSetUnionArrays);
+    for (int id = 0; id < 30; id += 3) {
+        ASSERT_TEST(memberSetAdd(target, id) == MS_SUCCESS, destroyMemberSetUnionArrays);
+    }
+    for (int id = 0; id < 30; id += 2) {
+        ASSERT_TEST(memberSetAdd(source, id) == MS_SUCCESS, destroyMemberSetUnionArrays);
+    }
+    ASSERT_TEST(memberSetAdd(source, 5 * CONTAINER_RANGE) == MS_SUCCESS, destroyMemberSetUnionArrays);
+    ASSERT_TEST(memberSetUnion(target, source) == MS_SUCCESS, destroyMemberSetUnionArrays);
+    for (int id = 0; id < 30; id++) {
+        ASSERT_TEST(memberSetContains(target, id) == (id % 2 == 0 || id % 3 == 0), destroyMemberSetUnionArrays);
+    }
+    ASSERT_TEST(memberSetContains(target, 5 * CONTAINER_RANGE), destroyMemberSetUnionArrays);
+    ASSERT_TEST(memberSetGetSize(target) == 21, destroyMemberSetUnionArrays);
+    ASSERT_TEST(memberSetGetSize(source) == 16, destroyMemberSetUnionArrays);
+    ASSERT_TEST(is_ordered(target), destroyMemberSetUnionArrays);
+    // a union with no new ids changes nothing
+    ASSERT_TEST(memberSetUnion(target, source) == MS_SUCCESS, destroyMemberSetUnionArrays);
+    ASSERT_TEST(memberSetGetSize(target) == 21, destroyMemberSetUnionArrays);
+
+destroyMemberSetUnionArrays:
+    memberSetDestroy(target);
+    memberSetDestroy(source);
+    return result;
+}
+
+bool testMemberSetUnionToBitmap() {
+    bool result = true;
+    MemberSet evens = memberSetCreate();
+    MemberSet odds = memberSetCreate();
+    MemberSet dense = NULL;
+    ASSERT_TEST(evens != NULL && odds != NULL, destroyMemberSetUnionToBitmap);
+    for (int i = 0; i < ARRAY_MAX / 2 + 1; i++) {
+        ASSERT_TEST(memberSetAdd(evens, 2 * i) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+        ASSERT_TEST(memberSetAdd(odds, 2 * i + 1) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    }
+    // two arrays whose union is larger than ARRAY_MAX make a bitmap
+    dense = memberSetCopy(evens);
+    ASSERT_TEST(dense != NULL, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetUnion(dense, odds) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetGetSize(dense) == ARRAY_MAX + 2, destroyMemberSetUnionToBitmap);
+    for (int id = 0; id < ARRAY_MAX + 2; id++) {
+        ASSERT_TEST(memberSetContains(dense, id), destroyMemberSetUnionToBitmap);
+    }
+    ASSERT_TEST(is_ordered(dense), destroyMemberSetUnionToBitmap);
+    // an array into a bitmap, and a bitmap into an array
+    ASSERT_TEST(memberSetAdd(odds, 3 * ARRAY_MAX + 1) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetUnion(dense, odds) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetGetSize(dense) == ARRAY_MAX + 3, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetContains(dense, 3 * ARRAY_MAX + 1), destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetAdd(evens, 4 * ARRAY_MAX) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetUnion(evens, dense) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetGetSize(evens) == ARRAY_MAX + 4, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetContains(evens, 4 * ARRAY_MAX), destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetContains(evens, 3 * ARRAY_MAX + 1), destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(is_ordered(evens), destroyMemberSetUnionToBitmap);
+    // the union of two bitmaps
+    ASSERT_TEST(memberSetAdd(dense, 5 * ARRAY_MAX) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetUnion(dense, evens) == MS_SUCCESS, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(memberSetGetSize(dense) == ARRAY_MAX + 5, destroyMemberSetUnionToBitmap);
+    ASSERT_TEST(is_ordered(dense), destroyMemberSetUnionToBitmap);
+
+destroyMemberSetUnionToBitmap:
+    memberSetDestroy(evens);
+    memberSetDestroy(odds);
+    memberSetDestroy(dense);
+    return result;
+}
+
+#define NUMBER_TESTS 4
+
+bool (*tests[]) (void) = {
+        testMemberSetAddRemove,
+        testMemberSetArrayToBitmap,
+        testMemberSetUnionArrays,
+        testMemberSetUnionToBitmap
+};
+
+const char* testNames[] = {
+        "testMemberSetAddRemove",
+        "testMemberSetArrayToBitmap",
+        "testMemberSetUnionArrays",
+        "testMemberSetUnionToBitmap"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: member_set_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
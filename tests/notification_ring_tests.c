@@ -0,0 +1,259 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "../notification_ring.h"
+#include "test_utilities.h"
+
+#define CONSUMERS 4
+#define PUBLISHED 200000
+#define RING_CAPACITY 64
+
+/**
+* make_notification: returns a notification of an added event with the given version.
+*/
+static Notification make_notification(long version)
+{
+    Notification notification={version,NOTIFY_EVENT_ADDED,(int)version,-1,1,1,2021};
+    return notification;
+}
+
+bool testNotificationRingCreateDestroy() {
+    bool result = true;
+    NotificationRing ring = NULL;
+    ASSERT_TEST(notificationRingCreate(4, NULL) == NR_NULL_ARGUMENT, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(notificationRingCreate(0, &ring) == NR_INVALID_CAPACITY, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(ring == NULL, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(notificationRingCreate(-4, &ring) == NR_INVALID_CAPACITY, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(notificationRingCreate(12, &ring) == NR_INVALID_CAPACITY, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(notificationRingCreate(1, &ring) == NR_SUCCESS, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(ring != NULL, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(notificationRingGetDropped(ring) == 0, destroyNotificationRingCreateDestroy);
+    ASSERT_TEST(notificationRingGetDropped(NULL) == -1, destroyNotificationRingCreateDestroy);
+
+destroyNotificationRingCreateDestroy:
+    notificationRingDestroy(ring);
+    return result;
+}
+
+bool testNotificationRingPublishConsume() {
+    bool result = true;
+    NotificationRing ring = NULL;
+    Notification notification = make_notification(1);
+    ASSERT_TEST(notificationRingCreate(4, &ring) == NR_SUCCESS, destroyNotificationRingPublishConsume);
+    ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_EMPTY, destroyNotificationRingPublishConsume);
+    ASSERT_TEST(notificationRingPublish(NULL, &notification) == NR_NULL_ARGUMENT, destroyNotificationRingPublishConsume);
+    ASSERT_TEST(notificationRingPublish(ring, NULL) == NR_NULL_ARGUMENT, destroyNotificationRingPublishConsume);
+    ASSERT_TEST(notificationRingConsume(ring, NULL) == NR_NULL_ARGUMENT, destroyNotificationRingPublishConsume);
+    for (long version = 1; version <= 3; version++) {
+        notification = make_notification(version);
+        ASSERT_TEST(notificationRingPublish(ring, &notification) == NR_SUCCESS, destroyNotificationRingPublishConsume);
+    }
+    for (long version = 1; version <= 3; version++) {
+        ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_SUCCESS, destroyNotificationRingPublishConsume);
+        ASSERT_TEST(notification.version == version, destroyNotificationRingPublishConsume);
+        ASSERT_TEST(notification.event_id == (int)version, destroyNotificationRingPublishConsume);
+        ASSERT_TEST(notification.kind == NOTIFY_EVENT_ADDED, destroyNotificationRingPublishConsume);
+    }
+    ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_EMPTY, destroyNotificationRingPublishConsume);
+    // the positions wrap around the ring many times
+    for (long version = 4; version <= 100; version++) {
+        notification = make_notification(version);
+        ASSERT_TEST(notificationRingPublish(ring, &notification) == NR_SUCCESS, destroyNotificationRingPublishConsume);
+        ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_SUCCESS, destroyNotificationRingPublishConsume);
+        ASSERT_TEST(notification.version == version, destroyNotificationRingPublishConsume);
+    }
+    ASSERT_TEST(notificationRingGetDropped(ring) == 0, destroyNotificationRingPublishConsume);
+
+destroyNotificationRingPublishConsume:
+    notificationRingDestroy(ring);
+    return result;
+}
+
+bool testNotificationRingFullDrops() {
+    bool result = true;
+    NotificationRing ring = NULL;
+    Notification notification;
+    ASSERT_TEST(notificationRingCreate(4, &ring) == NR_SUCCESS, destroyNotificationRingFullDrops);
+    for (long version = 1; version <= 4; version++) {
+        notification = make_notification(version);
+        ASSERT_TEST(notificationRingPublish(ring, &notification) == NR_SUCCESS, destroyNotificationRingFullDrops);
+    }
+    for (long version = 5; version <= 7; version++) {
+        notification = make_notification(version);
+        ASSERT_TEST(notificationRingPublish(ring, &notification) == NR_FULL, destroyNotificationRingFullDrops);
+        ASSERT_TEST(notificationRingGetDropped(ring) == version - 4, destroyNotificationRingFullDrops);
+    }
+    ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_SUCCESS, destroyNotificationRingFullDrops);
+    ASSERT_TEST(notification.version == 1, destroyNotificationRingFullDrops);
+    // a consumed cell is free again, and only that one
+    notification = make_notification(8);
+    ASSERT_TEST(notificationRingPublish(ring, &notification) == NR_SUCCESS, destroyNotificationRingFullDrops);
+    notification = make_notification(9);
+    ASSERT_TEST(notificationRingPublish(ring, &notification) == NR_FULL, destroyNotificationRingFullDrops);
+    ASSERT_TEST(notificationRingGetDropped(ring) == 4, destroyNotificationRingFullDrops);
+
+destroyNotificationRingFullDrops:
+    notificationRingDestroy(ring);
+    return result;
+}
+
+bool testNotificationRingVersionGaps() {
+    bool result = true;
+    NotificationRing ring = NULL;
+    Notification notification;
+    long expected[] = {1, 2, 3, 4, 8, 9};
+    ASSERT_TEST(notificationRingCreate(4, &ring) == NR_SUCCESS, destroyNotificationRingVersionGaps);
+    for (long version = 1; version <= 7; version++) {
+        notification = make_notification(version);
+        notificationRingPublish(ring, &notification);
+    }
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_SUCCESS, destroyNotificationRingVersionGaps);
+        ASSERT_TEST(notification.version == expected[i], destroyNotificationRingVersionGaps);
+    }
+    for (long version = 8; version <= 9; version++) {
+        notification = make_notification(version);
+        ASSERT_TEST(notificationRingPublish(ring, &notification) == NR_SUCCESS, destroyNotificationRingVersionGaps);
+    }
+    // the consumer sees the versions the full ring dropped as a gap
+    ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_SUCCESS, destroyNotificationRingVersionGaps);
+    ASSERT_TEST(notification.version == expected[4], destroyNotificationRingVersionGaps);
+    ASSERT_TEST(notification.version - expected[3] - 1 == notificationRingGetDropped(ring), destroyNotificationRingVersionGaps);
+    ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_SUCCESS, destroyNotificationRingVersionGaps);
+    ASSERT_TEST(notification.version == expected[5], destroyNotificationRingVersionGaps);
+    ASSERT_TEST(notificationRingConsume(ring, &notification) == NR_EMPTY, destroyNotificationRingVersionGaps);
+
+destroyNotificationRingVersionGaps:
+    notificationRingDestroy(ring);
+    return result;
+}
+
+/**
+* Consumer_ctx: a consumer thread, the ring and the versions it consumed.
+*/
+typedef struct consumer_ctx {
+    NotificationRing ring;
+    bool* published;
+    char* seen;
+    long consumed;
+} Consumer_ctx;
+
+static void* consume_all(void* arg)
+{
+    Consumer_ctx* ctx = arg;
+    Notification notification;
+    while (true) {
+        NotificationRingResult consumed = notificationRingConsume(ctx->ring, &notification);
+        if (consumed == NR_EMPTY) {
+            if (__atomic_load_n(ctx->published, __ATOMIC_ACQUIRE)) {
+                if (notificationRingConsume(ctx->ring, &notification) != NR_SUCCESS) {
+                    return NULL;
+                }
+            } else {
+                continue;
+            }
+        }
+        ctx->seen[notification.version]++;
+        ctx->consumed++;
+    }
+}
+
+bool testNotificationRingConcurrentConsumers() {
+    bool result = true;
+    NotificationRing ring = NULL;
+    bool published = false;
+    Consumer_ctx consumers[CONSUMERS];
+    pthread_t threads[CONSUMERS];
+    int started = 0;
+    for (int i = 0; i < CONSUMERS; i++) {
+        consumers[i].seen = NULL;
+    }
+    ASSERT_TEST(notificationRingCreate(RING_CAPACITY, &ring) == NR_SUCCESS, destroyNotificationRingConcurrentConsumers);
+    for (int i = 0; i < CONSUMERS; i++) {
+        consumers[i].ring = ring;
+        consumers[i].published = &published;
+        consumers[i].seen = calloc(PUBLISHED + 1, sizeof(*consumers[i].seen));
+        consumers[i].consumed = 0;
+        ASSERT_TEST(consumers[i].seen != NULL, destroyNotificationRingConcurrentConsumers);
+    }
+    for (; started < CONSUMERS; started++) {
+        ASSERT_TEST(pthread_create(&threads[started], NULL, consume_all, &consumers[started]) == 0,
+                    destroyNotificationRingConcurrentConsumers);
+    }
+    long published_num = 0;
+    for (long version = 1; version <= PUBLISHED; version++) {
+        Notification notification = make_notification(version);
+        if (notificationRingPublish(ring, &notification) == NR_SUCCESS) {
+            published_num++;
+        }
+    }
+    __atomic_store_n(&published, true, __ATOMIC_RELEASE);
+    for (; started > 0; started--) {
+        pthread_join(threads[started - 1], NULL);
+    }
+    long consumed = 0;
+    for (int i = 0; i < CONSUMERS; i++) {
+        consumed += consumers[i].consumed;
+    }
+    ASSERT_TEST(consumed == published_num, destroyNotificationRingConcurrentConsumers);
+    ASSERT_TEST(published_num + notificationRingGetDropped(ring) == PUBLISHED, destroyNotificationRingConcurrentConsumers);
+    // every published notification is consumed by exactly one consumer
+    for (long version = 1; version <= PUBLISHED; version++) {
+        int seen = 0;
+        for (int i = 0; i < CONSUMERS; i++) {
+            seen += consumers[i].seen[version];
+        }
+        ASSERT_TEST(seen <= 1, destroyNotificationRingConcurrentConsumers);
+    }
+
+destroyNotificationRingConcurrentConsumers:
+    __atomic_store_n(&published, true, __ATOMIC_RELEASE);
+    for (; started > 0; started--) {
+        pthread_join(threads[started - 1], NULL);
+    }
+    for (int i = 0; i < CONSUMERS; i++) {
+        free(consumers[i].seen);
+    }
+    notificationRingDestroy(ring);
+    return result;
+}
+
+#define NUMBER_TESTS 5
+
+bool (*tests[]) (void) = {
+        testNotificationRingCreateDestroy,
+        testNotificationRingPublishConsume,
+        testNotificationRingFullDrops,
+        testNotificationRingVersionGaps,
+        testNotificationRingConcurrentConsumers
+};
+
+const char* testNames[] = {
+        "testNotificationRingCreateDestroy",
+        "testNotificationRingPublishConsume",
+        "testNotificationRingFullDrops",
+        "testNotificationRingVersionGaps",
+        "testNotificationRingConcurrentConsumers"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: notification_ring_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,361 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../priority_queue_ext.h"
+#include "test_utilities.h"
+
+#define SMALL_SIZE 5
+#define LARGE_SIZE (3 * PQ_PARALLEL_COPY_MIN_SIZE + 17)
+#define ARENA_VALUES (4 * LARGE_SIZE)
+#define CLEAR_ROUNDS 3
+#define WORKERS 4
+#define TOP_K 3
+
+static bool fail_copies = false;
+static int arena_values[ARENA_VALUES];
+static int arena_used = 0;
+
+static PQElement copy_int(PQElement element) {
+    if (fail_copies) {
+        return NULL;
+    }
+    int* copy = malloc(sizeof(*copy));
+    if (copy != NULL) {
+        *copy = *(int*)element;
+    }
+    return copy;
+}
+
+static void free_int(PQElement element) {
+    free(element);
+}
+
+static bool equal_ints(PQElement element1, PQElement element2) {
+    return *(int*)element1 == *(int*)element2;
+}
+
+static int compare_ints(PQElementPriority priority1, PQElementPriority priority2) {
+    return *(int*)priority1 - *(int*)priority2;
+}
+
+/**
+* copy_to_arena: copies an int into the arena of the test, which the queues never free.
+*/
+static PQElement copy_to_arena(PQElement element) {
+    if (arena_used == ARENA_VALUES) {
+        return NULL;
+    }
+    arena_values[arena_used] = *(int*)element;
+    return &arena_values[arena_used++];
+}
+
+static int* make_int(int value) {
+    int* result = malloc(sizeof(*result));
+    if (result != NULL) {
+        *result = value;
+    }
+    return result;
+}
+
+static PriorityQueue create_int_queue() {
+    return pqCreate(copy_int, free_int, equal_ints, copy_int, free_int, compare_ints);
+}
+
+/**
+* has_order: checks that the elements of a queue are the given ints, in order.
+*/
+static bool has_order(PriorityQueue queue, const int* expected, int size) {
+    if (pqGetSize(queue) != size) {
+        return false;
+    }
+    int i = 0;
+    PQ_FOREACH(int*, element, queue) {
+        if (i == size || *element != expected[i]) {
+            return false;
+        }
+        i++;
+    }
+    return i == size;
+}
+
+/**
+* same_queues: checks that two queues hold the same elements with the same
+* priorities in the same order.
+*/
+static bool same_queues(PriorityQueue queue1, PriorityQueue queue2) {
+    int size = pqGetSize(queue1);
+    if (size != pqGetSize(queue2)) {
+        return false;
+    }
+    PQElement* elements1 = malloc(sizeof(*elements1) * size);
+    PQElement* elements2 = malloc(sizeof(*elements2) * size);
+    PQElementPriority* priorities1 = malloc(sizeof(*priorities1) * size);
+    PQElementPriority* priorities2 = malloc(sizeof(*priorities2) * size);
+    bool same = elements1 != NULL && elements2 != NULL && priorities1 != NULL && priorities2 != NULL &&
+                pqPeekTopK(queue1, size, elements1, priorities1) == size &&
+                pqPeekTopK(queue2, size, elements2, priorities2) == size;
+    for (int i = 0; same && i < size; i++) {
+        same = elements1[i] != elements2[i] && *(int*)elements1[i] == *(int*)elements2[i] &&
+               priorities1[i] != priorities2[i] && *(int*)priorities1[i] == *(int*)priorities2[i];
+    }
+    free(elements1);
+    free(elements2);
+    free(priorities1);
+    free(priorities2);
+    return same;
+}
+
+bool testPQChangePriority() {
+    bool result = true;
+    PriorityQueue queue = create_int_queue();
+    int elements[SMALL_SIZE] = {10, 20, 30, 40, 50};
+    int priorities[SMALL_SIZE] = {5, 4, 4, 2, 1};
+    int low = 0, high = 9, same = 4, missing = 7;
+    ASSERT_TEST(queue != NULL, destroyPQChangePriority);
+    for (int i = 0; i < SMALL_SIZE; i++) {
+        ASSERT_TEST(pqInsert(queue, &elements[i], &priorities[i]) == PQ_SUCCESS, destroyPQChangePriority);
+    }
+    ASSERT_TEST(pqChangePriority(queue, &missing, &priorities[0], &low) == PQ_ELEMENT_DOES_NOT_EXISTS,
+                destroyPQChangePriority);
+    ASSERT_TEST(pqChangePriority(queue, &elements[0], &priorities[1], &low) == PQ_ELEMENT_DOES_NOT_EXISTS,
+                destroyPQChangePriority);
+    ASSERT_TEST(pqChangePriority(queue, &elements[4], &priorities[4], &high) == PQ_SUCCESS, destroyPQChangePriority);
+    ASSERT_TEST(has_order(queue, (int[]){50, 10, 20, 30, 40}, SMALL_SIZE), destroyPQChangePriority);
+    ASSERT_TEST(pqChangePriority(queue, &elements[0], &priorities[0], &low) == PQ_SUCCESS, destroyPQChangePriority);
+    ASSERT_TEST(has_order(queue, (int[]){50, 20, 30, 40, 10}, SMALL_SIZE), destroyPQChangePriority);
+    // an element moved to a priority goes behind the elements that already have it
+    ASSERT_TEST(pqChangePriority(queue, &elements[1], &priorities[1], &same) == PQ_SUCCESS, destroyPQChangePriority);
+    ASSERT_TEST(has_order(queue, (int[]){50, 30, 20, 40, 10}, SMALL_SIZE), destroyPQChangePriority);
+    // a priority that cannot be copied leaves the queue as it was
+    fail_copies = true;
+    ASSERT_TEST(pqChangePriority(queue, &elements[3], &priorities[3], &high) == PQ_OUT_OF_MEMORY,
+                destroyPQChangePriority);
+    fail_copies = false;
+    ASSERT_TEST(has_order(queue, (int[]){50, 30, 20, 40, 10}, SMALL_SIZE), destroyPQChangePriority);
+    ASSERT_TEST(pqChangePriority(queue, &elements[3], &priorities[3], &high) == PQ_SUCCESS, destroyPQChangePriority);
+    ASSERT_TEST(has_order(queue, (int[]){50, 40, 30, 20, 10}, SMALL_SIZE), destroyPQChangePriority);
+    for (int i = 0; i < SMALL_SIZE - 1; i++) {
+        ASSERT_TEST(pqRemove(queue) == PQ_SUCCESS, destroyPQChangePriority);
+    }
+    ASSERT_TEST(pqChangePriority(queue, &elements[0], &low, &high) == PQ_SUCCESS, destroyPQChangePriority);
+    ASSERT_TEST(has_order(queue, (int[]){10}, 1), destroyPQChangePriority);
+
+destroyPQChangePriority:
+    fail_copies = false;
+    pqDestroy(queue);
+    return result;
+}
+
+bool testPQOwnershipTransfer() {
+    bool result = true;
+    PriorityQueue queue = create_int_queue();
+    int* element = NULL;
+    int* priority = NULL;
+    int shared_priority = 3;
+    ASSERT_TEST(queue != NULL, destroyPQOwnershipTransfer);
+    ASSERT_TEST(pqInsertTake(NULL, &shared_priority, &shared_priority) == PQ_NULL_ARGUMENT, destroyPQOwnershipTransfer);
+    ASSERT_TEST(pqPushMove(queue, NULL, &shared_priority) == PQ_NULL_ARGUMENT, destroyPQOwnershipTransfer);
+    ASSERT_TEST(pqPopTake(queue, (PQElement*)&element, (PQElementPriority*)&priority) == PQ_ELEMENT_DOES_NOT_EXISTS,
+                destroyPQOwnershipTransfer);
+    // the queue owns what it takes, and frees it itself
+    for (int i = 0; i < SMALL_SIZE; i++) {
+        element = make_int(i);
+        priority = make_int(i % 2);
+        ASSERT_TEST(element != NULL && priority != NULL, destroyPQOwnershipTransfer);
+        ASSERT_TEST(pqInsertTake(queue, element, priority) == PQ_SUCCESS, destroyPQOwnershipTransfer);
+        priority = NULL;
+        element = make_int(10 + i);
+        ASSERT_TEST(element != NULL, destroyPQOwnershipTransfer);
+        ASSERT_TEST(pqPushMove(queue, element, &shared_priority) == PQ_SUCCESS, destroyPQOwnershipTransfer);
+    }
+    element = NULL;
+    priority = NULL;
+    ASSERT_TEST(has_order(queue, (int[]){10, 11, 12, 13, 14, 1, 3, 0, 2, 4}, 2 * SMALL_SIZE),
+                destroyPQOwnershipTransfer);
+    // what the queue hands back belongs to the caller
+    ASSERT_TEST(pqPopTake(queue, (PQElement*)&element, (PQElementPriority*)&priority) == PQ_SUCCESS,
+                destroyPQOwnershipTransfer);
+    ASSERT_TEST(*element == 10 && *priority == shared_priority && priority != &shared_priority,
+                destroyPQOwnershipTransfer);
+    free(element);
+    free(priority);
+    element = NULL;
+    priority = NULL;
+    ASSERT_TEST(pqPopTake(queue, (PQElement*)&element, NULL) == PQ_SUCCESS && *element == 11,
+                destroyPQOwnershipTransfer);
+    free(element);
+    element = NULL;
+    ASSERT_TEST(pqPopTake(queue, NULL, (PQElementPriority*)&priority) == PQ_SUCCESS && *priority == shared_priority,
+                destroyPQOwnershipTransfer);
+    free(priority);
+    priority = NULL;
+    ASSERT_TEST(pqPopTake(queue, NULL, NULL) == PQ_SUCCESS, destroyPQOwnershipTransfer);
+    ASSERT_TEST(has_order(queue, (int[]){14, 1, 3, 0, 2, 4}, SMALL_SIZE + 1), destroyPQOwnershipTransfer);
+
+destroyPQOwnershipTransfer:
+    free(element);
+    free(priority);
+    pqDestroy(queue);
+    return result;
+}
+
+bool testPQArena() {
+    bool result = true;
+    PriorityQueue queue = pqCreateArena(copy_int, free_int, equal_ints, copy_int, free_int, compare_ints,
+                                        PQ_ARENA_OWNS_NOTHING);
+    PriorityQueue owned = NULL;
+    PriorityQueue priorities_owned = NULL;
+    ASSERT_TEST(queue != NULL, destroyPQArena);
+    ASSERT_TEST(pqCreateArena(copy_int, NULL, equal_ints, copy_int, free_int, compare_ints,
+                              PQ_ARENA_OWNS_PRIORITIES) == NULL, destroyPQArena);
+    // every round fills more than one slab, removes part of it and clears the rest,
+    // so the next round reuses the slabs and the removed nodes
+    for (int round = 0; round < CLEAR_ROUNDS; round++) {
+        for (int i = 0; i < LARGE_SIZE; i++) {
+            int priority = (i * 7919) % LARGE_SIZE;
+            ASSERT_TEST(pqInsert(queue, &i, &priority) == PQ_SUCCESS, destroyPQArena);
+        }
+        ASSERT_TEST(pqGetSize(queue) == LARGE_SIZE, destroyPQArena);
+        int previous = LARGE_SIZE;
+        for (int i = 0; i < LARGE_SIZE / 2; i++) {
+            int* first = pqGetFirst(queue);
+            ASSERT_TEST(first != NULL && (*first * 7919) % LARGE_SIZE < previous, destroyPQArena);
+            previous = (*first * 7919) % LARGE_SIZE;
+            ASSERT_TEST(pqRemove(queue) == PQ_SUCCESS, destroyPQArena);
+        }
+        ASSERT_TEST(pqClear(queue) == PQ_SUCCESS && pqGetSize(queue) == 0, destroyPQArena);
+        ASSERT_TEST(pqGetFirst(queue) == NULL, destroyPQArena);
+    }
+    // values owned by an arena of the caller are never freed by the queue
+    owned = pqCreateArena(copy_to_arena, NULL, equal_ints, copy_to_arena, NULL, compare_ints,
+                          PQ_ARENA_OWNS_ELEMENTS | PQ_ARENA_OWNS_PRIORITIES);
+    priorities_owned = pqCreateArena(copy_int, free_int, equal_ints, copy_to_arena, NULL, compare_ints,
+                                     PQ_ARENA_OWNS_PRIORITIES);
+    ASSERT_TEST(owned != NULL && priorities_owned != NULL, destroyPQArena);
+    for (int round = 0; round < CLEAR_ROUNDS; round++) {
+        arena_used = 0;
+        for (int i = 0; i < SMALL_SIZE; i++) {
+            int priority = i % 2;
+            ASSERT_TEST(pqInsert(owned, &i, &priority) == PQ_SUCCESS, destroyPQArena);
+            ASSERT_TEST(pqInsert(priorities_owned, &i, &priority) == PQ_SUCCESS, destroyPQArena);
+        }
+        ASSERT_TEST(has_order(owned, (int[]){1, 3, 0, 2, 4}, SMALL_SIZE), destroyPQArena);
+        ASSERT_TEST(has_order(priorities_owned, (int[]){1, 3, 0, 2, 4}, SMALL_SIZE), destroyPQArena);
+        ASSERT_TEST(pqRemove(owned) == PQ_SUCCESS && pqRemove(priorities_owned) == PQ_SUCCESS, destroyPQArena);
+        ASSERT_TEST(pqClear(owned) == PQ_SUCCESS && pqClear(priorities_owned) == PQ_SUCCESS, destroyPQArena);
+    }
+    ASSERT_TEST(pqInsert(owned, &arena_values[0], &arena_values[1]) == PQ_SUCCESS, destroyPQArena);
+
+destroyPQArena:
+    pqDestroy(queue);
+    pqDestroy(owned);
+    pqDestroy(priorities_owned);
+    return result;
+}
+
+bool testPQCopyWithWorkers() {
+    bool result = true;
+    PriorityQueue queue = create_int_queue();
+    PriorityQueue single = NULL;
+    PriorityQueue parallel = NULL;
+    ASSERT_TEST(queue != NULL, destroyPQCopyWithWorkers);
+    ASSERT_TEST(pqCopyWithWorkers(NULL, WORKERS) == NULL, destroyPQCopyWithWorkers);
+    // many equal priorities, so the copies must keep the insertion order too
+    for (int i = 0; i < LARGE_SIZE; i++) {
+        int priority = (i * 31) % 100;
+        ASSERT_TEST(pqInsert(queue, &i, &priority) == PQ_SUCCESS, destroyPQCopyWithWorkers);
+    }
+    single = pqCopyWithWorkers(queue, 1);
+    parallel = pqCopyWithWorkers(queue, WORKERS);
+    ASSERT_TEST(single != NULL && parallel != NULL, destroyPQCopyWithWorkers);
+    ASSERT_TEST(same_queues(queue, single), destroyPQCopyWithWorkers);
+    ASSERT_TEST(same_queues(single, parallel), destroyPQCopyWithWorkers);
+    // a copy made with workers orders new elements as its source would
+    int element = -1, priority = 50;
+    ASSERT_TEST(pqInsert(queue, &element, &priority) == PQ_SUCCESS, destroyPQCopyWithWorkers);
+    ASSERT_TEST(pqInsert(parallel, &element, &priority) == PQ_SUCCESS, destroyPQCopyWithWorkers);
+    ASSERT_TEST(same_queues(queue, parallel), destroyPQCopyWithWorkers);
+    ASSERT_TEST(pqGetSize(single) == LARGE_SIZE, destroyPQCopyWithWorkers);
+    // a failed copy on the workers leaves nothing behind
+    pqDestroy(parallel);
+    fail_copies = true;
+    parallel = pqCopyWithWorkers(queue, WORKERS);
+    fail_copies = false;
+    ASSERT_TEST(parallel == NULL, destroyPQCopyWithWorkers);
+
+destroyPQCopyWithWorkers:
+    fail_copies = false;
+    pqDestroy(queue);
+    pqDestroy(single);
+    pqDestroy(parallel);
+    return result;
+}
+
+bool testPQPeekTopK() {
+    bool result = true;
+    PriorityQueue queue = create_int_queue();
+    PQElement elements[SMALL_SIZE + 1];
+    PQElementPriority priorities[SMALL_SIZE + 1];
+    ASSERT_TEST(queue != NULL, destroyPQPeekTopK);
+    ASSERT_TEST(pqPeekTopK(NULL, 1, elements, NULL) == -1, destroyPQPeekTopK);
+    ASSERT_TEST(pqPeekTopK(queue, 1, NULL, NULL) == -1, destroyPQPeekTopK);
+    ASSERT_TEST(pqPeekTopK(queue, -1, elements, NULL) == -1, destroyPQPeekTopK);
+    ASSERT_TEST(pqPeekTopK(queue, TOP_K, elements, priorities) == 0, destroyPQPeekTopK);
+    for (int i = 0; i < SMALL_SIZE; i++) {
+        int priority = i % 2;
+        ASSERT_TEST(pqInsert(queue, &i, &priority) == PQ_SUCCESS, destroyPQPeekTopK);
+    }
+    ASSERT_TEST(pqPeekTopK(queue, 0, NULL, NULL) == 0, destroyPQPeekTopK);
+    // the iterator stays where it was
+    ASSERT_TEST(*(int*)pqGetFirst(queue) == 1, destroyPQPeekTopK);
+    ASSERT_TEST(pqPeekTopK(queue, TOP_K, elements, priorities) == TOP_K, destroyPQPeekTopK);
+    ASSERT_TEST(*(int*)elements[0] == 1 && *(int*)elements[1] == 3 && *(int*)elements[2] == 0, destroyPQPeekTopK);
+    ASSERT_TEST(*(int*)priorities[0] == 1 && *(int*)priorities[2] == 0, destroyPQPeekTopK);
+    ASSERT_TEST(*(int*)pqGetNext(queue) == 3, destroyPQPeekTopK);
+    ASSERT_TEST(pqPeekTopK(queue, SMALL_SIZE + 1, elements, NULL) == SMALL_SIZE, destroyPQPeekTopK);
+    ASSERT_TEST(*(int*)elements[SMALL_SIZE - 1] == 4, destroyPQPeekTopK);
+    ASSERT_TEST(*(int*)pqGetNext(queue) == 0, destroyPQPeekTopK);
+
+destroyPQPeekTopK:
+    pqDestroy(queue);
+    return result;
+}
+
+#define NUMBER_TESTS 5
+
+bool (*tests[]) (void) = {
+        testPQChangePriority,
+        testPQOwnershipTransfer,
+        testPQArena,
+        testPQCopyWithWorkers,
+        testPQPeekTopK
+};
+
+const char* testNames[] = {
+        "testPQChangePriority",
+        "testPQOwnershipTransfer",
+        "testPQArena",
+        "testPQCopyWithWorkers",
+        "testPQPeekTopK"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: priority_queue_ext_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
@@ -0,0 +1,361 @@
+#define _POSIX_C_SOURCE 200112L
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../event_manager_ext.h"
+#include "../schedule_file.h"
+#include "test_utilities.h"
+
+#define SCHEDULE_FILE "schedule_file_tests_schedule.bin"
+#define BROKEN_FILE "schedule_file_tests_broken.bin"
+#define MAX_FILE_SIZE 4096
+#define HEADER_SIZE (6 * sizeof(uint32_t))
+#define MAGIC_WORD 0
+#define VERSION_WORD 1
+#define STRINGS_SECTION 0
+#define EVENT_IDS_SECTION 1
+#define EVENT_NAMES_SECTION 2
+#define EVENT_LINK_OFFSETS_SECTION 9
+#define MEMBER_LINKS_SECTION 10
+
+/**
+* create_schedule: creates an event manager starting at 1.1.2021 with three
+* members and three events:
+*   meet on 1.1.2021 (id 7) with bob,
+*   party on 3.1.2021 (id 100) with bob and alice,
+*   talk on 3.1.2021 (id 8) with nobody.
+*/
+static EventManager create_schedule()
+{
+    Date date = dateCreate(1, 1, 2021);
+    EventManager em = createEventManager(date);
+    dateDestroy(date);
+    if (em == NULL) {
+        return NULL;
+    }
+    if (emAddMember(em, "alice", 12) != EM_SUCCESS || emAddMember(em, "bob", 3) != EM_SUCCESS ||
+        emAddMember(em, "carol", 40) != EM_SUCCESS || emAddEventByDiff(em, "party", 2, 100) != EM_SUCCESS ||
+        emAddEventByDiff(em, "meet", 0, 7) != EM_SUCCESS || emAddEventByDiff(em, "talk", 2, 8) != EM_SUCCESS ||
+        emAddMemberToEvent(em, 12, 100) != EM_SUCCESS || emAddMemberToEvent(em, 3, 100) != EM_SUCCESS ||
+        emAddMemberToEvent(em, 3, 7) != EM_SUCCESS) {
+        destroyEventManager(em);
+        return NULL;
+    }
+    return em;
+}
+
+/**
+* export_schedule: writes the schedule of create_schedule to SCHEDULE_FILE
+* with emExportBinary.
+*/
+static bool export_schedule()
+{
+    EventManager em = create_schedule();
+    if (em == NULL) {
+        return false;
+    }
+    int fd = open(SCHEDULE_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    bool exported = fd >= 0 && emExportBinary(em, fd) == EM_SUCCESS;
+    if (fd >= 0) {
+        exported = close(fd) == 0 && exported;
+    }
+    destroyEventManager(em);
+    return exported;
+}
+
+/**
+* read_bytes: reads a whole file into data and returns its size, or 0 if it
+* could not be read.
+*/
+static size_t read_bytes(const char* file_name, unsigned char* data)
+{
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t size = read(fd, data, MAX_FILE_SIZE);
+    close(fd);
+    return size < 0 ? 0 : (size_t)size;
+}
+
+/**
+* write_bytes: writes data as the whole content of a file.
+*/
+static bool write_bytes(const char* file_name, const unsigned char* data, size_t size)
+{
+    int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    bool written = write(fd, data, size) == (ssize_t)size;
+    return close(fd) == 0 && written;
+}
+
+/**
+* section_position: returns the position of the length word of a section,
+* following the lengths of the sections before it.
+*/
+static size_t section_position(const unsigned char* data, int section)
+{
+    size_t position = HEADER_SIZE;
+    for (int i = 0; i < section; i++) {
+        uint32_t length;
+        memcpy(&length, data + position, sizeof(length));
+        position += sizeof(length) + length + (4 - length % 4) % 4;
+    }
+    return position;
+}
+
+/**
+* set_word: overwrites the word at a position.
+*/
+static void set_word(unsigned char* data, size_t position, uint32_t value)
+{
+    memcpy(data + position, &value, sizeof(value));
+}
+
+/**
+* is_rejected: checks that both scheduleFileRead and scheduleFileMap reject
+* the given data as a bad format and return no file.
+*/
+static bool is_rejected(const unsigned char* data, size_t size)
+{
+    if (!write_bytes(BROKEN_FILE, data, size)) {
+        return false;
+    }
+    ScheduleFile file = NULL;
+    int fd = open(BROKEN_FILE, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    ScheduleFileResult read_result = scheduleFileRead(fd, &file);
+    close(fd);
+    if (read_result != SF_BAD_FORMAT || file != NULL) {
+        scheduleFileDestroy(file);
+        return false;
+    }
+    ScheduleFileResult map_result = scheduleFileMap(BROKEN_FILE, &file);
+    if (map_result != SF_BAD_FORMAT || file != NULL) {
+        scheduleFileDestroy(file);
+        return false;
+    }
+    return true;
+}
+
+/**
+* has_schedule_columns: checks that columns hold the schedule of
+* create_schedule, the events in the order of emPrintAllEvents and the
+* members ordered by id.
+*/
+static bool has_schedule_columns(const ScheduleColumns* columns)
+{
+    static const int32_t event_ids[] = {7, 100, 8};
+    static const char* event_names[] = {"meet", "party", "talk"};
+    static const int32_t event_days[] = {1, 3, 3};
+    static const uint32_t event_link_offsets[] = {0, 1, 3, 3};
+    static const int32_t member_ids[] = {3, 12, 40};
+    static const char* member_names[] = {"bob", "alice", "carol"};
+    static const int32_t member_counters[] = {2, 1, 0};
+    static const uint32_t member_links[] = {0, 0, 1};
+    if (columns == NULL || columns->events_num != 3 || columns->members_num != 3 || columns->links_num != 3) {
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (columns->event_ids[i] != event_ids[i] ||
+            strcmp(columns->strings + columns->event_names[i], event_names[i]) != 0 ||
+            columns->event_days[i] != event_days[i] || columns->event_months[i] != 1 ||
+            columns->event_years[i] != 2021 || columns->member_ids[i] != member_ids[i] ||
+            strcmp(columns->strings + columns->member_names[i], member_names[i]) != 0 ||
+            columns->member_counters[i] != member_counters[i] || columns->member_links[i] != member_links[i]) {
+            return false;
+        }
+    }
+    return memcmp(columns->event_link_offsets, event_link_offsets, sizeof(event_link_offsets)) == 0;
+}
+
+bool testReadExportedSchedule() {
+    bool result = true;
+    ScheduleFile file = NULL;
+    int fd = -1;
+    ASSERT_TEST(export_schedule(), destroyReadExportedSchedule);
+    fd = open(SCHEDULE_FILE, O_RDONLY);
+    ASSERT_TEST(fd >= 0, destroyReadExportedSchedule);
+    ASSERT_TEST(scheduleFileRead(fd, &file) == SF_SUCCESS, destroyReadExportedSchedule);
+    ASSERT_TEST(has_schedule_columns(scheduleFileGetColumns(file)), destroyReadExportedSchedule);
+    ASSERT_TEST(scheduleFileRead(fd, NULL) == SF_NULL_ARGUMENT, destroyReadExportedSchedule);
+
+destroyReadExportedSchedule:
+    if (fd >= 0) {
+        close(fd);
+    }
+    scheduleFileDestroy(file);
+    remove(SCHEDULE_FILE);
+    return result;
+}
+
+bool testMapExportedSchedule() {
+    bool result = true;
+    ScheduleFile file = NULL;
+    ScheduleFile missing = NULL;
+    remove(BROKEN_FILE);
+    ASSERT_TEST(export_schedule(), destroyMapExportedSchedule);
+    ASSERT_TEST(scheduleFileMap(SCHEDULE_FILE, &file) == SF_SUCCESS, destroyMapExportedSchedule);
+    ASSERT_TEST(has_schedule_columns(scheduleFileGetColumns(file)), destroyMapExportedSchedule);
+    ASSERT_TEST(scheduleFileMap(NULL, &missing) == SF_NULL_ARGUMENT, destroyMapExportedSchedule);
+    ASSERT_TEST(scheduleFileMap(BROKEN_FILE, &missing) == SF_IO_ERROR && missing == NULL, destroyMapExportedSchedule);
+
+destroyMapExportedSchedule:
+    scheduleFileDestroy(file);
+    remove(SCHEDULE_FILE);
+    return result;
+}
+
+bool testRejectTruncatedFile() {
+    bool result = true;
+    unsigned char data[MAX_FILE_SIZE];
+    size_t size = 0;
+    ASSERT_TEST(export_schedule(), destroyRejectTruncatedFile);
+    size = read_bytes(SCHEDULE_FILE, data);
+    ASSERT_TEST(size > HEADER_SIZE, destroyRejectTruncatedFile);
+    // every proper prefix cuts the last section, which holds the links
+    for (size_t length = 0; length < size; length++) {
+        ASSERT_TEST(is_rejected(data, length), destroyRejectTruncatedFile);
+    }
+
+destroyRejectTruncatedFile:
+    remove(SCHEDULE_FILE);
+    remove(BROKEN_FILE);
+    return result;
+}
+
+bool testRejectBadHeader() {
+    bool result = true;
+    unsigned char data[MAX_FILE_SIZE];
+    size_t size = 0;
+    ASSERT_TEST(export_schedule(), destroyRejectBadHeader);
+    size = read_bytes(SCHEDULE_FILE, data);
+    ASSERT_TEST(size > HEADER_SIZE, destroyRejectBadHeader);
+    set_word(data, MAGIC_WORD * sizeof(uint32_t), 0x454D5342u);
+    ASSERT_TEST(is_rejected(data, size), destroyRejectBadHeader);
+    set_word(data, MAGIC_WORD * sizeof(uint32_t), SCHEDULE_FILE_MAGIC);
+    set_word(data, VERSION_WORD * sizeof(uint32_t), SCHEDULE_FILE_VERSION + 1);
+    ASSERT_TEST(is_rejected(data, size), destroyRejectBadHeader);
+
+destroyRejectBadHeader:
+    remove(SCHEDULE_FILE);
+    remove(BROKEN_FILE);
+    return result;
+}
+
+bool testRejectBadSectionLength() {
+    bool result = true;
+    unsigned char data[MAX_FILE_SIZE];
+    size_t size = 0;
+    size_t position = 0;
+    ASSERT_TEST(export_schedule(), destroyRejectBadSectionLength);
+    size = read_bytes(SCHEDULE_FILE, data);
+    ASSERT_TEST(size > HEADER_SIZE, destroyRejectBadSectionLength);
+    // the event ids section claims one more event than the header
+    position = section_position(data, EVENT_IDS_SECTION);
+    set_word(data, position, 4 * sizeof(uint32_t));
+    ASSERT_TEST(is_rejected(data, size), destroyRejectBadSectionLength);
+    // and one less
+    set_word(data, position, 2 * sizeof(uint32_t));
+    ASSERT_TEST(is_rejected(data, size), destroyRejectBadSectionLength);
+
+destroyRejectBadSectionLength:
+    remove(SCHEDULE_FILE);
+    remove(BROKEN_FILE);
+    return result;
+}
+
+bool testRejectOutOfRangeColumns() {
+    bool result = true;
+    unsigned char data[MAX_FILE_SIZE];
+    unsigned char broken[MAX_FILE_SIZE];
+    size_t size = 0;
+    uint32_t strings_size = 0;
+    size_t names = 0;
+    size_t offsets = 0;
+    size_t links = 0;
+    ASSERT_TEST(export_schedule(), destroyRejectOutOfRangeColumns);
+    size = read_bytes(SCHEDULE_FILE, data);
+    ASSERT_TEST(size > HEADER_SIZE, destroyRejectOutOfRangeColumns);
+    memcpy(&strings_size, data + section_position(data, STRINGS_SECTION), sizeof(strings_size));
+    names = section_position(data, EVENT_NAMES_SECTION) + sizeof(uint32_t);
+    offsets = section_position(data, EVENT_LINK_OFFSETS_SECTION) + sizeof(uint32_t);
+    links = section_position(data, MEMBER_LINKS_SECTION) + sizeof(uint32_t);
+    // a name that starts past the string table
+    memcpy(broken, data, size);
+    set_word(broken, names + sizeof(uint32_t), strings_size);
+    ASSERT_TEST(is_rejected(broken, size), destroyRejectOutOfRangeColumns);
+    // a link to a member that does not exist
+    memcpy(broken, data, size);
+    set_word(broken, links, 3);
+    ASSERT_TEST(is_rejected(broken, size), destroyRejectOutOfRangeColumns);
+    // link offsets 0,2,1,3 that go back between the second and the third event
+    memcpy(broken, data, size);
+    set_word(broken, offsets + sizeof(uint32_t), 2);
+    set_word(broken, offsets + 2 * sizeof(uint32_t), 1);
+    ASSERT_TEST(is_rejected(broken, size), destroyRejectOutOfRangeColumns);
+    // link offsets that do not end at the number of links
+    memcpy(broken, data, size);
+    set_word(broken, offsets + 3 * sizeof(uint32_t), 2);
+    ASSERT_TEST(is_rejected(broken, size), destroyRejectOutOfRangeColumns);
+    // a string table whose last name is not terminated
+    memcpy(broken, data, size);
+    broken[section_position(data, STRINGS_SECTION) + sizeof(uint32_t) + strings_size - 1] = 'x';
+    ASSERT_TEST(is_rejected(broken, size), destroyRejectOutOfRangeColumns);
+    // the unchanged file is still accepted
+    ASSERT_TEST(!is_rejected(data, size), destroyRejectOutOfRangeColumns);
+
+destroyRejectOutOfRangeColumns:
+    remove(SCHEDULE_FILE);
+    remove(BROKEN_FILE);
+    return result;
+}
+
+#define NUMBER_TESTS 6
+
+bool (*tests[]) (void) = {
+        testReadExportedSchedule,
+        testMapExportedSchedule,
+        testRejectTruncatedFile,
+        testRejectBadHeader,
+        testRejectBadSectionLength,
+        testRejectOutOfRangeColumns
+};
+
+const char* testNames[] = {
+        "testReadExportedSchedule",
+        "testMapExportedSchedule",
+        "testRejectTruncatedFile",
+        "testRejectBadHeader",
+        "testRejectBadSectionLength",
+        "testRejectOutOfRangeColumns"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: schedule_file_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
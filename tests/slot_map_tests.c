@@ -0,0 +1,166 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../slot_map.h"
+#include "test_utilities.h"
+
+#define IDS 5000
+#define STEPS 200000
+#define NO_SLOT -1
+
+/**
+* next_random: a xorshift generator, so every run checks the same steps.
+*/
+static unsigned int next_random(unsigned int* seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+bool testSlotMapInsertFind() {
+    bool result = true;
+    SlotMap map = slotMapCreate();
+    int slot = NO_SLOT;
+    ASSERT_TEST(map != NULL, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapInsert(NULL, 1, &slot) == SM_NULL_ARGUMENT, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapInsert(map, -1, &slot) == SM_INVALID_ID, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapInsert(map, 1000000, &slot) == SM_SUCCESS, destroySlotMapInsertFind);
+    ASSERT_TEST(slot == 0, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapInsert(map, 3, NULL) == SM_SUCCESS, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapInsert(map, 3, &slot) == SM_ID_ALREADY_EXISTS, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapFind(map, 3) == 1, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapFind(map, 1000000) == 0, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapFind(map, 4) == NO_SLOT, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapFind(map, -3) == NO_SLOT, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapGetId(map, 1) == 3, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapGetId(map, 2) == NO_SLOT, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapGetSlots(map) == 2, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapRemove(map, 4) == SM_ID_NOT_EXISTS, destroySlotMapInsertFind);
+    ASSERT_TEST(slotMapRemove(map, -4) == SM_ID_NOT_EXISTS, destroySlotMapInsertFind);
+
+destroySlotMapInsertFind:
+    slotMapDestroy(map);
+    return result;
+}
+
+bool testSlotMapSlotReuse() {
+    bool result = true;
+    SlotMap map = slotMapCreate();
+    int slot = NO_SLOT;
+    ASSERT_TEST(map != NULL, destroySlotMapSlotReuse);
+    for (int id = 0; id < 100; id++) {
+        ASSERT_TEST(slotMapInsert(map, id * 7, &slot) == SM_SUCCESS, destroySlotMapSlotReuse);
+        ASSERT_TEST(slot == id, destroySlotMapSlotReuse);
+    }
+    ASSERT_TEST(slotMapRemove(map, 10 * 7) == SM_SUCCESS, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapRemove(map, 20 * 7) == SM_SUCCESS, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapGetId(map, 10) == NO_SLOT, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapFind(map, 10 * 7) == NO_SLOT, destroySlotMapSlotReuse);
+    // the slot freed last is given first, and no new slot is taken while one is free
+    ASSERT_TEST(slotMapInsert(map, 1, &slot) == SM_SUCCESS, destroySlotMapSlotReuse);
+    ASSERT_TEST(slot == 20, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapInsert(map, 2, &slot) == SM_SUCCESS, destroySlotMapSlotReuse);
+    ASSERT_TEST(slot == 10, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapGetId(map, 10) == 2, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapInsert(map, 3, &slot) == SM_SUCCESS, destroySlotMapSlotReuse);
+    ASSERT_TEST(slot == 100, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapGetSlots(map) == 101, destroySlotMapSlotReuse);
+    // a removed id can come back, in whatever slot is free
+    ASSERT_TEST(slotMapRemove(map, 3) == SM_SUCCESS, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapInsert(map, 10 * 7, &slot) == SM_SUCCESS, destroySlotMapSlotReuse);
+    ASSERT_TEST(slot == 100, destroySlotMapSlotReuse);
+    ASSERT_TEST(slotMapFind(map, 10 * 7) == 100, destroySlotMapSlotReuse);
+
+destroySlotMapSlotReuse:
+    slotMapDestroy(map);
+    return result;
+}
+
+bool testSlotMapBackwardShift() {
+    bool result = true;
+    SlotMap map = slotMapCreate();
+    int* slots = malloc(sizeof(*slots) * IDS);
+    int* owners = malloc(sizeof(*owners) * IDS);
+    int live = 0;
+    int max_live = 0;
+    unsigned int seed = 2463534242u;
+    ASSERT_TEST(map != NULL && slots != NULL && owners != NULL, destroySlotMapBackwardShift);
+    for (int i = 0; i < IDS; i++) {
+        slots[i] = NO_SLOT;
+        owners[i] = NO_SLOT;
+    }
+    // random inserts and removes keep long probe sequences in the table, and
+    // every remove shifts the ids after it back; a hole would lose them
+    for (int step = 0; step < STEPS; step++) {
+        int id = (int)(next_random(&seed) % IDS);
+        int slot = NO_SLOT;
+        if (slots[id] == NO_SLOT) {
+            ASSERT_TEST(slotMapInsert(map, id, &slot) == SM_SUCCESS, destroySlotMapBackwardShift);
+            ASSERT_TEST(slot >= 0 && slot < IDS && owners[slot] == NO_SLOT, destroySlotMapBackwardShift);
+            slots[id] = slot;
+            owners[slot] = id;
+            live++;
+            max_live = live > max_live ? live : max_live;
+        } else if (next_random(&seed) % 2 == 0) {
+            ASSERT_TEST(slotMapRemove(map, id) == SM_SUCCESS, destroySlotMapBackwardShift);
+            owners[slots[id]] = NO_SLOT;
+            slots[id] = NO_SLOT;
+            live--;
+        }
+        if (step % 1000 == 0) {
+            for (int other = 0; other < IDS; other++) {
+                ASSERT_TEST(slotMapFind(map, other) == slots[other], destroySlotMapBackwardShift);
+            }
+        }
+    }
+    for (int id = 0; id < IDS; id++) {
+        ASSERT_TEST(slotMapFind(map, id) == slots[id], destroySlotMapBackwardShift);
+        ASSERT_TEST(slots[id] == NO_SLOT || slotMapGetId(map, slots[id]) == id, destroySlotMapBackwardShift);
+    }
+    // slots stay dense: no more slots were ever given than ids were live at once
+    ASSERT_TEST(slotMapGetSlots(map) == max_live, destroySlotMapBackwardShift);
+    ASSERT_TEST(slotMapGetMemoryUsage(map) > 0, destroySlotMapBackwardShift);
+
+destroySlotMapBackwardShift:
+    slotMapDestroy(map);
+    free(slots);
+    free(owners);
+    return result;
+}
+
+#define NUMBER_TESTS 3
+
+bool (*tests[]) (void) = {
+        testSlotMapInsertFind,
+        testSlotMapSlotReuse,
+        testSlotMapBackwardShift
+};
+
+const char* testNames[] = {
+        "testSlotMapInsertFind",
+        "testSlotMapSlotReuse",
+        "testSlotMapBackwardShift"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: slot_map_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
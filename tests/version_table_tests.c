@@ -0,0 +1,206 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "../version_table.h"
+#include "test_utilities.h"
+
+#define SLOTS 1000
+#define VERSIONS 8
+#define READERS 4
+#define ROUNDS 200
+
+/**
+* make_record: creates a record holding a single int.
+*/
+static int* make_record(int value)
+{
+    int* record = versionRecordCreate(sizeof(*record));
+    if (record != NULL) {
+        *record = value;
+    }
+    return record;
+}
+
+/**
+* get_value: returns the int in a slot of a table, or -1 if the slot is empty.
+*/
+static int get_value(VersionTable table, int slot)
+{
+    const int* record = versionTableGet(table, slot);
+    return record == NULL ? -1 : *record;
+}
+
+bool testVersionTableSetGet() {
+    bool result = true;
+    VersionTable table = versionTableCreate();
+    ASSERT_TEST(table != NULL, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableGetSize(table) == 0, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableGetSize(NULL) == -1, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableGet(table, 0) == NULL, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableSet(NULL, 0, make_record(1)) == VT_NULL_ARGUMENT, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableSet(table, -1, make_record(1)) == VT_INVALID_SLOT, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableSet(table, 130, make_record(130)) == VT_SUCCESS, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableGetSize(table) == 131, destroyVersionTableSetGet);
+    ASSERT_TEST(get_value(table, 130) == 130, destroyVersionTableSetGet);
+    ASSERT_TEST(get_value(table, 3) == -1, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableGet(table, 131) == NULL, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableSet(table, 130, make_record(7)) == VT_SUCCESS, destroyVersionTableSetGet);
+    ASSERT_TEST(get_value(table, 130) == 7, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableSet(table, 130, NULL) == VT_SUCCESS, destroyVersionTableSetGet);
+    ASSERT_TEST(get_value(table, 130) == -1, destroyVersionTableSetGet);
+    ASSERT_TEST(versionTableGetSize(table) == 131, destroyVersionTableSetGet);
+
+destroyVersionTableSetGet:
+    versionTableDestroy(table);
+    return result;
+}
+
+bool testVersionTableCopyIsolation() {
+    bool result = true;
+    VersionTable table = versionTableCreate();
+    VersionTable copy = NULL;
+    ASSERT_TEST(table != NULL, destroyVersionTableCopyIsolation);
+    for (int slot = 0; slot < SLOTS; slot++) {
+        ASSERT_TEST(versionTableSet(table, slot, make_record(slot)) == VT_SUCCESS, destroyVersionTableCopyIsolation);
+    }
+    ASSERT_TEST(versionTableCopy(NULL) == NULL, destroyVersionTableCopyIsolation);
+    copy = versionTableCopy(table);
+    ASSERT_TEST(copy != NULL, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(versionTableGetSize(copy) == SLOTS, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(versionTableGetMemoryUsage(copy) == versionTableGetMemoryUsage(table), destroyVersionTableCopyIsolation);
+    // a change to the table is not seen by the copy
+    ASSERT_TEST(versionTableSet(table, 5, make_record(-5)) == VT_SUCCESS, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(versionTableSet(table, SLOTS + 100, make_record(1)) == VT_SUCCESS, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(get_value(table, 5) == -5, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(get_value(copy, 5) == 5, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(versionTableGetSize(copy) == SLOTS, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(versionTableGet(copy, SLOTS + 100) == NULL, destroyVersionTableCopyIsolation);
+    // nor is a change to the copy seen by the table
+    ASSERT_TEST(versionTableSet(copy, 6, NULL) == VT_SUCCESS, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(get_value(copy, 6) == -1, destroyVersionTableCopyIsolation);
+    ASSERT_TEST(get_value(table, 6) == 6, destroyVersionTableCopyIsolation);
+    for (int slot = 7; slot < SLOTS; slot++) {
+        ASSERT_TEST(get_value(copy, slot) == slot, destroyVersionTableCopyIsolation);
+        ASSERT_TEST(get_value(table, slot) == slot, destroyVersionTableCopyIsolation);
+    }
+    // the copy outlives the table it was made from
+    versionTableDestroy(table);
+    table = NULL;
+    ASSERT_TEST(get_value(copy, SLOTS - 1) == SLOTS - 1, destroyVersionTableCopyIsolation);
+
+destroyVersionTableCopyIsolation:
+    versionTableDestroy(copy);
+    versionTableDestroy(table);
+    return result;
+}
+
+/**
+* Reader_ctx: a reader thread, the versions it checks and releases and the
+* value every slot holds in them.
+*/
+typedef struct reader_ctx {
+    VersionTable versions[VERSIONS];
+    int values[VERSIONS];
+    bool failed;
+} Reader_ctx;
+
+static void* read_and_release(void* arg)
+{
+    Reader_ctx* ctx = arg;
+    for (int i = 0; i < VERSIONS; i++) {
+        for (int slot = 0; slot < SLOTS; slot++) {
+            if (get_value(ctx->versions[i], slot) != ctx->values[i] + slot) {
+                ctx->failed = true;
+            }
+        }
+        versionTableDestroy(ctx->versions[i]);
+        ctx->versions[i] = NULL;
+    }
+    return NULL;
+}
+
+bool testVersionTableReleaseAcrossThreads() {
+    bool result = true;
+    VersionTable table = versionTableCreate();
+    Reader_ctx readers[READERS];
+    pthread_t threads[READERS];
+    int started = 0;
+    ASSERT_TEST(table != NULL, destroyVersionTableReleaseAcrossThreads);
+    for (int round = 0; round < ROUNDS; round++) {
+        // every reader gets versions of its own, all sharing the memory of the table
+        for (int i = 0; i < VERSIONS; i++) {
+            for (int slot = 0; slot < SLOTS; slot++) {
+                ASSERT_TEST(versionTableSet(table, slot, make_record(round * VERSIONS + i + slot)) == VT_SUCCESS,
+                            destroyVersionTableReleaseAcrossThreads);
+            }
+            for (int reader = 0; reader < READERS; reader++) {
+                readers[reader].versions[i] = versionTableCopy(table);
+                readers[reader].values[i] = round * VERSIONS + i;
+                ASSERT_TEST(readers[reader].versions[i] != NULL, destroyVersionTableReleaseAcrossThreads);
+            }
+        }
+        for (started = 0; started < READERS; started++) {
+            readers[started].failed = false;
+            ASSERT_TEST(pthread_create(&threads[started], NULL, read_and_release, &readers[started]) == 0,
+                        destroyVersionTableReleaseAcrossThreads);
+        }
+        // the table keeps changing, and on odd rounds it is released before the readers release their versions
+        for (int slot = 0; slot < SLOTS; slot += 3) {
+            ASSERT_TEST(versionTableSet(table, slot, NULL) == VT_SUCCESS, destroyVersionTableReleaseAcrossThreads);
+        }
+        if (round % 2 == 1) {
+            versionTableDestroy(table);
+            table = versionTableCreate();
+            ASSERT_TEST(table != NULL, destroyVersionTableReleaseAcrossThreads);
+        }
+        for (; started > 0; started--) {
+            pthread_join(threads[started - 1], NULL);
+        }
+        for (int reader = 0; reader < READERS; reader++) {
+            ASSERT_TEST(!readers[reader].failed, destroyVersionTableReleaseAcrossThreads);
+        }
+    }
+
+destroyVersionTableReleaseAcrossThreads:
+    for (; started > 0; started--) {
+        pthread_join(threads[started - 1], NULL);
+    }
+    versionTableDestroy(table);
+    return result;
+}
+
+#define NUMBER_TESTS 3
+
+bool (*tests[]) (void) = {
+        testVersionTableSetGet,
+        testVersionTableCopyIsolation,
+        testVersionTableReleaseAcrossThreads
+};
+
+const char* testNames[] = {
+        "testVersionTableSetGet",
+        "testVersionTableCopyIsolation",
+        "testVersionTableReleaseAcrossThreads"
+};
+
+int main(int argc, char *argv[]) {
+    if (argc == 1) {
+        for (int test_idx = 0; test_idx < NUMBER_TESTS; test_idx++) {
+            RUN_TEST(tests[test_idx], testNames[test_idx]);
+        }
+        return 0;
+    }
+    if (argc != 2) {
+        fprintf(stdout, "Usage: version_table_tests <test index>\n");
+        return 0;
+    }
+
+    int test_idx = strtol(argv[1], NULL, 10);
+    if (test_idx < 1 || test_idx > NUMBER_TESTS) {
+        fprintf(stderr, "Invalid test index %d\n", test_idx);
+        return 0;
+    }
+
+    RUN_TEST(tests[test_idx - 1], testNames[test_idx - 1]);
+    return 0;
+}
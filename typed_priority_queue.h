@@ -0,0 +1,343 @@
+#ifndef TYPED_PRIORITY_QUEUE_H_
+#define TYPED_PRIORITY_QUEUE_H_
+
+#include "priority_queue.h"
+#include "priority_queue_ext.h"
+#include "allocator.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+* Typed Priority Queue
+*
+* A header-only priority queue that is generated by a macro for one element
+* type and one priority type, the same way a template would be instantiated.
+* Elements and priorities are stored by value and are compared and matched
+* through macros that are expanded inline, so no function pointer is called
+* and nothing is copied or freed on behalf of the user. Both types must be
+* trivially copyable, e.g. numbers, pointers or small structs. When the
+* elements are pointers the queue does not own what they point to.
+*
+* As in PriorityQueue, the elements are kept in a list ordered by priority and
+* elements with the same priority keep their insertion order.
+*
+* TYPED_PQ_DEFINE(Type, prefix, Element, Priority, HIGHER, EQUAL) defines the
+* queue type Type and the following static functions:
+*   prefix##Create          - Creates a new empty queue.
+*   prefix##CreateWithAllocator - Creates a new empty queue whose nodes are allocated by an allocator.
+*   prefix##Destroy         - Deletes an existing queue and frees all its nodes.
+*   prefix##GetSize         - Returns the number of elements in the queue.
+*   prefix##Contains        - Checks if an element is in the queue.
+*   prefix##Insert          - Inserts an element with a given priority.
+*   prefix##ChangePriority  - Moves an element from one priority to another, allocating nothing.
+*   prefix##Remove          - Removes the element with the highest priority.
+*   prefix##RemoveElement   - Removes the first occurrence of an element.
+*   prefix##GetFirst        - Sets the iterator at the highest priority element.
+*   prefix##GetNext         - Advances the iterator to the next element.
+*   prefix##PeekTopK        - Copies the k highest priority elements without moving the iterator.
+*   prefix##Clear           - Removes all the elements of the queue.
+*   prefix##GetStats        - Returns the instrumentation counters of the queue.
+*
+* HIGHER(priority1, priority2) must evaluate to true if priority1 comes strictly
+* before priority2, and EQUAL(element1, element2) to true if the elements match.
+* The macro is expanded at file scope and must not be followed by a semicolon.
+*
+* Instrumentation counters are maintained in the same PQStats as PriorityQueue
+* when the including file is compiled with ENABLE_STATS defined.
+*/
+
+/** Orders int priorities, such as packed dates, from the smallest up */
+#define TYPED_PQ_INT_ASCENDING(priority1, priority2) ((priority1) < (priority2))
+
+/** Matches elements that hold the same value, e.g. the same pointer */
+#define TYPED_PQ_SAME_VALUE(element1, element2) ((element1) == (element2))
+
+#ifdef ENABLE_STATS
+#define TYPED_PQ_STAT_ADD(queue, field, amount) ((queue)->stats.field += (amount))
+#define TYPED_PQ_STATS_FIELD PQStats stats;
+#define TYPED_PQ_STATS_ENABLE(queue) ((queue)->stats.enabled = true)
+#define TYPED_PQ_STATS_GET(queue, out) (*(out) = (queue)->stats)
+#else
+#define TYPED_PQ_STAT_ADD(queue, field, amount) ((void)0)
+#define TYPED_PQ_STATS_FIELD
+#define TYPED_PQ_STATS_ENABLE(queue) ((void)0)
+#define TYPED_PQ_STATS_GET(queue, out) ((void)0)
+#endif
+
+#define TYPED_PQ_DEFINE(Type, prefix, Element, Priority, HIGHER, EQUAL)                      \
+                                                                                              \
+typedef struct Type##_node {                                                                  \
+    Element element;                                                                          \
+    Priority priority;                                                                        \
+    struct Type##_node *next;                                                                 \
+} *Type##Node;                                                                                \
+                                                                                              \
+typedef struct Type##_t {                                                                     \
+    Type##Node head;                                                                          \
+    Type##Node it;                                                                            \
+    int size;                                                                                 \
+    Allocator allocator;                                                                      \
+    TYPED_PQ_STATS_FIELD                                                                      \
+} *Type;                                                                                      \
+                                                                                              \
+static inline Type prefix##CreateWithAllocator(const Allocator* allocator)                    \
+{                                                                                             \
+    Type queue = allocatorAlloc(allocator, sizeof(*queue));                                   \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return NULL;                                                                          \
+    }                                                                                         \
+    memset(queue, 0, sizeof(*queue));                                                         \
+    if(allocator != NULL)                                                                     \
+    {                                                                                         \
+        queue->allocator = *allocator;                                                        \
+    }                                                                                         \
+    TYPED_PQ_STATS_ENABLE(queue);                                                             \
+    return queue;                                                                             \
+}                                                                                             \
+                                                                                              \
+static inline Type prefix##Create(void)                                                       \
+{                                                                                             \
+    return prefix##CreateWithAllocator(NULL);                                                 \
+}                                                                                             \
+                                                                                              \
+static inline PriorityQueueResult prefix##Clear(Type queue)                                   \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return PQ_NULL_ARGUMENT;                                                              \
+    }                                                                                         \
+    Type##Node current = queue->head;                                                         \
+    while(current != NULL)                                                                    \
+    {                                                                                         \
+        Type##Node to_free = current;                                                         \
+        current = current->next;                                                              \
+        TYPED_PQ_STAT_ADD(queue, frees, 1);                                                   \
+        TYPED_PQ_STAT_ADD(queue, bytes_live, -(long)sizeof(*to_free));                        \
+        allocatorFree(&queue->allocator, to_free);                                            \
+    }                                                                                         \
+    queue->head = NULL;                                                                       \
+    queue->it = NULL;                                                                         \
+    queue->size = 0;                                                                          \
+    return PQ_SUCCESS;                                                                        \
+}                                                                                             \
+                                                                                              \
+static inline void prefix##Destroy(Type queue)                                                \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return;                                                                               \
+    }                                                                                         \
+    prefix##Clear(queue);                                                                     \
+    Allocator allocator = queue->allocator;                                                   \
+    allocatorFree(&allocator, queue);                                                         \
+}                                                                                             \
+                                                                                              \
+static inline int prefix##GetSize(Type queue)                                                 \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return -1;                                                                            \
+    }                                                                                         \
+    return queue->size;                                                                       \
+}                                                                                             \
+                                                                                              \
+static inline bool prefix##Contains(Type queue, Element element)                              \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return false;                                                                         \
+    }                                                                                         \
+    TYPED_PQ_STAT_ADD(queue, lookups, 1);                                                     \
+    for(Type##Node current = queue->head; current != NULL; current = current->next)           \
+    {                                                                                         \
+        TYPED_PQ_STAT_ADD(queue, nodes_scanned, 1);                                           \
+        if(EQUAL(current->element, element))                                                  \
+        {                                                                                     \
+            return true;                                                                      \
+        }                                                                                     \
+    }                                                                                         \
+    return false;                                                                             \
+}                                                                                             \
+                                                                                              \
+static inline PriorityQueueResult prefix##Insert(Type queue, Element element,                 \
+                                                 Priority priority)                           \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return PQ_NULL_ARGUMENT;                                                              \
+    }                                                                                         \
+    Type##Node new_node = allocatorAlloc(&queue->allocator, sizeof(*new_node));               \
+    if(new_node == NULL)                                                                      \
+    {                                                                                         \
+        return PQ_OUT_OF_MEMORY;                                                              \
+    }                                                                                         \
+    TYPED_PQ_STAT_ADD(queue, inserts, 1);                                                     \
+    TYPED_PQ_STAT_ADD(queue, allocations, 1);                                                 \
+    TYPED_PQ_STAT_ADD(queue, bytes_live, (long)sizeof(*new_node));                            \
+    new_node->element = element;                                                              \
+    new_node->priority = priority;                                                            \
+    Type##Node* link = &queue->head;                                                          \
+    while(*link != NULL)                                                                      \
+    {                                                                                         \
+        TYPED_PQ_STAT_ADD(queue, insert_comparisons, 1);                                      \
+        TYPED_PQ_STAT_ADD(queue, comparisons, 1);                                             \
+        if(HIGHER(priority, (*link)->priority))                                               \
+        {                                                                                     \
+            break;                                                                            \
+        }                                                                                     \
+        TYPED_PQ_STAT_ADD(queue, nodes_scanned, 1);                                           \
+        link = &(*link)->next;                                                                \
+    }                                                                                         \
+    new_node->next = *link;                                                                   \
+    *link = new_node;                                                                         \
+    queue->size++;                                                                            \
+    queue->it = NULL;                                                                         \
+    return PQ_SUCCESS;                                                                        \
+}                                                                                             \
+                                                                                              \
+static inline PriorityQueueResult prefix##RemoveElement(Type queue, Element element)          \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return PQ_NULL_ARGUMENT;                                                              \
+    }                                                                                         \
+    TYPED_PQ_STAT_ADD(queue, lookups, 1);                                                     \
+    Type##Node* link = &queue->head;                                                          \
+    while(*link != NULL && !EQUAL((*link)->element, element))                                 \
+    {                                                                                         \
+        TYPED_PQ_STAT_ADD(queue, nodes_scanned, 1);                                           \
+        link = &(*link)->next;                                                                \
+    }                                                                                         \
+    if(*link == NULL)                                                                         \
+    {                                                                                         \
+        return PQ_ELEMENT_DOES_NOT_EXISTS;                                                    \
+    }                                                                                         \
+    Type##Node to_free = *link;                                                               \
+    *link = to_free->next;                                                                    \
+    TYPED_PQ_STAT_ADD(queue, frees, 1);                                                       \
+    TYPED_PQ_STAT_ADD(queue, bytes_live, -(long)sizeof(*to_free));                            \
+    allocatorFree(&queue->allocator, to_free);                                                \
+    queue->size--;                                                                            \
+    queue->it = NULL;                                                                         \
+    return PQ_SUCCESS;                                                                        \
+}                                                                                             \
+                                                                                              \
+static inline PriorityQueueResult prefix##ChangePriority(Type queue, Element element,         \
+                                                         Priority old_priority,               \
+                                                         Priority new_priority)               \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return PQ_NULL_ARGUMENT;                                                              \
+    }                                                                                         \
+    TYPED_PQ_STAT_ADD(queue, lookups, 1);                                                     \
+    Type##Node* link = &queue->head;                                                          \
+    while(*link != NULL && !(EQUAL((*link)->element, element) &&                              \
+                             !HIGHER((*link)->priority, old_priority) &&                      \
+                             !HIGHER(old_priority, (*link)->priority)))                       \
+    {                                                                                         \
+        TYPED_PQ_STAT_ADD(queue, nodes_scanned, 1);                                           \
+        link = &(*link)->next;                                                                \
+    }                                                                                         \
+    if(*link == NULL)                                                                         \
+    {                                                                                         \
+        return PQ_ELEMENT_DOES_NOT_EXISTS;                                                    \
+    }                                                                                         \
+    Type##Node moved = *link;                                                                 \
+    *link = moved->next;                                                                      \
+    moved->priority = new_priority;                                                           \
+    TYPED_PQ_STAT_ADD(queue, inserts, 1);                                                     \
+    link = &queue->head;                                                                      \
+    while(*link != NULL)                                                                      \
+    {                                                                                         \
+        TYPED_PQ_STAT_ADD(queue, insert_comparisons, 1);                                      \
+        TYPED_PQ_STAT_ADD(queue, comparisons, 1);                                             \
+        if(HIGHER(new_priority, (*link)->priority))                                           \
+        {                                                                                     \
+            break;                                                                            \
+        }                                                                                     \
+        TYPED_PQ_STAT_ADD(queue, nodes_scanned, 1);                                           \
+        link = &(*link)->next;                                                                \
+    }                                                                                         \
+    moved->next = *link;                                                                      \
+    *link = moved;                                                                            \
+    queue->it = NULL;                                                                         \
+    return PQ_SUCCESS;                                                                        \
+}                                                                                             \
+                                                                                              \
+static inline PriorityQueueResult prefix##Remove(Type queue)                                  \
+{                                                                                             \
+    if(queue == NULL)                                                                         \
+    {                                                                                         \
+        return PQ_NULL_ARGUMENT;                                                              \
+    }                                                                                         \
+    Type##Node to_free = queue->head;                                                         \
+    if(to_free == NULL)                                                                       \
+    {                                                                                         \
+        return PQ_SUCCESS;                                                                    \
+    }                                                                                         \
+    queue->head = to_free->next;                                                              \
+    TYPED_PQ_STAT_ADD(queue, frees, 1);                                                       \
+    TYPED_PQ_STAT_ADD(queue, bytes_live, -(long)sizeof(*to_free));                            \
+    allocatorFree(&queue->allocator, to_free);                                                \
+    queue->size--;                                                                            \
+    queue->it = NULL;                                                                         \
+    return PQ_SUCCESS;                                                                        \
+}                                                                                             \
+                                                                                              \
+static inline Element* prefix##GetFirst(Type queue)                                           \
+{                                                                                             \
+    if(queue == NULL || queue->head == NULL)                                                  \
+    {                                                                                         \
+        return NULL;                                                                          \
+    }                                                                                         \
+    queue->it = queue->head;                                                                  \
+    return &queue->it->element;                                                               \
+}                                                                                             \
+                                                                                              \
+static inline Element* prefix##GetNext(Type queue)                                            \
+{                                                                                             \
+    if(queue == NULL || queue->it == NULL || queue->it->next == NULL)                         \
+    {                                                                                         \
+        return NULL;                                                                          \
+    }                                                                                         \
+    queue->it = queue->it->next;                                                              \
+    return &queue->it->element;                                                               \
+}                                                                                             \
+                                                                                              \
+static inline int prefix##PeekTopK(Type queue, int k, Element* elements,                     \
+                                   Priority* priorities)                                      \
+{                                                                                             \
+    if(queue == NULL || k < 0 || (elements == NULL && k > 0))                                 \
+    {                                                                                         \
+        return -1;                                                                            \
+    }                                                                                         \
+    int count = 0;                                                                            \
+    for(Type##Node current = queue->head; current != NULL && count < k;                       \
+        current = current->next)                                                              \
+    {                                                                                         \
+        TYPED_PQ_STAT_ADD(queue, nodes_scanned, 1);                                           \
+        elements[count] = current->element;                                                   \
+        if(priorities != NULL)                                                                \
+        {                                                                                     \
+            priorities[count] = current->priority;                                            \
+        }                                                                                     \
+        count++;                                                                              \
+    }                                                                                         \
+    return count;                                                                             \
+}                                                                                             \
+                                                                                              \
+static inline PriorityQueueResult prefix##GetStats(Type queue, PQStats* stats)                \
+{                                                                                             \
+    if(queue == NULL || stats == NULL)                                                        \
+    {                                                                                         \
+        return PQ_NULL_ARGUMENT;                                                              \
+    }                                                                                         \
+    memset(stats, 0, sizeof(*stats));                                                         \
+    TYPED_PQ_STATS_GET(queue, stats);                                                         \
+    return PQ_SUCCESS;                                                                        \
+}
+
+#endif /* TYPED_PRIORITY_QUEUE_H_ */
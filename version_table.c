@@ -0,0 +1,353 @@
+#include "version_table.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#define PAGE_SLOTS 64
+#define INITIAL_PAGES 16
+#define EXPAND_FACTOR 2
+
+/**
+* Record_count: the reference count of a record and the number of bytes
+* allocated for it, its header included.
+*/
+typedef struct record_count{
+    long references;
+    size_t size;
+}Record_count;
+
+/**
+* Record_header: the count in front of every record, padded so the record
+* that follows it is aligned for any type.
+*/
+typedef union record_header{
+    Record_count count;
+    long double align_long_double;
+    long long align_long_long;
+    void* align_pointer;
+}Record_header;
+
+/**
+* Page: PAGE_SLOTS consecutive slots, shared by the directories that list it.
+*/
+typedef struct page{
+    long references;
+    void* records[PAGE_SLOTS];
+}*Page;
+
+/**
+* Directory: the pages of a table, shared by the versions that hold it.
+* A NULL page holds no records.
+*/
+typedef struct directory{
+    long references;
+    int pages_num;
+    Page pages[];
+}*Directory;
+
+struct VersionTable_t{
+    Directory directory;
+    int size;
+    long bytes;
+};
+
+/**
+* retain: adds a reference to a reference count.
+*/
+static void retain(long* references)
+{
+    __atomic_fetch_add(references,1,__ATOMIC_RELAXED);
+}
+
+/**
+* release: drops a reference from a reference count.
+*
+* @param references - the reference count.
+* @return
+* TRUE - if it was the last reference, so the memory may be freed.
+* otherwise FALSE.
+*/
+static bool release(long* references)
+{
+    return __atomic_sub_fetch(references,1,__ATOMIC_ACQ_REL)==0;
+}
+
+/**
+* is_shared: checks if memory has references other than the caller's own.
+* A version that releases its reference on another thread may only make a
+* shared memory look shared a little longer, which costs an extra copy.
+*/
+static bool is_shared(long* references)
+{
+    return __atomic_load_n(references,__ATOMIC_ACQUIRE)>1;
+}
+
+void* versionRecordCreate(size_t size)
+{
+    Record_header* header=malloc(sizeof(*header)+size);
+    if(header==NULL)
+    {
+        return NULL;
+    }
+    header->count.references=1;
+    header->count.size=sizeof(*header)+size;
+    return header+1;
+}
+
+void versionRecordRelease(void* record)
+{
+    if(record==NULL)
+    {
+        return;
+    }
+    Record_header* header=(Record_header*)record-1;
+    if(release(&header->count.references))
+    {
+        free(header);
+    }
+}
+
+/**
+* record_size: returns the number of bytes allocated for a record.
+*
+* @param record - the record, may be NULL.
+* @return
+* 0 - if record is NULL.
+* otherwise the size of the record and its header.
+*/
+static size_t record_size(const void* record)
+{
+    return record==NULL ? 0 : ((const Record_header*)record-1)->count.size;
+}
+
+/**
+* release_page: drops a reference to a page, and frees the page and releases
+* its records if it was the last one.
+*
+* @param page - the page, may be NULL.
+*/
+static void release_page(Page page)
+{
+    if(page==NULL||!release(&page->references))
+    {
+        return;
+    }
+    for(int i=0;i<PAGE_SLOTS;i++){
+        versionRecordRelease(page->records[i]);
+    }
+    free(page);
+}
+
+/**
+* release_directory: drops a reference to a directory, and frees the
+* directory and releases its pages if it was the last one.
+*
+* @param directory - the directory, may be NULL.
+*/
+static void release_directory(Directory directory)
+{
+    if(directory==NULL||!release(&directory->references))
+    {
+        return;
+    }
+    for(int i=0;i<directory->pages_num;i++){
+        release_page(directory->pages[i]);
+    }
+    free(directory);
+}
+
+/**
+* own_directory: gives a table a directory of its own with room for at least
+* pages_num pages, copying the shared or small directory it had.
+*
+* @param table - the table that is changed.
+* @param pages_num - the number of pages needed.
+* @return
+* FALSE - if allocation fails, the table keeps its directory.
+* otherwise TRUE.
+*/
+static bool own_directory(VersionTable table,int pages_num)
+{
+    Directory directory=table->directory;
+    if(directory!=NULL&&directory->pages_num>=pages_num&&!is_shared(&directory->references))
+    {
+        return true;
+    }
+    int capacity= directory==NULL ? INITIAL_PAGES : directory->pages_num;
+    while(capacity<pages_num){
+        capacity*=EXPAND_FACTOR;
+    }
+    Directory owned=malloc(sizeof(*owned)+sizeof(*owned->pages)*capacity);
+    if(owned==NULL)
+    {
+        return false;
+    }
+    owned->references=1;
+    owned->pages_num=capacity;
+    memset(owned->pages,0,sizeof(*owned->pages)*capacity);
+    if(directory!=NULL)
+    {
+        for(int i=0;i<directory->pages_num;i++){
+            owned->pages[i]=directory->pages[i];
+            if(owned->pages[i]!=NULL)
+            {
+                retain(&owned->pages[i]->references);
+            }
+        }
+        table->bytes-=(long)(sizeof(*directory)+sizeof(*directory->pages)*directory->pages_num);
+        release_directory(directory);
+    }
+    table->bytes+=(long)(sizeof(*owned)+sizeof(*owned->pages)*capacity);
+    table->directory=owned;
+    return true;
+}
+
+/**
+* own_page: gives the directory of a table, which it owns, a page of its own,
+* copying the page if it is shared and creating it if it is missing.
+*
+* @param table - the table that is changed.
+* @param index - the index of the page in the directory.
+* @return
+* NULL - if allocation fails, the directory keeps its page.
+* otherwise the page.
+*/
+static Page own_page(VersionTable table,int index)
+{
+    Page page=table->directory->pages[index];
+    if(page!=NULL&&!is_shared(&page->references))
+    {
+        return page;
+    }
+    Page owned=malloc(sizeof(*owned));
+    if(owned==NULL)
+    {
+        return NULL;
+    }
+    owned->references=1;
+    if(page==NULL)
+    {
+        memset(owned->records,0,sizeof(owned->records));
+        table->bytes+=(long)sizeof(*owned);
+    }
+    else
+    {
+        for(int i=0;i<PAGE_SLOTS;i++){
+            owned->records[i]=page->records[i];
+            if(owned->records[i]!=NULL)
+            {
+                retain(&((Record_header*)owned->records[i]-1)->count.references);
+            }
+        }
+        release_page(page);
+    }
+    table->directory->pages[index]=owned;
+    return owned;
+}
+
+VersionTable versionTableCreate(void)
+{
+    VersionTable table=malloc(sizeof(*table));
+    if(table==NULL)
+    {
+        return NULL;
+    }
+    table->directory=NULL;
+    table->size=0;
+    table->bytes=(long)sizeof(*table);
+    return table;
+}
+
+void versionTableDestroy(VersionTable table)
+{
+    if(table==NULL)
+    {
+        return;
+    }
+    release_directory(table->directory);
+    free(table);
+}
+
+VersionTable versionTableCopy(VersionTable table)
+{
+    if(table==NULL)
+    {
+        return NULL;
+    }
+    VersionTable copy=malloc(sizeof(*copy));
+    if(copy==NULL)
+    {
+        return NULL;
+    }
+    copy->directory=table->directory;
+    copy->size=table->size;
+    copy->bytes=table->bytes;
+    if(copy->directory!=NULL)
+    {
+        retain(&copy->directory->references);
+    }
+    return copy;
+}
+
+int versionTableGetSize(VersionTable table)
+{
+    if(table==NULL)
+    {
+        return -1;
+    }
+    return table->size;
+}
+
+long versionTableGetMemoryUsage(VersionTable table)
+{
+    if(table==NULL)
+    {
+        return 0;
+    }
+    return table->bytes;
+}
+
+const void* versionTableGet(VersionTable table, int slot)
+{
+    if(table==NULL||slot<0||slot>=table->size)
+    {
+        return NULL;
+    }
+    Page page=table->directory->pages[slot/PAGE_SLOTS];
+    return page==NULL ? NULL : page->records[slot%PAGE_SLOTS];
+}
+
+VersionTableResult versionTableSet(VersionTable table, int slot, void* record)
+{
+    if(table==NULL)
+    {
+        versionRecordRelease(record);
+        return VT_NULL_ARGUMENT;
+    }
+    if(slot<0)
+    {
+        versionRecordRelease(record);
+        return VT_INVALID_SLOT;
+    }
+    if(record==NULL&&versionTableGet(table,slot)==NULL)
+    {
+        return VT_SUCCESS;
+    }
+    Page page=NULL;
+    if(own_directory(table,slot/PAGE_SLOTS+1))
+    {
+        page=own_page(table,slot/PAGE_SLOTS);
+    }
+    if(page==NULL)
+    {
+        versionRecordRelease(record);
+        return VT_OUT_OF_MEMORY;
+    }
+    table->bytes+=(long)record_size(record)-(long)record_size(page->records[slot%PAGE_SLOTS]);
+    versionRecordRelease(page->records[slot%PAGE_SLOTS]);
+    page->records[slot%PAGE_SLOTS]=record;
+    if(slot>=table->size)
+    {
+        table->size=slot+1;
+    }
+    return VT_SUCCESS;
+}
@@ -0,0 +1,147 @@
+#ifndef VERSION_TABLE_H_
+#define VERSION_TABLE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+* Version Table
+*
+* A table of immutable records indexed by slot, whose versions share their
+* memory. The slots are kept in fixed-size pages listed in a directory, and
+* the directory, the pages and the records are reference counted. Copying a
+* table takes O(1): the copy shares the directory of the table. A change to a
+* version copies the directory and the page of the slot when they are shared
+* with another version, so no other version ever sees it.
+*
+* A record is created by versionRecordCreate, filled by its creator and never
+* changed after it is put in a table. Records should hold no pointers to
+* memory they own, since they are freed with the last version that holds them.
+*
+* Every version may be used by a single thread at a time, and versions that
+* share memory may be used and destroyed by different threads at once.
+* Memory is freed by whichever thread drops its last reference, so the table
+* always allocates with malloc and takes no Allocator.
+*
+* The following functions are available:
+*   versionTableCreate      - Creates a new empty table.
+*   versionTableDestroy     - Deletes a version of a table and releases its records.
+*   versionTableCopy        - Creates a new version that shares the memory of a table.
+*   versionTableGetSize     - Returns the number of slots of a table.
+*   versionTableGetMemoryUsage - Returns the number of bytes a version of a table reaches.
+*   versionTableGet         - Returns the record in a slot.
+*   versionTableSet         - Puts a record in a slot, replacing the record that was there.
+*   versionRecordCreate     - Allocates a new record.
+*   versionRecordRelease    - Releases a record that was not put in a table.
+*/
+
+/** Type for defining the table */
+typedef struct VersionTable_t *VersionTable;
+
+/** Type used for returning error codes from table functions */
+typedef enum VersionTableResult_t {
+    VT_SUCCESS,
+    VT_OUT_OF_MEMORY,
+    VT_NULL_ARGUMENT,
+    VT_INVALID_SLOT
+} VersionTableResult;
+
+/**
+* versionTableCreate: Allocates a new empty table.
+*
+* @return
+*   NULL - if allocation failed.
+*   A new table in case of success.
+*/
+VersionTable versionTableCreate(void);
+
+/**
+* versionTableDestroy: Deallocates a version of a table. The memory it shares
+* with other versions is freed with the last of them.
+*
+* @param table - Target table to be deallocated. If table is NULL nothing will be done.
+*/
+void versionTableDestroy(VersionTable table);
+
+/**
+* versionTableCopy: Creates a new version with the records of a table in
+* O(1). Later changes to either of them are not seen by the other.
+*
+* @param table - The table to copy.
+* @return
+*   NULL - if a NULL was sent or allocation failed.
+*   The new version in case of success.
+*/
+VersionTable versionTableCopy(VersionTable table);
+
+/**
+* versionTableGetSize: Returns the number of slots of a table, one more than
+* the largest slot that was ever set.
+*
+* @param table - The table whose size is requested.
+* @return
+*   -1 if a NULL pointer was sent.
+*   Otherwise the number of slots.
+*/
+int versionTableGetSize(VersionTable table);
+
+/**
+* versionTableGetMemoryUsage: Returns the number of bytes of a version, its
+* directory, its pages and its records. Memory the version shares with other
+* versions is counted in each of them in full. Runs in O(1), the version keeps
+* the count up to date as it changes.
+*
+* @param table - The version to measure.
+* @return
+*   0 if a NULL pointer was sent.
+*   Otherwise the number of bytes.
+*/
+long versionTableGetMemoryUsage(VersionTable table);
+
+/**
+* versionTableGet: Returns the record in a slot of a table.
+*
+* @param table - The table to read.
+* @param slot - The slot of the record.
+* @return
+*   NULL if a NULL was sent, the slot is out of range or holds no record.
+*   Otherwise the record, which stays valid as long as the table is not changed or destroyed.
+*/
+const void* versionTableGet(VersionTable table, int slot);
+
+/**
+* versionTableSet: Puts a record in a slot of a table. The table takes the
+* reference the caller held to the record, and releases the record that was in
+* the slot. On failure the record is released and the table is unchanged.
+*
+* @param table - The table to change.
+* @param slot - The slot of the record.
+* @param record - The record, returned by versionRecordCreate. NULL empties the slot.
+* @return
+*   VT_NULL_ARGUMENT if a NULL was sent as table.
+*   VT_INVALID_SLOT if slot is negative.
+*   VT_OUT_OF_MEMORY if allocation failed.
+*   VT_SUCCESS the record had been put successfully.
+*/
+VersionTableResult versionTableSet(VersionTable table, int slot, void* record);
+
+/**
+* versionRecordCreate: Allocates a record of size bytes, with a single
+* reference held by the caller.
+*
+* @param size - The size of the record in bytes.
+* @return
+*   NULL - if allocation failed.
+*   The new record in case of success.
+*/
+void* versionRecordCreate(size_t size);
+
+/**
+* versionRecordRelease: Releases the reference the caller holds to a record
+* that was not put in a table.
+*
+* @param record - The record. If record is NULL nothing will be done.
+*/
+void versionRecordRelease(void* record);
+
+#endif /* VERSION_TABLE_H_ */